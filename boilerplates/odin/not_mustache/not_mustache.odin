@@ -62,6 +62,41 @@ SeekDir :: enum {
     Len = 3
 }
 
+EscapeState :: enum u8 {
+    Unknown = 0,
+    Clean,
+    Dirty
+}
+
+StringEncoding :: enum u8 {
+    None = 0,
+    JSON
+}
+
+JSONFlag :: enum u32 {
+    DeepCopy = 0,
+    CacheEscaped = 1,
+    KeepNumerals = 2,
+    Arena = 3,
+    Lazy = 4
+}
+
+JSONFlags :: bit_set[JSONFlag; u32]
+
+FDFlag :: enum u32 {
+    Aligned = 0     // output is written in whole 4096 byte blocks from an aligned part of the parse buffer, for fds opened with O_DIRECT
+}
+
+FDFlags :: bit_set[FDFlag; u32]
+
+DeflateFormat :: enum u32 {
+    Raw = 0,        // a bare deflate stream, RFC 1951
+    Zlib,           // the zlib format of RFC 1950, the "deflate" content coding of HTTP
+    Gzip            // the gzip format of RFC 1952, the "gzip" content coding of HTTP
+}
+
+DECIMALS_SHORTEST :: 0xFF
+
 /* ====== FUNCTION CALLBACK TYPES ====== */
 
 Alloc :: proc "c" (parser: ^Parser, size: int) -> (rawptr);
@@ -91,6 +126,9 @@ ParamType :: enum {
     List,
     Object,
     Template,
+    Int64,
+    Decimal,
+    JSON,
 }
 
 Param :: struct {
@@ -101,14 +139,32 @@ Param :: struct {
 
 ParamString :: struct {
     using param: Param,
-    str: string
+    str: string,
+    encoding: StringEncoding,
+    escapeState: EscapeState,
+    cacheEscaped: bool,
+    escaped: []u8
 }
 
 ParamNumber :: struct {
     using param: Param,
     value: f64,
     decimals: u8,
-    trimZeros: bool
+    trimZeros: bool,
+    numeral: string
+}
+
+ParamInt64 :: struct {
+    using param: Param,
+    value: i64,
+    numeral: string
+}
+
+ParamDecimal :: struct {
+    using param: Param,
+    units: i64,
+    scale: u8,
+    numeral: string
 }
 
 ParamBoolean :: struct {
@@ -122,6 +178,15 @@ ParamList :: struct {
     valueCount: u32
 }
 
+ParamJSON :: struct {
+    using param: Param,
+    pValues: ^Param,
+    valueCount: u32,
+    source: []u8,
+    document: rawptr,
+    paths: rawptr
+}
+
 ParamObject ::struct {
     using param: Param,
     pMembers: ^Param
@@ -152,6 +217,41 @@ Structure :: struct {
     __H: rawptr,        // DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER
 }
 
+// the parameter paths a set of templates can reference, zero initialize it before its first use
+PathSet :: struct {
+    __A: rawptr,        // DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER
+}
+
+// one file of a loadFiles batch, set exactly one of structChain and paramRoot
+Load :: struct {
+    filename: []u8,
+    structChain: ^Structure,    // an empty chain to compile the template into, it keeps the file's contents
+    paramRoot: ^^Param,         // where the parameter chain of a JSON file is stored
+    flags: JSONFlags,           // .DeepCopy is required, .Lazy and .KeepNumerals are not supported
+    filter: ^PathSet,           // see JSON_toParamChain, may be nil
+    err: Err,                   // the result of this file, set by loadFiles
+}
+
+// a thread that recompiles watched template files as they change (Linux)
+HotWatcher :: struct {
+    __A: rawptr,        // DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER
+}
+
+// a template file kept compiled by a HotWatcher (Linux)
+HotTemplate :: struct {
+    __A: rawptr,        // DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER
+}
+
+// a thread that hands the output of pipelined renders to their parse callback (Linux)
+Flusher :: struct {
+    __A: rawptr,        // DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER
+}
+
+// the compression state of renderDeflate, a deflater serves one render at a time
+Deflater :: struct {
+    __A: rawptr,        // DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER
+}
+
 
 foreign import not_mustache "not_mustache_bin:not_mustache.o"
 
@@ -168,7 +268,8 @@ foreign not_mustache {
 @param mustache_const_slice filename
 @param mustache_structure* structChain - a pointer to a chain of mustache structures
 @param mustache_param* params - the parameter chain
-@param mustache_slice sourceBuffer - if the file length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE
+@param mustache_slice sourceBuffer - if the file length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE,
+    unused where the file is memory mapped (POSIX builds without NOT_MUSTACHE_NO_MMAP)
 @param mustache_slice parseBuffer - where the parsed template will be stored
 @param void* parseCallbackUdata - passed to the parseCallback function
 @param mustache_parse_callback - called upon parse completion
@@ -191,7 +292,8 @@ parseFile :: proc (parser: ^Parser, parentStackBuffer: []u8,  filename: string ,
 @param mustache_stream - the input stream to parse from
 @param mustache_structure* structChain - a pointer to a chain of mustache structures
 @param mustache_param* params - the parameter chain
-@param mustache_slice sourceBuffer - if the stream length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE
+@param mustache_slice sourceBuffer - if the stream length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE.
+    A stream without a seek callback is read until it ends, see mustache_compile_stream for templates of any size
 @param mustache_slice parseBuffer - where the parsed template will be stored
 @param void* parseCallbackUdata - passed to the parseCallback function
 @param mustache_parse_callback - called upon parse completion.
@@ -208,6 +310,96 @@ parseStream :: proc (parser: ^Parser, parentStackBuffer: []u8, stream: ^Stream,
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
+-+- Compiles a mustache template source that is already in memory. -+-
+    The structure chain borrows the source instead of copying it, the source must stay
+    alive and unchanged until the chain is freed.
+
+@param mustache_parser* parser
+@param mustache_const_slice source - the template source
+@param mustache_structure* structChain - an empty (zero initialized or freed) structure chain
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain is not empty.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_compile")
+compile :: proc (parser: ^Parser, source: string, structChain: ^Structure) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a mustache template read from an input stream of any length. -+-
+    The stream is read and compiled a window of at most 64 KB at a time.
+    Only the literal text and the tags are kept, comments and mode pragmas are cut out as they are
+    read, in memory the chain owns and frees with mustache_structure_chain_free. The stream needs
+    no seek callback. Render the chain with mustache_render. Its source no longer lines up with the
+    stream, mustache_path_set_add_template and nested templates use the chain's own copy, and
+    mustache_render_sendfile writes it from memory, compile with mustache_compile_fd to send from the file.
+
+@param mustache_parser* parser
+@param mustache_stream* stream - the input stream to compile from, read until it ends
+@param mustache_structure* structChain - an empty (zero initialized or freed) structure chain
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain is not empty.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_compile_stream")
+compileStream :: proc (parser: ^Parser, stream: ^Stream, structChain: ^Structure) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Parses a template compiled by mustache_compile or mustache_compile_stream straight from its source. -+-
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer - a stack to hold the parent context(s)
+@param mustache_structure* structChain - a chain compiled by mustache_compile or mustache_compile_stream
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - where the parsed template will be stored
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback - called upon parse completion.
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain was not compiled by mustache_compile(_stream).
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_render")
+render :: proc (parser: ^Parser, parentStackBuffer: []u8, structChain: ^Structure,  params: ^Param,
+    parseBuffer: []u8,  parseCallbackUdata: rawptr, parseCallback: ParseCallback) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders like mustache_render and hashes the output as it is written, while it is still in cache. -+-
+    The hash is set before the parse callback is called, the callback can send it as an ETag ahead
+    of the output. It is the 64 bit XXH64 of the output with a seed of 0, as any xxHash library
+    computes it with XXH64(). It is not XXH3, whose XXH3_64bits() gives a different value.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer - a stack to hold the parent context(s)
+@param mustache_structure* structChain - a chain compiled by mustache_compile or mustache_compile_stream
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - where the parsed template will be stored
+@param uint64_t* hash - where the hash of the output is stored
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback - called upon parse completion.
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain was not compiled by mustache_compile(_stream) or hash is NULL.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_render_hashed")
+renderHashed :: proc (parser: ^Parser, parentStackBuffer: []u8, structChain: ^Structure,  params: ^Param,
+    parseBuffer: []u8, hash: ^u64, parseCallbackUdata: rawptr, parseCallback: ParseCallback) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
 -+- Destroys a structure chain, calling parser->free for every node in the list. -+-
 
 @param mustache_parser* parser
@@ -222,9 +414,9 @@ structureChainFree :: proc (parser: ^Parser, structChain: ^Structure) ---
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
--+- Primes a structure chain for its next use, this must be called if the parameter -+-
-    used to generate this structure chain have been modified since the its last 
--+- usage.                                                                          -+-
+-+- Clears the params a structure chain resolved in its last render. -+-
+    Every render resolves its params again from the parameter chain it is given,
+    so a chain can be rendered with a new or changed parameter chain without this.
 
 @param mustache_structure* structure_chain
 
@@ -237,7 +429,49 @@ structureChainFlush :: proc (structChain: ^Structure) ---
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
+-+- Adds every parameter path a template can reference to a path set. -+-
+    Nested templates found in params are added as well. A name used inside a section is added
+    below every section it could be resolved in, so the set can only hold more than the template
+    uses, never less. The structure chain is built from source if it is still empty, source must be
+    the same template that is later passed to mustache_parse_stream.
+    A JSON tree can be rendered from its root param, where the template names its members
+    'root.title', or from the root's members, where it names them 'title'. Both are matched
+    against the members of the JSON root, so either template projects the same tree.
+
+@param mustache_parser* parser
+@param mustache_path_set* paths - a zero initialized or previously used path set
+@param mustache_structure* structChain - the template's structure chain
+@param mustache_const_slice source - the template source
+@param mustache_param* params - the parameter chain holding the nested templates
+
+@return uint8_t - MUSTACHE_RES return code. On error the set falls back to keeping every path.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_path_set_add_template")
+pathSetAddTemplate :: proc (parser: ^Parser, paths: ^PathSet, structChain: ^Structure, source: string, params: ^Param) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Destroys a path set, calling parser->free for every path in it. -+-
+
+@param mustache_parser* parser
+@param mustache_path_set* paths
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_path_set_free")
+pathSetFree :: proc (parser: ^Parser, paths: ^PathSet) ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
 -+- Converts JSON from a file on disk into a mustache parameter chain. -+-
+    The file is memory mapped where the platform allows it and streamed otherwise,
+    the chain never points into it.
 @param mustache_parser* parser
 @param mustache_const_slice filename
 @param mustache_param** paramRoot - pointer to a pointer to the beginning of the parameter chain.
@@ -253,30 +487,79 @@ JSON_toParamChainFromDisk :: proc(parser: ^Parser, filename: []u8, paramRoot: ^^
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
+-+- Loads a batch of template and JSON files. -+-
+    On Linux the reads are queued on an io_uring and every file is compiled or converted
+    as soon as its read completes, while the rest are still being read. Elsewhere, and for
+    anything that is not a regular file, the files are read one by one.
+
+@param mustache_parser* parser
+@param mustache_load* loads - the files, each one's err is set
+@param uint32_t count
+
+@return uint8_t - MUSTACHE_RES return code, the err of the first file that failed to load.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_load_files")
+loadFiles :: proc(parser: ^Parser, loads: [^]Load, count: u32) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
 -+- Converts JSON into a mustache parameter chain. -+-
 
 @param mustache_parser* parser
 @param mustache_const_slice - JSON source
 @param mustache_param** paramRoot - pointer to a pointer 
-@param bool deepCopyData - if true, the source data will be copied rather than shallowly referenced where applicable.
+@param uint32_t flags - MUSTACHE_JSON_FLAGS, passing true is equivalent to MUSTACHE_JSON_DEEP_COPY.
+@param const mustache_path_set* filter - members no template in the set references are skipped without
+                                         being allocated, NULL keeps every member. A member of the root
+                                         is kept if a template names it 'name' or 'root.name'.
+                                         The set must outlive a tree built with MUSTACHE_JSON_LAZY.
 
-@return uint8_t - MUSTACHE_RES return code.
+@return uint8_t - MUSTACHE_RES return code. With MUSTACHE_JSON_LAZY the nested objects and lists are
+                  only checked for their brackets, a render that reaches a malformed one fails with
+                  MUSTACHE_ERR_INVALID_JSON.
 
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 *****/
 
 @(link_name="mustache_JSON_to_param_chain")
-JSON_toParamChain :: proc(parser: ^Parser, JSON: []u8, paramRoot: ^^Param, deepCopyData: bool) -> Err ---
+JSON_toParamChain :: proc(parser: ^Parser, JSON: []u8, paramRoot: ^^Param, flags: JSONFlags, filter: ^PathSet) -> Err ---
 
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
--+- Converts JSON into a mustache parameter chain. -+-
+-+- Converts JSON read from a stream into a mustache parameter chain. -+-
+    The stream is read into chunkBuffer a chunk at a time and only the tree is kept, so the
+    document never has to fit in memory. A key and value that do not fit in chunkBuffer together
+    move the chunk to a larger buffer from parser->alloc.
+
+@param mustache_parser* parser
+@param mustache_stream* stream - only the read callback is used
+@param mustache_slice chunkBuffer - the buffer the stream is read into
+@param mustache_param** paramRoot - pointer to a pointer 
+@param uint32_t flags - MUSTACHE_JSON_FLAGS, MUSTACHE_JSON_DEEP_COPY is required, MUSTACHE_JSON_LAZY and MUSTACHE_JSON_KEEP_NUMERALS are not supported.
+@param const mustache_path_set* filter - see mustache_JSON_to_param_chain.
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_JSON_to_param_chain_from_stream")
+JSON_toParamChainFromStream :: proc(parser: ^Parser, stream: ^Stream, chunkBuffer: []u8, paramRoot: ^^Param, flags: JSONFlags, filter: ^PathSet) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Frees a parameter chain created by mustache_JSON_to_param_chain. -+-
 
 @param mustache_parser* parser
-@param mustache_const_slice - JSON source
 @param mustache_param* paramRoot - the parameter root
-@param bool deepCopyData - determines what data will be freed.
+@param uint32_t flags - the MUSTACHE_JSON_FLAGS the chain was created with, passing true is equivalent to MUSTACHE_JSON_DEEP_COPY.
+                        With MUSTACHE_JSON_ARENA paramRoot must be the root returned by mustache_JSON_to_param_chain.
 
 @return uint8_t - MUSTACHE_RES return code.
 
@@ -284,7 +567,383 @@ JSON_toParamChain :: proc(parser: ^Parser, JSON: []u8, paramRoot: ^^Param, deepC
 */
 
 @(link_name="mustache_free_param_list")
-mustache_free_param_list :: proc(parser: ^Parser, paramRoot: ^Param, deepCopy: bool) -> Err ---
+mustache_free_param_list :: proc(parser: ^Parser, paramRoot: ^Param, flags: JSONFlags) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Releases the cached escaped form of a string param. -+-
+    This must be called before the contents of param->str are modified,
+    mustache_free_param_list calls it for every string in the list.
+
+@param mustache_parser* parser
+@param mustache_param_string* param
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_param_string_release")
+paramStringRelease :: proc(parser: ^Parser, param: ^ParamString) ---
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 HOT RELOAD (LINUX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+when ODIN_OS == .Linux {
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Starts a thread that watches template files with inotify and recompiles them as they change. -+-
+    The thread allocates through the parser, parser->alloc and parser->free must be thread safe.
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_hot_watcher_start")
+hotWatcherStart :: proc (parser: ^Parser, watcher: ^HotWatcher) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a template file and keeps it compiled as it changes on disk. -+-
+    Every change is compiled on the watcher's thread and published atomically, renders that
+    are in flight finish on the version they began with. A change that fails to compile
+    leaves the last good version published.
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher - a started watcher
+@param mustache_const_slice filename
+@param mustache_hot_template* hot
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_hot_template_open")
+hotTemplateOpen :: proc (parser: ^Parser, watcher: ^HotWatcher, filename: string, hot: ^HotTemplate) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Parses the latest compiled version of a hot template, it never compiles. -+-
+    Like any structure chain a hot template is rendered by one thread at a time.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer - a stack to hold the parent context(s)
+@param mustache_hot_template* hot
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - where the parsed template will be stored
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback - called upon parse completion.
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_hot_render")
+hotRender :: proc (parser: ^Parser, parentStackBuffer: []u8, hot: ^HotTemplate, params: ^Param,
+    parseBuffer: []u8,  parseCallbackUdata: rawptr, parseCallback: ParseCallback) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Stops watching a hot template and frees it, it must not be rendered while it is closed. -+-
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher
+@param mustache_hot_template* hot
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_hot_template_close")
+hotTemplateClose :: proc (parser: ^Parser, watcher: ^HotWatcher, hot: ^HotTemplate) ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Stops the watcher's thread and frees the watcher along with any template still open on it. -+-
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_hot_watcher_stop")
+hotWatcherStop :: proc (parser: ^Parser, watcher: ^HotWatcher) ---
+
+}
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 FD OUTPUT (POSIX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+when ODIN_OS == .Linux || ODIN_OS == .Darwin || ODIN_OS == .FreeBSD || ODIN_OS == .OpenBSD || ODIN_OS == .NetBSD {
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a template from an open file, for rendering with mustache_render_sendfile. -+-
+    The file is read from offset 0 whatever the fd's position, the position is left unchanged.
+    The chain owns a copy of the contents, it is freed with mustache_structure_chain_free.
+
+@param mustache_parser* parser
+@param int templateFd - a regular file
+@param mustache_structure* structChain - an empty chain
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_FILE_OPEN if the fd is not a regular file.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_compile_fd")
+compileFd :: proc (parser: ^Parser, templateFd: c.int, structChain: ^Structure) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template to an fd as it goes, a file, pipe or socket. -+-
+    Values and short literal spans are gathered in the parse buffer, longer literal spans are
+    written from the compiled source in place. Both go out together with writev once 128 KB
+    are queued, or earlier when half of the parse buffer is used. The parse buffer only has
+    to hold the output between two writes, a longer value is escaped into memory from
+    parser->alloc and written across as many writes as it takes.
+    With MUSTACHE_FD_ALIGNED everything is copied into the parse buffer and written in whole
+    4096 byte blocks from an aligned address within it, only the last block of the render
+    may be partial. It is written with O_DIRECT lifted from the fd. The fd's offset should
+    be block aligned when the render starts. A non-blocking outFd is polled.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - a compiled chain, see mustache_compile
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - holds the output between writes, at least 3 blocks with MUSTACHE_FD_ALIGNED
+@param int outFd
+@param uint32_t flags - MUSTACHE_FD_FLAGS
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_STREAM if writing to outFd failed.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_render_fd")
+renderFd :: proc (parser: ^Parser, parentStackBuffer: []u8, structChain: ^Structure,  params: ^Param,
+    parseBuffer: []u8,  outFd: c.int, flags: FDFlags) -> Err ---
+
+}
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 SENDFILE OUTPUT (LINUX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+when ODIN_OS == .Linux {
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template to an fd, sending long literal spans straight from the template's file. -+-
+    Literal spans of 16 KB or more go from the page cache to outFd, spliced into a pipe and sent
+    with sendfile to a socket or file. Values and shorter spans are written as by mustache_render_fd,
+    ahead of the next span that is sent. If templateFd is not a regular file at least as long as
+    the source, the spans are written from the compiled source instead.
+    templateFd must hold the source at offset 0 and must not be written while it renders, replace
+    the file with a rename and keep rendering from the old fd. A non-blocking outFd is polled.
+    On a TCP socket, TCP_CORK keeps the sends of a render from going out as many small segments.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - compiled from templateFd, see mustache_compile_fd
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - holds the output between sends
+@param int templateFd - the file the template was compiled from
+@param int outFd - a socket, pipe or file
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_STREAM if writing to outFd failed.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_render_sendfile")
+renderSendfile :: proc (parser: ^Parser, parentStackBuffer: []u8, structChain: ^Structure,  params: ^Param,
+    parseBuffer: []u8,  templateFd: c.int, outFd: c.int) -> Err ---
+
+}
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 PIPELINED OUTPUT (LINUX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+when ODIN_OS == .Linux {
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Starts a thread that flushes the output of pipelined renders through their parse callback. -+-
+    A flusher serves one render at a time, start one per rendering thread.
+
+@param mustache_parser* parser
+@param mustache_flusher* flusher
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_flusher_start")
+flusherStart :: proc (parser: ^Parser, flusher: ^Flusher) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template into one half of the parse buffer while the flusher hands the other to the parse callback. -+-
+    The parse callback is called on the flusher's thread with each half as it fills, in order,
+    and may be called many times per render. It must be done with a slice when it returns,
+    the render writes into it again. The render returns once the callback has been called
+    with the last of the output. A value longer than a half is escaped into memory from
+    parser->alloc and handed over across as many halves as it takes.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - a compiled chain, see mustache_compile
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - split in two halves, one is rendered into while the other is flushed
+@param mustache_flusher* flusher - a started flusher, not used by any other render at the same time
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback parseCallback - called on the flusher's thread
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_render_pipelined")
+renderPipelined :: proc (parser: ^Parser, parentStackBuffer: []u8, structChain: ^Structure,  params: ^Param,
+    parseBuffer: []u8,  flusher: ^Flusher,  parseCallbackUdata: rawptr, parseCallback: ParseCallback) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Stops the flusher's thread and frees the flusher, no render may be using it. -+-
+
+@param mustache_parser* parser
+@param mustache_flusher* flusher
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_flusher_stop")
+flusherStop :: proc (parser: ^Parser, flusher: ^Flusher) ---
+
+}
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 COMPRESSED OUTPUT
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Allocates the compression state of mustache_render_deflate, about 420 KB. -+-
+
+@param mustache_parser* parser
+@param mustache_deflater* deflater
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_deflater_create")
+deflaterCreate :: proc (parser: ^Parser, deflater: ^Deflater) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compresses the long literal spans of a compiled chain once, so that renders do not compress them again. -+-
+    mustache_render_deflate splices a compressed span into its output whenever it writes all of it.
+    Each span is compressed on its own and nothing after it can refer back into it, the output
+    is somewhat larger than if it was all compressed together. The spans are freed with the chain.
+
+@param mustache_parser* parser
+@param mustache_structure* structChain - a compiled chain, see mustache_compile
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain is not compiled or already has its spans compressed.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_compile_deflate")
+compileDeflate :: proc (parser: ^Parser, structChain: ^Structure) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template and compresses the output as it is written. -+-
+    The parse callback is called with the compressed output in chunks of up to 32 KB as they
+    fill, the last call ends the stream. A value longer than the parse buffer is escaped into
+    memory from parser->alloc and compressed across as many chunks as it takes.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - a compiled chain, see mustache_compile and mustache_compile_deflate
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - holds the output between compressions
+@param mustache_deflater* deflater - not used by any other render at the same time
+@param uint32_t format - MUSTACHE_DEFLATE_FORMAT
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback parseCallback - called with the compressed output
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_render_deflate")
+renderDeflate :: proc (parser: ^Parser, parentStackBuffer: []u8, structChain: ^Structure,  params: ^Param,
+    parseBuffer: []u8,  deflater: ^Deflater, format: DeflateFormat, parseCallbackUdata: rawptr, parseCallback: ParseCallback) -> Err ---
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Frees a deflater, no render may be using it. -+-
+
+@param mustache_parser* parser
+@param mustache_deflater* deflater
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+
+@(link_name="mustache_deflater_free")
+deflaterFree :: proc (parser: ^Parser, deflater: ^Deflater) ---
 
 /*
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
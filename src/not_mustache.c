@@ -28,10 +28,16 @@ form of Artificial Intelligence.
 
 ***************************************************/
 
+/* under -std=c99 glibc hides fseeko, pread, nanosleep, syscall and flags such as MAP_POPULATE and
+   O_CLOEXEC, it has to be told before the first include */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "not_mustache.h"
 #include <string.h>
 #include <streql/streqlasm.h>
-#include <math.h>
+#include <stdlib.h>
 #include <stdio.h>
 
 #ifndef NDEBUG
@@ -45,7 +51,91 @@ form of Artificial Intelligence.
 #define alloca(N) __builtin_alloca(N)
 #endif 
 
+#if defined(_MSC_VER)
+#define fseek64(F, O, W) _fseeki64(F, O, W)
+#define ftell64(F) _ftelli64(F)
+#else
+#define fseek64(F, O, W) fseeko(F, O, W)
+#define ftell64(F) ftello(F)
+#endif
+
+/* files are mapped instead of read where the platform can, NOT_MUSTACHE_NO_MMAP forces stdio */
+#if !defined(NOT_MUSTACHE_NO_MMAP) && (defined(__linux__) || defined(__APPLE__) || defined(__unix__))
+#define MUSTACHE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* templates can be watched and recompiled as they change on Linux, NOT_MUSTACHE_NO_HOT_RELOAD leaves it out */
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_HOT_RELOAD)
+#define MUSTACHE_HOT_RELOAD 1
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#endif
+
+/* batches of files are read through io_uring on Linux, NOT_MUSTACHE_NO_IO_URING reads them one by one */
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_IO_URING)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define MUSTACHE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#endif
+
+/* renders can be written to an fd as they go on POSIX */
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+#define MUSTACHE_FD_OUTPUT 1
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#if defined(O_DIRECT)
+#define MUSTACHE_O_DIRECT O_DIRECT
+#elif defined(__O_DIRECT)
+#define MUSTACHE_O_DIRECT __O_DIRECT
+#endif
+#endif
+
+/* literal spans of a template can be sent straight from its file on Linux, NOT_MUSTACHE_NO_SENDFILE leaves it out */
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_SENDFILE)
+#define MUSTACHE_SENDFILE 1
+#include <sys/sendfile.h>
+#endif
+
+/* pipelined renders hand their output to a flush thread on Linux, NOT_MUSTACHE_NO_PIPELINE leaves it out */
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_PIPELINE)
+#define MUSTACHE_PIPELINE 1
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+#if !defined(NOT_MUSTACHE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MUSTACHE_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#define MUSTACHE_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+#endif
+
 #define min(X, Y) ((X) < (Y) ? (X) : (Y))
+#define max(X, Y) ((X) > (Y) ? (X) : (Y))
 #define array_count(A) (sizeof(A)/sizeof(A[0]))
 
 typedef enum {
@@ -60,6 +150,8 @@ typedef struct {
     mustache_slice buf;
     uint32_t count;
     uint32_t MAX_COUNT;
+    uint32_t gen; /*incremented every time a frame is pushed or a list frame advances*/
+    uint8_t err; /*the first lazy subtree the render reached that did not parse*/
 } parent_stack;
 
 typedef enum
@@ -82,7 +174,15 @@ typedef struct {
     uint32_t lineEnd;
 } standalone_data;
 
+/* describes the parent stack state that a structure's cached param was resolved in */
+typedef struct {
+    uint32_t gen;   /*the generation of the top frame when the param was resolved, 0 if the stack was empty*/
+    int32_t depth;  /*the frame the param was found in, -1 if it was found in the global params (or not at all)*/
+    bool valid;
+} param_cache;
+
 typedef struct structure structure;
+typedef struct deflated_spans deflated_spans;
 typedef struct structure {
     structure* pNext;
     structure* pLast;
@@ -96,6 +196,37 @@ typedef struct structure {
     standalone_data* standalone;
 } structure;
 
+/* the caller's mustache_structure heads the chain. A chain compiled by mustache_compile borrows its
+   source, the root keeps it in the slots that a root does not otherwise use */
+typedef struct {
+    structure* pNext;
+    structure* pLast;
+    STRUCTURE_TYPE type; /*STRUCTURE_TYPE_ROOT once compiled by mustache_compile*/
+
+    uint32_t sourceLen;
+    uint32_t compacted;  /*mustache_compile_stream cut comments out, the offsets are not those of the stream*/
+    uint32_t ownsSource; /*the source was read by mustache_compile_stream and is freed with the chain*/
+
+    const uint8_t* source;
+    deflated_spans* deflated; /*the pieces of mustache_compile_deflate, freed with the chain*/
+} root_structure;
+
+/* a compiled chain renders from the source it was compiled from, which for mustache_compile_stream is
+   its own compacted copy rather than what the caller passes along with it */
+static mustache_const_slice chain_source(const mustache_structure* structChain, mustache_const_slice source)
+{
+    const root_structure* root = (const root_structure*)structChain;
+    if (root && root->type == STRUCTURE_TYPE_ROOT) {
+        return (mustache_const_slice){ root->source, root->sourceLen };
+    }
+    return source;
+}
+
+/* the smallest source mustache_compile_stream allocates for a stream of unknown length */
+#define MUSTACHE_COMPILE_STREAM_MIN_CHUNK 4096
+/* the most mustache_compile_stream reads before it compiles what it has */
+#define MUSTACHE_COMPILE_STREAM_WINDOW (64 * 1024)
+
 typedef struct {
     structure* pNext;
     structure* pLast;
@@ -118,6 +249,7 @@ typedef struct {
     uint32_t precedingMustacheLen;
 
     mustache_param* param;
+    param_cache cache;
 
     uint32_t interiorFirst; /*the first byte of the interior var name*/
     uint32_t interiorEnd; /*the last byte + 1 of the interior (the closing ')') after the name*/
@@ -135,8 +267,9 @@ typedef struct {
 
     mustache_param* param;
     standalone_data* standalone;
+    param_cache cache;
 
-    bool escapeHTML;
+    uint8_t escapeMode; /*ESCAPE_MODE*/
 } var_structure;
 
 typedef struct {
@@ -155,6 +288,8 @@ typedef struct {
 
     uint32_t curIdx; /*current child index*/
     mustache_param* curChild;
+    uint32_t frameGen; /*the parent stack generation of this frame, only valid while it is on the stack*/
+    param_cache cache;
 
     structure* close_or_else;
 
@@ -212,23 +347,12 @@ void __chkstk(void);
 static void ___chkstk_ms(void) {
     __chkstk();
 }
-int _isnan(double);
-static int __isnan__(double x) {
-    return _isnan(x);
-}
-#else
-#define __isnan__(x) isnan(x)
 #endif
 
-static size_t no_op_read_cb(void* udata, uint8_t* dst, size_t dstlen) {
-    mustache_param_template* tp = (mustache_param_template*)udata;
-    return tp->source.len;
-}
-
-        
-static uint64_t no_op_seek_cb(void* udata, int64_t whence, MUSTACHE_SEEK_DIR seekdir) {
-    return 0;
-}
+typedef struct render_sink render_sink;
+static uint8_t parse_source(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain,
+    mustache_param* params, mustache_const_slice source, mustache_slice outputBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback,
+    render_sink* sink);
 
 void nested_parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
 {
@@ -365,10 +489,6 @@ int32_t strtoi32(const char* str, uint8_t bufflen, int32_t* strLenOut)
     return num;
 }
 
-static int nm_isinf(double x) {
-    return x == 1.0 / 0.0 || x == -1.0 / 0.0;
-}
-
 static void parent_stack_pop(parent_stack* stack)
 {
 #ifndef NDEBUG
@@ -399,6 +519,7 @@ static uint8_t parent_stack_push(parent_stack* stack, scoped_structure* parent)
     uint8_t** pointers = (uint8_t**)stack->buf.u;
     pointers[stack->count] = (uint8_t*)parent;
     stack->count++;
+    parent->frameGen = ++stack->gen;
 
     return MUSTACHE_SUCCESS;
 };
@@ -429,30 +550,6 @@ static uint32_t u32_round_to_next_power_of_2(uint32_t v) {
     return v;
 }
 
-/* returns the digits in an i64 from a branched lookup table */
-static uint8_t digits_i64(int64_t n) {
-    if (n<0) {n = n * -1;}
-    if (n < 10) return 1;
-    if (n < 100) return 2;
-    if (n < 1000) return 3;
-    if (n < 10000) return 4;
-    if (n < 100000) return 5;
-    if (n < 1000000) return 6;
-    if (n < 10000000) return 7;
-    if (n < 100000000) return 8;
-    if (n < 1000000000) return 9;
-    if (n < 10000000000) return 10;
-    if (n < 100000000000) return 11;
-    if (n < 1000000000000) return 12;
-    if (n < 10000000000000) return 13;
-    if (n < 100000000000000) return 14;
-    if (n < 1000000000000000) return 15;
-    if (n < 10000000000000000) return 16;
-    if (n < 100000000000000000) return 17;
-    if (n < 1000000000000000000) return 18;
-    return 0;
-}
-
 /* returns the digits in a u32 from a branched lookup table */
 static uint8_t digits_u32(uint32_t n) {
     if (n < 10) return 1;
@@ -796,190 +893,1147 @@ static double n_pow10(uint16_t n) {
     return 0;
 }
 
-static const uint8_t* get_key_value_end(const uint8_t* start, const uint8_t* sourceEnd)
+/* converts a u32 to a string and returns the end of the write position. */
+static uint8_t* u32toa(uint32_t value, uint8_t* buf, size_t bufsize)
 {
-    while (start < sourceEnd)
+    uint8_t digits = digits_u32(value);
+    uint8_t* bufEnd = buf + bufsize - 1;
+    uint8_t i = 0;
+    while (value && buf < bufEnd)
     {
-        if (isspace(*start) || *start == '}') {
-            return start;
+        uint8_t* pos = buf + digits - i - 1;
+        if (pos<bufEnd) {
+            *pos = value % 10 + '0';
         }
-        start++;
+        value /= 10;
+        i++;
     }
-    return sourceEnd;
+    return buf+i;
 }
 
-/* converts an i64 to a NON null-terminated ASCII string and returns the number of digits written. */
-static int16_t i64toa(int64_t n,uint8_t* buf, size_t size)
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- NUMBER FORMATTING -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+/* Doubles are converted to the shortest decimal that parses back to the same value with the
+   Ryu algorithm (Ulf Adams, 2018), fixed decimal output rounds that shortest decimal.
+   Nothing here calls libm. */
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* writes the digits of a u64 two at a time and returns the end of the write position.
+   buf must hold at least 20 bytes. */
+static uint8_t* u64toa(uint64_t value, uint8_t* buf)
 {
-    int8_t dig = digits_i64(n);
-    int16_t i = 0;
-    while (n!=0)
-    {
-        i++;
-        buf[dig - i] = n % 10 + 48;
-        n /= 10;
+    uint8_t tmp[20];
+    uint8_t* p = tmp + sizeof(tmp);
+    while (value >= 100) {
+        uint32_t pair = (uint32_t)(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = digit_pairs[pair];
+        p[1] = digit_pairs[pair + 1];
+    }
+    if (value >= 10) {
+        p -= 2;
+        p[0] = digit_pairs[value * 2];
+        p[1] = digit_pairs[value * 2 + 1];
     }
-    return i;
+    else {
+        *--p = (uint8_t)('0' + value);
+    }
+    size_t len = tmp + sizeof(tmp) - p;
+    memcpy(buf, p, len);
+    return buf + len;
 }
 
-/* returns the expected write length of a dtoa call */
-static uint16_t dtoalen(double value, uint16_t precision, bool trimZeros) {
-    if (__isnan__(value)) {
-        return 3;
-    }
-    if (nm_isinf(value)) {
-        if (value < 0) {
-            return 4;
-        }
-        else {
-            return 3;
-        }
-    }
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_EXPONENT_BITS 11
+#define DOUBLE_BIAS 1023
+#define DOUBLE_POW5_INV_BITCOUNT 125
+#define DOUBLE_POW5_BITCOUNT 125
+
+/* floor(5^i / 2^(bitlen(5^i) - 125)) */
+static const uint64_t double_pow5_split[326][2] = {
+    { 0x0000000000000000ULL, 0x1000000000000000ULL },
+    { 0x0000000000000000ULL, 0x1400000000000000ULL },
+    { 0x0000000000000000ULL, 0x1900000000000000ULL },
+    { 0x0000000000000000ULL, 0x1F40000000000000ULL },
+    { 0x0000000000000000ULL, 0x1388000000000000ULL },
+    { 0x0000000000000000ULL, 0x186A000000000000ULL },
+    { 0x0000000000000000ULL, 0x1E84800000000000ULL },
+    { 0x0000000000000000ULL, 0x1312D00000000000ULL },
+    { 0x0000000000000000ULL, 0x17D7840000000000ULL },
+    { 0x0000000000000000ULL, 0x1DCD650000000000ULL },
+    { 0x0000000000000000ULL, 0x12A05F2000000000ULL },
+    { 0x0000000000000000ULL, 0x174876E800000000ULL },
+    { 0x0000000000000000ULL, 0x1D1A94A200000000ULL },
+    { 0x0000000000000000ULL, 0x12309CE540000000ULL },
+    { 0x0000000000000000ULL, 0x16BCC41E90000000ULL },
+    { 0x0000000000000000ULL, 0x1C6BF52634000000ULL },
+    { 0x0000000000000000ULL, 0x11C37937E0800000ULL },
+    { 0x0000000000000000ULL, 0x16345785D8A00000ULL },
+    { 0x0000000000000000ULL, 0x1BC16D674EC80000ULL },
+    { 0x0000000000000000ULL, 0x1158E460913D0000ULL },
+    { 0x0000000000000000ULL, 0x15AF1D78B58C4000ULL },
+    { 0x0000000000000000ULL, 0x1B1AE4D6E2EF5000ULL },
+    { 0x0000000000000000ULL, 0x10F0CF064DD59200ULL },
+    { 0x0000000000000000ULL, 0x152D02C7E14AF680ULL },
+    { 0x0000000000000000ULL, 0x1A784379D99DB420ULL },
+    { 0x0000000000000000ULL, 0x108B2A2C28029094ULL },
+    { 0x0000000000000000ULL, 0x14ADF4B7320334B9ULL },
+    { 0x4000000000000000ULL, 0x19D971E4FE8401E7ULL },
+    { 0x8800000000000000ULL, 0x1027E72F1F128130ULL },
+    { 0xAA00000000000000ULL, 0x1431E0FAE6D7217CULL },
+    { 0xD480000000000000ULL, 0x193E5939A08CE9DBULL },
+    { 0xC9A0000000000000ULL, 0x1F8DEF8808B02452ULL },
+    { 0xBE04000000000000ULL, 0x13B8B5B5056E16B3ULL },
+    { 0xAD85000000000000ULL, 0x18A6E32246C99C60ULL },
+    { 0xD8E6400000000000ULL, 0x1ED09BEAD87C0378ULL },
+    { 0x878FE80000000000ULL, 0x13426172C74D822BULL },
+    { 0x6973E20000000000ULL, 0x1812F9CF7920E2B6ULL },
+    { 0x03D0DA8000000000ULL, 0x1E17B84357691B64ULL },
+    { 0x8262889000000000ULL, 0x12CED32A16A1B11EULL },
+    { 0x22FB2AB400000000ULL, 0x178287F49C4A1D66ULL },
+    { 0xABB9F56100000000ULL, 0x1D6329F1C35CA4BFULL },
+    { 0xCB54395CA0000000ULL, 0x125DFA371A19E6F7ULL },
+    { 0xBE2947B3C8000000ULL, 0x16F578C4E0A060B5ULL },
+    { 0x2DB399A0BA000000ULL, 0x1CB2D6F618C878E3ULL },
+    { 0xFC90400474400000ULL, 0x11EFC659CF7D4B8DULL },
+    { 0x7BB4500591500000ULL, 0x166BB7F0435C9E71ULL },
+    { 0xDAA16406F5A40000ULL, 0x1C06A5EC5433C60DULL },
+    { 0xA8A4DE8459868000ULL, 0x118427B3B4A05BC8ULL },
+    { 0xD2CE16256FE82000ULL, 0x15E531A0A1C872BAULL },
+    { 0x87819BAECBE22800ULL, 0x1B5E7E08CA3A8F69ULL },
+    { 0xF4B1014D3F6D5900ULL, 0x111B0EC57E6499A1ULL },
+    { 0x71DD41A08F48AF40ULL, 0x1561D276DDFDC00AULL },
+    { 0x0E549208B31ADB10ULL, 0x1ABA4714957D300DULL },
+    { 0x28F4DB456FF0C8EAULL, 0x10B46C6CDD6E3E08ULL },
+    { 0x33321216CBECFB24ULL, 0x14E1878814C9CD8AULL },
+    { 0xBFFE969C7EE839EDULL, 0x1A19E96A19FC40ECULL },
+    { 0xF7FF1E21CF512434ULL, 0x105031E2503DA893ULL },
+    { 0xF5FEE5AA43256D41ULL, 0x14643E5AE44D12B8ULL },
+    { 0x337E9F14D3EEC892ULL, 0x197D4DF19D605767ULL },
+    { 0x005E46DA08EA7AB6ULL, 0x1FDCA16E04B86D41ULL },
+    { 0xA03AEC4845928CB2ULL, 0x13E9E4E4C2F34448ULL },
+    { 0xC849A75A56F72FDEULL, 0x18E45E1DF3B0155AULL },
+    { 0x7A5C1130ECB4FBD6ULL, 0x1F1D75A5709C1AB1ULL },
+    { 0xEC798ABE93F11D65ULL, 0x13726987666190AEULL },
+    { 0xA797ED6E38ED64BFULL, 0x184F03E93FF9F4DAULL },
+    { 0x517DE8C9C728BDEFULL, 0x1E62C4E38FF87211ULL },
+    { 0xD2EEB17E1C7976B5ULL, 0x12FDBB0E39FB474AULL },
+    { 0x87AA5DDDA397D462ULL, 0x17BD29D1C87A191DULL },
+    { 0xE994F5550C7DC97BULL, 0x1DAC74463A989F64ULL },
+    { 0x11FD195527CE9DEDULL, 0x128BC8ABE49F639FULL },
+    { 0xD67C5FAA71C24568ULL, 0x172EBAD6DDC73C86ULL },
+    { 0x8C1B77950E32D6C2ULL, 0x1CFA698C95390BA8ULL },
+    { 0x57912ABD28DFC639ULL, 0x121C81F7DD43A749ULL },
+    { 0xAD75756C7317B7C8ULL, 0x16A3A275D494911BULL },
+    { 0x98D2D2C78FDDA5BAULL, 0x1C4C8B1349B9B562ULL },
+    { 0x9F83C3BCB9EA8794ULL, 0x11AFD6EC0E14115DULL },
+    { 0x0764B4ABE8652979ULL, 0x161BCCA7119915B5ULL },
+    { 0x493DE1D6E27E73D7ULL, 0x1BA2BFD0D5FF5B22ULL },
+    { 0x6DC6AD264D8F0866ULL, 0x1145B7E285BF98F5ULL },
+    { 0xC938586FE0F2CA80ULL, 0x159725DB272F7F32ULL },
+    { 0x7B866E8BD92F7D20ULL, 0x1AFCEF51F0FB5EFFULL },
+    { 0xAD34051767BDAE34ULL, 0x10DE1593369D1B5FULL },
+    { 0x9881065D41AD19C1ULL, 0x15159AF804446237ULL },
+    { 0x7EA147F492186032ULL, 0x1A5B01B605557AC5ULL },
+    { 0x6F24CCF8DB4F3C1FULL, 0x1078E111C3556CBBULL },
+    { 0x4AEE003712230B27ULL, 0x14971956342AC7EAULL },
+    { 0xDDA98044D6ABCDF0ULL, 0x19BCDFABC13579E4ULL },
+    { 0x0A89F02B062B60B6ULL, 0x10160BCB58C16C2FULL },
+    { 0xCD2C6C35C7B638E4ULL, 0x141B8EBE2EF1C73AULL },
+    { 0x8077874339A3C71DULL, 0x1922726DBAAE3909ULL },
+    { 0xE0956914080CB8E4ULL, 0x1F6B0F092959C74BULL },
+    { 0x6C5D61AC8507F38EULL, 0x13A2E965B9D81C8FULL },
+    { 0x4774BA17A649F072ULL, 0x188BA3BF284E23B3ULL },
+    { 0x1951E89D8FDC6C8FULL, 0x1EAE8CAEF261ACA0ULL },
+    { 0x0FD3316279E9C3D9ULL, 0x132D17ED577D0BE4ULL },
+    { 0x13C7FDBB186434CFULL, 0x17F85DE8AD5C4EDDULL },
+    { 0x58B9FD29DE7D4203ULL, 0x1DF67562D8B36294ULL },
+    { 0xB7743E3A2B0E4942ULL, 0x12BA095DC7701D9CULL },
+    { 0xE5514DC8B5D1DB92ULL, 0x17688BB5394C2503ULL },
+    { 0xDEA5A13AE3465277ULL, 0x1D42AEA2879F2E44ULL },
+    { 0x0B2784C4CE0BF38AULL, 0x1249AD2594C37CEBULL },
+    { 0xCDF165F6018EF06DULL, 0x16DC186EF9F45C25ULL },
+    { 0x416DBF7381F2AC88ULL, 0x1C931E8AB871732FULL },
+    { 0x88E497A83137ABD5ULL, 0x11DBF316B346E7FDULL },
+    { 0xEB1DBD923D8596CAULL, 0x1652EFDC6018A1FCULL },
+    { 0x25E52CF6CCE6FC7DULL, 0x1BE7ABD3781ECA7CULL },
+    { 0x97AF3C1A40105DCEULL, 0x1170CB642B133E8DULL },
+    { 0xFD9B0B20D0147542ULL, 0x15CCFE3D35D80E30ULL },
+    { 0x3D01CDE904199292ULL, 0x1B403DCC834E11BDULL },
+    { 0x462120B1A28FFB9BULL, 0x1108269FD210CB16ULL },
+    { 0xD7A968DE0B33FA82ULL, 0x154A3047C694FDDBULL },
+    { 0xCD93C3158E00F923ULL, 0x1A9CBC59B83A3D52ULL },
+    { 0xC07C59ED78C09BB6ULL, 0x10A1F5B813246653ULL },
+    { 0xB09B7068D6F0C2A3ULL, 0x14CA732617ED7FE8ULL },
+    { 0xDCC24C830CACF34CULL, 0x19FD0FEF9DE8DFE2ULL },
+    { 0xC9F96FD1E7EC180FULL, 0x103E29F5C2B18BEDULL },
+    { 0x3C77CBC661E71E13ULL, 0x144DB473335DEEE9ULL },
+    { 0x8B95BEB7FA60E598ULL, 0x1961219000356AA3ULL },
+    { 0x6E7B2E65F8F91EFEULL, 0x1FB969F40042C54CULL },
+    { 0xC50CFCFFBB9BB35FULL, 0x13D3E2388029BB4FULL },
+    { 0xB6503C3FAA82A037ULL, 0x18C8DAC6A0342A23ULL },
+    { 0xA3E44B4F95234844ULL, 0x1EFB1178484134ACULL },
+    { 0xE66EAF11BD360D2BULL, 0x135CEAEB2D28C0EBULL },
+    { 0xE00A5AD62C839075ULL, 0x183425A5F872F126ULL },
+    { 0x980CF18BB7A47493ULL, 0x1E412F0F768FAD70ULL },
+    { 0x5F0816F752C6C8DCULL, 0x12E8BD69AA19CC66ULL },
+    { 0xF6CA1CB527787B13ULL, 0x17A2ECC414A03F7FULL },
+    { 0xF47CA3E2715699D7ULL, 0x1D8BA7F519C84F5FULL },
+    { 0xF8CDE66D86D62026ULL, 0x127748F9301D319BULL },
+    { 0xF7016008E88BA830ULL, 0x17151B377C247E02ULL },
+    { 0xB4C1B80B22AE923CULL, 0x1CDA62055B2D9D83ULL },
+    { 0x50F91306F5AD1B65ULL, 0x12087D4358FC8272ULL },
+    { 0xE53757C8B318623FULL, 0x168A9C942F3BA30EULL },
+    { 0x9E852DBADFDE7ACFULL, 0x1C2D43B93B0A8BD2ULL },
+    { 0xA3133C94CBEB0CC1ULL, 0x119C4A53C4E69763ULL },
+    { 0x8BD80BB9FEE5CFF1ULL, 0x16035CE8B6203D3CULL },
+    { 0xAECE0EA87E9F43EEULL, 0x1B843422E3A84C8BULL },
+    { 0x4D40C9294F238A75ULL, 0x1132A095CE492FD7ULL },
+    { 0x2090FB73A2EC6D12ULL, 0x157F48BB41DB7BCDULL },
+    { 0x68B53A508BA78856ULL, 0x1ADF1AEA12525AC0ULL },
+    { 0x417144725748B536ULL, 0x10CB70D24B7378B8ULL },
+    { 0x51CD958EED1AE283ULL, 0x14FE4D06DE5056E6ULL },
+    { 0xE640FAF2A8619B24ULL, 0x1A3DE04895E46C9FULL },
+    { 0xEFE89CD7A93D00F7ULL, 0x1066AC2D5DAEC3E3ULL },
+    { 0xEBE2C40D938C4134ULL, 0x14805738B51A74DCULL },
+    { 0x26DB7510F86F5181ULL, 0x19A06D06E2611214ULL },
+    { 0x9849292A9B4592F1ULL, 0x100444244D7CAB4CULL },
+    { 0xBE5B73754216F7ADULL, 0x1405552D60DBD61FULL },
+    { 0xADF25052929CB598ULL, 0x1906AA78B912CBA7ULL },
+    { 0x996EE4673743E2FFULL, 0x1F485516E7577E91ULL },
+    { 0xFFE54EC0828A6DDFULL, 0x138D352E5096AF1AULL },
+    { 0xBFDEA270A32D0957ULL, 0x18708279E4BC5AE1ULL },
+    { 0x2FD64B0CCBF84BADULL, 0x1E8CA3185DEB719AULL },
+    { 0x5DE5EEE7FF7B2F4CULL, 0x1317E5EF3AB32700ULL },
+    { 0x755F6AA1FF59FB1FULL, 0x17DDDF6B095FF0C0ULL },
+    { 0x92B7454A7F3079E7ULL, 0x1DD55745CBB7ECF0ULL },
+    { 0x5BB28B4E8F7E4C30ULL, 0x12A5568B9F52F416ULL },
+    { 0xF29F2E22335DDF3CULL, 0x174EAC2E8727B11BULL },
+    { 0xEF46F9AAC035570BULL, 0x1D22573A28F19D62ULL },
+    { 0xD58C5C0AB8215667ULL, 0x123576845997025DULL },
+    { 0x4AEF730D6629AC01ULL, 0x16C2D4256FFCC2F5ULL },
+    { 0x9DAB4FD0BFB41701ULL, 0x1C73892ECBFBF3B2ULL },
+    { 0xA28B11E277D08E60ULL, 0x11C835BD3F7D784FULL },
+    { 0x8B2DD65B15C4B1F9ULL, 0x163A432C8F5CD663ULL },
+    { 0x6DF94BF1DB35DE77ULL, 0x1BC8D3F7B3340BFCULL },
+    { 0xC4BBCF772901AB0AULL, 0x115D847AD000877DULL },
+    { 0x35EAC354F34215CDULL, 0x15B4E5998400A95DULL },
+    { 0x8365742A30129B40ULL, 0x1B221EFFE500D3B4ULL },
+    { 0xD21F689A5E0BA108ULL, 0x10F5535FEF208450ULL },
+    { 0x06A742C0F58E894AULL, 0x1532A837EAE8A565ULL },
+    { 0x4851137132F22B9DULL, 0x1A7F5245E5A2CEBEULL },
+    { 0xED32AC26BFD75B42ULL, 0x108F936BAF85C136ULL },
+    { 0xA87F57306FCD3212ULL, 0x14B378469B673184ULL },
+    { 0xD29F2CFC8BC07E97ULL, 0x19E056584240FDE5ULL },
+    { 0xA3A37C1DD7584F1EULL, 0x102C35F729689EAFULL },
+    { 0x8C8C5B254D2E62E6ULL, 0x14374374F3C2C65BULL },
+    { 0x6FAF71EEA079FB9FULL, 0x1945145230B377F2ULL },
+    { 0x0B9B4E6A48987A87ULL, 0x1F965966BCE055EFULL },
+    { 0x674111026D5F4C94ULL, 0x13BDF7E0360C35B5ULL },
+    { 0xC111554308B71FBAULL, 0x18AD75D8438F4322ULL },
+    { 0x7155AA93CAE4E7A8ULL, 0x1ED8D34E547313EBULL },
+    { 0x26D58A9C5ECF10C9ULL, 0x13478410F4C7EC73ULL },
+    { 0xF08AED437682D4FBULL, 0x1819651531F9E78FULL },
+    { 0xECADA89454238A3AULL, 0x1E1FBE5A7E786173ULL },
+    { 0x73EC895CB4963664ULL, 0x12D3D6F88F0B3CE8ULL },
+    { 0x90E7ABB3E1BBC3FDULL, 0x1788CCB6B2CE0C22ULL },
+    { 0x352196A0DA2AB4FDULL, 0x1D6AFFE45F818F2BULL },
+    { 0x0134FE24885AB11EULL, 0x1262DFEEBBB0F97BULL },
+    { 0xC1823DADAA715D65ULL, 0x16FB97EA6A9D37D9ULL },
+    { 0x31E2CD19150DB4BFULL, 0x1CBA7DE5054485D0ULL },
+    { 0x1F2DC02FAD2890F7ULL, 0x11F48EAF234AD3A2ULL },
+    { 0xA6F9303B9872B535ULL, 0x1671B25AEC1D888AULL },
+    { 0x50B77C4A7E8F6282ULL, 0x1C0E1EF1A724EAADULL },
+    { 0x5272ADAE8F199D91ULL, 0x1188D357087712ACULL },
+    { 0x670F591A32E004F6ULL, 0x15EB082CCA94D757ULL },
+    { 0x40D32F60BF980633ULL, 0x1B65CA37FD3A0D2DULL },
+    { 0x4883FD9C77BF03E0ULL, 0x111F9E62FE44483CULL },
+    { 0x5AA4FD0395AEC4D8ULL, 0x156785FBBDD55A4BULL },
+    { 0x314E3C447B1A760EULL, 0x1AC1677AAD4AB0DEULL },
+    { 0xDED0E5AACCF089C9ULL, 0x10B8E0ACAC4EAE8AULL },
+    { 0x96851F15802CAC3BULL, 0x14E718D7D7625A2DULL },
+    { 0xFC2666DAE037D74AULL, 0x1A20DF0DCD3AF0B8ULL },
+    { 0x9D980048CC22E68EULL, 0x10548B68A044D673ULL },
+    { 0x84FE005AFF2BA032ULL, 0x1469AE42C8560C10ULL },
+    { 0xA63D8071BEF6883EULL, 0x198419D37A6B8F14ULL },
+    { 0xCFCCE08E2EB42A4EULL, 0x1FE52048590672D9ULL },
+    { 0x21E00C58DD309A70ULL, 0x13EF342D37A407C8ULL },
+    { 0x2A580F6F147CC10DULL, 0x18EB0138858D09BAULL },
+    { 0xB4EE134AD99BF150ULL, 0x1F25C186A6F04C28ULL },
+    { 0x7114CC0EC80176D2ULL, 0x137798F428562F99ULL },
+    { 0xCD59FF127A01D486ULL, 0x18557F31326BBB7FULL },
+    { 0xC0B07ED7188249A8ULL, 0x1E6ADEFD7F06AA5FULL },
+    { 0xD86E4F466F516E09ULL, 0x1302CB5E6F642A7BULL },
+    { 0xCE89E3180B25C98BULL, 0x17C37E360B3D351AULL },
+    { 0x822C5BDE0DEF3BEEULL, 0x1DB45DC38E0C8261ULL },
+    { 0xF15BB96AC8B58575ULL, 0x1290BA9A38C7D17CULL },
+    { 0x2DB2A7C57AE2E6D2ULL, 0x1734E940C6F9C5DCULL },
+    { 0x391F51B6D99BA086ULL, 0x1D022390F8B83753ULL },
+    { 0x03B3931248014454ULL, 0x1221563A9B732294ULL },
+    { 0x04A077D6DA019569ULL, 0x16A9ABC9424FEB39ULL },
+    { 0x45C895CC9081FAC3ULL, 0x1C5416BB92E3E607ULL },
+    { 0x8B9D5D9FDA513CBAULL, 0x11B48E353BCE6FC4ULL },
+    { 0xAE84B507D0E58BE8ULL, 0x1621B1C28AC20BB5ULL },
+    { 0x1A25E249C51EEEE3ULL, 0x1BAA1E332D728EA3ULL },
+    { 0xF057AD6E1B33554DULL, 0x114A52DFFC679925ULL },
+    { 0x6C6D98C9A2002AA1ULL, 0x159CE797FB817F6FULL },
+    { 0x4788FEFC0A803549ULL, 0x1B04217DFA61DF4BULL },
+    { 0x0CB59F5D8690214EULL, 0x10E294EEBC7D2B8FULL },
+    { 0xCFE30734E83429A1ULL, 0x151B3A2A6B9C7672ULL },
+    { 0x83DBC9022241340AULL, 0x1A6208B50683940FULL },
+    { 0xB2695DA15568C086ULL, 0x107D457124123C89ULL },
+    { 0x1F03B509AAC2F0A7ULL, 0x149C96CD6D16CBACULL },
+    { 0x26C4A24C1573ACD1ULL, 0x19C3BC80C85C7E97ULL },
+    { 0x783AE56F8D684C03ULL, 0x101A55D07D39CF1EULL },
+    { 0x16499ECB70C25F03ULL, 0x1420EB449C8842E6ULL },
+    { 0x9BDC067E4CF2F6C4ULL, 0x19292615C3AA539FULL },
+    { 0x82D3081DE02FB476ULL, 0x1F736F9B3494E887ULL },
+    { 0xB1C3E512AC1DD0C9ULL, 0x13A825C100DD1154ULL },
+    { 0xDE34DE57572544FCULL, 0x18922F31411455A9ULL },
+    { 0x55C215ED2CEE963BULL, 0x1EB6BAFD91596B14ULL },
+    { 0xB5994DB43C151DE5ULL, 0x133234DE7AD7E2ECULL },
+    { 0xE2FFA1214B1A655EULL, 0x17FEC216198DDBA7ULL },
+    { 0xDBBF89699DE0FEB6ULL, 0x1DFE729B9FF15291ULL },
+    { 0x2957B5E202AC9F31ULL, 0x12BF07A143F6D39BULL },
+    { 0xF3ADA35A8357C6FEULL, 0x176EC98994F48881ULL },
+    { 0x70990C31242DB8BDULL, 0x1D4A7BEBFA31AAA2ULL },
+    { 0x865FA79EB69C9376ULL, 0x124E8D737C5F0AA5ULL },
+    { 0xE7F791866443B854ULL, 0x16E230D05B76CD4EULL },
+    { 0xA1F575E7FD54A669ULL, 0x1C9ABD04725480A2ULL },
+    { 0xA53969B0FE54E801ULL, 0x11E0B622C774D065ULL },
+    { 0x0E87C41D3DEA2202ULL, 0x1658E3AB7952047FULL },
+    { 0xD229B5248D64AA82ULL, 0x1BEF1C9657A6859EULL },
+    { 0x435A1136D85EEA91ULL, 0x117571DDF6C81383ULL },
+    { 0x143095848E76A536ULL, 0x15D2CE55747A1864ULL },
+    { 0x193CBAE5B2144E83ULL, 0x1B4781EAD1989E7DULL },
+    { 0x2FC5F4CF8F4CB112ULL, 0x110CB132C2FF630EULL },
+    { 0xBBB77203731FDD56ULL, 0x154FDD7F73BF3BD1ULL },
+    { 0x2AA54E844FE7D4ACULL, 0x1AA3D4DF50AF0AC6ULL },
+    { 0xDAA75112B1F0E4EBULL, 0x10A6650B926D66BBULL },
+    { 0xD15125575E6D1E26ULL, 0x14CFFE4E7708C06AULL },
+    { 0x85A56EAD360865B0ULL, 0x1A03FDE214CAF085ULL },
+    { 0x7387652C41C53F8EULL, 0x10427EAD4CFED653ULL },
+    { 0x50693E7752368F71ULL, 0x14531E58A03E8BE8ULL },
+    { 0x64838E1526C4334EULL, 0x1967E5EEC84E2EE2ULL },
+    { 0xFDA4719A70754022ULL, 0x1FC1DF6A7A61BA9AULL },
+    { 0xDE86C70086494815ULL, 0x13D92BA28C7D14A0ULL },
+    { 0x162878C0A7DB9A1AULL, 0x18CF768B2F9C59C9ULL },
+    { 0x5BB296F0D1D280A1ULL, 0x1F03542DFB83703BULL },
+    { 0x194F9E5683239064ULL, 0x1362149CBD322625ULL },
+    { 0x5FA385EC23EC747EULL, 0x183A99C3EC7EAFAEULL },
+    { 0xF78C67672CE7919DULL, 0x1E494034E79E5B99ULL },
+    { 0x3AB7C0A07C10BB02ULL, 0x12EDC82110C2F940ULL },
+    { 0x4965B0C89B14E9C3ULL, 0x17A93A2954F3B790ULL },
+    { 0x5BBF1CFAC1DA2433ULL, 0x1D9388B3AA30A574ULL },
+    { 0xB957721CB92856A0ULL, 0x127C35704A5E6768ULL },
+    { 0xE7AD4EA3E7726C48ULL, 0x171B42CC5CF60142ULL },
+    { 0xA198A24CE14F075AULL, 0x1CE2137F74338193ULL },
+    { 0x44FF65700CD16498ULL, 0x120D4C2FA8A030FCULL },
+    { 0x563F3ECC1005BDBEULL, 0x16909F3B92C83D3BULL },
+    { 0x2BCF0E7F14072D2EULL, 0x1C34C70A777A4C8AULL },
+    { 0x5B61690F6C847C3DULL, 0x11A0FC668AAC6FD6ULL },
+    { 0xF239C35347A59B4CULL, 0x16093B802D578BCBULL },
+    { 0xEEC83428198F021FULL, 0x1B8B8A6038AD6EBEULL },
+    { 0x553D20990FF96153ULL, 0x1137367C236C6537ULL },
+    { 0x2A8C68BF53F7B9A8ULL, 0x1585041B2C477E85ULL },
+    { 0x752F82EF28F5A812ULL, 0x1AE64521F7595E26ULL },
+    { 0x093DB1D57999890BULL, 0x10CFEB353A97DAD8ULL },
+    { 0x0B8D1E4AD7FFEB4EULL, 0x1503E602893DD18EULL },
+    { 0x8E7065DD8DFFE622ULL, 0x1A44DF832B8D45F1ULL },
+    { 0xF9063FAA78BFEFD5ULL, 0x106B0BB1FB384BB6ULL },
+    { 0xB747CF9516EFEBCAULL, 0x1485CE9E7A065EA4ULL },
+    { 0xE519C37A5CABE6BDULL, 0x19A742461887F64DULL },
+    { 0xAF301A2C79EB7036ULL, 0x1008896BCF54F9F0ULL },
+    { 0xDAFC20B798664C43ULL, 0x140AABC6C32A386CULL },
+    { 0x11BB28E57E7FDF54ULL, 0x190D56B873F4C688ULL },
+    { 0x1629F31EDE1FD72AULL, 0x1F50AC6690F1F82AULL },
+    { 0x4DDA37F34AD3E67AULL, 0x13926BC01A973B1AULL },
+    { 0xE150C5F01D88E019ULL, 0x187706B0213D09E0ULL },
+    { 0x19A4F76C24EB181FULL, 0x1E94C85C298C4C59ULL },
+    { 0xB0071AA39712EF13ULL, 0x131CFD3999F7AFB7ULL },
+    { 0x9C08E14C7CD7AAD8ULL, 0x17E43C8800759BA5ULL },
+    { 0x030B199F9C0D958EULL, 0x1DDD4BAA0093028FULL },
+    { 0x61E6F003C1887D79ULL, 0x12AA4F4A405BE199ULL },
+    { 0xBA60AC04B1EA9CD7ULL, 0x1754E31CD072D9FFULL },
+    { 0xA8F8D705DE65440DULL, 0x1D2A1BE4048F907FULL },
+    { 0xC99B8663AAFF4A88ULL, 0x123A516E82D9BA4FULL },
+    { 0xBC0267FC95BF1D2AULL, 0x16C8E5CA239028E3ULL },
+    { 0xAB0301FBBB2EE474ULL, 0x1C7B1F3CAC74331CULL },
+    { 0xEAE1E13D54FD4EC9ULL, 0x11CCF385EBC89FF1ULL },
+    { 0x659A598CAA3CA27BULL, 0x1640306766BAC7EEULL },
+    { 0xFF00EFEFD4CBCB1AULL, 0x1BD03C81406979E9ULL },
+    { 0x3F6095F5E4FF5EF0ULL, 0x116225D0C841EC32ULL },
+    { 0xCF38BB735E3F36ACULL, 0x15BAAF44FA52673EULL },
+    { 0x8306EA5035CF0457ULL, 0x1B295B1638E7010EULL },
+    { 0x11E4527221A162B6ULL, 0x10F9D8EDE39060A9ULL },
+    { 0x565D670EAA09BB64ULL, 0x15384F295C7478D3ULL },
+    { 0x2BF4C0D2548C2A3DULL, 0x1A8662F3B3919708ULL },
+    { 0x1B78F88374D79A66ULL, 0x1093FDD8503AFE65ULL },
+    { 0x625736A4520D8100ULL, 0x14B8FD4E6449BDFEULL },
+    { 0xFAED044D6690E140ULL, 0x19E73CA1FD5C2D7DULL },
+    { 0xBCD422B0601A8CC8ULL, 0x103085E53E599C6EULL },
+    { 0x6C092B5C78212FFAULL, 0x143CA75E8DF0038AULL },
+    { 0x070B763396297BF8ULL, 0x194BD136316C046DULL },
+    { 0x48CE53C07BB3DAF6ULL, 0x1F9EC583BDC70588ULL },
+    { 0x2D80F4584D5068DAULL, 0x13C33B72569C6375ULL },
+    { 0x78E1316E60A48310ULL, 0x18B40A4EEC437C52ULL }
+};
 
-    if (value < 0) {
-        value = -value;
-    }
+/* floor(2^(bitlen(5^i) - 1 + 125) / 5^i) + 1 */
+static const uint64_t double_pow5_inv_split[342][2] = {
+    { 0x0000000000000001ULL, 0x2000000000000000ULL },
+    { 0x999999999999999AULL, 0x1999999999999999ULL },
+    { 0x47AE147AE147AE15ULL, 0x147AE147AE147AE1ULL },
+    { 0x6C8B4395810624DEULL, 0x10624DD2F1A9FBE7ULL },
+    { 0x7A786C226809D496ULL, 0x1A36E2EB1C432CA5ULL },
+    { 0x61F9F01B866E43ABULL, 0x14F8B588E368F084ULL },
+    { 0xB4C7F34938583622ULL, 0x10C6F7A0B5ED8D36ULL },
+    { 0x87A6520EC08D236AULL, 0x1AD7F29ABCAF4857ULL },
+    { 0x9FB841A566D74F88ULL, 0x15798EE2308C39DFULL },
+    { 0xE62D01511F12A607ULL, 0x112E0BE826D694B2ULL },
+    { 0xD6AE6881CB5109A4ULL, 0x1B7CDFD9D7BDBAB7ULL },
+    { 0xDEF1ED34A2A73AEAULL, 0x15FD7FE17964955FULL },
+    { 0x7F27F0F6E885C8BBULL, 0x119799812DEA1119ULL },
+    { 0x650CB4BE40D60DF8ULL, 0x1C25C268497681C2ULL },
+    { 0xEA70909833DE7193ULL, 0x16849B86A12B9B01ULL },
+    { 0x21F3A6E0297EC143ULL, 0x1203AF9EE756159BULL },
+    { 0x6985D7CD0F313537ULL, 0x1CD2B297D889BC2BULL },
+    { 0x2137DFD73F5A90F9ULL, 0x170EF54646D49689ULL },
+    { 0xE75FE645CC4873FAULL, 0x12725DD1D243ABA0ULL },
+    { 0xA5663D3C7A0D865DULL, 0x1D83C94FB6D2AC34ULL },
+    { 0x511E976394D79EB1ULL, 0x179CA10C9242235DULL },
+    { 0xDA7EDF82DD794BC1ULL, 0x12E3B40A0E9B4F7DULL },
+    { 0x2A6498D1625BAC68ULL, 0x1E392010175EE596ULL },
+    { 0xEEB6E0A781E2F053ULL, 0x182DB34012B25144ULL },
+    { 0x58924D52CE4F26A9ULL, 0x1357C299A88EA76AULL },
+    { 0x27507BB7B07EA441ULL, 0x1EF2D0F5DA7DD8AAULL },
+    { 0x52A6C95FC0655034ULL, 0x18C240C4AECB13BBULL },
+    { 0x0EEBD44C99EAA690ULL, 0x13CE9A36F23C0FC9ULL },
+    { 0xB17953ADC3110A80ULL, 0x1FB0F6BE50601941ULL },
+    { 0xC12DDC8B02740867ULL, 0x195A5EFEA6B34767ULL },
+    { 0x3424B06F3529A052ULL, 0x14484BFEEBC29F86ULL },
+    { 0x901D59F290EE19DBULL, 0x1039D66589687F9EULL },
+    { 0x4CFBC31DB4B0295FULL, 0x19F623D5A8A73297ULL },
+    { 0x3D9635B15D59BAB2ULL, 0x14C4E977BA1F5BACULL },
+    { 0x97AB5E277DE16228ULL, 0x109D8792FB4C4956ULL },
+    { 0xF2ABC9D8C9689D0DULL, 0x1A95A5B7F87A0EF0ULL },
+    { 0x5BBCA17A3ABA173EULL, 0x154484932D2E725AULL },
+    { 0xAFCA1AC82EFB45CBULL, 0x11039D428A8B8EAEULL },
+    { 0xB2DCF7A6B1920945ULL, 0x1B38FB9DAA78E44AULL },
+    { 0xF57D92EBC141A104ULL, 0x15C72FB1552D836EULL },
+    { 0xC46475896767B403ULL, 0x116C262777579C58ULL },
+    { 0x6D6D88DBD8A5ECD2ULL, 0x1BE03D0BF225C6F4ULL },
+    { 0x8ABE071646EB23DBULL, 0x164CFDA3281E38C3ULL },
+    { 0x6EFE6C11D255B649ULL, 0x11D7314F534B609CULL },
+    { 0xB197134FB6EF8A0EULL, 0x1C8B821885456760ULL },
+    { 0x27AC0F72F8BFA1A5ULL, 0x16D601AD376AB91AULL },
+    { 0xB95672C260994E1EULL, 0x1244CE242C5560E1ULL },
+    { 0xF5571E03CDC21695ULL, 0x1D3AE36D13BBCE35ULL },
+    { 0x2AAC18030B01ABABULL, 0x17624F8A762FD82BULL },
+    { 0xBBBCE0026F348956ULL, 0x12B50C6EC4F31355ULL },
+    { 0x92C7CCD0B1EDA889ULL, 0x1DEE7A4AD4B81EEFULL },
+    { 0xDBD30A408E57BA07ULL, 0x17F1FB6F10934BF2ULL },
+    { 0x7CA8D50071DFC806ULL, 0x1327FC58DA0F6FF5ULL },
+    { 0xFAA7BB33E9660CD6ULL, 0x1EA6608E29B24CBBULL },
+    { 0x9552FC298784D711ULL, 0x18851A0B548EA3C9ULL },
+    { 0xAAA8C9BAD2D0AC0EULL, 0x139DAE6F76D88307ULL },
+    { 0xDDDADC5E1E1AACE3ULL, 0x1F62B0B257C0D1A5ULL },
+    { 0x7E48B04B4B488A4FULL, 0x191BC08EAC9A4151ULL },
+    { 0xCB6D59D5D5D3A1D9ULL, 0x141633A556E1CDDAULL },
+    { 0x3C577B1177DC817BULL, 0x1011C2EAABE7D7E2ULL },
+    { 0xC6F25E825960CF2AULL, 0x19B604AAACA62636ULL },
+    { 0x6BF518684780A5BBULL, 0x14919D5556EB51C5ULL },
+    { 0x232A79ED06008496ULL, 0x10747DDDDF22A7D1ULL },
+    { 0xD1DD8FE1A3340756ULL, 0x1A53FC9631D10C81ULL },
+    { 0xA7E4731AE8F66C45ULL, 0x150FFD44F4A73D34ULL },
+    { 0x531D28E253F8569EULL, 0x10D9976A5D52975DULL },
+    { 0xEB61DB03B98D5762ULL, 0x1AF5BF109550F22EULL },
+    { 0xBC4E48CFC7A445E8ULL, 0x159165A6DDDA5B58ULL },
+    { 0x6371D3D96C836B20ULL, 0x11411E1F17E1E2ADULL },
+    { 0x9F1C8628AD9F11CDULL, 0x1B9B6364F3030448ULL },
+    { 0xE5B06B53BE18DB0BULL, 0x1615E91D8F359D06ULL },
+    { 0xEAF3890FCB4715A2ULL, 0x11AB20E472914A6BULL },
+    { 0x44B8DB4C7871BC37ULL, 0x1C45016D841BAA46ULL },
+    { 0x03C715D6C6C1635FULL, 0x169D9ABE03495505ULL },
+    { 0x3638DE456BCDE919ULL, 0x1217AEFE69077737ULL },
+    { 0x56C163A2461641C1ULL, 0x1CF2B1970E725858ULL },
+    { 0xDF011C81D1AB67CEULL, 0x17288E1271F51379ULL },
+    { 0x7F3416CE4155ECA5ULL, 0x1286D80EC190DC61ULL },
+    { 0x6520247D3556476EULL, 0x1DA48CE468E7C702ULL },
+    { 0xEA801D30F7783925ULL, 0x17B6D71D20B96C01ULL },
+    { 0xBB99B0F3F92CFA84ULL, 0x12F8AC174D612334ULL },
+    { 0x5F5C4E532847F739ULL, 0x1E5AACF215683854ULL },
+    { 0x7F7D0B75B9D32C2EULL, 0x18488A5B44536043ULL },
+    { 0x9930D5F7C7DC2358ULL, 0x136D3B7C36A919CFULL },
+    { 0x8EB4898C72F9D226ULL, 0x1F152BF9F10E8FB2ULL },
+    { 0x722A07A38F2E41B8ULL, 0x18DDBCC7F40BA628ULL },
+    { 0xC1BB394FA5BE9AFAULL, 0x13E497065CD61E86ULL },
+    { 0x9C5EC2190930F7F6ULL, 0x1FD424D6FAF030D7ULL },
+    { 0x49E56814075A5FF8ULL, 0x197683DF2F268D79ULL },
+    { 0x6E51201005E1E660ULL, 0x145ECFE5BF520AC7ULL },
+    { 0xF1DA800CD181851AULL, 0x104BD984990E6F05ULL },
+    { 0x4FC400148268D4F5ULL, 0x1A12F5A0F4E3E4D6ULL },
+    { 0xD96999AA01ED772BULL, 0x14DBF7B3F71CB711ULL },
+    { 0xADEE1488018AC5BCULL, 0x10AFF95CC5B09274ULL },
+    { 0x497CEDA668DE092CULL, 0x1AB328946F80EA54ULL },
+    { 0x3ACA57B853E4D424ULL, 0x155C2076BF9A5510ULL },
+    { 0x623B7960431D7683ULL, 0x1116805EFFAEAA73ULL },
+    { 0x9D2BF566D1C8BD9EULL, 0x1B5733CB32B110B8ULL },
+    { 0x7DBCC452416D647FULL, 0x15DF5CA28EF40D60ULL },
+    { 0xCAFD69DB678AB6CCULL, 0x117F7D4ED8C33DE6ULL },
+    { 0xAB2F0FC572778ADFULL, 0x1BFF2EE48E052FD7ULL },
+    { 0x88F273045B92D580ULL, 0x1665BF1D3E6A8CACULL },
+    { 0xD3F528D049424466ULL, 0x11EAFF4A98553D56ULL },
+    { 0xB988414D4203A0A3ULL, 0x1CAB3210F3BB9557ULL },
+    { 0x6139CDD76802E6E9ULL, 0x16EF5B40C2FC7779ULL },
+    { 0xE761717920025254ULL, 0x125915CD68C9F92DULL },
+    { 0xA568B58E999D5086ULL, 0x1D5B561574765B7CULL },
+    { 0x5120913EE14AA6D2ULL, 0x177C44DDF6C515FDULL },
+    { 0xA74D40FF1AA21F0EULL, 0x12C9D0B1923744CAULL },
+    { 0x0BAECE64F769CB4AULL, 0x1E0FB44F50586E11ULL },
+    { 0x3C8BD850C5EE3C3BULL, 0x180C903F7379F1A7ULL },
+    { 0xCA0979DA37F1C9C9ULL, 0x133D4032C2C7F485ULL },
+    { 0xA9A8C2F6BFE942DBULL, 0x1EC866B79E0CBA6FULL },
+    { 0x2153CF2BCCBA9BE3ULL, 0x18A0522C7E709526ULL },
+    { 0x1AA9728970954982ULL, 0x13B374F06526DDB8ULL },
+    { 0xF775840F1A88759DULL, 0x1F8587E7083E2F8CULL },
+    { 0x5F9136727BA05E17ULL, 0x19379FEC0698260AULL },
+    { 0x1940F85B9619E4DFULL, 0x142C7FF0054684D5ULL },
+    { 0xE100C6AFAB47EA4CULL, 0x1023998CD1053710ULL },
+    { 0xCE67A44C453FDD47ULL, 0x19D28F47B4D524E7ULL },
+    { 0xD852E9D69DCCB106ULL, 0x14A8729FC3DDB71FULL },
+    { 0x79DBEE454B0A2738ULL, 0x1086C219697E2C19ULL },
+    { 0x295FE3A211A9D859ULL, 0x1A71368F0F30468FULL },
+    { 0xBAB31C81A7BB137AULL, 0x15275ED8D8F36BA5ULL },
+    { 0x6228E39AEC95A92FULL, 0x10EC4BE0AD8F8951ULL },
+    { 0x9D0E38F7E0EF7517ULL, 0x1B13AC9AAF4C0EE8ULL },
+    { 0xB0D82D931A592A79ULL, 0x15A956E225D67253ULL },
+    { 0x8D79BE0F4847552EULL, 0x11544581B7DEC1DCULL },
+    { 0x158F967EDA0BBB7CULL, 0x1BBA08CF8C979C94ULL },
+    { 0x77A611FF14D62F97ULL, 0x162E6D72D6DFB076ULL },
+    { 0xF951A7FF43DE8C79ULL, 0x11BEBDF578B2F391ULL },
+    { 0xC21C3FFED2FDAD8EULL, 0x1C6463225AB7EC1CULL },
+    { 0x01B0333242648AD8ULL, 0x16B6B5B5155FF017ULL },
+    { 0x0159C28E9B83A246ULL, 0x122BC490DDE659ACULL },
+    { 0xCEF604175F3903A3ULL, 0x1D12D41AFCA3C2ACULL },
+    { 0x725E69AC4C2D9C83ULL, 0x17424348CA1C9BBDULL },
+    { 0xF5185489D68AE39CULL, 0x129B69070816E2FDULL },
+    { 0xEE8D540FBDAB05C6ULL, 0x1DC574D80CF16B2FULL },
+    { 0xBED77672FE226B05ULL, 0x17D12A4670C1228CULL },
+    { 0xFF12C528CB4EBC04ULL, 0x130DBB6B8D674ED6ULL },
+    { 0xCB513B74787DF9A0ULL, 0x1E7C5F127BD87E24ULL },
+    { 0x090DC929F9FE614DULL, 0x18637F41FCAD31B7ULL },
+    { 0xA0D7D42194CB810AULL, 0x1382CC34CA2427C5ULL },
+    { 0x67BFB9CF5478CE77ULL, 0x1F37AD21436D0C6FULL },
+    { 0x1FCC94A5DD2D71F9ULL, 0x18F9574DCF8A7059ULL },
+    { 0x7FD6DD517DBDF4C7ULL, 0x13FAAC3E3FA1F37AULL },
+    { 0xFFBE2EE8C92FEE0BULL, 0x1FF779FD329CB8C3ULL },
+    { 0x6631BF20A0F324D6ULL, 0x1992C7FDC216FA36ULL },
+    { 0xB827CC1A1A5C1D78ULL, 0x14756CCB01ABFB5EULL },
+    { 0x935309AE7B7CE460ULL, 0x105DF0A267BCC918ULL },
+    { 0x1EEB42B0C594A099ULL, 0x1A2FE76A3F9474F4ULL },
+    { 0xE58902270476E6E1ULL, 0x14F31F8832DD2A5CULL },
+    { 0xB7A0CE859D2BEBE7ULL, 0x10C27FA028B0EEB0ULL },
+    { 0x59014A6F61DFDFD8ULL, 0x1AD0CC33744E4AB4ULL },
+    { 0xE0CDD525E7E64CADULL, 0x1573D68F903EA229ULL },
+    { 0x4D7177518651D6F1ULL, 0x11297872D9CBB4EEULL },
+    { 0x7BE8BEE8D6E957E8ULL, 0x1B758D848FAC54B0ULL },
+    { 0xFCBA3253DF211320ULL, 0x15F7A46A0C89DD59ULL },
+    { 0x63C8284318E74280ULL, 0x1192E9EE706E4AAEULL },
+    { 0x060D0D3827D86A66ULL, 0x1C1E43171A4A1117ULL },
+    { 0x6B3DA42CECAD21EBULL, 0x167E9C127B6E7412ULL },
+    { 0x88FE1CF0BD574E56ULL, 0x11FEE341FC585CDBULL },
+    { 0x419694B462254A23ULL, 0x1CCB0536608D615FULL },
+    { 0x67ABAA29E81DD4E9ULL, 0x1708D0F84D3DE77FULL },
+    { 0xB95621BB2017DD87ULL, 0x126D73F9D764B932ULL },
+    { 0xC223692B668C95A5ULL, 0x1D7BECC2F23AC1EAULL },
+    { 0xCE82BA891ED6DE1DULL, 0x179657025B6234BBULL },
+    { 0xA53562074BDF1818ULL, 0x12DEAC01E2B4F6FCULL },
+    { 0x3B889CD87964F359ULL, 0x1E3113363787F194ULL },
+    { 0xFC6D4A46C783F5E1ULL, 0x18274291C6065ADCULL },
+    { 0x30576E9F06032B1AULL, 0x13529BA7D19EAF17ULL },
+    { 0x1A257DCB3CD1DE90ULL, 0x1EEA92A61C311825ULL },
+    { 0x481DFE3C30A7E540ULL, 0x18BBA884E35A79B7ULL },
+    { 0xD34B31C9C0865100ULL, 0x13C9539D82AEC7C5ULL },
+    { 0x5211E942CDA3B4CDULL, 0x1FA885C8D117A609ULL },
+    { 0x74DB21023E1C90A4ULL, 0x19539E3A40DFB807ULL },
+    { 0xF715B401CB4A0D50ULL, 0x1442E4FB67196005ULL },
+    { 0xF8DE299B09080AA7ULL, 0x103583FC527AB337ULL },
+    { 0x8E304291A80CDDD7ULL, 0x19EF3993B72AB859ULL },
+    { 0x3E8D020E200A4B13ULL, 0x14BF6142F8EEF9E1ULL },
+    { 0x653D9B3E80083C0FULL, 0x10991A9BFA58C7E7ULL },
+    { 0x6EC8F864000D2CE4ULL, 0x1A8E90F9908E0CA5ULL },
+    { 0x8BD3F9E999A423EAULL, 0x153EDA614071A3B7ULL },
+    { 0x3CA994BAE1501CBBULL, 0x10FF151A99F482F9ULL },
+    { 0xC775BAC49BB3612BULL, 0x1B31BB5DC320D18EULL },
+    { 0xD2C4956A16291A89ULL, 0x15C162B168E70E0BULL },
+    { 0xDBD0778811BA7BA1ULL, 0x11678227871F3E6FULL },
+    { 0x2C80BF401C5D929BULL, 0x1BD8D03F3E9863E6ULL },
+    { 0xBD33CC3349E47549ULL, 0x16470CFF6546B651ULL },
+    { 0xCA8FD68F6E505DD4ULL, 0x11D270CC51055EA7ULL },
+    { 0x4419574BE3B3C953ULL, 0x1C83E7AD4E6EFDD9ULL },
+    { 0x0347790982F63AA9ULL, 0x16CFEC8AA52597E1ULL },
+    { 0xCF6C60D468C4FBBAULL, 0x123FF06EEA847980ULL },
+    { 0xE57A34870E07F92AULL, 0x1D331A4B10D3F59AULL },
+    { 0x512E906C0B399422ULL, 0x175C1508DA432AE2ULL },
+    { 0xDA8BA6BCD5C7A9B5ULL, 0x12B010D3E1CF5581ULL },
+    { 0x90DF712E22D90F87ULL, 0x1DE6815302E5559CULL },
+    { 0xDA4C5A8B4F140C6CULL, 0x17EB9AA8CF1DDE16ULL },
+    { 0xAEA37BA2A5A9A38AULL, 0x1322E220A5B17E78ULL },
+    { 0x7DD25F6AA2A905A9ULL, 0x1E9E369AA2B59727ULL },
+    { 0x97DB7F888220D154ULL, 0x187E92154EF7AC1FULL },
+    { 0x797C6606CE80A777ULL, 0x139874DDD8C6234CULL },
+    { 0x8F2D700AE4010BF1ULL, 0x1F5A549627A36BADULL },
+    { 0x0C2459A25000D65AULL, 0x191510781FB5EFBEULL },
+    { 0x701D1481D99A4515ULL, 0x1410D9F9B2F7F2FEULL },
+    { 0xC017439B147B6A77ULL, 0x100D7B2E28C65BFEULL },
+    { 0xCCF205C4ED9243F2ULL, 0x19AF2B7D0E0A2CCAULL },
+    { 0x0A5B37D0BE0E9CC2ULL, 0x148C22CA71A1BD6FULL },
+    { 0x0848F973CB3EE3CEULL, 0x10701BD527B4978CULL },
+    { 0xDA0E5BEC78649FB0ULL, 0x1A4CF9550C5425ACULL },
+    { 0x7B3EAFF060507FC0ULL, 0x150A6110D6A9B7BDULL },
+    { 0x95CBBFF380406633ULL, 0x10D51A73DEEE2C97ULL },
+    { 0xEFAC665266CD7052ULL, 0x1AEE90B964B04758ULL },
+    { 0x2623850EB8A459DBULL, 0x158BA6FAB6F36C47ULL },
+    { 0x1E82D0D893B6AE49ULL, 0x113C85955F29236CULL },
+    { 0xFD9E1AF41F8AB075ULL, 0x1B9408EEFEA838ACULL },
+    { 0x97B1AF29B2D559F7ULL, 0x16100725988693BDULL },
+    { 0xAC8E25BAF5777B2CULL, 0x11A66C1E139EDC97ULL },
+    { 0x7A7D092B2258C513ULL, 0x1C3D79C9B8FE2DBFULL },
+    { 0x61FDA0EF4EAD6A76ULL, 0x169794A160CB57CCULL },
+    { 0xE7FE1A590BBDEEC5ULL, 0x1212DD4DE7091309ULL },
+    { 0xA6635D5B45FCB13AULL, 0x1CEAFBAFD80E84DCULL },
+    { 0x851C4AAF6B308DC8ULL, 0x172262F3133ED0B0ULL },
+    { 0xD0E36EF2BC26D7D4ULL, 0x1281E8C275CBDA26ULL },
+    { 0xB49F17EAC6A48C86ULL, 0x1D9CA79D894629D7ULL },
+    { 0x2A18DFEF0550706BULL, 0x17B08617A104EE46ULL },
+    { 0x54E0B3259DD9F389ULL, 0x12F39E794D9D8B6BULL },
+    { 0x87CDEB6F62F65274ULL, 0x1E5297287C2F4578ULL },
+    { 0xD30B22BF825EA85DULL, 0x18421286C9BF6AC6ULL },
+    { 0x0F3C1BCC684BB9E4ULL, 0x13680ED23AFF889FULL },
+    { 0x18602C7A4079296DULL, 0x1F0CE4839198DA98ULL },
+    { 0x46B356C833942124ULL, 0x18D71D360E13E213ULL },
+    { 0x388F78A029434DB6ULL, 0x13DF4A91A4DCB4DCULL },
+    { 0x5A7F2766A86BAF8AULL, 0x1FCBAA82A1612160ULL },
+    { 0x153285EBB9EFBFA2ULL, 0x196FBB9BB44DB44DULL },
+    { 0xAA8ED189618C994EULL, 0x145962E2F6A4903DULL },
+    { 0xEED8A7A11AD6E10CULL, 0x1047824F2BB6D9CAULL },
+    { 0x7E27729B5E249B45ULL, 0x1A0C03B1DF8AF611ULL },
+    { 0xFE85F549181D4904ULL, 0x14D6695B193BF80DULL },
+    { 0xCB9E5DD4134AA0D0ULL, 0x10AB877C142FF9A4ULL },
+    { 0xDF63C9535211014DULL, 0x1AAC0BF9B9E65C3AULL },
+    { 0x191CA10F74DA6771ULL, 0x15566FFAFB1EB02FULL },
+    { 0xADB080D92A4852C1ULL, 0x1111F32F2F4BC025ULL },
+    { 0x15E7348EAA0D5134ULL, 0x1B4FEB7EB212CD09ULL },
+    { 0xAB1F5D3EEE710DC4ULL, 0x15D98932280F0A6DULL },
+    { 0xBC1917658B8DA49DULL, 0x117AD428200C0857ULL },
+    { 0x2CF4F23C127C3A94ULL, 0x1BF7B9D9CCE00D59ULL },
+    { 0xF0C3F4FCDB969543ULL, 0x165FC7E170B33DE0ULL },
+    { 0x5A365D9716121103ULL, 0x11E6398126F5CB1AULL },
+    { 0x9056FC24F01CE804ULL, 0x1CA38F350B22DE90ULL },
+    { 0xD9DF301D8CE3ECD0ULL, 0x16E93F5DA2824BA6ULL },
+    { 0xE17F59B13D8323DAULL, 0x125432B14ECEA2EBULL },
+    { 0x68CBC2B52F38395CULL, 0x1D53844EE47DD179ULL },
+    { 0x53D6355DBF602DE3ULL, 0x177603725064A794ULL },
+    { 0xA9782AB165E68B1CULL, 0x12C4CF8EA6B6EC76ULL },
+    { 0x0F26AAB56FD744FAULL, 0x1E07B27DD78B13F1ULL },
+    { 0x3F52222ABFDF6A62ULL, 0x18062864AC6F4327ULL },
+    { 0x65DB4E88997F884EULL, 0x1338205089F29C1FULL },
+    { 0x6FC54A7428CC0D4AULL, 0x1EC033B40FEA9365ULL },
+    { 0x596AA1F68709A43BULL, 0x1899C2F673220F84ULL },
+    { 0xADEEE7F86C07B696ULL, 0x13AE3591F5B4D936ULL },
+    { 0x497E3FF3E00C5756ULL, 0x1F7D228322BAF524ULL },
+    { 0xD464FFF64CD6AC45ULL, 0x1930E868E89590E9ULL },
+    { 0x4383FFF83D7889D1ULL, 0x14272053ED4473EEULL },
+    { 0xCF9CCCC69793A174ULL, 0x101F4D0FF1038FF1ULL },
+    { 0x7F6147A425B90252ULL, 0x19CBAE7FE805B31CULL },
+    { 0xCC4DD2E9B7C7350FULL, 0x14A2F1FFECD15C16ULL },
+    { 0x3D0B0F215FD290D9ULL, 0x10825B3323DAB012ULL },
+    { 0x61AB4B689950E7C1ULL, 0x1A6A2B85062AB350ULL },
+    { 0x4E22A2BA1440B967ULL, 0x1521BC6A6B555C40ULL },
+    { 0x0B4EE894DD009453ULL, 0x10E7C9EEBC4449CDULL },
+    { 0x1217DA87C800ED51ULL, 0x1B0C764AC6D3A948ULL },
+    { 0xDB46486CA000BDDAULL, 0x15A391D56BDC876CULL },
+    { 0x490506BD4CCD64AFULL, 0x114FA7DDEFE39F8AULL },
+    { 0xA8080AC87AE23AB1ULL, 0x1BB2A62FE638FF43ULL },
+    { 0x5339A239FBE82EF4ULL, 0x162884F31E93FF69ULL },
+    { 0x75C7B4FB2FECF25DULL, 0x11BA03F5B20FFF87ULL },
+    { 0x22D92191E647EA2EULL, 0x1C5CD322B67FFF3FULL },
+    { 0xB57A8141850654F2ULL, 0x16B0A8E891FFFF65ULL },
+    { 0xC4620101373843F5ULL, 0x1226ED86DB3332B7ULL },
+    { 0x3A366801F1F39FEEULL, 0x1D0B15A491EB8459ULL },
+    { 0xFB5EB99B27F6198BULL, 0x173C115074BC69E0ULL },
+    { 0x2F7EFAE2865E7AD6ULL, 0x129674405D6387E7ULL },
+    { 0xE597F7D0D6FD9156ULL, 0x1DBD86CD6238D971ULL },
+    { 0x8479930D78CADAABULL, 0x17CAD23DE82D7AC1ULL },
+    { 0xD06142712D6F1556ULL, 0x1308A831868AC89AULL },
+    { 0x4D686A4EAF182222ULL, 0x1E74404F3DAADA91ULL },
+    { 0xA453883EF279B4E8ULL, 0x185D003F6488AEDAULL },
+    { 0xE9DC6CFF28615D87ULL, 0x137D99CC506D58AEULL },
+    { 0xA960AE650D6895A4ULL, 0x1F2F5C7A1A488DE4ULL },
+    { 0xBAB3BEB73DED4483ULL, 0x18F2B061AEA07183ULL },
+    { 0x2EF6322C318A9D36ULL, 0x13F559E7BEE6C136ULL },
+    { 0xE4BD1D13827761F0ULL, 0x1FEEF63F97D79B89ULL },
+    { 0x83CA7DA9352C4E5AULL, 0x198BF832DFDFAFA1ULL },
+    { 0x9CA1FE20F756A515ULL, 0x146FF9C24CB2F2E7ULL },
+    { 0x4A1B31B3F9121DAAULL, 0x1059949B708F28B9ULL },
+    { 0x435EB5ECC1B695DDULL, 0x1A28EDC580E50DF5ULL },
+    { 0x35E55E57015EDE4AULL, 0x14ED8B04671DA4C4ULL },
+    { 0xC4B77EAC0118B1D5ULL, 0x10BE08D0527E1D69ULL },
+    { 0xA12597799B5AB622ULL, 0x1AC9A7B3B7302F0FULL },
+    { 0x4DB7AC6149155E81ULL, 0x156E1FC2F8F358D9ULL },
+    { 0xD7C6238107444B9BULL, 0x1124E63593F5E0ADULL },
+    { 0x593D059B3ED3AC2BULL, 0x1B6E3D2286563449ULL },
+    { 0xE0FD9E15CBDC89BCULL, 0x15F1CA820511C36DULL },
+    { 0xB3FE18116FE3A163ULL, 0x118E3B9B37416924ULL },
+    { 0x866359B57FD29BD1ULL, 0x1C16C5C525357507ULL },
+    { 0xD1E91491330EE30EULL, 0x16789E3750F790D2ULL },
+    { 0x74BA76DA8F3F1C0BULL, 0x11FA182C40C60D75ULL },
+    { 0xEDF72490E531C678ULL, 0x1CC359E067A348BBULL },
+    { 0x8B2C1D40B75B052DULL, 0x1702AE4D1FB5D3C9ULL },
+    { 0x6F567DCD5F7C0424ULL, 0x12688B70E62B0FD4ULL },
+    { 0x7EF0C94898C66D06ULL, 0x1D74124E3D11B2EDULL },
+    { 0x98C0A106E09EBD9FULL, 0x17900EA4FDA7C257ULL },
+    { 0x470080D24D4BCAE6ULL, 0x12D9A550CAEC9B79ULL },
+    { 0xD800CE1D487944A2ULL, 0x1E29088144ADC58EULL },
+    { 0x1333D8176D2DD082ULL, 0x1820D39A9D57D13FULL },
+    { 0xA8F646792424A6CEULL, 0x134D76154AACA765ULL },
+    { 0x74BD3D8EA03AA47DULL, 0x1EE25688777AA56FULL },
+    { 0x5D64313EE6955064ULL, 0x18B51206C5FBB78CULL },
+    { 0x4AB68DCBEBAAA6B7ULL, 0x13C40E6BD1962C70ULL },
+    { 0x1124161312AAA457ULL, 0x1FA01712E8F0471AULL },
+    { 0xDA8344DC0EEEE9DFULL, 0x194CDF4253F36C14ULL },
+    { 0xE2029D7CD8BF2180ULL, 0x143D7F6843292343ULL },
+    { 0x4E687DFD7A328133ULL, 0x103132B9CF541C36ULL },
+    { 0x4A40C9959050CEB8ULL, 0x19E851294BB9C6BDULL },
+    { 0x0833D477A6A70BC6ULL, 0x14B9DA876FC7D231ULL },
+    { 0xA02976C61EEC096BULL, 0x1094AED2BFD30E8DULL },
+    { 0x004257A364ACDBDFULL, 0x1A877E1DFFB81749ULL },
+    { 0xCD01DFB5EA23E319ULL, 0x153931B1996012A0ULL },
+    { 0x70CE4C91881CB5AEULL, 0x10FA8E27ADE6754DULL },
+    { 0x1AE3ADB5A69455E2ULL, 0x1B2A7D0C4970BBAFULL },
+    { 0x7BE957C4854377E8ULL, 0x15BB973D078D62F2ULL },
+    { 0xC987796A0435F987ULL, 0x1162DF64060AB58EULL },
+    { 0x75A58F1006BCC271ULL, 0x1BD1656CD67788E4ULL },
+    { 0xF7B7A5A66BCA3527ULL, 0x16411DF0AB92D3E9ULL },
+    { 0x5FC61E1EBCA1C41FULL, 0x11CDB18D560F0FEEULL },
+    { 0xFFA363646102D365ULL, 0x1C7C4F4889B1B316ULL },
+    { 0x32E91C504D9BDC51ULL, 0x16C9D906D48E28DFULL },
+    { 0x8F20E37371497D0EULL, 0x123B140576D820B2ULL },
+    { 0x7E9B0585820F2E7CULL, 0x1D2B533BF159CDEAULL },
+    { 0xCBAF379E01A5BECAULL, 0x1755DC2FF447D7EEULL },
+    { 0x0958F94B348498A1ULL, 0x12AB168CC36CACBFULL }
+};
 
-    uint16_t len = 0;
-    if (value < 0) {
-        len++;
-        value = -value;
+/* returns ceil(log2(5^e)), or 1 if e is 0. Valid for e in [0, 3528] */
+static int32_t pow5bits(int32_t e) {
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* returns floor(log10(2^e)) for e in [0, 1650] */
+static uint32_t log10_pow2(int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+/* returns floor(log10(5^e)) for e in [0, 2620] */
+static uint32_t log10_pow5(int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static bool multiple_of_pow5(uint64_t value, uint32_t p) {
+    uint32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
     }
+    return count >= p;
+}
+
+static bool multiple_of_pow2(uint64_t value, uint32_t p) {
+    return (value & ((1ull << p) - 1)) == 0;
+}
+
+/* returns the low 64 bits of a * b and stores the high 64 bits in hi */
+static uint64_t u64_mul128(uint64_t a, uint64_t b, uint64_t* hi)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    *hi = (uint64_t)(r >> 64);
+    return (uint64_t)r;
+#else
+    /* from 32 bit halves */
+    uint64_t aLo = (uint32_t)a, aHi = a >> 32;
+    uint64_t bLo = (uint32_t)b, bHi = b >> 32;
+    uint64_t b00 = aLo * bLo, b01 = aLo * bHi, b10 = aHi * bLo, b11 = aHi * bHi;
+    uint64_t mid = (b00 >> 32) + (uint32_t)b01 + (uint32_t)b10;
+    *hi = b11 + (b01 >> 32) + (b10 >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)b00;
+#endif
+}
 
-    long long int_part = (long long)value;
-    double frac_part = value - (double)int_part;
+/* returns ((m * mul) >> j) where mul is a 128 bit number, j is in (64, 128) */
+static uint64_t mul_shift64(uint64_t m, const uint64_t* mul, int32_t j)
+{
+    uint64_t high0, high1;
+    u64_mul128(m, mul[0], &high0);
+    uint64_t low1 = u64_mul128(m, mul[1], &high1);
+    uint64_t sum = high0 + low1;
+    if (sum < high0) {
+        high1++;
+    }
+    int32_t dist = j - 64;
+    return (high1 << (64 - dist)) | (sum >> dist);
+}
+
+typedef struct {
+    uint64_t mantissa;
+    int32_t exponent; /*the value is mantissa * 10^exponent*/
+} decimal64;
 
-    if (int_part == 0) {
-        len += 1;
+/* converts a finite, non-zero double from its IEEE parts to the shortest decimal that rounds back to it */
+static decimal64 double_to_decimal(uint64_t ieeeMantissa, uint32_t ieeeExponent)
+{
+    int32_t e2;
+    uint64_t m2;
+    if (ieeeExponent == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ieeeMantissa;
     }
     else {
-        long long tmp = int_part;
-        while (tmp > 0) {
-            len++;
-            tmp /= 10;
-        }
+        e2 = (int32_t)ieeeExponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = (1ull << DOUBLE_MANTISSA_BITS) | ieeeMantissa;
     }
 
-    if (precision > 0)
-    {
-        if (!trimZeros)
-        {
-            len += 1 + precision; 
+    /* integers below 2^53 need no search, only their trailing zeros removed */
+    if (e2 + 2 <= 0 && e2 + 2 >= -DOUBLE_MANTISSA_BITS && multiple_of_pow2(m2, -(e2 + 2))) {
+        decimal64 d = { m2 >> -(e2 + 2), 0 };
+        while (d.mantissa % 10 == 0) {
+            d.mantissa /= 10;
+            d.exponent++;
         }
-        else {
-            uint16_t frac_len = 0;
-            double frac = frac_part;
-            uint16_t i;
-            for ( i = 0; i < precision; i++) 
-            {
-                frac *= 10.0;
-                int digit = (int)frac;
-                frac -= digit;
-                if (digit != 0) {
-                    frac_len = i + 1;
-                }
+        return d;
+    }
+
+    bool acceptBounds = (m2 & 1) == 0;
+
+    /* the interval of decimals that round to the double is [mv - mmShift - 1, mv + 2] / 4 */
+    uint64_t mv = 4 * m2;
+    uint32_t mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+    if (e2 >= 0) {
+        uint32_t q = log10_pow2(e2) - (e2 > 3);
+        e10 = (int32_t)q;
+        int32_t k = DOUBLE_POW5_INV_BITCOUNT + pow5bits((int32_t)q) - 1;
+        int32_t i = -e2 + (int32_t)q + k;
+        vr = mul_shift64(4 * m2, double_pow5_inv_split[q], i);
+        vp = mul_shift64(4 * m2 + 2, double_pow5_inv_split[q], i);
+        vm = mul_shift64(4 * m2 - 1 - mmShift, double_pow5_inv_split[q], i);
+        if (q <= 21) {
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = multiple_of_pow5(mv, q);
+            }
+            else if (acceptBounds) {
+                vmIsTrailingZeros = multiple_of_pow5(mv - 1 - mmShift, q);
             }
-            if (frac_len > 0) {
-                len += 1 + frac_len; /* '.' */
+            else {
+                vp -= multiple_of_pow5(mv + 2, q);
             }
         }
     }
-
-    return len;
-}
-
-/* converts a u32 to a string and returns the end of the write position. */
-static uint8_t* u32toa(uint32_t value, uint8_t* buf, size_t bufsize)
-{
-    uint8_t digits = digits_u32(value);
-    uint8_t* bufEnd = buf + bufsize - 1;
-    uint8_t i = 0;
-    while (value && buf < bufEnd)
-    {
-        uint8_t* pos = buf + digits - i - 1;
-        if (pos<bufEnd) {
-            *pos = value % 10 + '0';
+    else {
+        uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = (int32_t)q + e2;
+        int32_t i = -e2 - (int32_t)q;
+        int32_t k = pow5bits(i) - DOUBLE_POW5_BITCOUNT;
+        int32_t j = (int32_t)q - k;
+        vr = mul_shift64(4 * m2, double_pow5_split[i], j);
+        vp = mul_shift64(4 * m2 + 2, double_pow5_split[i], j);
+        vm = mul_shift64(4 * m2 - 1 - mmShift, double_pow5_split[i], j);
+        if (q <= 1) {
+            vrIsTrailingZeros = true;
+            if (acceptBounds) {
+                vmIsTrailingZeros = mmShift == 1;
+            }
+            else {
+                --vp;
+            }
+        }
+        else if (q < 63) {
+            vrIsTrailingZeros = multiple_of_pow2(mv, q);
         }
-        value /= 10;
-        i++;
     }
-    return buf+i;
-}
-
-/* converts a double to string and returns the updated write head */
-static uint8_t* dtoa(double value, uint8_t* buf, size_t size, uint16_t precision, bool trimZeros) {
-    if (size == 0) return buf;
 
-    if (__isnan__(value)) {
-        memcpy(buf, "nan", min(size, 3));
-        return buf + min(size, 3);
+    /* remove digits while the bounds still differ */
+    int32_t removed = 0;
+    uint8_t lastRemovedDigit = 0;
+    uint64_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= vm % 10 == 0;
+            vrIsTrailingZeros &= lastRemovedDigit == 0;
+            lastRemovedDigit = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+            lastRemovedDigit = 4; /* round to even */
+        }
+        output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
     }
-    if (nm_isinf(value)) {
-        if (value < 0) {
-            memcpy(buf, "-inf", min(size, 4));
-            return buf + min(size, 4);
+    else {
+        bool roundUp = false;
+        if (vp / 100 > vm / 100) {
+            roundUp = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
         }
-        else {
-            memcpy(buf, "inf", min(size, 3));
-            return buf + min(size, 3);
+        while (vp / 10 > vm / 10) {
+            roundUp = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
         }
+        output = vr + (vr == vm || roundUp);
     }
 
-    char* start = buf;
+    decimal64 d = { output, e10 + removed };
+    return d;
+}
+
+/* the largest string dtoa builds: a sign, the 309 integer digits of the largest double, '.' and 255 decimals */
+#define DTOA_BUFFER_SIZE 576
 
-    if (value < 0) {
-        if (size <= 1) return buf;
-        *buf++ = '-';
-        size--;
-        value = -value;
+/* writes the shortest round-trip form of a decimal. Plain notation is used while the
+   decimal point lies within [-6, 21] digits of the first digit, otherwise scientific. */
+static uint8_t* write_decimal_shortest(const uint8_t* digits, int32_t digitCount, int32_t pointPos, uint8_t* out)
+{
+    if (pointPos > 21 || pointPos <= -6) {
+        *out++ = digits[0];
+        if (digitCount > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, digitCount - 1);
+            out += digitCount - 1;
+        }
+        int32_t exp = pointPos - 1;
+        *out++ = 'e';
+        *out++ = exp < 0 ? '-' : '+';
+        return u64toa(exp < 0 ? -exp : exp, out);
+    }
+    if (pointPos <= 0) {
+        *out++ = '0';
+        *out++ = '.';
+        memset(out, '0', -pointPos);
+        out += -pointPos;
+        memcpy(out, digits, digitCount);
+        return out + digitCount;
+    }
+    if (pointPos >= digitCount) {
+        memcpy(out, digits, digitCount);
+        out += digitCount;
+        memset(out, '0', pointPos - digitCount);
+        return out + pointPos - digitCount;
+    }
+    memcpy(out, digits, pointPos);
+    out += pointPos;
+    *out++ = '.';
+    memcpy(out, digits + pointPos, digitCount - pointPos);
+    return out + digitCount - pointPos;
+}
+
+/* writes a decimal with a fixed number of decimals, rounding half away from zero.
+   digits must have room for one more digit, which a rounding carry may add. */
+static uint8_t* write_decimal_fixed(uint8_t* digits, int32_t digitCount, int32_t pointPos, uint8_t decimals, bool trimZeros, uint8_t* out, bool* isZero)
+{
+    int32_t keep = pointPos + decimals;
+    if (keep < digitCount) {
+        bool roundUp = keep >= 0 && digits[keep] >= '5';
+        digitCount = keep > 0 ? keep : 0;
+        if (roundUp) {
+            int32_t i = digitCount - 1;
+            while (i >= 0 && digits[i] == '9') {
+                digits[i--] = '0';
+            }
+            if (i >= 0) {
+                digits[i]++;
+            }
+            else {
+                /* carried past the first digit */
+                memmove(digits + 1, digits, digitCount);
+                digits[0] = '1';
+                digitCount++;
+                pointPos++;
+            }
+        }
     }
 
-    /* get integer and frac parts */
-    long long int_part = (long long)value;
-    double frac_part = value - (double)int_part;
+    int32_t i;
+    *isZero = true;
+    for (i = 0; i < digitCount; ++i) {
+        if (digits[i] != '0') {
+            *isZero = false;
+            break;
+        }
+    }
 
-    /* Write integer part */
-    int written = i64toa(int_part, buf, size);
-    if (written < 0 || written >= (int)size) return buf;
+    /* integer part */
+    if (pointPos <= 0) {
+        *out++ = '0';
+    }
+    else {
+        int32_t n = min(pointPos, digitCount);
+        memcpy(out, digits, n);
+        out += n;
+        memset(out, '0', pointPos - n);
+        out += pointPos - n;
+    }
 
-    buf += written;
-    size -= written;
+    /* fractional part, digit i of the fraction is digits[pointPos + i] */
+    uint8_t* point = out;
+    *out++ = '.';
+    for (i = 0; i < decimals; ++i) {
+        int32_t di = pointPos + i;
+        *out++ = di >= 0 && di < digitCount ? digits[di] : '0';
+    }
+    if (trimZeros) {
+        while (out > point + 1 && out[-1] == '0') {
+            out--;
+        }
+    }
+    if (out == point + 1) {
+        out = point;
+    }
+    return out;
+}
 
-    char frac_buf[64];
-    uint8_t frac_len = 0;
+/* converts a double to string and returns the updated write head.
+   decimals of MUSTACHE_DECIMALS_SHORTEST writes the shortest string that parses back to the
+   same double, otherwise the shortest decimal is rounded to the given number of decimals and
+   written in plain notation whatever its magnitude. */
+static uint8_t* dtoa(double value, uint8_t* buf, size_t size, uint8_t decimals, bool trimZeros) {
+    if (size == 0) return buf;
 
-    frac_part += 0.5 * pow(10, -precision);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool sign = (bits >> 63) != 0;
+    uint64_t ieeeMantissa = bits & ((1ull << DOUBLE_MANTISSA_BITS) - 1);
+    uint32_t ieeeExponent = (uint32_t)((bits >> DOUBLE_MANTISSA_BITS) & ((1u << DOUBLE_EXPONENT_BITS) - 1));
 
-    int32_t i;
-    for ( i = 0; i < precision && frac_len + 1 < (int32_t)sizeof(frac_buf); i++) {
-        frac_part *= 10.0;
-        int32_t digit = (int32_t)frac_part;
-        frac_buf[frac_len++] = '0' + digit;
-        frac_part -= digit;
+    uint8_t tmp[DTOA_BUFFER_SIZE];
+    uint8_t* out = tmp;
+    if (ieeeExponent == (1u << DOUBLE_EXPONENT_BITS) - 1) {
+        const char* s = ieeeMantissa ? "nan" : (sign ? "-inf" : "inf");
+        size_t len = strlen(s);
+        memcpy(buf, s, min(size, len));
+        return buf + min(size, len);
     }
 
-    if (trimZeros) {
-        while (frac_len > 0 && frac_buf[frac_len - 1] == '0')
-            frac_len--;
+    uint8_t digits[20];
+    int32_t digitCount = 1;
+    int32_t pointPos = 1;
+    if (ieeeExponent == 0 && ieeeMantissa == 0) {
+        digits[0] = '0';
+    }
+    else {
+        decimal64 d = double_to_decimal(ieeeMantissa, ieeeExponent);
+        digitCount = (int32_t)(u64toa(d.mantissa, digits) - digits);
+        pointPos = digitCount + d.exponent;
     }
 
-    /* skip '.' if no frac. digits remain */
-    if (frac_len == 0)
-        return buf;
+    /* the sign of a negative zero is written, the sign of a value that only rounds to zero is not */
+    if (decimals == MUSTACHE_DECIMALS_SHORTEST) {
+        if (sign) {
+            *out++ = '-';
+        }
+        out = write_decimal_shortest(digits, digitCount, pointPos, out);
+    }
+    else {
+        bool isZero;
+        uint8_t* numFirst = out + 1;
+        uint8_t* numEnd = write_decimal_fixed(digits, digitCount, pointPos, decimals, trimZeros, numFirst, &isZero);
+        if (sign && (!isZero || (ieeeExponent == 0 && ieeeMantissa == 0))) {
+            *out++ = '-';
+            out = numEnd;
+        }
+        else {
+            memmove(out, numFirst, numEnd - numFirst);
+            out += numEnd - numFirst;
+        }
+    }
 
-    /* '.' */
-    if (size < 2) return buf;
-    *buf++ = '.';
-    size--;
+    size_t len = min(size, (size_t)(out - tmp));
+    memcpy(buf, tmp, len);
+    return buf + len;
+}
 
-    /* write fractional digits */
-    uint8_t i_8;
-    for ( i_8= 0; i_8 < frac_len && size > 1; i_8++) {
-        *buf++ = frac_buf[i_8];
-        size--;
+/* converts an i64 to string and returns the updated write head */
+static uint8_t* i64toa(int64_t value, uint8_t* buf, size_t size)
+{
+    uint8_t tmp[21];
+    uint8_t* out = tmp;
+    uint64_t mag = (uint64_t)value;
+    if (value < 0) {
+        *out++ = '-';
+        mag = 0 - mag;
     }
+    out = u64toa(mag, out);
+
+    size_t len = min(size, (size_t)(out - tmp));
+    memcpy(buf, tmp, len);
+    return buf + len;
+}
 
-    return buf;
+/* converts a fixed-point decimal, units / 10^scale, to string and returns the updated write head */
+static uint8_t* decimaltoa(int64_t units, uint8_t scale, uint8_t* buf, size_t size)
+{
+    uint8_t tmp[DTOA_BUFFER_SIZE];
+    uint8_t* out = tmp;
+    uint64_t mag = (uint64_t)units;
+    if (units < 0) {
+        *out++ = '-';
+        mag = 0 - mag;
+    }
+
+    bool isZero;
+    uint8_t digits[20];
+    int32_t digitCount = (int32_t)(u64toa(mag, digits) - digits);
+    out = write_decimal_fixed(digits, digitCount, digitCount - scale, scale, false, out, &isZero);
+
+    size_t len = min(size, (size_t)(out - tmp));
+    memcpy(buf, tmp, len);
+    return buf + len;
 }
 
 
@@ -988,12 +2042,15 @@ static uint64_t fseek_callback(void* udata, int64_t whence, MUSTACHE_SEEK_DIR se
     FILE* fptr = (FILE*)udata;
 
     if (seekdir == MUSTACHE_SEEK_LEN) {
-        _fseeki64(fptr, 0, SEEK_END);
-        uint64_t s = _ftelli64(fptr);
+        /* pipes and sockets cannot seek, their length is not known */
+        if (fseek64(fptr, 0, SEEK_END) != 0) {
+            return UINT64_MAX;
+        }
+        uint64_t s = ftell64(fptr);
         rewind(fptr);
         return s;
     }
-    return _fseeki64(fptr, whence, seekdir);
+    return fseek64(fptr, whence, seekdir);
 }
 
 static size_t fread_callback(void* udata, uint8_t* dst, size_t dstlen)
@@ -1002,6 +2059,70 @@ static size_t fread_callback(void* udata, uint8_t* dst, size_t dstlen)
     return fread(dst, 1, dstlen, fptr);
 }
 
+/* the stream's length, UINT64_MAX when the stream has no seek callback or cannot tell */
+static uint64_t stream_len(mustache_stream* stream)
+{
+    if (!stream->seekCallback) {
+        return UINT64_MAX;
+    }
+    return stream->seekCallback(stream->udata, 0, MUSTACHE_SEEK_LEN);
+}
+
+/* reads until dst is full or the stream ends, a pipe or socket may hand over less than was asked for */
+static size_t stream_read_full(mustache_stream* stream, uint8_t* dst, size_t dstlen)
+{
+    size_t filled = 0;
+    while (filled < dstlen)
+    {
+        size_t readBytes = stream->readCallback(stream->udata, dst + filled, dstlen - filled);
+        if (!readBytes || readBytes > dstlen - filled) {
+            break;
+        }
+        filled += readBytes;
+    }
+    return filled;
+}
+
+#ifdef MUSTACHE_MMAP
+/* maps a regular file read-only. Returns false when the file is not a regular file or could not be
+   mapped, the caller then reads it through stdio instead, which also reports a missing file. */
+static bool file_map(const uint8_t* filenameNT, mustache_const_slice* view)
+{
+    /* opening a fifo would connect to its writer, it is left for stdio to open once */
+    struct stat st;
+    if (stat((const char*)filenameNT, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+
+    int fd = open((const char*)filenameNT, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (uint64_t)st.st_size <= SIZE_MAX) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    /* the mapping holds its own reference to the file */
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    /* both the compiler and the JSON parser make forward passes over the whole file */
+#ifdef MADV_SEQUENTIAL
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+    *view = (mustache_const_slice){ map, (uint64_t)st.st_size };
+    return true;
+}
+
+static void file_unmap(mustache_const_slice view)
+{
+    munmap((void*)view.u, (size_t)view.len);
+}
+#endif
+
 
 
 
@@ -1016,7 +2137,7 @@ static scoped_structure* get_scoped_else_parent(const structure* close, const ui
             blockBegin = blockEnd;
         }
 
-        if (*cur == '{' && *(cur - 1) == '{' && *(cur - 2) != '/') {
+        if (*cur == '{' && *(cur - 1) == '{' && (cur - 2 < sourceBegin || *(cur - 2) != '/')) {
             if (*(cur + 1) == '#' || *(cur + 1) == '^') {
                 depth--;
                 if (depth == 0) {
@@ -1053,7 +2174,7 @@ static scoped_structure* get_scoped_close_parent(const structure* close, const u
     uint32_t depth = 0;
     while (cur >= sourceBegin + 1) {
         const uint8_t* blockBegin = NULL;
-        if (*cur == '{' && *(cur - 1) == '{' && *(cur - 2) != '/') {
+        if (*cur == '{' && *(cur - 1) == '{' && (cur - 2 < sourceBegin || *(cur - 2) != '/')) {
             if (*(cur + 1) == '#' || *(cur + 1) == '^' || strneql(cur+1,"else",4)) {
                 depth--;
                 if (depth == 0) {
@@ -1235,57 +2356,98 @@ static mustache_param_template* get_nested_template_param(const uint8_t* nameBeg
 }
 
 
-static mustache_param* get_parameter(const uint8_t* nameBegin, const uint8_t* nameEnd, mustache_param* globalParams, parent_stack* parentStack)
-{
-    /* TRAVERSE PARENT STACK */
-    uint16_t nameLen = nameEnd - nameBegin;
-    int32_t i;
-    for (i = parentStack->count-1; i >= 0; i--) {
-        scoped_structure* structNode = ((scoped_structure**)parentStack->buf.u)[i];
-        mustache_param* parentNode = structNode->param;
-
-        mustache_param* node;
-        uint32_t MAX_COUNT;
+/*FORWARD DECLARATION*/
+static uint8_t JSON_materialize(mustache_param* param);
 
-        if (parentNode->type == MUSTACHE_PARAM_LIST) {
-            mustache_param_list* list = (mustache_param_list*)parentNode;
-            MAX_COUNT = list->valueCount;
-            node = list->pValues;
-        }
-        else if (parentNode->type == MUSTACHE_PARAM_OBJECT) {
-            mustache_param_object* obj = (mustache_param_object*)parentNode;
-            node = obj->pMembers;
-            MAX_COUNT = UINT32_MAX;
-        }
-        else {
-#ifndef NDEBUG
-            assert(00 && "get_parameter: PARENT STACK IS CORRUPTED.");
-#endif
-            return NULL;
-        }
+/* parses a lazy node the render reached, a subtree that does not parse fails the render */
+static bool stack_materialize(parent_stack* parentStack, mustache_param* param)
+{
+    uint8_t err = JSON_materialize(param);
+    if (err && !parentStack->err) {
+        parentStack->err = err;
+    }
+    return !err;
+}
 
+/* searches a single frame of the parent stack for a parameter, returns NULL if the frame does not hold it. */
+static mustache_param* get_frame_parameter(parent_stack* parentStack, scoped_structure* frame, const uint8_t* nameBegin, uint16_t nameLen)
+{
+    mustache_param* parentNode = frame->param;
 
+    mustache_param* node;
+    uint32_t MAX_COUNT;
 
+    if (parentNode->type == MUSTACHE_PARAM_LIST) {
+        mustache_param_list* list = (mustache_param_list*)parentNode;
 
-        uint32_t c = 0;
-        while (node&&c<MAX_COUNT)
-        {
-            if (node->name.len == nameLen &&
-                strneql(node->name.u, nameBegin, nameLen))
+        /* names are bound to the members of the current element first */
+        if (frame->curChild && frame->curChild->type == MUSTACHE_PARAM_OBJECT) {
+            node = ((mustache_param_object*)frame->curChild)->pMembers;
+            while (node)
             {
-                return node;
-            }
-            node = node->pNext;
-            c++;
+                if (node->name.len == nameLen &&
+                    strneql(node->name.u, nameBegin, nameLen))
+                {
+                    return stack_materialize(parentStack, node) ? node : NULL;
+                }
+                node = node->pNext;
+            }
+        }
+
+        MAX_COUNT = list->valueCount;
+        node = list->pValues;
+    }
+    else if (parentNode->type == MUSTACHE_PARAM_OBJECT) {
+        mustache_param_object* obj = (mustache_param_object*)parentNode;
+        node = obj->pMembers;
+        MAX_COUNT = UINT32_MAX;
+    }
+    else {
+#ifndef NDEBUG
+        assert(00 && "get_frame_parameter: PARENT STACK IS CORRUPTED.");
+#endif
+        return NULL;
+    }
+
+    uint32_t c = 0;
+    while (node&&c<MAX_COUNT)
+    {
+        if (node->name.len == nameLen &&
+            strneql(node->name.u, nameBegin, nameLen))
+        {
+            return stack_materialize(parentStack, node) ? node : NULL;
+        }
+        node = node->pNext;
+        c++;
+    }
+    return NULL;
+}
+
+/* depthOut receives the index of the frame the parameter was found in, or -1 if it came from the global params. */
+static mustache_param* get_parameter(const uint8_t* nameBegin, const uint8_t* nameEnd, mustache_param* globalParams, parent_stack* parentStack, int32_t* depthOut)
+{
+    /* TRAVERSE PARENT STACK */
+    uint16_t nameLen = nameEnd - nameBegin;
+    int32_t i;
+    for (i = parentStack->count-1; i >= 0; i--) {
+        scoped_structure* structNode = ((scoped_structure**)parentStack->buf.u)[i];
+        mustache_param* node = get_frame_parameter(parentStack, structNode, nameBegin, nameLen);
+        if (node) {
+            if (depthOut)
+                *depthOut = i;
+            return node;
         }
     }
 
+    if (depthOut)
+        *depthOut = -1;
+
     /* TRAVERSE GLOBAL PARAMS */
     while (globalParams) {
         if (globalParams->name.len == nameLen &&
             strneql(globalParams->name.u, nameBegin, nameLen))
         {
-            return globalParams;
+            return stack_materialize(parentStack, globalParams) ? globalParams : NULL;
         }
 
         globalParams = globalParams->pNext;
@@ -1320,7 +2482,7 @@ static mustache_param* get_child_param(uint8_t* nameBegin, uint8_t nameLen, must
     while (node && ni < MAX_COUNT)
     {
         if (node->name.len == nameLen && strneql(node->name.u, nameBegin, nameLen)) {
-            return node;
+            return JSON_materialize(node) ? NULL : node;
         }
         node = node->pNext;
         ni++;
@@ -1328,172 +2490,1090 @@ static mustache_param* get_child_param(uint8_t* nameBegin, uint8_t nameLen, must
     return NULL;
 }
 
-static uint8_t* write_variable(mustache_param* paramBASE, uint8_t* outputHead, uint8_t* outputEnd, bool escapeHTML)
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+-    ESCAPING     -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+typedef enum {
+    ESCAPE_MODE_NONE=0,
+    ESCAPE_MODE_HTML,
+    ESCAPE_MODE_URL,
+    ESCAPE_MODE_JS,
+    ESCAPE_MODE_JSON,
+    ESCAPE_MODE_CSV
+} ESCAPE_MODE;
+
+typedef struct {
+    const char* str;
+    uint8_t len;
+    bool hex; /*the escaped byte is appended as two hex digits*/
+    bool separator; /*the byte leads U+2028 or U+2029 in UTF-8, the last hex digit of the code point is appended*/
+} escape_replacement;
+
+typedef struct {
+    uint8_t lo;
+    uint8_t hi;
+} byte_range;
+
+#define ESCAPER_MAX_CHARS 8
+#define ESCAPER_MAX_RANGES 6
+
+/* the set of bytes an escaper changes is described twice: as single characters and inclusive
+   ranges for the vector kernels, and as a lookup table that also selects the replacement. */
+typedef struct {
+    uint8_t chars[ESCAPER_MAX_CHARS];
+    uint8_t charCount;
+    byte_range ranges[ESCAPER_MAX_RANGES];
+    uint8_t rangeCount;
+
+    const uint8_t* table; /*maps a byte to its index in replacements, 0 if the byte is not escaped*/
+    const escape_replacement* replacements;
+} escaper;
+
+/* each table maps a byte to its index in the escaper's replacements, 0 if the byte is not escaped */
+static const uint8_t html_escape_table[256] = {
+    ['&'] = 1, ['<'] = 2, ['>'] = 3, ['"'] = 4, ['\''] = 5
+};
+
+/* URL: 1 every byte other than A-Z a-z 0-9 - . _ ~ */
+static const uint8_t url_escape_table[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1,
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0,
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
+};
+
+/* JSON: 1 '"', 2 '\\', 3-7 \b \f \n \r \t, 8 remaining control characters */
+static const uint8_t json_escape_table[256] = {
+    8, 8, 8, 8, 8, 8, 8, 8, 3, 7, 5, 8, 4, 6, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* JS: as JSON, 8 also covers '<' '>' '&' so the string cannot close a script tag, 9 '\'',
+   10 the lead byte of U+2028 and U+2029, which end a line inside a string literal */
+static const uint8_t js_escape_table[256] = {
+    8, 8, 8, 8, 8, 8, 8, 8, 3, 7, 5, 8, 4, 6, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    0, 0, 1, 0, 0, 0, 8, 9, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 8, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const uint8_t csv_field_table[256] = {
+    [','] = 1, ['"'] = 1, ['\r'] = 1, ['\n'] = 1
+};
+
+static const uint8_t csv_quoted_table[256] = {
+    ['"'] = 1
+};
+
+static const escape_replacement html_replacements[] = {
+    { "", 0, false },
+    { "&amp;", 5, false },
+    { "&lt;", 4, false },
+    { "&gt;", 4, false },
+    { "&quot;", 6, false },
+    { "&#039;", 6, false }
+};
+
+static const escape_replacement url_replacements[] = {
+    { "", 0, false },
+    { "%", 1, true }
+};
+
+static const escape_replacement js_replacements[] = {
+    { "", 0, false },
+    { "\\\"", 2, false },
+    { "\\\\", 2, false },
+    { "\\b", 2, false },
+    { "\\f", 2, false },
+    { "\\n", 2, false },
+    { "\\r", 2, false },
+    { "\\t", 2, false },
+    { "\\u00", 4, true },
+    { "\\'", 2, false },
+    { "\\u202", 5, false, true }
+};
+
+static const escape_replacement csv_replacements[] = {
+    { "", 0, false },
+    { "\"\"", 2, false }
+};
+
+static const escaper html_escaper = {
+    .chars = { '&', '<', '>', '"', '\'' }, .charCount = 5,
+    .rangeCount = 0,
+    .table = html_escape_table, .replacements = html_replacements
+};
+
+static const escaper url_escaper = {
+    .chars = { 0x2F, 0x60 }, .charCount = 2,
+    .ranges = { { 0x00, 0x2C }, { 0x3A, 0x40 }, { 0x5B, 0x5E }, { 0x7B, 0x7D }, { 0x7F, 0xFF } }, .rangeCount = 5,
+    .table = url_escape_table, .replacements = url_replacements
+};
+
+static const escaper js_escaper = {
+    .chars = { '"', '\\', '\'', '<', '>', '&', 0xE2 }, .charCount = 7,
+    .ranges = { { 0x00, 0x1F } }, .rangeCount = 1,
+    .table = js_escape_table, .replacements = js_replacements
+};
+
+static const escaper json_escaper = {
+    .chars = { '"', '\\' }, .charCount = 2,
+    .ranges = { { 0x00, 0x1F } }, .rangeCount = 1,
+    .table = json_escape_table, .replacements = js_replacements
+};
+
+/* the bytes that force a CSV field to be quoted */
+static const escaper csv_field_escaper = {
+    .chars = { ',', '"', '\r', '\n' }, .charCount = 4,
+    .rangeCount = 0,
+    .table = csv_field_table, .replacements = csv_replacements
+};
+
+/* the bytes escaped inside a quoted CSV field */
+static const escaper csv_quoted_escaper = {
+    .chars = { '"' }, .charCount = 1,
+    .rangeCount = 0,
+    .table = csv_quoted_table, .replacements = csv_replacements
+};
+
+static const escaper* get_escaper(uint8_t mode)
+{
+    switch (mode)
+    {
+    case ESCAPE_MODE_HTML:
+        return &html_escaper;
+    case ESCAPE_MODE_URL:
+        return &url_escaper;
+    case ESCAPE_MODE_JS:
+        return &js_escaper;
+    case ESCAPE_MODE_JSON:
+        return &json_escaper;
+    case ESCAPE_MODE_CSV:
+        return &csv_field_escaper;
+    default:
+        return NULL;
+    }
+}
+
+/* returns the ESCAPE_MODE named by [name, nameEnd), or -1 if it names no mode. */
+static int8_t get_escape_mode(const uint8_t* name, const uint8_t* nameEnd)
 {
-    if (paramBASE->type == MUSTACHE_PARAM_NUMBER) {
-        mustache_param_number* param = (mustache_param_number*)paramBASE;
-        outputHead = dtoa(param->value, outputHead, (size_t)(outputEnd - outputHead),
-            param->decimals, param->trimZeros);
+    static const struct {
+        const char* name;
+        uint8_t len;
+        uint8_t mode;
+    } modes[] = {
+        { "raw", 3, ESCAPE_MODE_NONE },
+        { "html", 4, ESCAPE_MODE_HTML },
+        { "url", 3, ESCAPE_MODE_URL },
+        { "js", 2, ESCAPE_MODE_JS },
+        { "json", 4, ESCAPE_MODE_JSON },
+        { "csv", 3, ESCAPE_MODE_CSV }
+    };
+
+    uint32_t i;
+    for (i = 0; i < array_count(modes); ++i) {
+        if (nameEnd - name == modes[i].len && strneql((const char*)name, modes[i].name, modes[i].len)) {
+            return modes[i].mode;
+        }
     }
-    else if (paramBASE->type == MUSTACHE_PARAM_BOOLEAN) {
-        mustache_param_boolean* param = (mustache_param_boolean*)paramBASE;
-        if (param->value) {
-            uint8_t dist = min((int8_t)strlen("true"), outputEnd - outputHead);
-            memcpy(outputHead, "true", dist);
-            outputHead += dist;
+    return -1;
+}
+
+typedef const uint8_t* (*escape_find_fn)(const escaper* esc, const uint8_t* cur, const uint8_t* end);
+
+/* returns the first byte in [cur, end) that the escaper changes, or end. */
+static const uint8_t* escape_find_scalar(const escaper* esc, const uint8_t* cur, const uint8_t* end)
+{
+    const uint8_t* table = esc->table;
+    while (cur < end && !table[*cur]) {
+        cur++;
+    }
+    return cur;
+}
+
+#if defined(MUSTACHE_SSE2)
+
+static uint32_t u32_ctz(uint32_t v) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return i;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+/* a byte lies within a range if (byte - lo) saturates to 0 once (hi - lo) is subtracted */
+static const uint8_t* escape_find_sse2(const escaper* esc, const uint8_t* cur, const uint8_t* end)
+{
+    __m128i chars[ESCAPER_MAX_CHARS];
+    __m128i lo[ESCAPER_MAX_RANGES];
+    __m128i width[ESCAPER_MAX_RANGES];
+    const __m128i zero = _mm_setzero_si128();
+
+    uint8_t i;
+    for (i = 0; i < esc->charCount; ++i) {
+        chars[i] = _mm_set1_epi8((char)esc->chars[i]);
+    }
+    for (i = 0; i < esc->rangeCount; ++i) {
+        lo[i] = _mm_set1_epi8((char)esc->ranges[i].lo);
+        width[i] = _mm_set1_epi8((char)(esc->ranges[i].hi - esc->ranges[i].lo));
+    }
+
+    while (end - cur >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)cur);
+        __m128i m = zero;
+        for (i = 0; i < esc->charCount; ++i) {
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, chars[i]));
         }
-        else {
-            uint8_t dist = min((int8_t)strlen("false"), outputEnd - outputHead);
-            memcpy(outputHead, "false", dist);
-            outputHead += dist;
+        for (i = 0; i < esc->rangeCount; ++i) {
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(v, lo[i]), width[i]), zero));
+        }
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(m);
+        if (mask) {
+            return cur + u32_ctz(mask);
         }
+        cur += 16;
     }
-    else if (paramBASE->type == MUSTACHE_PARAM_STRING) {
-        mustache_param_string* param = (mustache_param_string*)paramBASE;
+    return escape_find_scalar(esc, cur, end);
+}
 
-        uint32_t distToEnd = outputEnd - outputHead;
+#if defined(MUSTACHE_AVX2)
 
-        if (escapeHTML) {
-            /*
-                '&': '&amp;',
-                '<': '&lt;',
-                '>': '&gt;',
-                '"': '&quot;',
-                "'": '&#039;'
-            */
-            uint8_t* cur = param->str.u;
-            uint8_t* end = param->str.u + param->str.len;
-            while (cur<end && outputHead < outputEnd)
-            {
-                if (*cur == '&') {
-                    uint8_t dist = min(outputEnd - outputHead, strlen("&amp;"));
-                    memcpy(outputHead, "&amp;", dist);
-                    outputHead += dist;
-                }
-                else if (*cur == '<') {
-                    uint8_t dist = min(outputEnd - outputHead, strlen("&lt;"));
-                    memcpy(outputHead, "&lt;", dist);
-                    outputHead += dist;
-                }
-                else if (*cur == '>') {
-                    uint8_t dist = min(outputEnd - outputHead, strlen("&gt;"));
-                    memcpy(outputHead, "&gt;", dist);
-                    outputHead += dist;
-                }
-                else if (*cur == '"') {
-                    uint8_t dist = min(outputEnd - outputHead, strlen("&quot;"));
-                    memcpy(outputHead, "&quot;", dist);
-                    outputHead += dist;
-                }
-                else if (*cur == '\'') {
-                    uint8_t dist = min(outputEnd - outputHead, strlen("&#039;"));
-                    memcpy(outputHead, "&#039;", dist);
-                    outputHead += dist;
-                }
-                else {
-                    *outputHead = *cur;
-                    outputHead++;
-                }
-                cur++;
-            }
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+static const uint8_t* escape_find_avx2(const escaper* esc, const uint8_t* cur, const uint8_t* end)
+{
+    __m256i chars[ESCAPER_MAX_CHARS];
+    __m256i lo[ESCAPER_MAX_RANGES];
+    __m256i width[ESCAPER_MAX_RANGES];
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint8_t i;
+    for (i = 0; i < esc->charCount; ++i) {
+        chars[i] = _mm256_set1_epi8((char)esc->chars[i]);
+    }
+    for (i = 0; i < esc->rangeCount; ++i) {
+        lo[i] = _mm256_set1_epi8((char)esc->ranges[i].lo);
+        width[i] = _mm256_set1_epi8((char)(esc->ranges[i].hi - esc->ranges[i].lo));
+    }
+
+    while (end - cur >= 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)cur);
+        __m256i m = zero;
+        for (i = 0; i < esc->charCount; ++i) {
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, chars[i]));
         }
-        else {
-            uint32_t dist = min(distToEnd, param->str.len);
-            memcpy(outputHead, param->str.u, dist);
-            outputHead += dist;
+        for (i = 0; i < esc->rangeCount; ++i) {
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_sub_epi8(v, lo[i]), width[i]), zero));
+        }
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(m);
+        if (mask) {
+            return cur + u32_ctz(mask);
         }
+        cur += 32;
     }
-   
-    return outputHead;
+    return escape_find_sse2(esc, cur, end);
 }
 
-static uint8_t is_parent(mustache_param* param) {
-    if (param->type == MUSTACHE_PARAM_LIST || param->type == MUSTACHE_PARAM_OBJECT) {
-        return true;
+static bool cpu_has_avx2(void)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
     }
-    return false;
+    __cpuid(info, 1);
+    /* OSXSAVE & AVX, then check the OS saves the YMM registers */
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+        return false;
+    }
+    if ((_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
 }
 
+#endif /* MUSTACHE_AVX2 */
+#endif /* MUSTACHE_SSE2 */
 
-static uint8_t* get_mustache_close(uint8_t* inputHead, uint8_t* inputEnd) {
-    while (inputHead < inputEnd)
+/* the widest kernel the build targets, simd_select swaps in AVX2 while the program loads */
+#if defined(MUSTACHE_SSE2)
+static escape_find_fn escape_find = escape_find_sse2;
+#else
+static escape_find_fn escape_find = escape_find_scalar;
+#endif
+
+/* the line and paragraph separators U+2028 and U+2029 in UTF-8 */
+static bool is_line_separator(const uint8_t* cur, const uint8_t* end)
+{
+    return end - cur >= 3 && cur[0] == 0xE2 && cur[1] == 0x80 && (cur[2] == 0xA8 || cur[2] == 0xA9);
+}
+
+/* writes the escaped form of a string and returns the updated write head.
+   Runs of bytes that need no escaping are copied in bulk, if a replacement does not fit
+   in the output it is dropped entirely rather than written partially. */
+static uint8_t* write_escaped(const escaper* esc, const uint8_t* cur, const uint8_t* end, uint8_t* outputHead, uint8_t* outputEnd)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    while (cur < end)
     {
-        if (is_mustache_close(inputHead)) {
-            return inputHead;
+        const uint8_t* next = escape_find(esc, cur, end);
+
+        size_t run = min((size_t)(next - cur), (size_t)(outputEnd - outputHead));
+        memcpy(outputHead, cur, run);
+        outputHead += run;
+        if (cur + run != next || next == end) {
+            break;
         }
-        inputHead++;
+
+        const escape_replacement* r = &esc->replacements[esc->table[*next]];
+        if (r->separator && !is_line_separator(next, end)) {
+            /* any other character with the same lead byte is copied */
+            if (outputHead == outputEnd) {
+                break;
+            }
+            *outputHead++ = *next;
+            cur = next + 1;
+            continue;
+        }
+        if (r->len + (r->hex ? 2 : 0) + (r->separator ? 1 : 0) > outputEnd - outputHead) {
+            break;
+        }
+        memcpy(outputHead, r->str, r->len);
+        outputHead += r->len;
+        if (r->hex) {
+            outputHead[0] = hex[*next >> 4];
+            outputHead[1] = hex[*next & 0xF];
+            outputHead += 2;
+        }
+        if (r->separator) {
+            *outputHead++ = next[2] == 0xA8 ? '8' : '9';
+            cur = next + 3;
+            continue;
+        }
+        cur = next + 1;
     }
-    return NULL;
+    return outputHead;
 }
 
-static uint8_t* get_scoped_interior_end(uint8_t* interiorFirst, uint8_t* end)
+/* writes a string in the given ESCAPE_MODE and returns the updated write head. */
+static uint8_t* write_escaped_mode(uint8_t mode, const uint8_t* cur, const uint8_t* end, uint8_t* outputHead, uint8_t* outputEnd)
 {
-    uint32_t no = 1;
-    while (interiorFirst <end)
-    {
-        uint8_t prefix = *(interiorFirst + 2);
-        if (is_mustache_open(interiorFirst) && (prefix=='#' || prefix=='^')) {
-            no++;
-            interiorFirst += 2;
+    const escaper* esc = get_escaper(mode);
+    if (!esc) {
+        size_t dist = min((size_t)(end - cur), (size_t)(outputEnd - outputHead));
+        memcpy(outputHead, cur, dist);
+        return outputHead + dist;
+    }
+
+    if (esc == &csv_field_escaper) {
+        if (escape_find(esc, cur, end) == end) {
+            return write_escaped(esc, cur, end, outputHead, outputEnd);
         }
-        else if (is_mustache_open(interiorFirst) && prefix=='/') {
-            no--;
-            if (no == 0) {
-                return interiorFirst;
-            }
+        /* a quoted field is only written if both of its quotes fit */
+        if (outputEnd - outputHead < 2) {
+            return outputHead;
         }
+        *outputHead++ = '"';
+        outputHead = write_escaped(&csv_quoted_escaper, cur, end, outputHead, outputEnd - 1);
+        *outputHead++ = '"';
+        return outputHead;
+    }
 
-        interiorFirst++;
+    return write_escaped(esc, cur, end, outputHead, outputEnd);
+}
+
+/* returns the length of the escaped form of a string */
+static size_t escaped_len(const escaper* esc, const uint8_t* cur, const uint8_t* end)
+{
+    size_t len = end - cur;
+    while ((cur = escape_find(esc, cur, end)) < end) {
+        const escape_replacement* r = &esc->replacements[esc->table[*cur]];
+        if (r->separator) {
+            if (is_line_separator(cur, end)) {
+                len += r->len + 1 - 3;
+                cur += 3;
+            }
+            else {
+                cur++;
+            }
+            continue;
+        }
+        len += r->len + (r->hex ? 2 : 0) - 1;
+        cur++;
     }
-    return NULL;
+    return len;
 }
 
-static bool is_truthy(mustache_param* p)
+static uint8_t get_escape_state(const uint8_t* str, size_t len)
 {
-    if (p == NULL) {
-        return false;
+    return escape_find(&html_escaper, str, str + len) == str + len ? MUSTACHE_ESCAPE_CLEAN : MUSTACHE_ESCAPE_DIRTY;
+}
+
+/* returns a slice that can be written verbatim as the escaped form of a string param,
+   or a NULL slice if the param must be escaped while it is written. */
+static mustache_slice get_escaped_string(mustache_parser* parser, mustache_param_string* param)
+{
+    if (param->escapeState == MUSTACHE_ESCAPE_UNKNOWN) {
+        param->escapeState = get_escape_state(param->str.u, param->str.len);
     }
-    if (p->type == MUSTACHE_PARAM_STRING) {
-        mustache_param_string* param = (mustache_param_string*)p;
-        if (param->str.len > 0) {
-            return true;
-        } else {
-            return false;
+    if (param->escapeState == MUSTACHE_ESCAPE_CLEAN) {
+        return param->str;
+    }
+    if (param->escaped.u || !param->cacheEscaped) {
+        return param->escaped;
+    }
+
+    const uint8_t* end = param->str.u + param->str.len;
+    size_t len = escaped_len(&html_escaper, param->str.u, end);
+    uint8_t* escaped = parser->alloc(parser, len);
+    if (!escaped) {
+        return param->escaped; /* fall back to escaping while writing */
+    }
+    write_escaped(&html_escaper, param->str.u, end, escaped, escaped + len);
+    param->escaped = (mustache_slice){ escaped, len };
+    return param->escaped;
+}
+
+/* returns the value of 4 hex digits, or -1 if any of them is not a hex digit */
+static int32_t parse_hex4(const uint8_t* cur)
+{
+    int32_t value = 0;
+    uint32_t i;
+    for (i = 0; i < 4; ++i) {
+        uint8_t c = cur[i];
+        int32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        }
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+            digit = (c | 0x20) - 'a' + 10;
         }
+        else {
+            return -1;
+        }
+        value = (value << 4) | digit;
     }
-    else if (p->type == MUSTACHE_PARAM_BOOLEAN) {
-        mustache_param_boolean* param = (mustache_param_boolean*)p;
-        return param->value;
+    return value;
+}
+
+static uint8_t* write_utf8(uint32_t codepoint, uint8_t* out)
+{
+    if (codepoint < 0x80) {
+        *out++ = (uint8_t)codepoint;
     }
-    else if (p->type == MUSTACHE_PARAM_NUMBER) {
-        mustache_param_number* param = (mustache_param_number*)p;
-        return (bool)param->value;
+    else if (codepoint < 0x800) {
+        *out++ = (uint8_t)(0xC0 | (codepoint >> 6));
+        *out++ = (uint8_t)(0x80 | (codepoint & 0x3F));
     }
-    else if (p->type == MUSTACHE_PARAM_LIST) {
-        mustache_param_list* param = (mustache_param_list*)p;
-        return param->valueCount;
+    else if (codepoint < 0x10000) {
+        *out++ = (uint8_t)(0xE0 | (codepoint >> 12));
+        *out++ = (uint8_t)(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = (uint8_t)(0x80 | (codepoint & 0x3F));
     }
-    if (p) {
-        return true;
+    else {
+        *out++ = (uint8_t)(0xF0 | (codepoint >> 18));
+        *out++ = (uint8_t)(0x80 | ((codepoint >> 12) & 0x3F));
+        *out++ = (uint8_t)(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = (uint8_t)(0x80 | (codepoint & 0x3F));
     }
-    return false;
+    return out;
 }
 
-static uint8_t source_to_structured(mustache_parser* parser, structure* structureRoot, uint8_t* inputFirst, uint8_t* inputHead, uint8_t* inputEnd)
+/* decodes the backslash escapes of JSON string contents into out and returns the end of the decoded
+   string, which is never longer than the source. An unpaired surrogate becomes U+FFFD and a malformed
+   escape is copied as is. */
+static uint8_t* JSON_decode_string(const uint8_t* cur, const uint8_t* end, uint8_t* out)
 {
-    structure* last_struct = structureRoot;
-    while (inputHead<inputEnd)
+    while (cur < end)
     {
-        if (is_mustache_open(inputHead))
+        const uint8_t* backslash = memchr(cur, '\\', end - cur);
+        if (!backslash) {
+            backslash = end;
+        }
+        memcpy(out, cur, backslash - cur);
+        out += backslash - cur;
+        cur = backslash;
+        if (cur == end) {
+            break;
+        }
+        if (end - cur < 2) {
+            *out++ = *cur++;
+            break;
+        }
+
+        switch (cur[1])
         {
-            uint8_t precedingStacheLen=2;
-            uint8_t* first = inputHead+2;
+        case '"': case '\\': case '/':
+            *out++ = cur[1];
+            cur += 2;
+            continue;
+        case 'b':
+            *out++ = '\b';
+            cur += 2;
+            continue;
+        case 'f':
+            *out++ = '\f';
+            cur += 2;
+            continue;
+        case 'n':
+            *out++ = '\n';
+            cur += 2;
+            continue;
+        case 'r':
+            *out++ = '\r';
+            cur += 2;
+            continue;
+        case 't':
+            *out++ = '\t';
+            cur += 2;
+            continue;
+        case 'u':
+            break;
+        default:
+            *out++ = *cur++;
+            continue;
+        }
+
+        int32_t unit = end - cur >= 6 ? parse_hex4(cur + 2) : -1;
+        if (unit < 0) {
+            *out++ = *cur++;
+            continue;
+        }
+        cur += 6;
+
+        uint32_t codepoint = (uint32_t)unit;
+        if (unit >= 0xD800 && unit <= 0xDFFF) {
+            codepoint = 0xFFFD;
+            if (unit <= 0xDBFF && end - cur >= 6 && cur[0] == '\\' && cur[1] == 'u') {
+                int32_t low = parse_hex4(cur + 2);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    codepoint = 0x10000 + (((uint32_t)unit - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                    cur += 6;
+                }
+            }
+        }
+        out = write_utf8(codepoint, out);
+    }
+    return out;
+}
+
+#define JSON_DECODE_SCRATCH 1024
+
+/* writes a string param whose str still holds JSON escapes. It is decoded into a scratch buffer, on
+   the stack unless the string is long, and then written like any other string. The cached HTML form
+   is only copied if all of it fits, cutting it could split an entity. */
+static uint8_t* write_json_string(mustache_parser* parser, mustache_param_string* param, uint8_t* outputHead, uint8_t* outputEnd, uint8_t escapeMode)
+{
+    size_t distToEnd = outputEnd - outputHead;
+    if (escapeMode == ESCAPE_MODE_HTML && param->escaped.u && param->escaped.len <= distToEnd) {
+        memcpy(outputHead, param->escaped.u, param->escaped.len);
+        return outputHead + param->escaped.len;
+    }
+
+    uint8_t stackScratch[JSON_DECODE_SCRATCH];
+    uint8_t* scratch = stackScratch;
+    if (param->str.len > sizeof(stackScratch)) {
+        scratch = parser->alloc(parser, param->str.len);
+        if (!scratch) {
+            return outputHead;
+        }
+    }
+    uint8_t* decodedEnd = JSON_decode_string(param->str.u, param->str.u + param->str.len, scratch);
+
+    if (escapeMode == ESCAPE_MODE_HTML && param->cacheEscaped && !param->escaped.u) {
+        size_t len = escaped_len(&html_escaper, scratch, decodedEnd);
+        uint8_t* escaped = parser->alloc(parser, len);
+        if (escaped) {
+            write_escaped(&html_escaper, scratch, decodedEnd, escaped, escaped + len);
+            param->escaped = (mustache_slice){ escaped, len };
+        }
+    }
+    if (escapeMode == ESCAPE_MODE_HTML && param->escaped.u && param->escaped.len <= distToEnd) {
+        memcpy(outputHead, param->escaped.u, param->escaped.len);
+        outputHead += param->escaped.len;
+    }
+    else {
+        outputHead = write_escaped_mode(escapeMode, scratch, decodedEnd, outputHead, outputEnd);
+    }
+
+    if (scratch != stackScratch) {
+        parser->free(parser, scratch);
+    }
+    return outputHead;
+}
+
+/* writes the numeral a number param was parsed from */
+static uint8_t* write_numeral(mustache_const_slice numeral, uint8_t* outputHead, uint8_t* outputEnd)
+{
+    size_t dist = min((size_t)numeral.len, (size_t)(outputEnd - outputHead));
+    memcpy(outputHead, numeral.u, dist);
+    return outputHead + dist;
+}
+
+static uint8_t* write_variable(mustache_parser* parser, mustache_param* paramBASE, uint8_t* outputHead, uint8_t* outputEnd, uint8_t escapeMode)
+{
+    if (paramBASE->type == MUSTACHE_PARAM_NUMBER) {
+        mustache_param_number* param = (mustache_param_number*)paramBASE;
+        if (param->numeral.u) {
+            outputHead = write_numeral(param->numeral, outputHead, outputEnd);
+        }
+        else {
+            outputHead = dtoa(param->value, outputHead, (size_t)(outputEnd - outputHead),
+                param->decimals, param->trimZeros);
+        }
+    }
+    else if (paramBASE->type == MUSTACHE_PARAM_INT64) {
+        mustache_param_int64* param = (mustache_param_int64*)paramBASE;
+        if (param->numeral.u) {
+            outputHead = write_numeral(param->numeral, outputHead, outputEnd);
+        }
+        else {
+            outputHead = i64toa(param->value, outputHead, (size_t)(outputEnd - outputHead));
+        }
+    }
+    else if (paramBASE->type == MUSTACHE_PARAM_DECIMAL) {
+        mustache_param_decimal* param = (mustache_param_decimal*)paramBASE;
+        if (param->numeral.u) {
+            outputHead = write_numeral(param->numeral, outputHead, outputEnd);
+        }
+        else {
+            outputHead = decimaltoa(param->units, param->scale, outputHead, (size_t)(outputEnd - outputHead));
+        }
+    }
+    else if (paramBASE->type == MUSTACHE_PARAM_BOOLEAN) {
+        mustache_param_boolean* param = (mustache_param_boolean*)paramBASE;
+        if (param->value) {
+            uint8_t dist = min((int8_t)strlen("true"), outputEnd - outputHead);
+            memcpy(outputHead, "true", dist);
+            outputHead += dist;
+        }
+        else {
+            uint8_t dist = min((int8_t)strlen("false"), outputEnd - outputHead);
+            memcpy(outputHead, "false", dist);
+            outputHead += dist;
+        }
+    }
+    else if (paramBASE->type == MUSTACHE_PARAM_STRING) {
+        mustache_param_string* param = (mustache_param_string*)paramBASE;
+
+        /* most JSON strings have no escapes, once that is known they are written as they are */
+        if (param->encoding == MUSTACHE_ENCODING_JSON && (param->str.len == 0 || !memchr(param->str.u, '\\', param->str.len))) {
+            param->encoding = MUSTACHE_ENCODING_NONE;
+        }
+
+        uint32_t distToEnd = outputEnd - outputHead;
+
+        if (param->encoding == MUSTACHE_ENCODING_JSON) {
+            outputHead = write_json_string(parser, param, outputHead, outputEnd, escapeMode);
+        }
+        else if (escapeMode == ESCAPE_MODE_HTML) {
+            /* the cached form is only copied if all of it fits, cutting it could split an entity */
+            mustache_slice escaped = get_escaped_string(parser, param);
+            if (escaped.u && escaped.len <= distToEnd) {
+                memcpy(outputHead, escaped.u, escaped.len);
+                outputHead += escaped.len;
+            }
+            else {
+                outputHead = write_escaped(&html_escaper, param->str.u, param->str.u + param->str.len, outputHead, outputEnd);
+            }
+        }
+        else if (escapeMode != ESCAPE_MODE_NONE) {
+            outputHead = write_escaped_mode(escapeMode, param->str.u, param->str.u + param->str.len, outputHead, outputEnd);
+        }
+        else {
+            uint32_t dist = min(distToEnd, param->str.len);
+            memcpy(outputHead, param->str.u, dist);
+            outputHead += dist;
+        }
+    }
+   
+    return outputHead;
+}
+
+/* the most bytes an escape mode writes for one byte of a string, "&quot;" or "\\u00XX" */
+#define ESCAPE_MAX_GROWTH 6
+
+/* an upper bound of what write_variable writes for a param, a quoted CSV field adds its two quotes */
+static size_t get_variable_max_len(mustache_param* paramBASE, uint8_t escapeMode)
+{
+    switch (paramBASE->type)
+    {
+    case MUSTACHE_PARAM_NUMBER: {
+        mustache_param_number* param = (mustache_param_number*)paramBASE;
+        return param->numeral.u ? param->numeral.len : DTOA_BUFFER_SIZE;
+    }
+    case MUSTACHE_PARAM_INT64: {
+        mustache_param_int64* param = (mustache_param_int64*)paramBASE;
+        return param->numeral.u ? param->numeral.len : DTOA_BUFFER_SIZE;
+    }
+    case MUSTACHE_PARAM_DECIMAL: {
+        mustache_param_decimal* param = (mustache_param_decimal*)paramBASE;
+        return param->numeral.u ? param->numeral.len : DTOA_BUFFER_SIZE;
+    }
+    case MUSTACHE_PARAM_BOOLEAN:
+        return strlen("false");
+    case MUSTACHE_PARAM_STRING: {
+        mustache_param_string* param = (mustache_param_string*)paramBASE;
+        return escapeMode == ESCAPE_MODE_NONE ? param->str.len : param->str.len * ESCAPE_MAX_GROWTH + 2;
+    }
+    default:
+        return 0;
+    }
+}
+
+static uint8_t is_parent(mustache_param* param) {
+    if (param->type == MUSTACHE_PARAM_LIST || param->type == MUSTACHE_PARAM_OBJECT) {
+        return true;
+    }
+    return false;
+}
+
+
+static uint8_t* get_mustache_close(uint8_t* inputHead, uint8_t* inputEnd) {
+    while (inputHead + 1 < inputEnd)
+    {
+        if (is_mustache_close(inputHead)) {
+            return inputHead;
+        }
+        inputHead++;
+    }
+    return NULL;
+}
+
+/* searches for the close of a section from *cursor with *depth sections open, up to end. Returns NULL
+   if it is not found before end, *cursor and *depth are then left where a later search can go on. */
+static uint8_t* scan_scoped_interior_end(uint8_t** cursor, uint32_t* depth, uint8_t* end)
+{
+    uint8_t* interiorFirst = *cursor;
+    uint32_t no = *depth;
+    /* a tag is at least its "{{" and prefix, the source may end right after the last byte */
+    while (interiorFirst + 2 < end)
+    {
+        uint8_t prefix = *(interiorFirst + 2);
+        if (is_mustache_open(interiorFirst) && (prefix=='#' || prefix=='^')) {
+            no++;
+            interiorFirst += 2;
+        }
+        else if (is_mustache_open(interiorFirst) && prefix=='/') {
+            no--;
+            if (no == 0) {
+                return interiorFirst;
+            }
+        }
+
+        interiorFirst++;
+    }
+    *cursor = interiorFirst;
+    *depth = no;
+    return NULL;
+}
+
+static uint8_t* get_scoped_interior_end(uint8_t* interiorFirst, uint8_t* end)
+{
+    uint32_t no = 1;
+    return scan_scoped_interior_end(&interiorFirst, &no, end);
+}
+
+/* a section whose close has not been read yet, see compile_state */
+typedef struct {
+    scoped_structure* section;
+    uint32_t scanned;   /*the offset the search for its close goes on from*/
+    uint32_t depth;
+} pending_section;
+
+/* what the compile of a source that arrives in windows carries from one window to the next. Without
+   more to come the source is compiled as one piece, with sections closed as soon as they are read. */
+typedef struct {
+    structure* root;
+    structure* last;            /*the last structure in the chain*/
+    uint8_t defaultEscape;
+    bool windowed;              /*sections are closed by compile_close_pending, comments are cut out of the source*/
+    bool more;                  /*the source may go on past its end*/
+    uint8_t awaiting;           /*the byte a windowed compile stopped for, it goes on once one is read*/
+    uint32_t stop;              /*where a windowed compile stopped, at the first tag it could not finish*/
+
+    pending_section* pending;
+    uint32_t pendingCount;
+    uint32_t pendingCapacity;
+} compile_state;
+
+/* the offset past the bytes a render skips for a structure, a later cut must not start before it */
+static uint32_t get_structure_skip_end(const structure* mstruct)
+{
+    if (mstruct->type == STRUCTURE_TYPE_SKIP_RANGE) {
+        return ((const skip_range_structure*)mstruct)->skipLast + 1;
+    }
+    uint32_t skipEnd = mstruct->contentsEnd + 2;
+    switch (mstruct->type)
+    {
+    case STRUCTURE_TYPE_ELSE: case STRUCTURE_TYPE_CLOSE: case STRUCTURE_TYPE_COMMENT:
+    case STRUCTURE_TYPE_SCOPED_POUND: case STRUCTURE_TYPE_SCOPED_CARET:
+        if (mstruct->standalone && mstruct->standalone->lineEnd + 1 > skipEnd) {
+            skipEnd = mstruct->standalone->lineEnd + 1;
+        }
+        break;
+    default:
+        break;
+    }
+    return skipEnd;
+}
+
+/* returns the end of the bytes a comment or pragma leaves out of every render, its own line if it stands
+   alone on it, and sets *cutFirst to their first byte. NULL if cutting them could change how the rest
+   compiles: a structure before it still reaches into them, or the bytes on either side would join into
+   a tag. first and end are the first byte after "{{" and the first '}' of "}}". */
+static uint8_t* get_comment_cut(const structure* root, const structure* last, uint8_t* inputFirst, uint8_t* first, uint8_t* end,
+    uint8_t* inputEnd, uint8_t** cutFirst)
+{
+    uint8_t* tagFirst = first - 2;
+    uint8_t* tagEnd = end + 2;
+    uint8_t* lineBegin = get_line_begin(first, inputFirst);
+    uint8_t* lineEnd = get_line_end(first, inputEnd);
+
+    uint8_t* from = tagFirst;
+    uint8_t* to = tagEnd;
+    if (is_line_standalone(lineBegin, lineEnd)) {
+        /* a standalone line can hold other section tags, the line is only cut with the comment alone on it.
+           A comment over several lines is standalone by its first line, which ends inside it. */
+        if (lineEnd < tagEnd || memchr(lineBegin, '{', tagFirst - lineBegin) || memchr(tagEnd, '{', lineEnd - tagEnd)) {
+            return NULL;
+        }
+        from = lineBegin;
+        to = lineEnd < inputEnd ? lineEnd + 1 : lineEnd;
+    }
+    else if (memchr(tagEnd, '{', get_line_end(tagEnd, inputEnd) - tagEnd)) {
+        /* without the comment a tag after it could stand alone on the line */
+        return NULL;
+    }
+
+    if (last != root && (uint32_t)(from - inputFirst) < get_structure_skip_end(last)) {
+        return NULL;
+    }
+    /* a section that does not stand alone starts its next iteration at the tag after it */
+    if ((last->type == STRUCTURE_TYPE_SCOPED_POUND || last->type == STRUCTURE_TYPE_SCOPED_CARET || last->type == STRUCTURE_TYPE_ELSE)
+        && !last->standalone) {
+        return NULL;
+    }
+    uint8_t before = from > inputFirst ? *(from - 1) : 0;
+    uint8_t after = to < inputEnd ? *to : 0;
+    if (((before == '{' || before == '/') && after == '{') || (before == '}' && after == '}')) {
+        return NULL;
+    }
+
+    *cutFirst = from;
+    return to;
+}
+
+/* adds a section to those whose close compile_close_pending looks for */
+static uint8_t compile_defer_section(mustache_parser* parser, compile_state* state, scoped_structure* section)
+{
+    if (state->pendingCount == state->pendingCapacity) {
+        uint32_t capacity = state->pendingCapacity ? state->pendingCapacity * 2 : 16;
+        pending_section* pending = parser->alloc(parser, capacity * sizeof(pending_section));
+        if (!pending) {
+            return MUSTACHE_ERR_ALLOC;
+        }
+        if (state->pending) {
+            memcpy(pending, state->pending, state->pendingCount * sizeof(pending_section));
+            parser->free(parser, state->pending);
+        }
+        state->pending = pending;
+        state->pendingCapacity = capacity;
+    }
+    state->pending[state->pendingCount++] = (pending_section){ section, section->interiorFirst, 1 };
+    return MUSTACHE_SUCCESS;
+}
+
+/* looks for the closes of the pending sections in the source up to compiledEnd, which a later cut can
+   no longer change. Without more source to come every section must have been closed. */
+static uint8_t compile_close_pending(compile_state* state, uint8_t* inputFirst, uint8_t* compiledEnd)
+{
+    uint32_t kept = 0;
+    uint32_t i;
+    for (i = 0; i < state->pendingCount; i++) {
+        pending_section* pending = &state->pending[i];
+        uint8_t* cursor = inputFirst + pending->scanned;
+        uint8_t* interiorEnd = scan_scoped_interior_end(&cursor, &pending->depth, compiledEnd);
+        if (interiorEnd) {
+            pending->section->interiorEnd = (uint32_t)(interiorEnd - inputFirst);
+            continue;
+        }
+        pending->scanned = (uint32_t)(cursor - inputFirst);
+        state->pending[kept++] = *pending;
+    }
+    state->pendingCount = kept;
+    return state->pendingCount && !state->more ? MUSTACHE_ERR_INVALID_TEMPLATE : MUSTACHE_SUCCESS;
+}
+
+static bool is_truthy(mustache_param* p)
+{
+    if (p == NULL) {
+        return false;
+    }
+    if (p->type == MUSTACHE_PARAM_STRING) {
+        mustache_param_string* param = (mustache_param_string*)p;
+        if (param->str.len > 0) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    else if (p->type == MUSTACHE_PARAM_BOOLEAN) {
+        mustache_param_boolean* param = (mustache_param_boolean*)p;
+        return param->value;
+    }
+    else if (p->type == MUSTACHE_PARAM_NUMBER) {
+        mustache_param_number* param = (mustache_param_number*)p;
+        return (bool)param->value;
+    }
+    else if (p->type == MUSTACHE_PARAM_INT64) {
+        mustache_param_int64* param = (mustache_param_int64*)p;
+        return param->value != 0;
+    }
+    else if (p->type == MUSTACHE_PARAM_DECIMAL) {
+        mustache_param_decimal* param = (mustache_param_decimal*)p;
+        return param->units != 0;
+    }
+    else if (p->type == MUSTACHE_PARAM_LIST) {
+        mustache_param_list* param = (mustache_param_list*)p;
+        return param->valueCount;
+    }
+    if (p) {
+        return true;
+    }
+    return false;
+}
+
+/* compiles the tags from inputHead on into the chain. With more of the source to come it stops at the
+   first tag that is not followed by all it needs, and a comment it can cut out moves the rest of the
+   source back over it, *inputEndOut is then moved back as well. */
+static uint8_t compile_source(mustache_parser* parser, compile_state* state, uint8_t* inputFirst, uint8_t* inputHead, uint8_t** inputEndOut)
+{
+    uint8_t* inputEnd = *inputEndOut;
+    structure* last_struct = state->last;
+    uint8_t defaultEscape = state->defaultEscape;
+    state->awaiting = 0;
+    while (inputHead<inputEnd)
+    {
+        if (state->more && inputHead + 1 == inputEnd && *inputHead == '{') {
+            state->awaiting = '{';
+            break;
+        }
+        if (inputHead + 1 < inputEnd && is_mustache_open(inputHead))
+        {
+            const bool escaped = inputHead > inputFirst && *(inputHead-1) == '/';
+            uint8_t precedingStacheLen=2;
+            uint8_t* first = inputHead+2;
             uint8_t* end = get_mustache_close(first, inputEnd);
             structure* mstruct = NULL;
+            if (!end && state->more) {
+                state->awaiting = '}';
+                break;
+            }
+            if (!end) {
+                return MUSTACHE_ERR_INVALID_TEMPLATE;
+            }
+
+            /* an escape mode prefix: {{%mode name}}, or {{%mode}} on its own to set the default */
+            int8_t escapeMode = -1;
+            bool isPragma = false;
+            if (end && *first == '%' && !escaped) {
+                uint8_t* modeFirst = first + 1;
+                uint8_t* modeEnd = modeFirst;
+                while (modeEnd < end && *modeEnd != ' ') {
+                    modeEnd++;
+                }
+                escapeMode = get_escape_mode(modeFirst, modeEnd);
+                if (escapeMode < 0) {
+                    return MUSTACHE_ERR_INVALID_TEMPLATE;
+                }
+                uint8_t* nameFirst = modeEnd;
+                while (nameFirst < end && *nameFirst == ' ') {
+                    nameFirst++;
+                }
+                if (nameFirst == end) {
+                    isPragma = true;
+                    defaultEscape = (uint8_t)escapeMode;
+                }
+                else {
+                    /* a mode only applies to a variable, not to sections, closures, comments, partials, len() or else */
+                    if (*nameFirst == '#' || *nameFirst == '^' || *nameFirst == '/' || *nameFirst == '!' || *nameFirst == '>' ||
+                        *nameFirst == '&' || *nameFirst == '%' || (end - nameFirst >= 4 && strneql((const char*)nameFirst, "len(", 4)) ||
+                        (end - nameFirst == 4 && strneql((const char*)nameFirst, "else", 4))) {
+                        return MUSTACHE_ERR_INVALID_TEMPLATE;
+                    }
+                    if (nameFirst - inputHead > UINT8_MAX) {
+                        return MUSTACHE_ERR_INVALID_TEMPLATE;
+                    }
+                    precedingStacheLen = (uint8_t)(nameFirst - inputHead);
+                    first = nameFirst;
+                }
+            }
 
+            /* standalone lines are only known once the whole line has been read */
+            if (state->more && !escaped && !memchr(end, '\n', inputEnd - end) && (isPragma || *first == '!' || *first == '/' ||
+                *first == '#' || *first == '^' || (end - first == 4 && strneql((const char*)first, "else", 4)))) {
+                state->awaiting = '\n';
+                break;
+            }
+            if (state->more && end - first >= 4 && strneql((const char*)first, "len(", 4) && !memchr(first, ')', inputEnd - first)) {
+                state->awaiting = ')';
+                break;
+            }
 
             /* handle escape case */
-            if (*(inputHead-1)=='/') {
+            if (escaped) {
                 mstruct = parser->alloc(parser, sizeof(skip_range_structure));
                 if (!mstruct) { return MUSTACHE_ERR_ALLOC; }
                 mstruct->type = STRUCTURE_TYPE_SKIP_RANGE;
@@ -1589,15 +3669,34 @@ static uint8_t source_to_structured(mustache_parser* parser, structure* structur
 
                 len_structure* asLen = (len_structure*)mstruct;
                 asLen->param = NULL;
+                asLen->cache.valid = false;
                 asLen->interiorFirst = (interiorFirst - inputFirst);
                 asLen->interiorEnd = interiorEnd - inputFirst;
 
                 inputHead = end + 2;
             }
-            /* handle comments and closures */
-            else if (*first == '/' || *first == '!')
+            /* handle comments, pragmas and closures */
+            else if (*first == '/' || *first == '!' || isPragma)
             {
-                if (*first == '/') {
+                uint8_t* cutFirst;
+                uint8_t* cutEnd = state->windowed && (*first == '!' || isPragma) ?
+                    get_comment_cut(state->root, last_struct, inputFirst, first, end, inputEnd, &cutFirst) : NULL;
+                if (cutEnd) {
+                    /* a pending search can have gone into the whitespace before a standalone comment */
+                    uint32_t cutOffset = (uint32_t)(cutFirst - inputFirst);
+                    uint32_t cutLen = (uint32_t)(cutEnd - cutFirst);
+                    uint32_t i;
+                    for (i = 0; i < state->pendingCount; i++) {
+                        if (state->pending[i].scanned > cutOffset) {
+                            state->pending[i].scanned = max(cutOffset, state->pending[i].scanned - min(cutLen, state->pending[i].scanned));
+                        }
+                    }
+                    memmove(cutFirst, cutEnd, inputEnd - cutEnd);
+                    inputEnd -= cutLen;
+                    inputHead = cutFirst;
+                    continue;
+                }
+                if (*first == '/' && !isPragma) {
                     mstruct = parser->alloc(parser, sizeof(close_structure));
                     if (!mstruct) {
                         return MUSTACHE_ERR_ALLOC;
@@ -1701,15 +3800,27 @@ static uint8_t source_to_structured(mustache_parser* parser, structure* structur
 
                 scoped_structure* asScoped = (scoped_structure*)mstruct;
                 asScoped->interiorFirst = end - inputFirst + 2;
-                uint8_t* int_end = get_scoped_interior_end(end+2,inputEnd);
+                uint8_t* int_end = state->windowed ? end + 2 : get_scoped_interior_end(end+2,inputEnd);
+                if (state->windowed && compile_defer_section(parser, state, asScoped)) {
+                    if (mstruct->standalone) {
+                        parser->free(parser, mstruct->standalone);
+                    }
+                    parser->free(parser, mstruct);
+                    return MUSTACHE_ERR_ALLOC;
+                }
                 if (!int_end) {
                     asScoped->interiorEnd = 0;
+                    if (mstruct->standalone) {
+                        parser->free(parser, mstruct->standalone);
+                    }
                     parser->free(parser, mstruct);
                     return MUSTACHE_ERR_INVALID_TEMPLATE;
                 }
                 asScoped->interiorEnd = int_end - inputFirst;
                 asScoped->close_or_else = NULL;
                 asScoped->wasEvaluated = false;
+                asScoped->renderedLastEvaluation = false;
+                asScoped->cache.valid = false;
             }
             /* handle nested templates */
             else if (*first == '>') {
@@ -1759,13 +3870,17 @@ static uint8_t source_to_structured(mustache_parser* parser, structure* structur
                 
                 var_structure* asVar = (var_structure*)mstruct;
                 asVar->standalone = NULL;
+                asVar->cache.valid = false;
 
-                if (*first == '&') {
+                if (escapeMode >= 0) {
+                    asVar->escapeMode = (uint8_t)escapeMode;
+                }
+                else if (*first == '&') {
                     first++;
-                    asVar->escapeHTML = false;
+                    asVar->escapeMode = ESCAPE_MODE_NONE;
                     precedingStacheLen = 3;
                 } else {
-                    asVar->escapeHTML = true;
+                    asVar->escapeMode = defaultEscape;
                 }
             }
 
@@ -1783,10 +3898,24 @@ static uint8_t source_to_structured(mustache_parser* parser, structure* structur
         
         inputHead++;
     }
-    
+
+    state->last = last_struct;
+    state->defaultEscape = defaultEscape;
+    state->stop = (uint32_t)(min(inputHead, inputEnd) - inputFirst);
+    *inputEndOut = inputEnd;
     return MUSTACHE_SUCCESS;
 }
 
+static uint8_t source_to_structured(mustache_parser* parser, structure* structureRoot, uint8_t* inputFirst, uint8_t* inputHead, uint8_t* inputEnd)
+{
+    compile_state state;
+    memset(&state, 0, sizeof(state));
+    state.root = structureRoot;
+    state.last = structureRoot;
+    state.defaultEscape = ESCAPE_MODE_HTML;
+    return compile_source(parser, &state, inputFirst, inputHead, &inputEnd);
+}
+
 
 static uint8_t* mwrite(uint8_t* outputHead, uint8_t* outputEnd, const uint8_t* sourceBeg, const uint8_t* sourceEnd)
 {
@@ -1802,522 +3931,3429 @@ static uint8_t* mwrite(uint8_t* outputHead, uint8_t* outputEnd, const uint8_t* s
 }
 
 
-void eval_jump(structure* mstruct, const uint8_t* m_name_first, const uint8_t* m_name_end, const uint8_t* input, uint8_t* outputEnd, uint8_t** outputHead, const uint8_t** lastNonEscaped) {
-    if (mstruct->standalone) {
-        const uint8_t* t = input + mstruct->standalone->lineBegin;
-        if (t > *lastNonEscaped) {
-            *outputHead = mwrite(*outputHead, outputEnd, *lastNonEscaped, t);
-        }
-        *lastNonEscaped = input + mstruct->standalone->lineEnd + 1;
-    }
-    else {
-        const uint8_t* t = m_name_first - 3;
-        if (t > *lastNonEscaped) {
-            *outputHead = mwrite(*outputHead, outputEnd, *lastNonEscaped, t);
-        }
-        *lastNonEscaped = m_name_end + strlen("{{");
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- -+- -+- DEFLATE -+- -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+/* A deflater compresses the output of a render as it is flushed, into one deflate block that uses the
+   fixed Huffman codes of RFC 1951. Fixed codes need no table ahead of the data, so the block is written
+   as the output comes and the literal spans mustache_compile_deflate compressed once are spliced into it
+   bit for bit. Matches are found through a hash of the next 3 bytes and a short chain of the earlier
+   positions with the same hash. Positions count up for the life of the deflater, whatever lies before
+   windowBase cannot be matched, so a new render or a spliced piece only has to move windowBase past the
+   old output instead of clearing the tables. */
+#define DEFLATE_WINDOW (32 * 1024)              /* the farthest back a match can reach */
+#define DEFLATE_WINDOW_CAPACITY (128 * 1024)    /* once full, all but the last DEFLATE_WINDOW bytes are dropped */
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_MAX_CHAIN 8
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_OUT_SIZE (32 * 1024)            /* compressed output reaches the parse callback in chunks of up to this */
+#define DEFLATE_POS_LIMIT 0xC0000000u           /* positions restart from 1 past this, the hash heads are cleared */
+
+/* literal spans of at least DEFLATE_PIECE_MIN bytes are pre-deflated in pieces of up to DEFLATE_PIECE_MAX,
+   a piece is only spliced when a literal write covers all of it */
+#define DEFLATE_PIECE_MIN 1024
+#define DEFLATE_PIECE_MAX (16 * 1024)
+
+static const uint16_t deflate_length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t deflate_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t deflate_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t deflate_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+typedef struct {
+    mustache_parser* parser;
+    void* parseCallbackUdata;
+    mustache_parse_callback parseCallback;
+
+    uint8_t format;                 /* MUSTACHE_DEFLATE_FORMAT */
+    uint32_t checksum;              /* the crc32 or adler32 of the output so far */
+    uint32_t totalIn;               /* the length of the output so far modulo 2^32, as gzip records it */
+
+    uint32_t windowBase;            /* the position of window[0] */
+    uint32_t windowLen;
+
+    uint64_t bitBuf;
+    uint32_t bitCount;
+    uint32_t outLen;
+
+    uint16_t litCode[288];          /* the fixed codes, bit reversed as deflate writes them */
+    uint8_t litBits[288];
+    uint8_t distCode[30];
+    uint8_t lengthSymbol[256];      /* a match length - DEFLATE_MIN_MATCH to its length code */
+    uint8_t distSymbol[512];        /* see deflate_dist_symbol */
+    uint32_t crcTable[256];
+
+    uint32_t head[1 << DEFLATE_HASH_BITS];  /* the last position with each hash, 0 for none */
+    uint32_t prev[DEFLATE_WINDOW];          /* the position before it with the same hash */
+    uint8_t window[DEFLATE_WINDOW_CAPACITY];
+    uint8_t out[DEFLATE_OUT_SIZE];
+} deflater;
+
+/* a literal span compressed on its own, matches only reach back within it */
+typedef struct {
+    uint32_t srcFirst;              /* the span's offset in the source */
+    uint32_t srcLen;
+    uint32_t bitsFirst;             /* the byte its codes start at in deflated_spans.bits */
+    uint32_t bitLen;
+    uint32_t crc;
+    uint32_t crcShift;              /* see crc32_shift */
+    uint32_t adler;
+} deflate_piece;
+
+/* the pre-deflated pieces of a compiled template in source order, one allocation with their bits */
+struct deflated_spans {
+    uint32_t count;
+    deflate_piece* pieces;
+    uint8_t* bits;
+};
+
+static uint32_t bit_reverse(uint32_t code, uint32_t bits)
+{
+    uint32_t reversed = 0;
+    while (bits--)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
     }
+    return reversed;
 }
 
-static uint32_t get_parent_child_count(mustache_param* parent)
+static uint32_t crc32_update(const uint32_t* table, uint32_t crc, const uint8_t* cur, size_t len)
 {
-#ifndef NDEBUG
-    if (parent->type != MUSTACHE_PARAM_OBJECT && parent->type != MUSTACHE_PARAM_LIST) {
-        assert(00 && "get_parent_child_count: parent IS NOT A VALID PARENT.");
-    }
-#endif
-    if (parent->type == MUSTACHE_PARAM_LIST) {
-        mustache_param_list* asList = (mustache_param_list*)parent;
-        return asList->valueCount;
+    crc = ~crc;
+    while (len--) {
+        crc = table[(crc ^ *cur++) & 0xFF] ^ (crc >> 8);
     }
-    else {
-        uint32_t c = 0;
-        while (parent)
-        {
-            c++;
-            parent = parent->pNext;
+    return ~crc;
+}
+
+/* a times b modulo the crc polynomial, with x^0 in the top bit as the crc keeps it */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b)
+{
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+    while (m)
+    {
+        if (a & m) {
+            p ^= b;
         }
-        return c;
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ 0xEDB88320 : b >> 1;
     }
+    return p;
 }
 
-static mustache_param* get_nth_child(mustache_param* parent, int32_t idx) 
+/* x^(8 * len) modulo the crc polynomial, the crc32 of A followed by len bytes B is
+   crc32_multmodp(crc32_shift(len), crc32(A)) ^ crc32(B) */
+static uint32_t crc32_shift(uint64_t len)
 {
-#ifndef NDEBUG
-    if (parent->type != MUSTACHE_PARAM_OBJECT && parent->type != MUSTACHE_PARAM_LIST) {
-        assert(00 && "get_nth_child: parent IS NOT A VALID PARENT.");
-    }
-#endif
-    uint32_t childCount = get_parent_child_count(parent);
-    if (idx < 0) {
-        idx = childCount +idx;
+    uint32_t p = (uint32_t)1 << 31;
+    uint32_t square = (uint32_t)1 << 30;
+    uint32_t i;
+    for (i = 0; i < 3; i++) {
+        square = crc32_multmodp(square, square);
     }
-
-    uint32_t i = 0;
-    mustache_param* child = ((mustache_param_object*)parent)->pMembers;
-    while (i!=idx && child && i < childCount)
+    while (len)
     {
-        i++;
-        child = child->pNext;
+        if (len & 1) {
+            p = crc32_multmodp(square, p);
+        }
+        square = crc32_multmodp(square, square);
+        len >>= 1;
     }
-    return child;
+    return p;
 }
 
+#define ADLER32_BASE 65521
+/* the most bytes that can be summed before the sums may overflow 32 bits */
+#define ADLER32_NMAX 5552
 
-static mustache_param* resolve_param_member(mustache_param* root, const uint8_t* strFirst, const uint8_t* strEnd)
+static uint32_t adler32_update(uint32_t adler, const uint8_t* cur, size_t len)
 {
-#ifndef NDEBUG
-    if (*strFirst != '.' && *strFirst != '[') {
-        assert(00 && "resolve_param_member: strFirst must be a string parameter chain, i.e. '.member.name'");
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (len)
+    {
+        size_t n = min(len, ADLER32_NMAX);
+        len -= n;
+        while (n--) {
+            a += *cur++;
+            b += a;
+        }
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
     }
-#endif 
+    return a | (b << 16);
+}
 
-    if (strFirst+1 == strEnd) {
-        return root;
+/* the adler32 of A followed by len bytes B from the adler32 of each */
+static uint32_t adler32_combine(uint32_t adlerA, uint32_t adlerB, uint32_t len)
+{
+    uint32_t rem = len % ADLER32_BASE;
+    uint32_t a = adlerA & 0xFFFF;
+    uint32_t b = (uint32_t)(((uint64_t)rem * a) % ADLER32_BASE);
+    a += (adlerB & 0xFFFF) + ADLER32_BASE - 1;
+    b += (adlerA >> 16) + (adlerB >> 16) + ADLER32_BASE - rem;
+    if (a >= ADLER32_BASE) {
+        a -= ADLER32_BASE;
     }
+    if (a >= ADLER32_BASE) {
+        a -= ADLER32_BASE;
+    }
+    if (b >= 2 * ADLER32_BASE) {
+        b -= 2 * ADLER32_BASE;
+    }
+    if (b >= ADLER32_BASE) {
+        b -= ADLER32_BASE;
+    }
+    return a | (b << 16);
+}
 
-    const uint8_t* cur = strFirst;
+static deflater* deflater_create(mustache_parser* parser)
+{
+    deflater* d = parser->alloc(parser, sizeof(deflater));
+    if (!d) {
+        return NULL;
+    }
+    /* the prev chains are only followed from a head, they need no clearing */
+    memset(d->head, 0, sizeof(d->head));
+    d->windowBase = 1;
+    d->windowLen = 0;
 
-    mustache_param* param = root;
-    const uint8_t* lastDot = NULL;
-    while (cur <= strEnd)
+    uint32_t sym;
+    for (sym = 0; sym < 288; sym++)
     {
-        if (*cur == '[') {
-            const uint8_t* intFirst = cur+1;
-            while (*cur != ']' || cur == strEnd) {
-                cur++;
-            }
-            /* resolve member */
-            const uint8_t* intEnd = cur;
+        if (sym < 144) {
+            d->litCode[sym] = (uint16_t)bit_reverse(0x30 + sym, 8);
+            d->litBits[sym] = 8;
+        }
+        else if (sym < 256) {
+            d->litCode[sym] = (uint16_t)bit_reverse(0x190 + sym - 144, 9);
+            d->litBits[sym] = 9;
+        }
+        else if (sym < 280) {
+            d->litCode[sym] = (uint16_t)bit_reverse(sym - 256, 7);
+            d->litBits[sym] = 7;
+        }
+        else {
+            d->litCode[sym] = (uint16_t)bit_reverse(0xC0 + sym - 280, 8);
+            d->litBits[sym] = 8;
+        }
+    }
 
-            int32_t index = strtoi32(intFirst, intEnd - intFirst, NULL);
-            mustache_param* child = get_nth_child(root, index);
-            if (!child)
-                return NULL;
-            param = child;
+    uint32_t code;
+    /* 258 falls in the range of code 27 as well, code 28 comes last and takes it */
+    for (code = 0; code < array_count(deflate_length_base); code++) {
+        uint32_t len;
+        for (len = deflate_length_base[code]; len < deflate_length_base[code] + (1u << deflate_length_extra[code]) && len <= DEFLATE_MAX_MATCH; len++) {
+            d->lengthSymbol[len - DEFLATE_MIN_MATCH] = (uint8_t)code;
         }
-        else if (*cur == '.' || cur == strEnd)
-        {    
-            if (lastDot) {
+    }
+    for (code = 0; code < array_count(deflate_dist_base); code++) {
+        uint32_t dist;
+        d->distCode[code] = (uint8_t)bit_reverse(code, 5);
+        for (dist = deflate_dist_base[code]; dist < deflate_dist_base[code] + (1u << deflate_dist_extra[code]); dist++) {
+            d->distSymbol[dist <= 256 ? dist - 1 : 256 + ((dist - 1) >> 7)] = (uint8_t)code;
+        }
+    }
 
-                const uint8_t* nameBegin = lastDot + 1;
-                const uint8_t* nameEnd = cur;
-                uint32_t nameLen = nameEnd - nameBegin;
+    uint32_t i;
+    for (i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        uint32_t bit;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        d->crcTable[i] = crc;
+    }
+    return d;
+}
 
-                uint32_t i;
-                if (param->type == MUSTACHE_PARAM_LIST) {
-                    mustache_param_list* asList = (mustache_param_list*)param;
-                    i = asList->valueCount;
-                }
-                else {
-                    i = UINT32_MAX;
-                }
+/* distances up to 256 have a symbol each, longer ones share one per 128 */
+static uint32_t deflate_dist_symbol(const deflater* d, uint32_t dist)
+{
+    return dist <= 256 ? d->distSymbol[dist - 1] : d->distSymbol[256 + ((dist - 1) >> 7)];
+}
 
-                param = ((mustache_param_list*)param)->pValues;
-                while (param && i > 0)
-                {
-                    if (nameLen == param->name.len && strneql(nameBegin, param->name.u, nameLen)) {
-                        break;
-                    }
-                    param = param->pNext;
-                    i--;
-                }
+static void deflate_deliver(deflater* d)
+{
+    if (d->outLen) {
+        d->parseCallback(d->parser, d->parseCallbackUdata, (mustache_slice){ d->out, d->outLen });
+        d->outLen = 0;
+    }
+}
 
-                if (!param) {
-                    return NULL;
-                }
-            }
-            lastDot = cur;
+/* appends up to 32 bits, first bit lowest */
+static void deflate_put(deflater* d, uint32_t bits, uint32_t count)
+{
+    d->bitBuf |= (uint64_t)bits << d->bitCount;
+    d->bitCount += count;
+    if (d->bitCount >= 32) {
+        uint8_t* out = d->out + d->outLen;
+        out[0] = (uint8_t)d->bitBuf;
+        out[1] = (uint8_t)(d->bitBuf >> 8);
+        out[2] = (uint8_t)(d->bitBuf >> 16);
+        out[3] = (uint8_t)(d->bitBuf >> 24);
+        d->outLen += 4;
+        d->bitBuf >>= 32;
+        d->bitCount -= 32;
+        if (d->outLen > DEFLATE_OUT_SIZE - 4) {
+            deflate_deliver(d);
         }
-        cur++;
     }
+}
 
-    return param;
+/* pads the last byte with zero bits and moves the whole bytes out of the bit buffer */
+static void deflate_align(deflater* d)
+{
+    deflate_put(d, 0, (8 - d->bitCount % 8) % 8);
+    while (d->bitCount)
+    {
+        if (d->outLen == DEFLATE_OUT_SIZE) {
+            deflate_deliver(d);
+        }
+        d->out[d->outLen++] = (uint8_t)d->bitBuf;
+        d->bitBuf >>= 8;
+        d->bitCount -= 8;
+    }
 }
 
-uint8_t write_structured(mustache_slice outputBuffer, uint8_t** oh, mustache_const_slice inputBuffer, uint8_t* inputEnd, structure* structureRoot, 
-                         mustache_param* globalParams, parent_stack* parentStack, mustache_parser* parser)
+static uint32_t deflate_hash(const uint8_t* cur)
 {
-    structure* mstruct = structureRoot->pNext; /* SKIP ROOT */
+    uint32_t v = (uint32_t)cur[0] | ((uint32_t)cur[1] << 8) | ((uint32_t)cur[2] << 16);
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
 
-    /* INPUT */
-    const uint8_t* inputHead = inputBuffer.u;
-    const uint8_t* input=inputBuffer.u;
+static void deflate_insert(deflater* d, uint32_t idx)
+{
+    uint32_t pos = d->windowBase + idx;
+    uint32_t h = deflate_hash(d->window + idx);
+    d->prev[pos % DEFLATE_WINDOW] = d->head[h];
+    d->head[h] = pos;
+}
 
-    /* OUTPUT */
-    uint8_t* outputHead = outputBuffer.u;
-    uint8_t* outputEnd = outputBuffer.u + outputBuffer.len;
+static void deflate_match(deflater* d, uint32_t len, uint32_t dist)
+{
+    uint32_t code = d->lengthSymbol[len - DEFLATE_MIN_MATCH];
+    uint32_t sym = 257 + code;
+    deflate_put(d, d->litCode[sym] | ((len - deflate_length_base[code]) << d->litBits[sym]), d->litBits[sym] + deflate_length_extra[code]);
+    code = deflate_dist_symbol(d, dist);
+    deflate_put(d, d->distCode[code] | ((dist - deflate_dist_base[code]) << 5), 5 + deflate_dist_extra[code]);
+}
 
-    const uint8_t* lastNonEscaped = inputHead;
-    while (mstruct)
+/* compresses window[first, end), matches may start anywhere in the window but do not run past end */
+static void deflate_compress(deflater* d, uint32_t first, uint32_t end)
+{
+    const uint8_t* window = d->window;
+    uint32_t idx = first;
+    while (idx < end)
     {
-        if (mstruct->type == STRUCTURE_TYPE_SKIP_RANGE) {
-            skip_range_structure* asSkipRange = (skip_range_structure*)mstruct;
-            const uint8_t* t = input + asSkipRange->skipFirst;
-            inputHead = t;
-            outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, inputHead);
-            t = input + asSkipRange->skipLast;
-            lastNonEscaped = t;
+        uint32_t bestLen = 0;
+        uint32_t bestDist = 0;
+
+        if (end - idx >= DEFLATE_MIN_MATCH) {
+            uint32_t pos = d->windowBase + idx;
+            uint32_t h = deflate_hash(window + idx);
+            uint32_t cand = d->head[h];
+            d->prev[pos % DEFLATE_WINDOW] = cand;
+            d->head[h] = pos;
+
+            uint32_t limit = idx > DEFLATE_WINDOW ? pos - DEFLATE_WINDOW : d->windowBase;
+            uint32_t maxLen = min(end - idx, DEFLATE_MAX_MATCH);
+            uint32_t chain = DEFLATE_MAX_CHAIN;
+            const uint8_t* cur = window + idx;
+            while (cand >= limit && cand < pos && chain--)
+            {
+                const uint8_t* earlier = window + (cand - d->windowBase);
+                /* a match can only beat the best one if it agrees on the byte past it */
+                if (earlier[bestLen] == cur[bestLen]) {
+                    uint32_t len = 0;
+                    while (len < maxLen && earlier[len] == cur[len]) {
+                        len++;
+                    }
+                    if (len > bestLen) {
+                        bestLen = len;
+                        bestDist = pos - cand;
+                        if (len == maxLen) {
+                            break;
+                        }
+                    }
+                }
+                cand = d->prev[cand % DEFLATE_WINDOW];
+            }
         }
-        else if (mstruct->type == STRUCTURE_TYPE_LEN)
-        {
-            const uint8_t* m_len_str_first = input + mstruct->contentsFirst;
-            const uint8_t* m_len_str_end = input + mstruct->contentsEnd;
-
-            len_structure* asLen = (len_structure*)mstruct;
-            const uint8_t* int_begin = input + asLen->interiorFirst;
-            const uint8_t* int_end = input + asLen->interiorEnd;
 
+        if (bestLen >= DEFLATE_MIN_MATCH) {
+            deflate_match(d, bestLen, bestDist);
+            /* the positions inside the match can start later matches too */
+            uint32_t matchEnd = idx + bestLen;
+            for (idx++; idx < matchEnd && end - idx >= DEFLATE_MIN_MATCH; idx++) {
+                deflate_insert(d, idx);
+            }
+            idx = matchEnd;
+        }
+        else {
+            deflate_put(d, d->litCode[window[idx]], d->litBits[window[idx]]);
+            idx++;
+        }
+    }
+}
 
-            outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, m_len_str_first - mstruct->precedingMustacheLen);
+/* moves windowBase past the window, nothing written so far can be matched */
+static void deflate_forget(deflater* d, uint32_t skipped)
+{
+    d->windowBase += d->windowLen + skipped;
+    d->windowLen = 0;
+    if (d->windowBase > DEFLATE_POS_LIMIT) {
+        memset(d->head, 0, sizeof(d->head));
+        d->windowBase = 1;
+    }
+}
 
+static void deflate_write(deflater* d, const uint8_t* first, size_t len)
+{
+    if (d->format == MUSTACHE_DEFLATE_GZIP) {
+        d->checksum = crc32_update(d->crcTable, d->checksum, first, len);
+    }
+    else if (d->format == MUSTACHE_DEFLATE_ZLIB) {
+        d->checksum = adler32_update(d->checksum, first, len);
+    }
+    d->totalIn += (uint32_t)len;
 
-            if (!asLen->param) {
-                mstruct->param = get_parameter(int_begin, int_end, globalParams, parentStack);
-            }
-            if (asLen->param) {
-                uint32_t cc = get_parent_child_count(mstruct->param);
-                outputHead = u32toa(cc, outputHead, (size_t)(outputEnd - outputHead));
-                lastNonEscaped = m_len_str_end + strlen("}}");
+    while (len)
+    {
+        if (d->windowLen == DEFLATE_WINDOW_CAPACITY) {
+            uint32_t dropped = DEFLATE_WINDOW_CAPACITY - DEFLATE_WINDOW;
+            memmove(d->window, d->window + dropped, DEFLATE_WINDOW);
+            d->windowBase += dropped;
+            d->windowLen = DEFLATE_WINDOW;
+            if (d->windowBase > DEFLATE_POS_LIMIT) {
+                memset(d->head, 0, sizeof(d->head));
+                d->windowBase = 1;
             }
         }
-        else if (mstruct->type == STRUCTURE_TYPE_NESTED_TEMPLATE) {
-            
-            nested_template_structure* asTemplate = (nested_template_structure*)mstruct;
-            const uint8_t* m_name_first = input + mstruct->contentsFirst+(asTemplate->precedingMustacheLen-2);
-            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+        uint32_t part = (uint32_t)min(len, (size_t)(DEFLATE_WINDOW_CAPACITY - d->windowLen));
+        memcpy(d->window + d->windowLen, first, part);
+        deflate_compress(d, d->windowLen, d->windowLen + part);
+        d->windowLen += part;
+        first += part;
+        len -= part;
+    }
+}
 
-            outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, m_name_first - mstruct->precedingMustacheLen);
-            lastNonEscaped = m_name_end + strlen("}}");
+/* starts the stream and its only block, the header is delivered with the first compressed output */
+static void deflate_begin(deflater* d, mustache_parser* parser, uint8_t format, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    d->parser = parser;
+    d->parseCallbackUdata = parseCallbackUdata;
+    d->parseCallback = parseCallback;
+    d->format = format;
+    d->checksum = format == MUSTACHE_DEFLATE_ZLIB ? 1 : 0;
+    d->totalIn = 0;
+    d->bitBuf = 0;
+    d->bitCount = 0;
+    d->outLen = 0;
+    deflate_forget(d, 0);
+
+    if (format == MUSTACHE_DEFLATE_GZIP) {
+        /* no name, no modification time, unknown OS */
+        static const uint8_t gzipHeader[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+        memcpy(d->out, gzipHeader, sizeof(gzipHeader));
+        d->outLen = sizeof(gzipHeader);
+    }
+    else if (format == MUSTACHE_DEFLATE_ZLIB) {
+        /* a 32 KB window and the fastest compression level, the pair is a multiple of 31 */
+        d->out[0] = 0x78;
+        d->out[1] = 0x01;
+        d->outLen = 2;
+    }
+    /* BFINAL, BTYPE 01 for the fixed codes */
+    deflate_put(d, 3, 3);
+}
 
-            if (!asTemplate->param) {
-                mstruct->param = (mustache_param*)get_nested_template_param(m_name_first, m_name_end, globalParams);
-                if (!mstruct->param) {
-                    goto skip_node;
-                }
-            }
+static void deflate_end(deflater* d)
+{
+    deflate_put(d, d->litCode[256], d->litBits[256]);
+    deflate_align(d);
+
+    uint8_t trailer[8];
+    uint32_t trailerLen = 0;
+    if (d->format == MUSTACHE_DEFLATE_GZIP) {
+        uint32_t i;
+        for (i = 0; i < 4; i++) {
+            trailer[i] = (uint8_t)(d->checksum >> (8 * i));
+            trailer[4 + i] = (uint8_t)(d->totalIn >> (8 * i));
+        }
+        trailerLen = 8;
+    }
+    else if (d->format == MUSTACHE_DEFLATE_ZLIB) {
+        uint32_t i;
+        for (i = 0; i < 4; i++) {
+            trailer[i] = (uint8_t)(d->checksum >> (24 - 8 * i));
+        }
+        trailerLen = 4;
+    }
+    if (d->outLen + trailerLen > DEFLATE_OUT_SIZE) {
+        deflate_deliver(d);
+    }
+    memcpy(d->out + d->outLen, trailer, trailerLen);
+    d->outLen += trailerLen;
+    deflate_deliver(d);
+}
 
-            
-            mustache_param_template* template_param = (mustache_param_template*)mstruct->param;
-            
+/* appends the codes of a pre-deflated piece, the output after it cannot match into it */
+static void deflate_splice(deflater* d, const deflated_spans* spans, const deflate_piece* piece)
+{
+    if (d->format == MUSTACHE_DEFLATE_GZIP) {
+        d->checksum = crc32_multmodp(piece->crcShift, d->checksum) ^ piece->crc;
+    }
+    else if (d->format == MUSTACHE_DEFLATE_ZLIB) {
+        d->checksum = adler32_combine(d->checksum, piece->adler, piece->srcLen);
+    }
+    d->totalIn += piece->srcLen;
+    deflate_forget(d, piece->srcLen);
 
-            mustache_stream dummy_stream = {
-                .readCallback = no_op_read_cb,
-                .seekCallback = no_op_seek_cb,
-                .udata=template_param
-            };
+    const uint8_t* bits = spans->bits + piece->bitsFirst;
+    uint32_t bitLen = piece->bitLen;
+    for (; bitLen >= 32; bitLen -= 32, bits += 4) {
+        deflate_put(d, (uint32_t)bits[0] | ((uint32_t)bits[1] << 8) | ((uint32_t)bits[2] << 16) | ((uint32_t)bits[3] << 24), 32);
+    }
+    for (; bitLen >= 8; bitLen -= 8, bits++) {
+        deflate_put(d, *bits, 8);
+    }
+    if (bitLen) {
+        deflate_put(d, *bits & ((1u << bitLen) - 1), bitLen);
+    }
+}
 
-            mustache_slice input_slice = {(uint8_t*)template_param->source.u, template_param->source.len};
-            mustache_slice output_slice = {outputHead, outputEnd-outputHead};
-            uint64_t bytesWritten=0;
+/* the first piece that starts at or after the offset, NULL if there is none */
+static const deflate_piece* deflated_find(const deflated_spans* spans, uint64_t offset)
+{
+    uint32_t lo = 0;
+    uint32_t hi = spans->count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (spans->pieces[mid].srcFirst < offset) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo < spans->count ? spans->pieces + lo : NULL;
+}
 
+/* finds the next run of literal text between tags. A standalone tag takes the rest of its line out of
+   the output, so a run is trimmed to the whole lines in it, a piece is only used if all of it is written. */
+static const uint8_t* deflate_next_span(const uint8_t* cur, const uint8_t* sourceFirst, const uint8_t* sourceEnd, const uint8_t** spanFirst, const uint8_t** spanEnd)
+{
+    const uint8_t* open = cur;
+    while (true)
+    {
+        open = memchr(open, '{', sourceEnd - open);
+        if (!open || open + 1 == sourceEnd) {
+            open = sourceEnd;
+            break;
+        }
+        if (open[1] == '{') {
+            break;
+        }
+        open++;
+    }
 
+    *spanFirst = cur;
+    *spanEnd = open;
+    if (cur != sourceFirst) {
+        const uint8_t* lineEnd = memchr(cur, '\n', open - cur);
+        *spanFirst = lineEnd ? lineEnd + 1 : open;
+    }
+    if (open != sourceEnd) {
+        while (*spanEnd > *spanFirst && (*spanEnd)[-1] != '\n') {
+            (*spanEnd)--;
+        }
+    }
 
+    if (open == sourceEnd) {
+        return sourceEnd;
+    }
+    /* past the tag, a triple mustache closes with a third brace */
+    const uint8_t* close = open + 2;
+    while (close + 1 < sourceEnd && !(close[0] == '}' && close[1] == '}')) {
+        close++;
+    }
+    if (close + 1 >= sourceEnd) {
+        return sourceEnd;
+    }
+    close += 2;
+    if (close < sourceEnd && *close == '}') {
+        close++;
+    }
+    return close;
+}
 
-            uint8_t err = mustache_parse_stream(parser, template_param->parentStackBuffer, &dummy_stream, template_param->structure, template_param->parameters, input_slice, output_slice, &bytesWritten, nested_parse_callback);
-            if (err!=MUSTACHE_SUCCESS) {
-                goto skip_node;
-            }
+static uint32_t deflate_piece_count(uint64_t spanLen)
+{
+    return spanLen < DEFLATE_PIECE_MIN ? 0 : (uint32_t)((spanLen + DEFLATE_PIECE_MAX - 1) / DEFLATE_PIECE_MAX);
+}
 
-            uint8_t* parsed_begin = outputHead;
-            outputHead+=bytesWritten;
-            uint8_t* parsed_end = outputHead;
+typedef struct {
+    mustache_parser* parser;
+    uint8_t* bytes;
+    size_t len;
+    size_t capacity;
+    bool failed;
+} deflate_blob;
+
+static void deflate_blob_append(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    deflate_blob* blob = udata;
+    if (blob->failed) {
+        return;
+    }
+    if (blob->len + parsed.len > blob->capacity) {
+        size_t capacity = max(blob->capacity * 2, blob->len + parsed.len);
+        uint8_t* grown = parser->alloc(parser, capacity);
+        if (!grown) {
+            blob->failed = true;
+            return;
+        }
+        if (blob->bytes) {
+            memcpy(grown, blob->bytes, blob->len);
+            parser->free(parser, blob->bytes);
+        }
+        blob->bytes = grown;
+        blob->capacity = capacity;
+    }
+    memcpy(blob->bytes + blob->len, parsed.u, parsed.len);
+    blob->len += parsed.len;
+}
+
+
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- -+- CONTENT HASH -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+/* A streaming XXH64 with a seed of 0, the digest matches that of any xxHash implementation over the
+   same bytes. Input is consumed in stripes of 32 bytes across four lanes, a partial stripe waits in
+   pending for the next update. */
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+typedef struct {
+    uint64_t totalLen;
+    uint64_t lanes[4];
+    uint8_t pending[32];
+    uint32_t pendingLen;
+} xxh64_state;
+
+static inline uint64_t xxh64_rotl(uint64_t v, uint32_t r)
+{
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint64_t xxh64_read64(const uint8_t* p)
+{
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+#else
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+        (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+#endif
+}
+
+static inline uint64_t xxh64_read32(const uint8_t* p)
+{
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24;
+}
+
+static inline uint64_t xxh64_round(uint64_t lane, uint64_t input)
+{
+    lane += input * XXH_PRIME64_2;
+    return xxh64_rotl(lane, 31) * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t lane)
+{
+    acc ^= xxh64_round(0, lane);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void xxh64_init(xxh64_state* state)
+{
+    state->totalLen = 0;
+    state->lanes[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+    state->lanes[1] = XXH_PRIME64_2;
+    state->lanes[2] = 0;
+    state->lanes[3] = 0 - XXH_PRIME64_1;
+    state->pendingLen = 0;
+}
+
+/* runs whole stripes through the lanes and returns the first byte past them */
+static const uint8_t* xxh64_stripes(uint64_t* lanes, const uint8_t* first, const uint8_t* end)
+{
+    uint64_t v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+    while (end - first >= 32)
+    {
+        v1 = xxh64_round(v1, xxh64_read64(first));
+        v2 = xxh64_round(v2, xxh64_read64(first + 8));
+        v3 = xxh64_round(v3, xxh64_read64(first + 16));
+        v4 = xxh64_round(v4, xxh64_read64(first + 24));
+        first += 32;
+    }
+    lanes[0] = v1; lanes[1] = v2; lanes[2] = v3; lanes[3] = v4;
+    return first;
+}
+
+static void xxh64_update(xxh64_state* state, const uint8_t* first, size_t len)
+{
+    const uint8_t* end = first + len;
+    state->totalLen += len;
+
+    if (state->pendingLen) {
+        size_t fill = min(len, (size_t)(32 - state->pendingLen));
+        memcpy(state->pending + state->pendingLen, first, fill);
+        state->pendingLen += (uint32_t)fill;
+        first += fill;
+        if (state->pendingLen < 32) {
+            return;
+        }
+        xxh64_stripes(state->lanes, state->pending, state->pending + 32);
+        state->pendingLen = 0;
+    }
+
+    first = xxh64_stripes(state->lanes, first, end);
+    memcpy(state->pending, first, (size_t)(end - first));
+    state->pendingLen = (uint32_t)(end - first);
+}
+
+static uint64_t xxh64_digest(const xxh64_state* state)
+{
+    uint64_t h;
+    if (state->totalLen >= 32) {
+        const uint64_t* lanes = state->lanes;
+        h = xxh64_rotl(lanes[0], 1) + xxh64_rotl(lanes[1], 7) + xxh64_rotl(lanes[2], 12) + xxh64_rotl(lanes[3], 18);
+        h = xxh64_merge_round(h, lanes[0]);
+        h = xxh64_merge_round(h, lanes[1]);
+        h = xxh64_merge_round(h, lanes[2]);
+        h = xxh64_merge_round(h, lanes[3]);
+    }
+    else {
+        h = XXH_PRIME64_5;
+    }
+    h += state->totalLen;
+
+    const uint8_t* p = state->pending;
+    const uint8_t* end = p + state->pendingLen;
+    for (; end - p >= 8; p += 8) {
+        h ^= xxh64_round(0, xxh64_read64(p));
+        h = xxh64_rotl(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (end - p >= 4) {
+        h ^= xxh64_read32(p) * XXH_PRIME64_1;
+        h = xxh64_rotl(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= *p * XXH_PRIME64_5;
+        h = xxh64_rotl(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- -+- RENDER OUTPUT -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+/* A render with a sink writes its output to an fd as it goes rather than handing all of it to the
+   parse callback at the end, the parse buffer only holds what was written since the last flush.
+   Values and short literal spans are copied into the parse buffer. Longer literal spans are queued
+   in place as iovecs between the buffered segments and everything queued goes out in one writev.
+   With a template fd, spans of MUSTACHE_SENDFILE_MIN_SPAN or more are sent from the template's file
+   with sendfile instead, they go from the page cache to the fd without passing through user space.
+   An aligned sink copies everything into the buffer and writes whole MUSTACHE_FD_ALIGNMENT blocks
+   from it, as O_DIRECT needs. A pipelined sink copies everything into one half of the buffer and
+   hands it to a flush thread once it fills, the render goes on in the other half meanwhile.
+   A deflate sink copies everything into the buffer and compresses it on every flush, the pre-deflated
+   pieces of a literal span are spliced in instead. A buffered sink never flushes, the whole output goes
+   to the parse callback at the end as without a sink, it is there to hash the output as it is written.
+   Only the deflate and buffered sinks are not bound to POSIX. */
+typedef enum {
+    SINK_WRITEV,
+    SINK_ALIGNED,
+    SINK_PIPELINE,
+    SINK_DEFLATE,
+    SINK_BUFFERED
+} SINK_MODE;
+
+/* a buffered sink hashes its output once this much is pending, while it is still in cache */
+#define MUSTACHE_HASH_CHUNK (16 * 1024)
+
+#ifdef MUSTACHE_PIPELINE
+/* A flusher hands the chunks of pipelined renders to their parse callback on a thread of its own.
+   Chunks pass through a single producer single consumer ring, the render advances head and the
+   thread advances tail. The semaphores count the chunks that are ready and the chunks the thread
+   is done with, a side only sleeps in them when it has to wait for the other. A render has at most
+   two chunks in flight, one per half of its buffer, so the ring never fills. */
+#define PIPELINE_SLOTS 4
+
+typedef struct {
+    uint8_t* first;             /* NULL stops the thread */
+    uint64_t len;
+    void* parseCallbackUdata;
+    mustache_parse_callback parseCallback;
+} pipeline_chunk;
+
+typedef struct {
+    mustache_parser* parser;
+    pthread_t thread;
+    sem_t ready;
+    sem_t drained;
+    uint32_t head;
+    uint32_t tail;
+    pipeline_chunk ring[PIPELINE_SLOTS];
+} pipeline;
+#endif
+
+typedef struct render_sink {
+    uint8_t* bufferFirst;       /* the start of the parse buffer, the output head restarts here after a flush */
+    uint8_t* bufferEnd;
+    uint8_t* segmentFirst;      /* the buffered output that is not queued yet runs from here up to the output head */
+    const uint8_t* source;      /* the compiled source, templateFd holds the same bytes at the same offsets */
+    uint8_t mode;               /* SINK_MODE */
+    uint8_t err;                /* the first failed write, nothing is written after it */
+    deflater* deflate;
+    const deflated_spans* deflated; /* the pre-deflated pieces of the source, NULL if it has none */
+    uint8_t* hashedEnd;         /* the buffered output from here up to the output head is not hashed yet */
+    uint64_t* digest;           /* set to the hash of the output before the parse callback is called */
+    xxh64_state hash;
+#ifdef MUSTACHE_FD_OUTPUT
+    int templateFd;
+    int outFd;
+    bool canSendfile;           /* cleared once templateFd turns out not to hold the source */
+    bool outIsPipe;             /* spans are spliced into the pipe rather than sent */
+    uint32_t iovCount;
+    size_t queuedBytes;
+    struct iovec iov[64];
+#endif
+#ifdef MUSTACHE_PIPELINE
+    pipeline* pipe;
+    uint8_t* halves[2];
+    uint64_t halfLen;
+    uint32_t half;              /* the half being filled */
+    uint32_t inFlight;          /* chunks handed to the flush thread and not drained yet */
+    void* parseCallbackUdata;
+    mustache_parse_callback parseCallback;
+#endif
+} render_sink;
+
+#ifdef MUSTACHE_FD_OUTPUT
+/* below this a span costs more as a syscall of its own than as a copy into the next write */
+#define MUSTACHE_SENDFILE_MIN_SPAN (16 * 1024)
+/* below this a span is copied next to the values around it rather than given an iovec of its own */
+#define MUSTACHE_FD_IOV_MIN_SPAN 256
+/* queued output is written once it reaches this much */
+#define MUSTACHE_FD_FLUSH_BYTES (128 * 1024)
+/* the block size of aligned writes, a multiple of the logical block size of the devices O_DIRECT is used on */
+#define MUSTACHE_FD_ALIGNMENT 4096
+
+/* a non-blocking fd is waited on rather than treated as failed */
+static bool fd_wait_writable(int fd)
+{
+    struct pollfd pfd = { fd, POLLOUT, 0 };
+    int res;
+    do {
+        res = poll(&pfd, 1, -1);
+    } while (res < 0 && errno == EINTR);
+    return res > 0 && !(pfd.revents & (POLLERR | POLLNVAL));
+}
+
+/* writes the iovecs in full, a short write resumes partway through the iovec it stopped in */
+static uint8_t fd_writev_all(int fd, struct iovec* iov, uint32_t count)
+{
+    while (count)
+    {
+        ssize_t written = writev(fd, iov, (int)count);
+        if (written > 0) {
+            size_t left = (size_t)written;
+            while (count && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count) {
+                iov->iov_base = (uint8_t*)iov->iov_base + left;
+                iov->iov_len -= left;
+            }
+        }
+        else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!fd_wait_writable(fd)) {
+                return MUSTACHE_ERR_STREAM;
+            }
+        }
+        else if (written >= 0 || errno != EINTR) {
+            return MUSTACHE_ERR_STREAM;
+        }
+    }
+    return MUSTACHE_SUCCESS;
+}
+
+static uint8_t fd_write_all(int fd, const uint8_t* first, size_t len)
+{
+    struct iovec iov = { (void*)first, len };
+    return len ? fd_writev_all(fd, &iov, 1) : MUSTACHE_SUCCESS;
+}
+
+#ifdef MUSTACHE_PIPELINE
+static void sem_wait_uninterrupted(sem_t* sem)
+{
+    while (sem_wait(sem) != 0 && errno == EINTR) {}
+}
+
+static void pipeline_push(pipeline* pipe, pipeline_chunk chunk)
+{
+    uint32_t head = __atomic_load_n(&pipe->head, __ATOMIC_RELAXED);
+    pipe->ring[head % PIPELINE_SLOTS] = chunk;
+    __atomic_store_n(&pipe->head, head + 1, __ATOMIC_RELEASE);
+    sem_post(&pipe->ready);
+}
+
+static void* pipeline_main(void* udata)
+{
+    pipeline* pipe = udata;
+    while (true)
+    {
+        sem_wait_uninterrupted(&pipe->ready);
+        uint32_t tail = pipe->tail;
+        /* pairs with the release of head, the chunk was written before it */
+        if (__atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) == tail) {
+#ifndef NDEBUG
+            assert(00 && "pipeline_main: A CHUNK WAS SIGNALED BUT THE RING IS EMPTY.");
+#endif
+            continue;
+        }
+        pipeline_chunk chunk = pipe->ring[tail % PIPELINE_SLOTS];
+        __atomic_store_n(&pipe->tail, tail + 1, __ATOMIC_RELEASE);
+        if (!chunk.first) {
+            break;
+        }
+        chunk.parseCallback(pipe->parser, chunk.parseCallbackUdata, (mustache_slice){ chunk.first, chunk.len });
+        sem_post(&pipe->drained);
+    }
+    return NULL;
+}
+
+/* hands the filled half to the flush thread and moves on to the other half once it is drained */
+static uint8_t* sink_swap_halves(render_sink* sink, uint8_t* outputHead)
+{
+    if (outputHead == sink->bufferFirst) {
+        return outputHead;
+    }
+    pipeline_push(sink->pipe, (pipeline_chunk){ sink->bufferFirst, (uint64_t)(outputHead - sink->bufferFirst), sink->parseCallbackUdata, sink->parseCallback });
+    sink->inFlight++;
+    /* chunks drain in order, the other half is free once the chunk before this one is */
+    if (sink->inFlight == 2) {
+        sem_wait_uninterrupted(&sink->pipe->drained);
+        sink->inFlight--;
+    }
+    sink->half ^= 1;
+    sink->bufferFirst = sink->halves[sink->half];
+    sink->bufferEnd = sink->bufferFirst + sink->halfLen;
+    return sink->bufferFirst;
+}
+#endif
+
+static void sink_queue(render_sink* sink, const uint8_t* first, size_t len)
+{
+    sink->iov[sink->iovCount++] = (struct iovec){ (void*)first, len };
+    sink->queuedBytes += len;
+}
+
+static void sink_queue_buffered(render_sink* sink, uint8_t* outputHead)
+{
+    if (outputHead > sink->segmentFirst) {
+        sink_queue(sink, sink->segmentFirst, (size_t)(outputHead - sink->segmentFirst));
+        sink->segmentFirst = outputHead;
+    }
+}
+#endif
+
+/* writes everything queued along with the buffered output, returns the restarted output head. An
+   aligned sink only writes whole blocks and moves what is left of the last one to the front. */
+static uint8_t* sink_flush(render_sink* sink, uint8_t* outputHead)
+{
+    if (sink->mode == SINK_DEFLATE) {
+        deflate_write(sink->deflate, sink->bufferFirst, (size_t)(outputHead - sink->bufferFirst));
+        return sink->bufferFirst;
+    }
+#ifdef MUSTACHE_PIPELINE
+    if (sink->mode == SINK_PIPELINE) {
+        return sink_swap_halves(sink, outputHead);
+    }
+#endif
+#ifdef MUSTACHE_FD_OUTPUT
+    if (sink->mode == SINK_ALIGNED) {
+        size_t buffered = (size_t)(outputHead - sink->bufferFirst);
+        size_t blocks = buffered - buffered % MUSTACHE_FD_ALIGNMENT;
+        if (!sink->err) {
+            sink->err = fd_write_all(sink->outFd, sink->bufferFirst, blocks);
+        }
+        memmove(sink->bufferFirst, sink->bufferFirst + blocks, buffered - blocks);
+        return sink->bufferFirst + (buffered - blocks);
+    }
+
+    sink_queue_buffered(sink, outputHead);
+    if (!sink->err && sink->iovCount) {
+        sink->err = fd_writev_all(sink->outFd, sink->iov, sink->iovCount);
+    }
+    sink->iovCount = 0;
+    sink->queuedBytes = 0;
+    sink->segmentFirst = sink->bufferFirst;
+#endif
+    return sink->bufferFirst;
+}
+
+/* hashes the output written since the last time, a buffered sink does it every MUSTACHE_HASH_CHUNK */
+static void sink_hash(render_sink* sink, uint8_t* outputHead)
+{
+    xxh64_update(&sink->hash, sink->hashedEnd, (size_t)(outputHead - sink->hashedEnd));
+    sink->hashedEnd = outputHead;
+}
+
+/* writes the rest of the output once the render is done, a pipelined render waits for all of it to be flushed
+   and a deflate stream is ended. A buffered sink only hashes the rest, its output goes to the parse callback. */
+static void sink_finish(render_sink* sink, uint8_t* outputHead)
+{
+    if (sink->mode == SINK_BUFFERED) {
+        sink_hash(sink, outputHead);
+        *sink->digest = xxh64_digest(&sink->hash);
+        return;
+    }
+    outputHead = sink_flush(sink, outputHead);
+#ifdef MUSTACHE_PIPELINE
+    while (sink->inFlight)
+    {
+        sem_wait_uninterrupted(&sink->pipe->drained);
+        sink->inFlight--;
+    }
+#endif
+    if (sink->mode == SINK_DEFLATE) {
+        deflate_end(sink->deflate);
+    }
+#ifdef MUSTACHE_FD_OUTPUT
+    if (sink->mode != SINK_ALIGNED || outputHead == sink->bufferFirst || sink->err) {
+        return;
+    }
+
+    /* the last block is partial, O_DIRECT is lifted for it */
+#ifdef MUSTACHE_O_DIRECT
+    int fdFlags = fcntl(sink->outFd, F_GETFL);
+    bool direct = fdFlags >= 0 && (fdFlags & MUSTACHE_O_DIRECT);
+    if (direct) {
+        fcntl(sink->outFd, F_SETFL, fdFlags & ~MUSTACHE_O_DIRECT);
+    }
+#endif
+    sink->err = fd_write_all(sink->outFd, sink->bufferFirst, (size_t)(outputHead - sink->bufferFirst));
+#ifdef MUSTACHE_O_DIRECT
+    if (direct) {
+        fcntl(sink->outFd, F_SETFL, fdFlags);
+    }
+#endif
+#endif
+}
+
+/* flushes ahead of a value once less than half of the parse buffer is left, a longer value is written by sink_write_variable */
+static uint8_t* sink_reserve(render_sink* sink, uint8_t* outputHead, uint8_t** outputEnd)
+{
+    if (sink && sink->mode == SINK_BUFFERED) {
+        if ((size_t)(outputHead - sink->hashedEnd) >= MUSTACHE_HASH_CHUNK) {
+            sink_hash(sink, outputHead);
+        }
+        return outputHead;
+    }
+    if (sink && (size_t)(*outputEnd - outputHead) < (size_t)(*outputEnd - sink->bufferFirst) / 2) {
+        outputHead = sink_flush(sink, outputHead);
+        *outputEnd = sink->bufferEnd;
+    }
+    return outputHead;
+}
+
+#ifdef MUSTACHE_SENDFILE
+static void sink_sendfile(render_sink* sink, const uint8_t* first, size_t len)
+{
+    off_t offset = (off_t)(first - sink->source);
+    while (len && sink->canSendfile && !sink->err)
+    {
+        /* a pipe takes the file's pages with splice, anything else goes through sendfile, which splices
+           through a pipe of its own */
+        ssize_t sent;
+        if (sink->outIsPipe) {
+            loff_t spliceOffset = offset;
+            sent = splice(sink->templateFd, &spliceOffset, sink->outFd, NULL, len, SPLICE_F_MOVE);
+            offset = (off_t)spliceOffset;
+        }
+        else {
+            sent = sendfile(sink->outFd, sink->templateFd, &offset, len);
+        }
+        if (sent > 0) {
+            len -= (size_t)sent;
+        }
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!fd_wait_writable(sink->outFd)) {
+                sink->err = MUSTACHE_ERR_STREAM;
+            }
+        }
+        else if (sent == 0 || errno == EINVAL || errno == ENOSYS) {
+            /* the file was truncated or the fds cannot be spliced, the rest comes from the source in memory */
+            sink->canSendfile = false;
+        }
+        else if (errno != EINTR) {
+            sink->err = MUSTACHE_ERR_STREAM;
+        }
+    }
+    if (len && !sink->err) {
+        sink->err = fd_write_all(sink->outFd, sink->source + offset, len);
+    }
+}
+#endif
+
+/* copies a span into the parse buffer, flushing each time it fills */
+static uint8_t* sink_copy(render_sink* sink, uint8_t* outputHead, uint8_t** outputEnd, const uint8_t* sourceBeg, const uint8_t* sourceEnd)
+{
+    while ((size_t)(sourceEnd - sourceBeg) > (size_t)(*outputEnd - outputHead))
+    {
+        size_t part = (size_t)(*outputEnd - outputHead);
+        memcpy(outputHead, sourceBeg, part);
+        sourceBeg += part;
+        outputHead = sink_flush(sink, *outputEnd);
+        *outputEnd = sink->bufferEnd;
+    }
+    return mwrite(outputHead, *outputEnd, sourceBeg, sourceEnd);
+}
+
+/* writes a value into the parse buffer. With a sink, a value that might not fit in what is left of it
+   is written into memory of its own first and copied out across as many flushes as it takes. */
+static uint8_t* sink_write_variable(mustache_parser* parser, render_sink* sink, mustache_param* param, uint8_t* outputHead,
+    uint8_t** outputEnd, uint8_t escapeMode, uint8_t* err)
+{
+    if (!sink || sink->mode == SINK_BUFFERED) {
+        return write_variable(parser, param, outputHead, *outputEnd, escapeMode);
+    }
+    size_t maxLen = get_variable_max_len(param, escapeMode);
+    if (maxLen <= (size_t)(*outputEnd - outputHead)) {
+        return write_variable(parser, param, outputHead, *outputEnd, escapeMode);
+    }
+    uint8_t* scratch = parser->alloc(parser, maxLen);
+    if (!scratch) {
+        *err = MUSTACHE_ERR_ALLOC;
+        return outputHead;
+    }
+    uint8_t* scratchEnd = write_variable(parser, param, scratch, scratch + maxLen, escapeMode);
+    outputHead = sink_copy(sink, outputHead, outputEnd, scratch, scratchEnd);
+    parser->free(parser, scratch);
+    return outputHead;
+}
+
+/* writes a literal span of the template into the parse buffer or, with a sink, queues or sends it.
+   A flush can move the parse buffer to the other half of a pipelined sink, outputEnd follows it. */
+static uint8_t* lwrite(render_sink* sink, uint8_t* outputHead, uint8_t** outputEnd, const uint8_t* sourceBeg, const uint8_t* sourceEnd)
+{
+    if (!sink || sourceBeg >= sourceEnd) {
+        return mwrite(outputHead, *outputEnd, sourceBeg, sourceEnd);
+    }
+    size_t len = (size_t)(sourceEnd - sourceBeg);
+
+    if (sink->mode == SINK_BUFFERED) {
+        outputHead = mwrite(outputHead, *outputEnd, sourceBeg, sourceEnd);
+        if ((size_t)(outputHead - sink->hashedEnd) >= MUSTACHE_HASH_CHUNK) {
+            sink_hash(sink, outputHead);
+        }
+        return outputHead;
+    }
+
+    if (sink->mode == SINK_DEFLATE && sink->deflated && len >= DEFLATE_PIECE_MIN) {
+        /* the pieces the span covers whole are spliced, the output around them is compressed as it comes */
+        const deflate_piece* piece = deflated_find(sink->deflated, (uint64_t)(sourceBeg - sink->source));
+        const deflate_piece* piecesEnd = sink->deflated->pieces + sink->deflated->count;
+        for (; piece && piece < piecesEnd && sink->source + piece->srcFirst + piece->srcLen <= sourceEnd; piece++)
+        {
+            outputHead = sink_copy(sink, outputHead, outputEnd, sourceBeg, sink->source + piece->srcFirst);
+            outputHead = sink_flush(sink, outputHead);
+            deflate_splice(sink->deflate, sink->deflated, piece);
+            sourceBeg = sink->source + piece->srcFirst + piece->srcLen;
+        }
+    }
+
+    if (sink->mode != SINK_WRITEV) {
+        return sink_copy(sink, outputHead, outputEnd, sourceBeg, sourceEnd);
+    }
+
+#ifdef MUSTACHE_FD_OUTPUT
+#ifdef MUSTACHE_SENDFILE
+    if (sink->canSendfile && len >= MUSTACHE_SENDFILE_MIN_SPAN) {
+        outputHead = sink_flush(sink, outputHead);
+        sink_sendfile(sink, sourceBeg, len);
+        return outputHead;
+    }
+#endif
+
+    if (len >= MUSTACHE_FD_IOV_MIN_SPAN || len > (size_t)(*outputEnd - outputHead)) {
+        /* the buffered segment and the span take up to two iovecs, a third is left for the segment a flush queues */
+        if (sink->iovCount + 3 > array_count(sink->iov)) {
+            outputHead = sink_flush(sink, outputHead);
+        }
+        sink_queue_buffered(sink, outputHead);
+        sink_queue(sink, sourceBeg, len);
+        if (sink->queuedBytes >= MUSTACHE_FD_FLUSH_BYTES) {
+            outputHead = sink_flush(sink, outputHead);
+        }
+        return outputHead;
+    }
+#endif
+    return mwrite(outputHead, *outputEnd, sourceBeg, sourceEnd);
+}
+
+void eval_jump(structure* mstruct, const uint8_t* m_name_first, const uint8_t* m_name_end, const uint8_t* input, render_sink* sink, uint8_t** outputEnd, uint8_t** outputHead, const uint8_t** lastNonEscaped) {
+    if (mstruct->standalone) {
+        const uint8_t* t = input + mstruct->standalone->lineBegin;
+        if (t > *lastNonEscaped) {
+            *outputHead = lwrite(sink, *outputHead, outputEnd, *lastNonEscaped, t);
+        }
+        *lastNonEscaped = input + mstruct->standalone->lineEnd + 1;
+    }
+    else {
+        const uint8_t* t = m_name_first - 3;
+        if (t > *lastNonEscaped) {
+            *outputHead = lwrite(sink, *outputHead, outputEnd, *lastNonEscaped, t);
+        }
+        *lastNonEscaped = m_name_end + strlen("{{");
+    }
+}
+
+static uint32_t get_parent_child_count(mustache_param* parent)
+{
+#ifndef NDEBUG
+    if (parent->type != MUSTACHE_PARAM_OBJECT && parent->type != MUSTACHE_PARAM_LIST) {
+        assert(00 && "get_parent_child_count: parent IS NOT A VALID PARENT.");
+    }
+#endif
+    if (parent->type == MUSTACHE_PARAM_LIST) {
+        mustache_param_list* asList = (mustache_param_list*)parent;
+        return asList->valueCount;
+    }
+    else {
+        uint32_t c = 0;
+        while (parent)
+        {
+            c++;
+            parent = parent->pNext;
+        }
+        return c;
+    }
+}
+
+static mustache_param* get_nth_child(parent_stack* parentStack, mustache_param* parent, int32_t idx) 
+{
+#ifndef NDEBUG
+    if (parent->type != MUSTACHE_PARAM_OBJECT && parent->type != MUSTACHE_PARAM_LIST) {
+        assert(00 && "get_nth_child: parent IS NOT A VALID PARENT.");
+    }
+#endif
+    uint32_t childCount = get_parent_child_count(parent);
+    if (idx < 0) {
+        idx = childCount +idx;
+    }
+
+    uint32_t i = 0;
+    mustache_param* child = ((mustache_param_object*)parent)->pMembers;
+    while (i!=idx && child && i < childCount)
+    {
+        i++;
+        child = child->pNext;
+    }
+    if (child && !stack_materialize(parentStack, child)) {
+        return NULL;
+    }
+    return child;
+}
+
+
+static mustache_param* resolve_param_member(parent_stack* parentStack, mustache_param* root, const uint8_t* strFirst, const uint8_t* strEnd)
+{
+#ifndef NDEBUG
+    if (*strFirst != '.' && *strFirst != '[') {
+        assert(00 && "resolve_param_member: strFirst must be a string parameter chain, i.e. '.member.name'");
+    }
+#endif 
+
+    if (strFirst+1 == strEnd) {
+        return root;
+    }
+
+    const uint8_t* cur = strFirst;
+
+    mustache_param* param = root;
+    const uint8_t* lastDot = NULL;
+    while (cur <= strEnd)
+    {
+        if (*cur == '[') {
+            const uint8_t* intFirst = cur+1;
+            while (*cur != ']' || cur == strEnd) {
+                cur++;
+            }
+            /* resolve member */
+            const uint8_t* intEnd = cur;
+
+            int32_t index = strtoi32(intFirst, intEnd - intFirst, NULL);
+            mustache_param* child = get_nth_child(parentStack, root, index);
+            if (!child)
+                return NULL;
+            param = child;
+        }
+        else if (*cur == '.' || cur == strEnd)
+        {    
+            if (lastDot) {
+
+                const uint8_t* nameBegin = lastDot + 1;
+                const uint8_t* nameEnd = cur;
+                uint32_t nameLen = nameEnd - nameBegin;
+
+                uint32_t i;
+                if (param->type == MUSTACHE_PARAM_LIST) {
+                    mustache_param_list* asList = (mustache_param_list*)param;
+                    i = asList->valueCount;
+                }
+                else {
+                    i = UINT32_MAX;
+                }
+
+                param = ((mustache_param_list*)param)->pValues;
+                while (param && i > 0)
+                {
+                    if (nameLen == param->name.len && strneql(nameBegin, param->name.u, nameLen)) {
+                        break;
+                    }
+                    param = param->pNext;
+                    i--;
+                }
+
+                if (!param || !stack_materialize(parentStack, param)) {
+                    return NULL;
+                }
+            }
+            lastDot = cur;
+        }
+        cur++;
+    }
+
+    return param;
+}
+
+static param_cache* get_param_cache(structure* mstruct)
+{
+    switch (mstruct->type)
+    {
+    case STRUCTURE_TYPE_VAR:
+        return &((var_structure*)mstruct)->cache;
+    case STRUCTURE_TYPE_LEN:
+        return &((len_structure*)mstruct)->cache;
+    case STRUCTURE_TYPE_SCOPED_POUND:
+    case STRUCTURE_TYPE_SCOPED_CARET:
+        return &((scoped_structure*)mstruct)->cache;
+    default:
+        return NULL;
+    }
+}
+
+/* resolves the param of a structure, including any '.member' or '[idx]' chain, through the structure's param cache.
+   Frames receive increasing generations as they are pushed or advanced, so every frame that changed since the param
+   was cached sits on top of those that did not. Only the changed frames are searched again, meaning params bound to
+   the current loop element are resolved per element, while loop-invariant params are resolved once per loop. */
+static mustache_param* get_structure_param(structure* mstruct, const uint8_t* nameFirst, const uint8_t* nameEnd, mustache_param* globalParams, parent_stack* parentStack)
+{
+    param_cache* cache = get_param_cache(mstruct);
+    scoped_structure** frames = (scoped_structure**)parentStack->buf.u;
+    const uint32_t topGen = parentStack->count ? frames[parentStack->count - 1]->frameGen : 0;
+
+    if (cache->valid && cache->gen == topGen) {
+        return mstruct->param;
+    }
+
+    const uint8_t* firstEnd = nameFirst;
+    while (firstEnd < nameEnd) {
+        if (*firstEnd == '.' || *firstEnd == '[') {
+            break;
+        }
+        firstEnd++;
+    }
+
+    mustache_param* root = NULL;
+    int32_t depth = -1;
+    bool fullResolve = !cache->valid;
+
+    if (!fullResolve) {
+        /* the frame the param was found in must be unchanged */
+        if (cache->depth >= (int32_t)parentStack->count ||
+            (cache->depth >= 0 && frames[cache->depth]->frameGen > cache->gen)) 
+        {
+            fullResolve = true;
+        }
+        else {
+            /* search the frames newer than the cache, these may shadow the cached param */
+            int32_t i;
+            for (i = parentStack->count - 1; i > cache->depth && frames[i]->frameGen > cache->gen; i--) {
+                root = get_frame_parameter(parentStack, frames[i], nameFirst, firstEnd - nameFirst);
+                if (root) {
+                    depth = i;
+                    break;
+                }
+            }
+            if (!root) {
+                cache->gen = topGen;
+                return mstruct->param;
+            }
+        }
+    }
+
+    if (fullResolve) {
+        root = get_parameter(nameFirst, firstEnd, globalParams, parentStack, &depth);
+    }
+
+    if (root && firstEnd != nameEnd) {
+        root = resolve_param_member(parentStack, root, firstEnd, nameEnd);
+    }
+
+    mstruct->param = root;
+    cache->gen = topGen;
+    cache->depth = depth;
+    cache->valid = true;
+    return root;
+}
+
+uint8_t write_structured(mustache_slice outputBuffer, uint8_t** oh, mustache_const_slice inputBuffer, uint8_t* inputEnd, structure* structureRoot, 
+                         mustache_param* globalParams, parent_stack* parentStack, mustache_parser* parser, render_sink* sink)
+{
+    structure* mstruct = structureRoot->pNext; /* SKIP ROOT */
+
+    /* INPUT */
+    const uint8_t* inputHead = inputBuffer.u;
+    const uint8_t* input=inputBuffer.u;
+
+    /* OUTPUT */
+    uint8_t* outputHead = outputBuffer.u;
+    uint8_t* outputEnd = outputBuffer.u + outputBuffer.len;
+
+    const uint8_t* lastNonEscaped = inputHead;
+    while (mstruct)
+    {
+        if (mstruct->type == STRUCTURE_TYPE_SKIP_RANGE) {
+            skip_range_structure* asSkipRange = (skip_range_structure*)mstruct;
+            const uint8_t* t = input + asSkipRange->skipFirst;
+            inputHead = t;
+            outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, inputHead);
+            t = input + asSkipRange->skipLast;
+            lastNonEscaped = t;
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_LEN)
+        {
+            const uint8_t* m_len_str_first = input + mstruct->contentsFirst;
+            const uint8_t* m_len_str_end = input + mstruct->contentsEnd;
+
+            len_structure* asLen = (len_structure*)mstruct;
+            const uint8_t* int_begin = input + asLen->interiorFirst;
+            const uint8_t* int_end = input + asLen->interiorEnd;
+
+
+            outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, m_len_str_first - mstruct->precedingMustacheLen);
+            outputHead = sink_reserve(sink, outputHead, &outputEnd);
+
+
+            get_structure_param(mstruct, int_begin, int_end, globalParams, parentStack);
+            if (asLen->param && is_parent(asLen->param)) {
+                uint32_t cc = get_parent_child_count(mstruct->param);
+                outputHead = u32toa(cc, outputHead, (size_t)(outputEnd - outputHead));
+                lastNonEscaped = m_len_str_end + strlen("}}");
+            }
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_NESTED_TEMPLATE) {
+            
+            nested_template_structure* asTemplate = (nested_template_structure*)mstruct;
+            const uint8_t* m_name_first = input + mstruct->contentsFirst+(asTemplate->precedingMustacheLen-2);
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+
+            outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, m_name_first - mstruct->precedingMustacheLen);
+            outputHead = sink_reserve(sink, outputHead, &outputEnd);
+            lastNonEscaped = m_name_end + strlen("}}");
+
+            if (!asTemplate->param) {
+                mstruct->param = (mustache_param*)get_nested_template_param(m_name_first, m_name_end, globalParams);
+                if (!mstruct->param) {
+                    goto skip_node;
+                }
+            }
+
+            
+            mustache_param_template* template_param = (mustache_param_template*)mstruct->param;
+            
+
+            mustache_slice output_slice = {outputHead, outputEnd-outputHead};
+            uint64_t bytesWritten=0;
+
+            /* the nested source is already in memory, it is rendered in place */
+            uint8_t err = parse_source(parser, template_param->parentStackBuffer, template_param->structure, template_param->parameters, chain_source(template_param->structure, template_param->source), output_slice, &bytesWritten, nested_parse_callback, NULL);
+            if (err!=MUSTACHE_SUCCESS) {
+                goto skip_node;
+            }
+
+            uint8_t* parsed_begin = outputHead;
+            outputHead+=bytesWritten;
+            uint8_t* parsed_end = outputHead;
+
+            if (asTemplate->precedingSpaces>0) {
+                apply_spaces_to_source(asTemplate->precedingSpaces, parser, parsed_begin, parsed_end, (mustache_slice){ parsed_begin, (uint64_t)(outputEnd - parsed_begin) }, &bytesWritten);
+                outputHead+=bytesWritten;
+            }
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_VAR) 
+        {
+            var_structure* asVar = (var_structure*)mstruct;
+            const uint8_t* m_name_first = input + mstruct->contentsFirst;
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+            const uint32_t nameLen = m_name_end - m_name_first;
+            uint8_t err = MUSTACHE_SUCCESS;
+
+            outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, m_name_first - mstruct->precedingMustacheLen);
+            outputHead = sink_reserve(sink, outputHead, &outputEnd);
+            lastNonEscaped = m_name_end + strlen("{{");
+
+            /* HANDLE '.' CASE, outside of every section there is no current element */
+            if (*m_name_first == '.')
+            {
+                if (!parentStack->count) {
+                    goto skip_node;
+                }
+                scoped_structure* parent = parent_stack_last(parentStack);
+                mustache_param* m_child = parent->curChild;
+                /* resolve '.' or chains '.member.name' */
+                mustache_param* member = resolve_param_member(parentStack, m_child, m_name_first, m_name_end);
+                if (member) {
+                    outputHead = sink_write_variable(parser, sink, member, outputHead, &outputEnd, asVar->escapeMode, &err);
+                }
+            }
+            else if (get_structure_param(mstruct, m_name_first, m_name_end, globalParams, parentStack)) {
+                outputHead = sink_write_variable(parser, sink, mstruct->param, outputHead, &outputEnd, asVar->escapeMode, &err);
+            }
+            if (err) {
+                *oh = outputHead;
+                return err;
+            }
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_ELSE)
+        {
+            else_structure* asElse = (else_structure*)mstruct;
+            const uint8_t* m_name_first = input + mstruct->contentsFirst + 1;
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+
+            const uint8_t* interiorBegin = input + asElse->interiorBegin;
+            const uint8_t* interiorEnd = input + asElse->contentsEnd;
+
+
+            scoped_structure* parentAsScoped = (scoped_structure*)asElse->parent;
+
+            if (!parentAsScoped->renderedLastEvaluation)
+            {
+                if (mstruct->standalone) {
+                    const uint8_t* t = input + mstruct->standalone->lineBegin;
+                    outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                    lastNonEscaped = input + mstruct->standalone->lineEnd + strlen("\n");
+                }
+                else {
+                    const uint8_t* t = m_name_first - strlen("{{x");
+                    outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                    lastNonEscaped = m_name_end + strlen("{{");
+                }
+            }
+            else {
+                uint32_t nameLen = m_name_end - m_name_first;
+                const uint8_t* t;
+                if (mstruct->standalone) {
+                    t = input + mstruct->standalone->lineBegin;
+                }
+                else {
+                    t = m_name_first - strlen("{{x");
+                }
+                outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                lastNonEscaped = input + asElse->close->contentsEnd + strlen("}}");
+
+                mstruct = (structure*)asElse->close;
+                goto skip_node_no_advance;
+            }
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_SCOPED_CARET || mstruct->type == STRUCTURE_TYPE_SCOPED_POUND) {
+            scoped_structure* asScoped = (scoped_structure*)mstruct;
+        
+            const uint8_t* m_name_first = input + mstruct->contentsFirst+1;
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+
+            mustache_param* lastParam = mstruct->param;
+            if (!get_structure_param(mstruct, m_name_first, m_name_end, globalParams, parentStack)) {
+                goto skip_node;
+            }
+            if (mstruct->param != lastParam) {
+                asScoped->wasEvaluated = false;
+            }
+
+            asScoped->curIdx = 0;
+            
+            if (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND && mstruct->param && is_parent(mstruct->param))
+            {
+                parent_stack_push(parentStack, asScoped);
+
+                mustache_param_object* pAsObj = (mustache_param_object*)asScoped->param;
+                asScoped->curChild = pAsObj->pMembers;
+                if (asScoped->curChild) {
+                    stack_materialize(parentStack, asScoped->curChild);
+                }
+
+                if (mstruct->standalone) {
+                    const uint8_t* t = input + mstruct->standalone->lineBegin;
+                    outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                    lastNonEscaped = input + mstruct->standalone->lineEnd + strlen("\n");
+                }
+                else {
+                    const uint8_t* t = m_name_first - strlen("{{x");
+                    outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                    lastNonEscaped = m_name_end + strlen("{{");
+                }
+            }
+            else if (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND || mstruct->type==STRUCTURE_TYPE_SCOPED_CARET) 
+            {
+                
+                scoped_structure* asScoped = (scoped_structure*)mstruct;
+               
+                if (!asScoped->wasEvaluated) {
+                    bool truthy = is_truthy(mstruct->param);
+                    asScoped->renderedLastEvaluation = (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND && truthy) || (mstruct->type == STRUCTURE_TYPE_SCOPED_CARET && !truthy);
+                    asScoped->wasEvaluated = true;
+                }
+                if (asScoped->renderedLastEvaluation)
+                {
+                    if (mstruct->standalone) {
+                        const uint8_t* t = input + mstruct->standalone->lineBegin;
+                        outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                        lastNonEscaped = input + mstruct->standalone->lineEnd + strlen("\n");
+                    }
+                    else {
+                        const uint8_t* t = m_name_first - strlen("{{x");
+                        outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                        lastNonEscaped = m_name_end + strlen("{{");
+                    }
+                }
+                else {
+                    uint32_t nameLen = m_name_end - m_name_first;
+                    const uint8_t* t;
+                    if (mstruct->standalone) {
+                        t = input + mstruct->standalone->lineBegin;
+                    } else {
+                        t = m_name_first - strlen("{{x");
+                    }
+                    outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, t);
+                    lastNonEscaped = input + asScoped->interiorEnd+nameLen+strlen("{{x}}");
+
+                    mstruct = asScoped->close_or_else;
+                    goto skip_node_no_advance;
+                }
+            }
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_COMMENT || mstruct->type == STRUCTURE_TYPE_CLOSE) 
+        {
+            const uint8_t* m_name_first = input + mstruct->contentsFirst+1;
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+
+            if (mstruct->type == STRUCTURE_TYPE_CLOSE)
+            {
+                close_structure* asClose = (close_structure*)mstruct;
+
+                if (!mstruct->param) {
+                    mstruct->param = asClose->parent->param;
+                }
+
+                if (!asClose->parent) {
+                    return MUSTACHE_ERR_INVALID_TEMPLATE;
+                }
+
+                scoped_structure* parent = asClose->parent;
+
+                /* only a parent that was pushed onto the stack iterates or pops */
+                if (parent->type!=STRUCTURE_TYPE_ELSE && parent->param && 
+                    parentStack->count && parent_stack_last(parentStack) == parent) 
+                {
+                    if (parent->param->type == MUSTACHE_PARAM_LIST)
+                    {
+                        mustache_param_list* param = (mustache_param_list*)parent->param;
+                        parent->curIdx++;
+                        parent->curChild = parent->curChild ? parent->curChild->pNext : NULL;
+                        if (parent->curIdx < param->valueCount && parent->curChild)
+                        {
+                            stack_materialize(parentStack, parent->curChild);
+                            /* the current element changed, params bound to it must be resolved again */
+                            parent->frameGen = ++parentStack->gen;
+
+                            eval_jump(mstruct, m_name_first, m_name_end, input, sink, &outputEnd, &outputHead, &lastNonEscaped);
+
+                            /* go to parent next again */
+                            mstruct = (structure*)parent;
+                            eval_jump(mstruct, m_name_first, m_name_end, input, sink, &outputEnd, &outputHead, &lastNonEscaped);
+                            goto skip_node;
+                        }
+                    }
+                    parent_stack_pop(parentStack);
+                }
+            }
+
+            eval_jump(mstruct, m_name_first, m_name_end, input, sink, &outputEnd, &outputHead, &lastNonEscaped);
+        }
+
+    skip_node:
+        mstruct = mstruct->pNext;
+    skip_node_no_advance:
+        mstruct = mstruct;
+    }
+
+
+    outputHead = lwrite(sink, outputHead, &outputEnd, lastNonEscaped, inputEnd);
+    *oh = outputHead;
+    return MUSTACHE_SUCCESS;
+}
+
+void mustache_structure_chain_free(mustache_parser* p, mustache_structure* structure_chain)
+{
+    root_structure* asRoot = (root_structure*)structure_chain;
+    if (asRoot->type == STRUCTURE_TYPE_ROOT && asRoot->ownsSource) {
+        p->free(p, (void*)asRoot->source);
+    }
+    if (asRoot->type == STRUCTURE_TYPE_ROOT && asRoot->deflated) {
+        p->free(p, asRoot->deflated);
+    }
+
+    structure* root = (structure*)structure_chain;
+    root = root->pNext;
+    while (root)
+    {
+        structure* next = root->pNext;
+        if (root->type == STRUCTURE_TYPE_ELSE) {
+            else_structure* as = (else_structure*)root;
+            if (as->standalone) {
+                p->free(p,as->standalone);
+            }
+        }
+        else if (root->type == STRUCTURE_TYPE_VAR) {
+            var_structure* as = (var_structure*)root;
+            if (as->standalone) {
+                p->free(p,as->standalone);
+            }
+        }
+        else if (root->type == STRUCTURE_TYPE_CLOSE) {
+            close_structure* as = (close_structure*)root;
+            if (as->standalone) {
+                p->free(p,as->standalone);
+            }
+        }
+        else if (root->type == STRUCTURE_TYPE_SCOPED_CARET) {
+            scoped_structure* as = (scoped_structure*)root;
+            if (as->standalone) {
+                p->free(p,as->standalone);
+            }
+        }
+        else if (root->type == STRUCTURE_TYPE_SCOPED_POUND) {
+            scoped_structure* as = (scoped_structure*)root;
+            if (as->standalone) {
+                p->free(p,as->standalone);
+            }
+        }
+        else if (root->type == STRUCTURE_TYPE_COMMENT) {
+            if (root->standalone) {
+                p->free(p,root->standalone);
+            }
+        }
+        
+        p->free(p,root);
+        root = next;
+    }
+
+    memset(structure_chain, 0, sizeof(*structure_chain));
+}
+
+void mustache_structure_chain_flush(mustache_structure* structure_chain)
+{
+    structure* root = (structure*)structure_chain;
+    root = root->pNext;
+    while (root)
+    {
+        param_cache* cache = get_param_cache(root);
+        if (cache) {
+            cache->valid = false;
+        }
+        if (root->type != STRUCTURE_TYPE_ELSE && root->type != STRUCTURE_TYPE_SKIP_RANGE) {
+            root->param = NULL;
+        }
+        root = root->pNext;
+    }
+}
+
+/* compiles the source into the structure chain when it is still empty, then renders it. With a sink the
+   output goes out through it and the parse callback is not called. */
+static uint8_t parse_source(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain,
+    mustache_param* params, mustache_const_slice source, mustache_slice outputBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback,
+    render_sink* sink)
+{
+    uint8_t* input = (uint8_t*)source.u;
+    uint8_t* inputEnd = input + source.len;
+
+    /* a stream compiled without its comments may leave less than a tag */
+    bool compiled = ((structure*)structChain)->type == STRUCTURE_TYPE_ROOT;
+    if ((source.len < 4 && !compiled) || source.len >= UINT32_MAX-3) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    uint8_t* outputHead = outputBuffer.u;
+    uint8_t* outputEnd = outputBuffer.u + outputBuffer.len;
+
+    parent_stack parentStack = {
+        .buf =  parentStackBuffer,
+        .count = 0,
+        .MAX_COUNT = parentStackBuffer.len / sizeof(void*),
+        .gen = 0,
+        .err = MUSTACHE_SUCCESS
+    };
+
+    structure* structureRoot = (structure*)structChain;
+
+    MUSTACHE_RES err;
+    if (!structureRoot->pNext) {
+        err = source_to_structured(parser, structureRoot, input, input, inputEnd);
+        if (err) {
+            return err;
+        }
+    }
+    else {
+
+        /* RESET EVAL STATE */
+        structure* root = (structure*)structureRoot;
+        root = root->pNext;
+        while (root)
+        {
+            if (root->type == STRUCTURE_TYPE_SCOPED_CARET || root->type == STRUCTURE_TYPE_SCOPED_POUND)
+            {
+                scoped_structure* asScoped = (scoped_structure*)root;
+                asScoped->wasEvaluated = false;
+            }
+            /* the params may be a different chain every render, even one at the address of a freed one */
+            param_cache* cache = get_param_cache(root);
+            if (cache) {
+                cache->valid = false;
+            }
+            root = root->pNext;
+        }
+    }
+
+    err = write_structured(
+        outputBuffer, &outputHead,
+        source,
+        inputEnd,
+        structureRoot, params, &parentStack,
+        parser, sink
+    );
+    if (!err) {
+        err = parentStack.err;
+    }
+
+    /* a failed render still waits for the output it already handed off */
+    if (sink && sink->mode != SINK_BUFFERED) {
+        sink_finish(sink, outputHead);
+        return err ? err : sink->err;
+    }
+    if (err) {
+        return err;
+    }
+
+    mustache_slice parsedSlice = {
+        .u = outputBuffer.u,
+        .len = outputHead - outputBuffer.u,
+    };
+
+    if (sink) {
+        sink_finish(sink, outputHead);
+    }
+    parseCallback(parser, parseCallbackUdata, parsedSlice);
+
+    return MUSTACHE_SUCCESS;
+}
+
+uint8_t mustache_compile(mustache_parser* parser, mustache_const_slice source, mustache_structure* structChain)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->pNext || root->type == STRUCTURE_TYPE_ROOT) {
+        return MUSTACHE_ERR_ARGS;
+    }
+    if (source.len < 4 || source.len >= UINT32_MAX-3) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    uint8_t err = source_to_structured(parser, (structure*)root, (uint8_t*)source.u, (uint8_t*)source.u, (uint8_t*)source.u + source.len);
+    if (err) {
+        return err;
+    }
+
+    root->type = STRUCTURE_TYPE_ROOT;
+    root->source = source.u;
+    root->sourceLen = (uint32_t)source.len;
+    root->ownsSource = false;
+    root->compacted = false;
+    return MUSTACHE_SUCCESS;
+}
+
+/* compiles a source the chain takes over, it is freed with the chain or right away if compiling fails */
+static uint8_t compile_owned(mustache_parser* parser, uint8_t* source, size_t sourceLen, mustache_structure* structChain)
+{
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ source, sourceLen }, structChain);
+    if (err) {
+        parser->free(parser, source);
+        return err;
+    }
+    ((root_structure*)structChain)->ownsSource = true;
+    return MUSTACHE_SUCCESS;
+}
+
+uint8_t mustache_compile_stream(mustache_parser* parser, mustache_stream* stream, mustache_structure* structChain)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->pNext || root->type == STRUCTURE_TYPE_ROOT) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    /* the source starts at one window, the extra byte lets a shorter stream of known length end
+       without growing. It grows by doubling only when what is kept of it fills it. */
+    uint64_t streamLen = stream_len(stream);
+    size_t capacity = streamLen < MUSTACHE_COMPILE_STREAM_WINDOW ? (size_t)streamLen + 1 : MUSTACHE_COMPILE_STREAM_WINDOW;
+    capacity = max(capacity, (size_t)MUSTACHE_COMPILE_STREAM_MIN_CHUNK);
+    uint8_t* source = parser->alloc(parser, capacity);
+    if (!source) {
+        return MUSTACHE_ERR_ALLOC;
+    }
+
+    compile_state state;
+    memset(&state, 0, sizeof(state));
+    state.root = (structure*)root;
+    state.last = (structure*)root;
+    state.defaultEscape = ESCAPE_MODE_HTML;
+    state.windowed = true;
+    state.more = true;
+
+    /* each window is compiled as it is read, only the literal spans and the tags stay in the source */
+    uint64_t streamRead = 0;
+    size_t sourceLen = 0;
+    uint8_t err = MUSTACHE_SUCCESS;
+    while (!err && state.more)
+    {
+        if (sourceLen == capacity) {
+            /* the structures address the source with 32 bit offsets */
+            if (capacity >= UINT32_MAX - 3) {
+                err = MUSTACHE_ERR_ARGS;
+                break;
+            }
+            size_t grown = min((uint64_t)capacity * 2, (uint64_t)UINT32_MAX - 3);
+            uint8_t* larger = parser->alloc(parser, grown);
+            if (!larger) {
+                err = MUSTACHE_ERR_ALLOC;
+                break;
+            }
+            memcpy(larger, source, sourceLen);
+            parser->free(parser, source);
+            source = larger;
+            capacity = grown;
+        }
+
+        size_t window = min(capacity - sourceLen, (size_t)MUSTACHE_COMPILE_STREAM_WINDOW);
+        size_t readBytes = stream->readCallback(stream->udata, source + sourceLen, window);
+        if (!readBytes || readBytes > window) {
+            readBytes = 0;
+            state.more = false;
+        }
+        sourceLen += readBytes;
+        streamRead += readBytes;
+
+        /* a compile that stopped for a byte it needs only goes on once one has been read */
+        if (state.more && state.awaiting && !memchr(source + sourceLen - readBytes, state.awaiting, readBytes)) {
+            continue;
+        }
+        uint8_t* sourceEnd = source + sourceLen;
+        err = compile_source(parser, &state, source, source + state.stop, &sourceEnd);
+        sourceLen = sourceEnd - source;
+        if (!err) {
+            err = compile_close_pending(&state, source, state.more ? source + state.stop : sourceEnd);
+        }
+    }
+    if (state.pending) {
+        parser->free(parser, state.pending);
+    }
+    if (!err && streamRead < 4) {
+        err = MUSTACHE_ERR_ARGS;
+    }
+    if (err) {
+        parser->free(parser, source);
+        mustache_structure_chain_free(parser, structChain);
+        return err;
+    }
+
+    root->type = STRUCTURE_TYPE_ROOT;
+    root->source = source;
+    root->sourceLen = (uint32_t)sourceLen;
+    root->ownsSource = true;
+    root->compacted = sourceLen != streamRead;
+    return MUSTACHE_SUCCESS;
+}
+
+uint8_t mustache_render(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->type != STRUCTURE_TYPE_ROOT) {
+        return MUSTACHE_ERR_ARGS;
+    }
+    return parse_source(parser, parentStackBuffer, structChain, params, (mustache_const_slice){ root->source, root->sourceLen },
+        parseBuffer, parseCallbackUdata, parseCallback, NULL);
+}
+
+uint8_t mustache_render_hashed(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, uint64_t* hash, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->type != STRUCTURE_TYPE_ROOT || !hash) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    render_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.bufferFirst = parseBuffer.u;
+    sink.bufferEnd = parseBuffer.u + parseBuffer.len;
+    sink.segmentFirst = parseBuffer.u;
+    sink.source = root->source;
+    sink.mode = SINK_BUFFERED;
+    sink.hashedEnd = parseBuffer.u;
+    sink.digest = hash;
+    xxh64_init(&sink.hash);
+
+    return parse_source(parser, parentStackBuffer, structChain, params, (mustache_const_slice){ root->source, root->sourceLen },
+        parseBuffer, parseCallbackUdata, parseCallback, &sink);
+}
+
+uint8_t mustache_parse_file(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_const_slice filename, mustache_structure* structChain, mustache_param* params, mustache_slice sourceBuffer, mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+#ifndef NDEBUG
+    if (filename.len > 2048) {
+        assert(00 && "mustache_parse_file: SUCH A LARGE FILENAME MAY RESULT IN PROGRAM INSTABILITY!");
+    }
+#endif
+    /* tragically fopen requires a null terminated string, and there is no workaround even for an all-around */
+    /* system specific design, it's possible on Windows but not on Linux to my knowledge :( */
+    uint8_t* filenameNT = alloca(filename.len + 1);
+    memcpy(filenameNT, filename.u, filename.len);
+    filenameNT[filename.len] = 0;
+
+#ifdef MUSTACHE_MMAP
+    /* compile and render straight from the mapping, the source buffer is not needed */
+    mustache_const_slice view;
+    if (file_map(filenameNT, &view)) {
+        uint8_t err = parse_source(parser, parentStackBuffer, structChain, params, view, parseBuffer, parseCallbackUdata, parseCallback, NULL);
+        file_unmap(view);
+        return err;
+    }
+#endif
+
+    FILE* fptr;
+    fptr = fopen(filenameNT, "rb");
+    if (!fptr) {
+        return MUSTACHE_ERR_FILE_OPEN;
+    }
+
+    /* parse in chunks */
+    mustache_stream stream = {
+        .udata = fptr,
+        .readCallback = fread_callback,
+        .seekCallback = fseek_callback,
+    };
+
+    uint8_t err = mustache_parse_stream(parser, parentStackBuffer, &stream, structChain, params, sourceBuffer, parseBuffer, parseCallbackUdata, parseCallback);
+    fclose(fptr);
+    return err;
+}
+
+uint8_t mustache_parse_stream(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_stream* stream, mustache_structure* structChain,
+    mustache_param* params, mustache_slice inputBuffer, mustache_slice outputBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    uint64_t streamLen = stream_len(stream);
+    if (streamLen != UINT64_MAX && streamLen > inputBuffer.len) {
+        return MUSTACHE_ERR_NO_SPACE;
+    }
+
+    size_t readBytes = stream_read_full(stream, inputBuffer.u, streamLen == UINT64_MAX ? inputBuffer.len : (size_t)streamLen);
+    if (streamLen == UINT64_MAX && readBytes == inputBuffer.len) {
+        /* a full buffer only holds the whole template if the stream ends with it */
+        uint8_t probe;
+        if (stream->readCallback(stream->udata, &probe, 1)) {
+            return MUSTACHE_ERR_NO_SPACE;
+        }
+    }
+    else if (streamLen != UINT64_MAX && readBytes < streamLen) {
+        return MUSTACHE_ERR_STREAM;
+    }
+
+    return parse_source(parser, parentStackBuffer, structChain, params, (mustache_const_slice){ inputBuffer.u, readBytes },
+        outputBuffer, parseCallbackUdata, parseCallback, NULL);
+}
+
+#ifdef MUSTACHE_FD_OUTPUT
+uint8_t mustache_compile_fd(mustache_parser* parser, int templateFd, mustache_structure* structChain)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->pNext || root->type == STRUCTURE_TYPE_ROOT) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    struct stat st;
+    if (fstat(templateFd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return MUSTACHE_ERR_FILE_OPEN;
+    }
+    if ((uint64_t)st.st_size >= UINT32_MAX - 3) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    size_t sourceLen = (size_t)st.st_size;
+    uint8_t* source = parser->alloc(parser, sourceLen + 1);
+    if (!source) {
+        return MUSTACHE_ERR_ALLOC;
+    }
+
+    /* read by offset, the renders send from the same offsets and the fd's position is left alone */
+    size_t filled = 0;
+    while (filled < sourceLen)
+    {
+        ssize_t readBytes = pread(templateFd, source + filled, sourceLen - filled, (off_t)filled);
+        if (readBytes > 0) {
+            filled += (size_t)readBytes;
+        }
+        else if (readBytes == 0 || errno != EINTR) {
+            break;
+        }
+    }
+    if (filled != sourceLen) {
+        parser->free(parser, source);
+        return MUSTACHE_ERR_STREAM;
+    }
+
+    return compile_owned(parser, source, sourceLen, structChain);
+}
+#endif
+
+/* renders a compiled template through a sink, which the caller has pointed at its output */
+static uint8_t render_sink_run(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, render_sink* sink)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->type != STRUCTURE_TYPE_ROOT || !parseBuffer.len) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    sink->bufferFirst = parseBuffer.u;
+    sink->bufferEnd = parseBuffer.u + parseBuffer.len;
+    sink->segmentFirst = parseBuffer.u;
+    sink->source = root->source;
+    return parse_source(parser, parentStackBuffer, structChain, params, (mustache_const_slice){ root->source, root->sourceLen },
+        parseBuffer, NULL, NULL, sink);
+}
+
+#ifdef MUSTACHE_FD_OUTPUT
+uint8_t mustache_render_fd(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, int outFd, uint32_t flags)
+{
+    render_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.templateFd = -1;
+    sink.outFd = outFd;
+
+    if (flags & MUSTACHE_FD_ALIGNED) {
+        /* the buffer is narrowed to whole blocks at an aligned address */
+        uintptr_t first = ((uintptr_t)parseBuffer.u + MUSTACHE_FD_ALIGNMENT - 1) & ~(uintptr_t)(MUSTACHE_FD_ALIGNMENT - 1);
+        uint64_t skipped = (uint64_t)(first - (uintptr_t)parseBuffer.u);
+        if (parseBuffer.len < skipped + 2 * MUSTACHE_FD_ALIGNMENT) {
+            return MUSTACHE_ERR_ARGS;
+        }
+        parseBuffer.u = (uint8_t*)first;
+        parseBuffer.len = (parseBuffer.len - skipped) / MUSTACHE_FD_ALIGNMENT * MUSTACHE_FD_ALIGNMENT;
+        sink.mode = SINK_ALIGNED;
+    }
+
+    return render_sink_run(parser, parentStackBuffer, structChain, params, parseBuffer, &sink);
+}
+#endif
+
+#ifdef MUSTACHE_SENDFILE
+uint8_t mustache_render_sendfile(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, int templateFd, int outFd)
+{
+    render_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.templateFd = templateFd;
+    sink.outFd = outFd;
+
+    /* a file shorter than the source cannot be the one it was compiled from, and a compacted source no
+       longer lines up with the file it was read from, either is all written from memory */
+    root_structure* root = (root_structure*)structChain;
+    struct stat st;
+    if (!root->compacted && fstat(templateFd, &st) == 0 && S_ISREG(st.st_mode) && (uint64_t)st.st_size >= root->sourceLen) {
+        sink.canSendfile = true;
+    }
+    if (fstat(outFd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        sink.outIsPipe = true;
+    }
+
+    return render_sink_run(parser, parentStackBuffer, structChain, params, parseBuffer, &sink);
+}
+#endif
+
+#ifdef MUSTACHE_PIPELINE
+uint8_t mustache_flusher_start(mustache_parser* parser, mustache_flusher* flusherHandle)
+{
+    pipeline* pipe = parser->alloc(parser, sizeof(pipeline));
+    if (!pipe) {
+        return MUSTACHE_ERR_ALLOC;
+    }
+    memset(pipe, 0, sizeof(*pipe));
+    pipe->parser = parser;
+
+    if (sem_init(&pipe->ready, 0, 0) != 0) {
+        parser->free(parser, pipe);
+        return MUSTACHE_ERR;
+    }
+    if (sem_init(&pipe->drained, 0, 0) != 0) {
+        sem_destroy(&pipe->ready);
+        parser->free(parser, pipe);
+        return MUSTACHE_ERR;
+    }
+    if (pthread_create(&pipe->thread, NULL, pipeline_main, pipe) != 0) {
+        sem_destroy(&pipe->drained);
+        sem_destroy(&pipe->ready);
+        parser->free(parser, pipe);
+        return MUSTACHE_ERR;
+    }
+
+    flusherHandle->__A = pipe;
+    return MUSTACHE_SUCCESS;
+}
+
+uint8_t mustache_render_pipelined(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, mustache_flusher* flusherHandle, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    pipeline* pipe = flusherHandle->__A;
+    if (!pipe || !parseCallback || parseBuffer.len < 2) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    render_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.templateFd = -1;
+    sink.outFd = -1;
+    sink.mode = SINK_PIPELINE;
+    sink.pipe = pipe;
+    sink.halfLen = parseBuffer.len / 2;
+    sink.halves[0] = parseBuffer.u;
+    sink.halves[1] = parseBuffer.u + sink.halfLen;
+    sink.parseCallbackUdata = parseCallbackUdata;
+    sink.parseCallback = parseCallback;
+
+    /* the render starts in the first half */
+    parseBuffer.len = sink.halfLen;
+    return render_sink_run(parser, parentStackBuffer, structChain, params, parseBuffer, &sink);
+}
+
+void mustache_flusher_stop(mustache_parser* parser, mustache_flusher* flusherHandle)
+{
+    pipeline* pipe = flusherHandle->__A;
+    if (!pipe) {
+        return;
+    }
+
+    pipeline_push(pipe, (pipeline_chunk){ NULL, 0, NULL, NULL });
+    pthread_join(pipe->thread, NULL);
+    sem_destroy(&pipe->drained);
+    sem_destroy(&pipe->ready);
+    parser->free(parser, pipe);
+    flusherHandle->__A = NULL;
+}
+#endif
+
+uint8_t mustache_deflater_create(mustache_parser* parser, mustache_deflater* deflaterHandle)
+{
+    deflater* d = deflater_create(parser);
+    if (!d) {
+        return MUSTACHE_ERR_ALLOC;
+    }
+    deflaterHandle->__A = d;
+    return MUSTACHE_SUCCESS;
+}
+
+uint8_t mustache_compile_deflate(mustache_parser* parser, mustache_structure* structChain)
+{
+    root_structure* root = (root_structure*)structChain;
+    if (root->type != STRUCTURE_TYPE_ROOT || root->deflated) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    const uint8_t* sourceFirst = root->source;
+    const uint8_t* sourceEnd = root->source + root->sourceLen;
+    const uint8_t* spanFirst;
+    const uint8_t* spanEnd;
+    const uint8_t* cur;
+
+    /* the pieces are counted first, they share one allocation with their codes */
+    uint32_t count = 0;
+    for (cur = sourceFirst; cur < sourceEnd;) {
+        cur = deflate_next_span(cur, sourceFirst, sourceEnd, &spanFirst, &spanEnd);
+        count += deflate_piece_count((uint64_t)(spanEnd - spanFirst));
+    }
+    if (!count) {
+        return MUSTACHE_SUCCESS;
+    }
+
+    deflate_piece* pieces = parser->alloc(parser, count * sizeof(deflate_piece));
+    deflater* d = deflater_create(parser);
+    if (!pieces || !d) {
+        if (pieces) {
+            parser->free(parser, pieces);
+        }
+        if (d) {
+            parser->free(parser, d);
+        }
+        return MUSTACHE_ERR_ALLOC;
+    }
+
+    deflate_blob blob = { parser, NULL, 0, 0, false };
+    deflate_begin(d, parser, MUSTACHE_DEFLATE_RAW, &blob, deflate_blob_append);
+    /* a piece is only the codes of its bytes, without the block header deflate_begin put down */
+    d->bitBuf = 0;
+    d->bitCount = 0;
+
+    deflate_piece* piece = pieces;
+    for (cur = sourceFirst; cur < sourceEnd;)
+    {
+        cur = deflate_next_span(cur, sourceFirst, sourceEnd, &spanFirst, &spanEnd);
+        uint32_t spanCount = deflate_piece_count((uint64_t)(spanEnd - spanFirst));
+        uint32_t i;
+        for (i = 0; i < spanCount; i++, piece++)
+        {
+            /* the pieces of a span are spread evenly, none of them ends up much shorter than the rest */
+            const uint8_t* first = spanFirst + (uint64_t)(spanEnd - spanFirst) * i / spanCount;
+            const uint8_t* end = spanFirst + (uint64_t)(spanEnd - spanFirst) * (i + 1) / spanCount;
+            uint32_t len = (uint32_t)(end - first);
+
+            deflate_forget(d, 0);
+            piece->srcFirst = (uint32_t)(first - sourceFirst);
+            piece->srcLen = len;
+            piece->bitsFirst = (uint32_t)(blob.len + d->outLen);
+            deflate_write(d, first, len);
+            piece->bitLen = (uint32_t)((blob.len + d->outLen - piece->bitsFirst) * 8 + d->bitCount);
+            deflate_align(d);
+
+            piece->crc = crc32_update(d->crcTable, 0, first, len);
+            piece->crcShift = crc32_shift(len);
+            piece->adler = adler32_update(1, first, len);
+        }
+    }
+    deflate_deliver(d);
+    parser->free(parser, d);
+
+    deflated_spans* spans = blob.failed ? NULL : parser->alloc(parser, sizeof(deflated_spans) + count * sizeof(deflate_piece) + blob.len);
+    if (spans) {
+        spans->count = count;
+        spans->pieces = (deflate_piece*)(spans + 1);
+        spans->bits = (uint8_t*)(spans->pieces + count);
+        memcpy(spans->pieces, pieces, count * sizeof(deflate_piece));
+        memcpy(spans->bits, blob.bytes, blob.len);
+        root->deflated = spans;
+    }
+    parser->free(parser, pieces);
+    if (blob.bytes) {
+        parser->free(parser, blob.bytes);
+    }
+    return spans ? MUSTACHE_SUCCESS : MUSTACHE_ERR_ALLOC;
+}
+
+uint8_t mustache_render_deflate(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params,
+    mustache_slice parseBuffer, mustache_deflater* deflaterHandle, uint32_t format, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    deflater* d = deflaterHandle->__A;
+    root_structure* root = (root_structure*)structChain;
+    if (!d || !parseCallback || format > MUSTACHE_DEFLATE_GZIP || root->type != STRUCTURE_TYPE_ROOT) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    render_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.mode = SINK_DEFLATE;
+    sink.deflate = d;
+    sink.deflated = root->deflated;
+#ifdef MUSTACHE_FD_OUTPUT
+    sink.templateFd = -1;
+    sink.outFd = -1;
+#endif
+
+    deflate_begin(d, parser, (uint8_t)format, parseCallbackUdata, parseCallback);
+    return render_sink_run(parser, parentStackBuffer, structChain, params, parseBuffer, &sink);
+}
+
+void mustache_deflater_free(mustache_parser* parser, mustache_deflater* deflaterHandle)
+{
+    if (deflaterHandle->__A) {
+        parser->free(parser, deflaterHandle->__A);
+        deflaterHandle->__A = NULL;
+    }
+}
+
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- -+-  HOT RELOAD -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+#ifdef MUSTACHE_HOT_RELOAD
+
+/* A hot template publishes its compiled form through a single pointer. The watcher thread compiles a
+   changed file into a new version, swaps the pointer and then waits out the renders that may still
+   hold the old version before freeing it. Renders count themselves in one of two reader counters,
+   the one selected by the epoch when they began. The watcher flips the epoch and waits for the old
+   counter to drain twice, after which no render can still see the old version. */
+
+typedef struct {
+    mustache_structure chain;
+} hot_version;
+
+typedef struct hot_template hot_template;
+typedef struct hot_template {
+    hot_template* pNext;        /*the watcher's list*/
+    hot_version* current;
+    uint32_t epoch;
+    uint32_t readers[2];
+    int dirWatch;               /*the inotify watch on the file's directory*/
+    bool stale;
+    const uint8_t* name;        /*the file name within its directory*/
+    uint32_t nameLen;
+    /*the null terminated path is stored right after the node*/
+} hot_template;
+
+typedef struct {
+    mustache_parser* parser;
+    hot_template* templates;
+    pthread_mutex_t lock;       /*guards the list against the watcher thread*/
+    pthread_t thread;
+    int inotifyFd;
+    int stopFd;
+} hot_watcher;
+
+/* directories are watched rather than files, editors replace a file by renaming a new one over it */
+#define HOT_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+static uint8_t hot_compile(mustache_parser* parser, const uint8_t* pathNT, hot_version** version)
+{
+    FILE* fptr = fopen((const char*)pathNT, "rb");
+    if (!fptr) {
+        return MUSTACHE_ERR_FILE_OPEN;
+    }
+
+    hot_version* compiled = parser->alloc(parser, sizeof(hot_version));
+    if (!compiled) {
+        fclose(fptr);
+        return MUSTACHE_ERR_ALLOC;
+    }
+    memset(compiled, 0, sizeof(*compiled));
+
+    mustache_stream stream = {
+        .udata = fptr,
+        .readCallback = fread_callback,
+        .seekCallback = fseek_callback,
+    };
+    uint8_t err = mustache_compile_stream(parser, &stream, &compiled->chain);
+    fclose(fptr);
+    if (err) {
+        mustache_structure_chain_free(parser, &compiled->chain);
+        parser->free(parser, compiled);
+        return err;
+    }
+
+    *version = compiled;
+    return MUSTACHE_SUCCESS;
+}
+
+static void hot_version_free(mustache_parser* parser, hot_version* version)
+{
+    mustache_structure_chain_free(parser, &version->chain);
+    parser->free(parser, version);
+}
+
+/* returns once every render that began before the call has finished */
+static void hot_synchronize(hot_template* hot)
+{
+    int flip;
+    for (flip = 0; flip < 2; flip++)
+    {
+        uint32_t epoch = __atomic_load_n(&hot->epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&hot->epoch, epoch ^ 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&hot->readers[epoch], __ATOMIC_SEQ_CST)) {
+            struct timespec nap = { 0, 100000 };
+            nanosleep(&nap, NULL);
+        }
+    }
+}
+
+/* recompiles a template and publishes it, a file that fails to compile leaves the last good version */
+static void hot_reload(mustache_parser* parser, hot_template* hot)
+{
+    hot_version* version;
+    if (hot_compile(parser, (const uint8_t*)(hot + 1), &version)) {
+        return;
+    }
+
+    hot_version* retired = __atomic_exchange_n(&hot->current, version, __ATOMIC_SEQ_CST);
+    hot_synchronize(hot);
+    hot_version_free(parser, retired);
+}
+
+static void* hot_watcher_main(void* udata)
+{
+    hot_watcher* watcher = (hot_watcher*)udata;
+    uint8_t events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (true)
+    {
+        struct pollfd fds[2] = {
+            { .fd = watcher->inotifyFd, .events = POLLIN },
+            { .fd = watcher->stopFd, .events = POLLIN },
+        };
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+
+        ssize_t len = read(watcher->inotifyFd, events, sizeof(events));
+        if (len <= 0) {
+            continue;
+        }
+
+        /* one save raises several events, every template is reloaded at most once per batch */
+        pthread_mutex_lock(&watcher->lock);
+        const uint8_t* cur = events;
+        while (cur < events + len)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)cur;
+            hot_template* hot = watcher->templates;
+            while (hot)
+            {
+                if ((event->mask & IN_Q_OVERFLOW) ||
+                    (event->wd == hot->dirWatch && event->len && strlen(event->name) == hot->nameLen && strneql((const uint8_t*)event->name, hot->name, hot->nameLen)))
+                {
+                    hot->stale = true;
+                }
+                hot = hot->pNext;
+            }
+            cur += sizeof(struct inotify_event) + event->len;
+        }
+
+        hot_template* hot = watcher->templates;
+        while (hot)
+        {
+            if (hot->stale) {
+                hot->stale = false;
+                hot_reload(watcher->parser, hot);
+            }
+            hot = hot->pNext;
+        }
+        pthread_mutex_unlock(&watcher->lock);
+    }
+    return NULL;
+}
+
+uint8_t mustache_hot_watcher_start(mustache_parser* parser, mustache_hot_watcher* watcherHandle)
+{
+    hot_watcher* watcher = parser->alloc(parser, sizeof(hot_watcher));
+    if (!watcher) {
+        return MUSTACHE_ERR_ALLOC;
+    }
+    watcher->parser = parser;
+    watcher->templates = NULL;
+    watcher->inotifyFd = inotify_init1(IN_CLOEXEC);
+    watcher->stopFd = eventfd(0, EFD_CLOEXEC);
+    if (watcher->inotifyFd < 0 || watcher->stopFd < 0) {
+        goto fail_fds;
+    }
+    if (pthread_mutex_init(&watcher->lock, NULL)) {
+        goto fail_fds;
+    }
+    if (pthread_create(&watcher->thread, NULL, hot_watcher_main, watcher)) {
+        pthread_mutex_destroy(&watcher->lock);
+        goto fail_fds;
+    }
+
+    watcherHandle->__A = watcher;
+    return MUSTACHE_SUCCESS;
+
+fail_fds:
+    if (watcher->inotifyFd >= 0) {
+        close(watcher->inotifyFd);
+    }
+    if (watcher->stopFd >= 0) {
+        close(watcher->stopFd);
+    }
+    parser->free(parser, watcher);
+    return MUSTACHE_ERR;
+}
+
+uint8_t mustache_hot_template_open(mustache_parser* parser, mustache_hot_watcher* watcherHandle, mustache_const_slice filename, mustache_hot_template* hotHandle)
+{
+    hot_watcher* watcher = (hot_watcher*)watcherHandle->__A;
+#ifndef NDEBUG
+    if (!watcher) {
+        assert(00 && "mustache_hot_template_open: THE WATCHER WAS NOT STARTED!");
+    }
+#endif
+    if (!filename.len || filename.len > UINT32_MAX - 2) {
+        return MUSTACHE_ERR_ARGS;
+    }
+
+    hot_template* hot = parser->alloc(parser, sizeof(hot_template) + filename.len + 1);
+    if (!hot) {
+        return MUSTACHE_ERR_ALLOC;
+    }
+    uint8_t* path = (uint8_t*)(hot + 1);
+    memcpy(path, filename.u, filename.len);
+    path[filename.len] = 0;
+
+    hot->pNext = NULL;
+    hot->epoch = 0;
+    hot->readers[0] = 0;
+    hot->readers[1] = 0;
+    hot->stale = false;
+
+    /* the first version is compiled here so that no render ever compiles */
+    uint8_t err = hot_compile(parser, path, &hot->current);
+    if (err) {
+        parser->free(parser, hot);
+        return err;
+    }
+
+    /* split the path into the watched directory and the name events are matched against */
+    uint8_t* slash = path + filename.len;
+    while (slash > path && *(slash - 1) != '/') {
+        slash--;
+    }
+    hot->name = slash;
+    hot->nameLen = (uint32_t)(path + filename.len - slash);
+
+    if (slash == path) {
+        hot->dirWatch = inotify_add_watch(watcher->inotifyFd, ".", HOT_WATCH_MASK);
+    }
+    else if (slash - 1 == path) {
+        hot->dirWatch = inotify_add_watch(watcher->inotifyFd, "/", HOT_WATCH_MASK);
+    }
+    else {
+        *(slash - 1) = 0;
+        hot->dirWatch = inotify_add_watch(watcher->inotifyFd, (const char*)path, HOT_WATCH_MASK);
+        *(slash - 1) = '/';
+    }
+    if (hot->dirWatch < 0) {
+        hot_version_free(parser, hot->current);
+        parser->free(parser, hot);
+        return MUSTACHE_ERR_FILE_OPEN;
+    }
+
+    pthread_mutex_lock(&watcher->lock);
+    hot->pNext = watcher->templates;
+    watcher->templates = hot;
+    pthread_mutex_unlock(&watcher->lock);
+
+    hotHandle->__A = hot;
+    return MUSTACHE_SUCCESS;
+}
 
-            if (asTemplate->precedingSpaces>0) {
-                apply_spaces_to_source(asTemplate->precedingSpaces, parser, parsed_begin, parsed_end, outputBuffer, &bytesWritten);
-                outputHead+=bytesWritten;
-            }
+uint8_t mustache_hot_render(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_hot_template* hotHandle, mustache_param* params,
+    mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+{
+    hot_template* hot = (hot_template*)hotHandle->__A;
+
+    /* count the render in before the version is read, the watcher cannot free a version a counted render can see */
+    uint32_t epoch = __atomic_load_n(&hot->epoch, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&hot->readers[epoch], 1, __ATOMIC_SEQ_CST);
+    hot_version* version = __atomic_load_n(&hot->current, __ATOMIC_SEQ_CST);
+
+    uint8_t err = mustache_render(parser, parentStackBuffer, &version->chain, params, parseBuffer, parseCallbackUdata, parseCallback);
+
+    __atomic_fetch_sub(&hot->readers[epoch], 1, __ATOMIC_SEQ_CST);
+    return err;
+}
+
+void mustache_hot_template_close(mustache_parser* parser, mustache_hot_watcher* watcherHandle, mustache_hot_template* hotHandle)
+{
+    hot_watcher* watcher = (hot_watcher*)watcherHandle->__A;
+    hot_template* hot = (hot_template*)hotHandle->__A;
+
+    pthread_mutex_lock(&watcher->lock);
+    hot_template** link = &watcher->templates;
+    while (*link != hot) {
+        link = &(*link)->pNext;
+    }
+    *link = hot->pNext;
+
+    /* the directory stays watched while another template lives in it */
+    bool shared = false;
+    hot_template* other = watcher->templates;
+    while (other && !shared) {
+        shared = other->dirWatch == hot->dirWatch;
+        other = other->pNext;
+    }
+    if (!shared) {
+        inotify_rm_watch(watcher->inotifyFd, hot->dirWatch);
+    }
+    pthread_mutex_unlock(&watcher->lock);
+
+    hot_version_free(parser, hot->current);
+    parser->free(parser, hot);
+    memset(hotHandle, 0, sizeof(*hotHandle));
+}
+
+void mustache_hot_watcher_stop(mustache_parser* parser, mustache_hot_watcher* watcherHandle)
+{
+    hot_watcher* watcher = (hot_watcher*)watcherHandle->__A;
+
+    uint64_t stop = 1;
+    ssize_t written = write(watcher->stopFd, &stop, sizeof(stop));
+    (void)written;
+    pthread_join(watcher->thread, NULL);
+
+    /* templates left open are closed with the watcher */
+    while (watcher->templates)
+    {
+        hot_template* hot = watcher->templates;
+        watcher->templates = hot->pNext;
+        hot_version_free(parser, hot->current);
+        parser->free(parser, hot);
+    }
+
+    close(watcher->inotifyFd);
+    close(watcher->stopFd);
+    pthread_mutex_destroy(&watcher->lock);
+    parser->free(parser, watcher);
+    memset(watcherHandle, 0, sizeof(*watcherHandle));
+}
+
+#endif
+
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- -+- FILE LOADING  -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+static uint8_t load_check(const mustache_load* load)
+{
+    if (!load->structChain == !load->paramRoot) {
+        return MUSTACHE_ERR_ARGS;
+    }
+    if (load->structChain) {
+        root_structure* root = (root_structure*)load->structChain;
+        if (root->pNext || root->type == STRUCTURE_TYPE_ROOT) {
+            return MUSTACHE_ERR_ARGS;
         }
-        else if (mstruct->type == STRUCTURE_TYPE_VAR) 
-        {
-            var_structure* asVar = (var_structure*)mstruct;
-            const uint8_t* m_name_first = input + mstruct->contentsFirst;
-            const uint8_t* m_name_end = input + mstruct->contentsEnd;
-            const uint32_t nameLen = m_name_end - m_name_first;
+    }
+    /* the file's contents are freed once it is loaded, nothing can borrow from them */
+    else if (!(load->flags & MUSTACHE_JSON_DEEP_COPY) || (load->flags & (MUSTACHE_JSON_LAZY | MUSTACHE_JSON_KEEP_NUMERALS))) {
+        return MUSTACHE_ERR_ARGS;
+    }
+    return MUSTACHE_SUCCESS;
+}
 
-            outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, m_name_first - mstruct->precedingMustacheLen);
-            lastNonEscaped = m_name_end + strlen("{{");
+/* compiles or ingests a file's contents, a compiled chain takes them over */
+static uint8_t load_contents(mustache_parser* parser, mustache_load* load, uint8_t* contents, size_t len)
+{
+    uint8_t err;
+    if (load->structChain) {
+        err = compile_owned(parser, contents, len, load->structChain);
+    }
+    else {
+        err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ contents, len }, load->paramRoot, load->flags, load->filter);
+        parser->free(parser, contents);
+    }
+    return err;
+}
 
-            /* HANDLE '.' CASE */
-            if (*m_name_first == '.')
-            {
-                scoped_structure* parent = parent_stack_last(parentStack);
-                mustache_param* m_child = parent->curChild;
-                /* resolve '.' or chains '.member.name' */
-                mustache_param* member = resolve_param_member(m_child, m_name_first, m_name_end);
-                if (member) {
-                    outputHead = write_variable(member, outputHead, outputEnd, asVar->escapeHTML);
-                }
-            }
-            else if (!mstruct->param) {
-                const uint8_t* m_first_end = m_name_first;
-                while (m_first_end<m_name_end) {
-                    if (*m_first_end == '.' || *m_first_end == '[') {
-                        break;
-                    }
-                    m_first_end++;
-                }
+/* loads one file through stdio, anything that cannot be read ahead of time ends up here */
+static uint8_t load_blocking(mustache_parser* parser, mustache_load* load)
+{
+#ifndef NDEBUG
+    if (load->filename.len > 2048) {
+        assert(00 && "mustache_load_files: SUCH A LARGE FILENAME MAY RESULT IN PROGRAM INSTABILITY!");
+    }
+#endif
+    uint8_t* filenameNT = alloca(load->filename.len + 1);
+    memcpy(filenameNT, load->filename.u, load->filename.len);
+    filenameNT[load->filename.len] = 0;
 
-                
-                mstruct->param = get_parameter(m_name_first, m_first_end, globalParams, parentStack);
-                if (!mstruct->param) {
-                    goto skip_node;
-                }
-                if (m_first_end != m_name_end) {
-                    mustache_param* member = resolve_param_member(mstruct->param, m_first_end, m_name_end);
-                    mstruct->param = member;
-                }
-            }
-            if (mstruct->param) {
-                outputHead = write_variable(mstruct->param, outputHead, outputEnd, asVar->escapeHTML);
-                int p =0;
-            }
+    FILE* fptr = fopen((const char*)filenameNT, "rb");
+    if (!fptr) {
+        return MUSTACHE_ERR_FILE_OPEN;
+    }
+
+    mustache_stream stream = {
+        .udata = fptr,
+        .readCallback = fread_callback,
+        .seekCallback = fseek_callback,
+    };
+
+    uint8_t err;
+    if (load->structChain) {
+        err = mustache_compile_stream(parser, &stream, load->structChain);
+    }
+    else {
+        uint8_t chunk[16384];
+        err = mustache_JSON_to_param_chain_from_stream(parser, &stream, (mustache_slice){ chunk, sizeof(chunk) }, load->paramRoot, load->flags, load->filter);
+    }
+    fclose(fptr);
+    return err;
+}
+
+#ifdef MUSTACHE_IO_URING
+
+/* The reads of a batch are queued on an io_uring and each file is compiled or ingested as soon as its
+   read completes, while the reads behind it are still in flight. The ring is driven through the raw
+   system calls, the submission and completion queues are shared with the kernel through mappings. */
+
+typedef struct {
+    int fd;
+    uint32_t entries;
+    uint32_t* sqHead;
+    uint32_t* sqTail;
+    uint32_t sqMask;
+    uint32_t* sqArray;
+    struct io_uring_sqe* sqes;
+    uint32_t* cqHead;
+    uint32_t* cqTail;
+    uint32_t cqMask;
+    struct io_uring_cqe* cqes;
+
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+} uring;
+
+/* the reads a batch keeps in flight */
+#define LOAD_RING_ENTRIES 64
+/* a single read is capped, a larger file is read in several */
+#define LOAD_MAX_READ (1u << 30)
+
+typedef struct {
+    int fd;
+    uint8_t* contents;
+    size_t len;
+    size_t filled;
+} load_state;
+
+static bool uring_init(uring* ring, uint32_t entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return false;
+    }
+
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        ring->sqRingSize = ring->cqRingSize = max(ring->sqRingSize, ring->cqRingSize);
+    }
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring->cqRing = singleMap ? ring->sqRing : mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || (void*)ring->sqes == MAP_FAILED) {
+        if (ring->sqRing != MAP_FAILED) {
+            munmap(ring->sqRing, ring->sqRingSize);
         }
-        else if (mstruct->type == STRUCTURE_TYPE_ELSE)
-        {
-            else_structure* asElse = (else_structure*)mstruct;
-            const uint8_t* m_name_first = input + mstruct->contentsFirst + 1;
-            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+        if (!singleMap && ring->cqRing != MAP_FAILED) {
+            munmap(ring->cqRing, ring->cqRingSize);
+        }
+        if ((void*)ring->sqes != MAP_FAILED) {
+            munmap(ring->sqes, ring->sqesSize);
+        }
+        close(fd);
+        return false;
+    }
 
-            const uint8_t* interiorBegin = input + asElse->interiorBegin;
-            const uint8_t* interiorEnd = input + asElse->contentsEnd;
+    uint8_t* sq = ring->sqRing;
+    ring->sqHead = (uint32_t*)(sq + params.sq_off.head);
+    ring->sqTail = (uint32_t*)(sq + params.sq_off.tail);
+    ring->sqMask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (uint32_t*)(sq + params.sq_off.array);
 
+    uint8_t* cq = ring->cqRing;
+    ring->cqHead = (uint32_t*)(cq + params.cq_off.head);
+    ring->cqTail = (uint32_t*)(cq + params.cq_off.tail);
+    ring->cqMask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
 
-            scoped_structure* parentAsScoped = (scoped_structure*)asElse->parent;
+static void uring_free(uring* ring)
+{
+    munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != ring->sqRing) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    munmap(ring->sqRing, ring->sqRingSize);
+    close(ring->fd);
+}
 
-            if (!parentAsScoped->renderedLastEvaluation)
-            {
-                if (mstruct->standalone) {
-                    const uint8_t* t = input + mstruct->standalone->lineBegin;
-                    outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                    lastNonEscaped = input + mstruct->standalone->lineEnd + strlen("\n");
+/* queues the rest of a file's read, the caller never has more reads in flight than the ring has entries */
+static void uring_queue_read(uring* ring, load_state* state, uint32_t idx)
+{
+    uint32_t tail = *ring->sqTail;
+    uint32_t slot = tail & ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[slot];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = state->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(state->contents + state->filled);
+    sqe->len = (uint32_t)min(state->len - state->filled, (size_t)LOAD_MAX_READ);
+    sqe->off = state->filled;
+    sqe->user_data = idx;
+
+    ring->sqArray[slot] = slot;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* opens a file and sizes its contents, false sends the load down the blocking path */
+static bool load_open(mustache_parser* parser, const mustache_load* load, load_state* state)
+{
+    uint8_t* filenameNT = alloca(load->filename.len + 1);
+    memcpy(filenameNT, load->filename.u, load->filename.len);
+    filenameNT[load->filename.len] = 0;
+
+    /* only regular files have a size to read ahead of time, a fifo is not even opened here */
+    struct stat st;
+    if (stat((const char*)filenameNT, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX) {
+        return false;
+    }
+
+    state->fd = open((const char*)filenameNT, O_RDONLY | O_CLOEXEC);
+    if (state->fd < 0) {
+        return false;
+    }
+    state->len = (size_t)st.st_size;
+    state->filled = 0;
+    state->contents = parser->alloc(parser, state->len);
+    if (!state->contents) {
+        close(state->fd);
+        return false;
+    }
+    return true;
+}
+
+static void load_files_uring(mustache_parser* parser, uring* ring, mustache_load* loads, uint32_t count, load_state* states)
+{
+    uint32_t next = 0;
+    uint32_t inFlight = 0;
+    uint32_t queued = 0;
+
+    while (next < count || inFlight)
+    {
+        while (next < count && inFlight < ring->entries)
+        {
+            mustache_load* load = &loads[next];
+            load_state* state = &states[next];
+            if (!load->err) {
+                if (load_open(parser, load, state)) {
+                    uring_queue_read(ring, state, next);
+                    inFlight++;
+                    queued++;
                 }
                 else {
-                    const uint8_t* t = m_name_first - strlen("{{x");
-                    outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                    lastNonEscaped = m_name_end + strlen("{{");
+                    load->err = load_blocking(parser, load);
                 }
             }
-            else {
-                uint32_t nameLen = m_name_end - m_name_first;
-                const uint8_t* t;
-                if (mstruct->standalone) {
-                    t = input + mstruct->standalone->lineBegin;
-                }
-                else {
-                    t = m_name_first - strlen("{{x");
-                }
-                outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                lastNonEscaped = input + asElse->close->contentsEnd + strlen("}}");
+            next++;
+        }
+        if (!inFlight) {
+            break;
+        }
 
-                mstruct = (structure*)asElse->close;
-                goto skip_node_no_advance;
+        /* submit what was queued and wait for at least one read to complete */
+        int entered = (int)syscall(__NR_io_uring_enter, ring->fd, queued, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (entered < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
             }
+            /* the ring refused the submission, the reads it holds are done the blocking way */
+            break;
         }
-        else if (mstruct->type == STRUCTURE_TYPE_SCOPED_CARET || mstruct->type == STRUCTURE_TYPE_SCOPED_POUND) {
-            scoped_structure* asScoped = (scoped_structure*)mstruct;
-        
-            const uint8_t* m_name_first = input + mstruct->contentsFirst+1;
-            const uint8_t* m_name_end = input + mstruct->contentsEnd;
-
-            if (!mstruct->param) {
+        queued -= min((uint32_t)entered, queued);
 
-                const uint8_t* m_first_end = m_name_first;
-                while (m_first_end < m_name_end) {
-                    if (*m_first_end == '.' || *m_first_end == '[') {
+        uint32_t head = *ring->cqHead;
+        const uint32_t tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            const struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+            const uint32_t idx = (uint32_t)cqe->user_data;
+            const int32_t res = cqe->res;
+            head++;
+
+            mustache_load* load = &loads[idx];
+            load_state* state = &states[idx];
+            if (res > 0) {
+                state->filled += (size_t)res;
+            }
+            else if (res == 0) {
+                /* the file shrank after it was sized */
+                state->len = state->filled;
+            }
+            else {
+                /* a kernel without IORING_OP_READ, or a read that failed, finishes with pread */
+                while (state->filled < state->len) {
+                    ssize_t readBytes = pread(state->fd, state->contents + state->filled, state->len - state->filled, (off_t)state->filled);
+                    if (readBytes <= 0) {
+                        state->len = state->filled;
                         break;
                     }
-                    m_first_end++;
-                }
-
-                
-                mstruct->param = get_parameter(m_name_first, m_first_end, globalParams, parentStack);
-                if (!mstruct->param) {
-                    goto skip_node;
+                    state->filled += (size_t)readBytes;
                 }
+            }
 
-                if (m_first_end != m_name_end) {
-                    mstruct->param = resolve_param_member(mstruct->param, m_first_end, m_name_end);
-                }
+            if (state->filled < state->len) {
+                uring_queue_read(ring, state, idx);
+                queued++;
+                continue;
             }
 
-            asScoped->curIdx = 0;
-            
-            if (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND && mstruct->param && is_parent(mstruct->param))
-            {
-                parent_stack_push(parentStack, asScoped);
+            close(state->fd);
+            inFlight--;
+            load->err = load_contents(parser, load, state->contents, state->len);
+            state->contents = NULL;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
 
-                mustache_param_object* pAsObj = (mustache_param_object*)asScoped->param;
-                asScoped->curChild = pAsObj->pMembers;
+    /* only a failed ring leaves reads behind */
+    uint32_t i;
+    for (i = 0; i < next; i++) {
+        if (states[i].contents) {
+            close(states[i].fd);
+            parser->free(parser, states[i].contents);
+            states[i].contents = NULL;
+            loads[i].err = load_blocking(parser, &loads[i]);
+        }
+    }
+    for (; i < count; i++) {
+        if (!loads[i].err) {
+            loads[i].err = load_blocking(parser, &loads[i]);
+        }
+    }
+}
 
-                if (mstruct->standalone) {
-                    const uint8_t* t = input + mstruct->standalone->lineBegin;
-                    outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                    lastNonEscaped = input + mstruct->standalone->lineEnd + strlen("\n");
-                }
-                else {
-                    const uint8_t* t = m_name_first - strlen("{{x");
-                    outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                    lastNonEscaped = m_name_end + strlen("{{");
-                }
-            }
-            else if (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND || mstruct->type==STRUCTURE_TYPE_SCOPED_CARET) 
-            {
-                
-                scoped_structure* asScoped = (scoped_structure*)mstruct;
-               
-                if (!asScoped->wasEvaluated) {
-                    bool truthy = is_truthy(mstruct->param);
-                    asScoped->renderedLastEvaluation = (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND && truthy) || (mstruct->type == STRUCTURE_TYPE_SCOPED_CARET && !truthy);
-                    asScoped->wasEvaluated = true;
-                }
-                if (asScoped->renderedLastEvaluation)
-                {
-                    if (mstruct->standalone) {
-                        const uint8_t* t = input + mstruct->standalone->lineBegin;
-                        outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                        lastNonEscaped = input + mstruct->standalone->lineEnd + strlen("\n");
-                    }
-                    else {
-                        const uint8_t* t = m_name_first - strlen("{{x");
-                        outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                        lastNonEscaped = m_name_end + strlen("{{");
-                    }
-                }
-                else {
-                    uint32_t nameLen = m_name_end - m_name_first;
-                    const uint8_t* t;
-                    if (mstruct->standalone) {
-                        t = input + mstruct->standalone->lineBegin;
-                    } else {
-                        t = m_name_first - strlen("{{x");
-                    }
-                    outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, t);
-                    lastNonEscaped = input + asScoped->interiorEnd+nameLen+strlen("{{x}}");
+#endif
 
-                    mstruct = asScoped->close_or_else;
-                    goto skip_node_no_advance;
-                }
+uint8_t mustache_load_files(mustache_parser* parser, mustache_load* loads, uint32_t count)
+{
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        loads[i].err = load_check(&loads[i]);
+    }
+
+#ifdef MUSTACHE_IO_URING
+    uring ring;
+    load_state* states = count > 1 ? parser->alloc(parser, count * sizeof(load_state)) : NULL;
+    if (states && uring_init(&ring, min(count, LOAD_RING_ENTRIES))) {
+        memset(states, 0, count * sizeof(load_state));
+        load_files_uring(parser, &ring, loads, count, states);
+        uring_free(&ring);
+    }
+    else
+#endif
+    {
+        for (i = 0; i < count; i++) {
+            if (!loads[i].err) {
+                loads[i].err = load_blocking(parser, &loads[i]);
             }
         }
-        else if (mstruct->type == STRUCTURE_TYPE_COMMENT || mstruct->type == STRUCTURE_TYPE_CLOSE) 
-        {
-            const uint8_t* m_name_first = input + mstruct->contentsFirst+1;
-            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+    }
+#ifdef MUSTACHE_IO_URING
+    if (states) {
+        parser->free(parser, states);
+    }
+#endif
+
+    for (i = 0; i < count; i++) {
+        if (loads[i].err) {
+            return loads[i].err;
+        }
+    }
+    return MUSTACHE_SUCCESS;
+}
 
-            if (mstruct->type == STRUCTURE_TYPE_CLOSE)
-            {
-                close_structure* asClose = (close_structure*)mstruct;
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+- PATH PROJECTION -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
 
-                if (!mstruct->param) {
-                    mstruct->param = asClose->parent->param;
-                }
+/* A path set is a tree of the parameter names a template can reach, the root stands for the global
+   params. Lists are transparent, the elements of a list are matched against the list's own node,
+   since a template cannot tell a list from an object by name alone. A whole node keeps everything
+   below it, it stands in for the '.' and '[idx]' forms that reach children by position. */
+typedef struct path_node path_node;
+typedef struct path_node {
+    path_node* pNext;
+    path_node* pChildren;
+    mustache_const_slice name; /*stored right after the node*/
+    bool whole;
+} path_node;
 
-                if (!asClose->parent) {
-                    return MUSTACHE_ERR_INVALID_TEMPLATE;
-                }
+typedef struct {
+    path_node* root;
+} path_set;
 
-                scoped_structure* parent = asClose->parent;
+/* the frames a name can be resolved in, past this many the set gives up and keeps everything */
+#define PATH_MAX_VISIBLE 1024
 
-                if (parent->type!=STRUCTURE_TYPE_ELSE && parent->param) {
-                    if (parent->param->type == MUSTACHE_PARAM_LIST)
-                    {
-                        mustache_param_list* param = (mustache_param_list*)parent->param;
-                        parent->curIdx++;
-                        parent->curChild = parent->curChild->pNext;
-                        if (parent->curIdx < param->valueCount && parent->curChild)
-                        {
+typedef struct {
+    path_node** nodes;
+    uint32_t count;
+    uint32_t capacity;
+} path_scope;
 
-                            eval_jump(mstruct, m_name_first, m_name_end, input, outputEnd, &outputHead, &lastNonEscaped);
+/* the nested templates currently being walked, a template that includes itself is walked once */
+typedef struct path_visit path_visit;
+typedef struct path_visit {
+    path_visit* pLast;
+    mustache_param_template* templateParam;
+} path_visit;
 
-                            /* go to parent next again */
-                            mstruct = (structure*)parent;
-                            eval_jump(mstruct, m_name_first, m_name_end, input, outputEnd, &outputHead, &lastNonEscaped);
-                            goto skip_node;
-                        }
-                        else if (mstruct->param && is_parent(mstruct->param)) {
-                            parent_stack_pop(parentStack);
-                        }
-                    }
-                }
-            }
+static path_node* path_node_create(mustache_parser* parser, const uint8_t* nameFirst, const uint8_t* nameEnd)
+{
+    uint32_t nameLen = (uint32_t)(nameEnd - nameFirst);
+    path_node* node = parser->alloc(parser, sizeof(path_node) + nameLen);
+    if (!node) {
+        return NULL;
+    }
+    uint8_t* name = (uint8_t*)(node + 1);
+    memcpy(name, nameFirst, nameLen);
+    node->pNext = NULL;
+    node->pChildren = NULL;
+    node->name = (mustache_const_slice){ name, nameLen };
+    node->whole = false;
+    return node;
+}
 
-            eval_jump(mstruct, m_name_first, m_name_end, input, outputEnd, &outputHead, &lastNonEscaped);
+static const path_node* path_find_child(const path_node* parent, const uint8_t* nameFirst, uint64_t nameLen)
+{
+    const path_node* child = parent->pChildren;
+    while (child)
+    {
+        if (child->name.len == nameLen && strneql((const char*)child->name.u, (const char*)nameFirst, nameLen)) {
+            return child;
         }
+        child = child->pNext;
+    }
+    return NULL;
+}
 
-    skip_node:
-        mstruct = mstruct->pNext;
-    skip_node_no_advance:
-        mstruct = mstruct;
+/* inserts a dotted name below parent and returns its last node. Everything below a whole node is
+   already kept, so the whole node itself is returned. A name indexed with '[idx]' keeps all of its
+   first member, the index selects among those children by position. */
+static path_node* path_insert(mustache_parser* parser, path_node* parent, const uint8_t* nameFirst, const uint8_t* nameEnd)
+{
+    const uint8_t* segFirst = nameFirst;
+    bool indexed = memchr(nameFirst, '[', nameEnd - nameFirst) != NULL;
+
+    while (segFirst < nameEnd && !parent->whole)
+    {
+        const uint8_t* segEnd = segFirst;
+        while (segEnd < nameEnd && *segEnd != '.' && *segEnd != '[') {
+            segEnd++;
+        }
+        path_node* child = (path_node*)path_find_child(parent, segFirst, segEnd - segFirst);
+        if (!child) {
+            child = path_node_create(parser, segFirst, segEnd);
+            if (!child) {
+                return NULL;
+            }
+            child->pNext = parent->pChildren;
+            parent->pChildren = child;
+        }
+        parent = child;
+        if (indexed) {
+            parent->whole = true;
+            break;
+        }
+        segFirst = segEnd + 1;
     }
+    return parent;
+}
 
+static uint8_t path_scope_push(mustache_parser* parser, path_scope* scope, path_node* node)
+{
+    uint32_t i;
+    for (i = 0; i < scope->count; i++) {
+        if (scope->nodes[i] == node) {
+            return MUSTACHE_SUCCESS;
+        }
+    }
+    if (scope->count == scope->capacity) {
+        uint32_t capacity = scope->capacity ? scope->capacity * 2 : 16;
+        path_node** nodes = parser->alloc(parser, capacity * sizeof(path_node*));
+        if (!nodes) {
+            return MUSTACHE_ERR_ALLOC;
+        }
+        if (scope->nodes) {
+            memcpy(nodes, scope->nodes, scope->count * sizeof(path_node*));
+            parser->free(parser, scope->nodes);
+        }
+        scope->nodes = nodes;
+        scope->capacity = capacity;
+    }
+    scope->nodes[scope->count++] = node;
+    return MUSTACHE_SUCCESS;
+}
 
-    outputHead = mwrite(outputHead, outputEnd, lastNonEscaped, inputEnd);
-    *oh = outputHead;
+/* inserts a name below every frame it could be resolved in, the new nodes are pushed onto the scope
+   when pushFrames is set so that the names of a section's interior are inserted below them too. */
+static uint8_t path_insert_visible(mustache_parser* parser, path_scope* scope, const uint8_t* nameFirst, const uint8_t* nameEnd, bool pushFrames)
+{
+    const uint32_t visible = scope->count;
+    uint32_t i;
+    for (i = 0; i < visible; i++) {
+        path_node* node = path_insert(parser, scope->nodes[i], nameFirst, nameEnd);
+        if (!node) {
+            return MUSTACHE_ERR_ALLOC;
+        }
+        if (pushFrames) {
+            uint8_t err = path_scope_push(parser, scope, node);
+            if (err) {
+                return err;
+            }
+        }
+    }
     return MUSTACHE_SUCCESS;
 }
 
-void mustache_structure_chain_free(mustache_parser* p, mustache_structure* structure_chain)
+static uint8_t path_set_add_chain(mustache_parser* parser, path_set* set, structure* structureRoot, const uint8_t* input, uint64_t inputLen, mustache_param* params, path_visit* visited);
+
+/* walks the structures of a section's interior up to its closing structure, which is returned, or
+   up to the end of the chain. sectionFirst is the first scope node pushed by the innermost section. */
+static uint8_t path_walk(mustache_parser* parser, path_set* set, path_scope* scope, structure** cursor, uint32_t sectionFirst, const uint8_t* input,
+    mustache_param* params, path_visit* visited)
 {
-    structure* root = (structure*)structure_chain;
-    root = root->pNext;
-    while (root)
+    structure* mstruct = *cursor;
+    uint8_t err = MUSTACHE_SUCCESS;
+
+    while (mstruct && !set->root->whole)
     {
-        structure* next = root->pNext;
-        if (root->type == STRUCTURE_TYPE_ELSE) {
-            else_structure* as = (else_structure*)root;
-            if (as->standalone) {
-                p->free(p,as->standalone);
+        if (mstruct->type == STRUCTURE_TYPE_VAR) {
+            const uint8_t* m_name_first = input + mstruct->contentsFirst;
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+
+            if (*m_name_first == '.') {
+                /* '.' and '.member' reach into the current element of the innermost section */
+                uint32_t i;
+                for (i = sectionFirst; i < scope->count; i++) {
+                    scope->nodes[i]->whole = true;
+                }
             }
-        }
-        else if (root->type == STRUCTURE_TYPE_VAR) {
-            var_structure* as = (var_structure*)root;
-            if (as->standalone) {
-                p->free(p,as->standalone);
+            else {
+                err = path_insert_visible(parser, scope, m_name_first, m_name_end, false);
             }
         }
-        else if (root->type == STRUCTURE_TYPE_CLOSE) {
-            close_structure* as = (close_structure*)root;
-            if (as->standalone) {
-                p->free(p,as->standalone);
-            }
+        else if (mstruct->type == STRUCTURE_TYPE_LEN) {
+            len_structure* asLen = (len_structure*)mstruct;
+            err = path_insert_visible(parser, scope, input + asLen->interiorFirst, input + asLen->interiorEnd, false);
         }
-        else if (root->type == STRUCTURE_TYPE_SCOPED_CARET) {
-            scoped_structure* as = (scoped_structure*)root;
-            if (as->standalone) {
-                p->free(p,as->standalone);
+        else if (mstruct->type == STRUCTURE_TYPE_SCOPED_POUND || mstruct->type == STRUCTURE_TYPE_SCOPED_CARET) {
+            const uint8_t* m_name_first = input + mstruct->contentsFirst + 1;
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+            const uint32_t visible = scope->count;
+            const bool pushesFrame = mstruct->type == STRUCTURE_TYPE_SCOPED_POUND;
+
+            /* only a '#' section pushes a frame */
+            err = path_insert_visible(parser, scope, m_name_first, m_name_end, pushesFrame);
+            if (!err && scope->count > PATH_MAX_VISIBLE) {
+                set->root->whole = true;
+            }
+            if (!err) {
+                mstruct = mstruct->pNext;
+                err = path_walk(parser, set, scope, &mstruct, pushesFrame ? visible : sectionFirst, input, params, visited);
+            }
+            scope->count = visible;
+            if (err || !mstruct) {
+                break;
             }
         }
-        else if (root->type == STRUCTURE_TYPE_SCOPED_POUND) {
-            scoped_structure* as = (scoped_structure*)root;
-            if (as->standalone) {
-                p->free(p,as->standalone);
+        else if (mstruct->type == STRUCTURE_TYPE_CLOSE) {
+            break;
+        }
+        else if (mstruct->type == STRUCTURE_TYPE_NESTED_TEMPLATE) {
+            nested_template_structure* asTemplate = (nested_template_structure*)mstruct;
+            const uint8_t* m_name_first = input + mstruct->contentsFirst + (asTemplate->precedingMustacheLen - 2);
+            const uint8_t* m_name_end = input + mstruct->contentsEnd;
+
+            mustache_param_template* templateParam = get_nested_template_param(m_name_first, m_name_end, params);
+            path_visit* visit = visited;
+            while (visit && visit->templateParam != templateParam) {
+                visit = visit->pLast;
+            }
+            /* nested templates render against their own params with an empty parent stack */
+            if (templateParam && !visit) {
+                path_visit self = { visited, templateParam };
+                mustache_const_slice nestedSource = chain_source(templateParam->structure, templateParam->source);
+                err = path_set_add_chain(parser, set, (structure*)templateParam->structure, nestedSource.u, nestedSource.len,
+                    templateParam->parameters, &self);
             }
         }
-        
-        p->free(p,root);
-        root = next;
+
+        if (err) {
+            break;
+        }
+        mstruct = mstruct->pNext;
     }
 
-    memset(structure_chain, 0, sizeof(*structure_chain));
+    *cursor = mstruct;
+    return err;
 }
 
-void mustache_structure_chain_flush(mustache_structure* structure_chain)
+static uint8_t path_set_add_chain(mustache_parser* parser, path_set* set, structure* structureRoot, const uint8_t* input, uint64_t inputLen, mustache_param* params, path_visit* visited)
 {
-    structure* root = (structure*)structure_chain;
-    root = root->pNext;
-    while (root)
-    {
-        if (root->type == STRUCTURE_TYPE_SCOPED_CARET || root->type == STRUCTURE_TYPE_SCOPED_POUND)
-        {
-            scoped_structure* asScoped = (scoped_structure*)root;
+    uint8_t err;
+    if (!structureRoot->pNext) {
+        if (inputLen < 4 || inputLen >= UINT32_MAX - 3) {
+            return MUSTACHE_ERR_ARGS;
         }
-        root->param = NULL;
-        root = root->pNext;
+        err = source_to_structured(parser, structureRoot, (uint8_t*)input, (uint8_t*)input, (uint8_t*)input + inputLen);
+        if (err) {
+            return err;
+        }
+    }
+
+    /* a JSON tree is rendered either from its root param, reaching the members as 'root.name', or from
+       the root's members, reaching them as 'name'. Global names are inserted below 'root' as well. */
+    path_node* jsonRoot = path_insert(parser, set->root, (const uint8_t*)"root", (const uint8_t*)"root" + 4);
+    if (!jsonRoot) {
+        return MUSTACHE_ERR_ALLOC;
     }
+    path_scope scope = { NULL, 0, 0 };
+    err = path_scope_push(parser, &scope, set->root);
+    if (!err) {
+        err = path_scope_push(parser, &scope, jsonRoot);
+    }
+    if (!err) {
+        structure* mstruct = structureRoot->pNext;
+        err = path_walk(parser, set, &scope, &mstruct, scope.count, input, params, visited);
+    }
+    if (scope.nodes) {
+        parser->free(parser, scope.nodes);
+    }
+    return err;
 }
 
-uint8_t mustache_parse_file(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_const_slice filename, mustache_structure* structChain, mustache_param* params, mustache_slice sourceBuffer, mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+uint8_t mustache_path_set_add_template(mustache_parser* parser, mustache_path_set* paths, mustache_structure* structChain, mustache_const_slice source, mustache_param* params)
+{
+    path_set* set = (path_set*)paths;
+    source = chain_source(structChain, source);
+    if (!set->root) {
+        set->root = path_node_create(parser, source.u, source.u);
+        if (!set->root) {
+            return MUSTACHE_ERR_ALLOC;
+        }
+    }
+
+    uint8_t err = path_set_add_chain(parser, set, (structure*)structChain, source.u, source.len, params, NULL);
+    if (err) {
+        /* a partial set could filter out referenced params */
+        set->root->whole = true;
+    }
+    return err;
+}
+
+static void path_node_free(mustache_parser* parser, path_node* node)
+{
+    while (node)
+    {
+        path_node* next = node->pNext;
+        path_node_free(parser, node->pChildren);
+        parser->free(parser, node);
+        node = next;
+    }
+}
+
+void mustache_path_set_free(mustache_parser* parser, mustache_path_set* paths)
+{
+    path_set* set = (path_set*)paths;
+    if (set->root) {
+        path_node_free(parser, set->root);
+    }
+    memset(paths, 0, sizeof(*paths));
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+/* -+- -+- -+- -+- -+- -+-  JSON  PARSING  -+- -+- -+- -+- -+- -+- */
+/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
+
+uint8_t mustache_JSON_to_param_chain_from_disk(mustache_parser* parser, mustache_const_slice filename, mustache_param** paramRoot)
 {
 #ifndef NDEBUG
     if (filename.len > 2048) {
@@ -2330,634 +7366,2143 @@ uint8_t mustache_parse_file(mustache_parser* parser, mustache_slice parentStackB
     memcpy(filenameNT, filename.u, filename.len);
     filenameNT[filename.len] = 0;
 
+#ifdef MUSTACHE_MMAP
+    /* the whole document is indexed in place, the tree copies what it keeps out of the mapping */
+    mustache_const_slice view;
+    if (file_map(filenameNT, &view)) {
+        uint8_t err = mustache_JSON_to_param_chain(parser, view, paramRoot, MUSTACHE_JSON_DEEP_COPY, NULL);
+        file_unmap(view);
+        return err;
+    }
+#endif
+
     FILE* fptr;
     fptr = fopen(filenameNT, "rb");
     if (!fptr) {
         return MUSTACHE_ERR_FILE_OPEN;
     }
 
-    /* parse in chunks */
     mustache_stream stream = {
         .udata = fptr,
         .readCallback = fread_callback,
         .seekCallback = fseek_callback,
     };
 
-    uint8_t err = mustache_parse_stream(parser, parentStackBuffer, &stream, structChain, params, sourceBuffer, parseBuffer, parseCallbackUdata, parseCallback);
-    fclose(fptr);
-    return err;
+    /* the file is read a chunk at a time, only the tree it describes is kept */
+    uint8_t chunk[16384];
+    uint8_t err = mustache_JSON_to_param_chain_from_stream(parser, &stream, (mustache_slice){ chunk, sizeof(chunk) }, paramRoot, MUSTACHE_JSON_DEEP_COPY, NULL);
+
+    fclose(fptr);
+    return err;
+}
+
+
+/* The structural index finds every token of the input 64 bytes at a time. Each block is classified
+   into bitmasks, one bit per byte, and the masks are combined so that the bits left standing are the
+   structural characters outside strings, the quotes that open and close strings, and the first byte
+   of every number or literal. The parser then jumps from token to token instead of scanning bytes,
+   and the closing quote of a string is simply the token after its opening quote. */
+
+typedef struct {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t structural;    /* { } [ ] : , */
+    uint64_t whitespace;
+} JSON_block;
+
+typedef void (*JSON_classify_fn)(const uint8_t* block, JSON_block* out);
+
+static void JSON_classify_scalar(const uint8_t* block, JSON_block* out)
+{
+    *out = (JSON_block){ 0 };
+    uint32_t i;
+    for (i = 0; i < 64; ++i) {
+        uint64_t bit = 1ull << i;
+        switch (block[i])
+        {
+        case '\\':
+            out->backslash |= bit;
+            break;
+        case '"':
+            out->quote |= bit;
+            break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            out->structural |= bit;
+            break;
+        case ' ': case '\t': case '\n': case '\r':
+            out->whitespace |= bit;
+            break;
+        }
+    }
+}
+
+#if defined(MUSTACHE_SSE2)
+
+/* '[' and ']' differ from '{' and '}' only by bit 5, so setting it folds four compares into two */
+static void JSON_classify_sse2(const uint8_t* block, JSON_block* out)
+{
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bit5 = _mm_set1_epi8(0x20);
+    const __m128i openCurly = _mm_set1_epi8('{');
+    const __m128i closeCurly = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    *out = (JSON_block){ 0 };
+    uint32_t i;
+    for (i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(block + i * 16));
+        __m128i folded = _mm_or_si128(v, bit5);
+        __m128i structural = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openCurly), _mm_cmpeq_epi8(folded, closeCurly)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        uint32_t shift = i * 16;
+        out->backslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << shift;
+        out->quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << shift;
+        out->structural |= (uint64_t)(uint32_t)_mm_movemask_epi8(structural) << shift;
+        out->whitespace |= (uint64_t)(uint32_t)_mm_movemask_epi8(whitespace) << shift;
+    }
+}
+
+#if defined(MUSTACHE_AVX2)
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+static void JSON_classify_avx2(const uint8_t* block, JSON_block* out)
+{
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i bit5 = _mm256_set1_epi8(0x20);
+    const __m256i openCurly = _mm256_set1_epi8('{');
+    const __m256i closeCurly = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+
+    *out = (JSON_block){ 0 };
+    uint32_t i;
+    for (i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(block + i * 32));
+        __m256i folded = _mm256_or_si256(v, bit5);
+        __m256i structural = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, openCurly), _mm256_cmpeq_epi8(folded, closeCurly)),
+                                             _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        __m256i whitespace = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                                             _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+        uint32_t shift = i * 32;
+        out->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)) << shift;
+        out->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << shift;
+        out->structural |= (uint64_t)(uint32_t)_mm256_movemask_epi8(structural) << shift;
+        out->whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(whitespace) << shift;
+    }
+}
+
+#endif /* MUSTACHE_AVX2 */
+#endif /* MUSTACHE_SSE2 */
+
+/* the widest kernel the build targets, simd_select swaps in AVX2 while the program loads */
+#if defined(MUSTACHE_SSE2)
+static JSON_classify_fn JSON_classify = JSON_classify_sse2;
+#else
+static JSON_classify_fn JSON_classify = JSON_classify_scalar;
+#endif
+
+#if defined(MUSTACHE_AVX2)
+/* selects the AVX2 kernels once, before main or while the library loads, so no thread can read a
+   kernel pointer while it is written */
+#if defined(_MSC_VER)
+static void __cdecl simd_select(void);
+#pragma section(".CRT$XCU", read)
+__declspec(allocate(".CRT$XCU")) void (__cdecl* mustache_simd_select)(void) = simd_select;
+#if defined(_M_IX86)
+#pragma comment(linker, "/include:_mustache_simd_select")
+#else
+#pragma comment(linker, "/include:mustache_simd_select")
+#endif
+#else
+__attribute__((constructor))
+#endif
+static void simd_select(void)
+{
+    if (cpu_has_avx2()) {
+        escape_find = escape_find_avx2;
+        JSON_classify = JSON_classify_avx2;
+    }
+}
+#endif
+
+static uint32_t u64_ctz(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return i;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+/* returns the bytes escaped by a backslash. A run of backslashes escapes the byte after it only if
+   the run has odd length: adding the starts of odd aligned runs to the backslash mask carries through
+   each run, which flips the parity of the bits it leaves behind. */
+static uint64_t JSON_find_escaped(uint64_t backslash, uint64_t* prevEscaped)
+{
+    const uint64_t evenBits = 0x5555555555555555ull;
+
+    backslash &= ~*prevEscaped;
+    uint64_t followsEscape = (backslash << 1) | *prevEscaped;
+    uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    *prevEscaped = sequencesStartingOnEvenBits < backslash;
+    uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+/* bit i of the result is the xor of bits 0..i, which turns quote positions into string interiors */
+static uint64_t prefix_xor(uint64_t v) {
+    v ^= v << 1;
+    v ^= v << 2;
+    v ^= v << 4;
+    v ^= v << 8;
+    v ^= v << 16;
+    v ^= v << 32;
+    return v;
+}
+
+#define JSON_INDEX_BATCH_BLOCKS 64
+
+/* JSON read from a mustache_stream is indexed one region of a fixed buffer at a time. A region ends
+   right after a bracket or comma outside of a string, so every key and value in it is complete and
+   the parser holds no pointer into the buffer when the next region replaces it. The unparsed tail
+   is carried over to the front of the buffer, which only grows when a single key and value do not
+   fit in it. */
+typedef struct {
+    mustache_parser* parser;
+    mustache_stream* stream;
+    uint8_t* buf;
+    size_t capacity;
+    size_t filled;
+    bool ownsBuf;   /*the buffer outgrew the caller's and was allocated*/
+    bool eof;
+    uint8_t err;
+} JSON_reader;
+
+#define JSON_READER_MIN_CHUNK 4096
+
+/* tokens are found a batch of blocks at a time so the index stays on the stack, offsets are relative
+   to batchBase. The carries hold the state at the end of the last block indexed. */
+typedef struct {
+    const uint8_t* cur;
+    const uint8_t* sourceEnd;
+    const uint8_t* batchBase;
+    uint64_t prevEscaped;   /*1 if the first byte of the next block is escaped*/
+    uint64_t prevInString;  /*all ones if the next block starts inside a string*/
+    uint64_t prevScalar;    /*1 if the last byte indexed was part of a number or literal*/
+    uint32_t count;
+    uint32_t next;
+    JSON_reader* reader;    /*refills the index once the region is exhausted, NULL for input held in memory*/
+    uint16_t tokens[JSON_INDEX_BATCH_BLOCKS * 64];
+} JSON_index;
+
+static void JSON_index_init(JSON_index* index, const uint8_t* source, const uint8_t* sourceEnd)
+{
+    index->cur = source;
+    index->sourceEnd = sourceEnd;
+    index->batchBase = source;
+    index->prevEscaped = 0;
+    index->prevInString = 0;
+    index->prevScalar = 0;
+    index->count = 0;
+    index->next = 0;
+    index->reader = NULL;
 }
 
-uint8_t mustache_parse_stream(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_stream* stream, mustache_structure* structChain,
-    mustache_param* params, mustache_slice inputBuffer, mustache_slice outputBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback)
+static void JSON_index_batch(JSON_index* index)
 {
-    uint8_t* inputHead = inputBuffer.u;
-    uint8_t* inputBeg = inputBuffer.u;
+    index->batchBase = index->cur;
+    index->count = 0;
+    index->next = 0;
 
-    uint8_t* mustacheOpen = NULL;
-    uint8_t* mustacheClose = inputBuffer.u;
+    uint32_t b;
+    for (b = 0; b < JSON_INDEX_BATCH_BLOCKS && index->cur < index->sourceEnd; ++b)
+    {
+        JSON_block block;
+        size_t remaining = index->sourceEnd - index->cur;
+        if (remaining >= 64) {
+            JSON_classify(index->cur, &block);
+        }
+        else {
+            /* the tail is padded with whitespace, which never produces a token */
+            uint8_t padded[64];
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, index->cur, remaining);
+            JSON_classify(padded, &block);
+        }
 
-    size_t streamLen = stream->seekCallback(stream->udata, 0, MUSTACHE_SEEK_LEN);
-    size_t readBytes = stream->readCallback(stream->udata, inputBuffer.u, inputBuffer.len);
-    if (readBytes < streamLen) {
-        return MUSTACHE_ERR_NO_SPACE;
+        uint64_t escaped = JSON_find_escaped(block.backslash, &index->prevEscaped);
+        uint64_t quote = block.quote & ~escaped;
+        /* covers the opening quote and the string's contents but not its closing quote */
+        uint64_t inString = prefix_xor(quote) ^ index->prevInString;
+        index->prevInString = (uint64_t)((int64_t)inString >> 63);
+
+        uint64_t scalar = ~(block.structural | block.whitespace | quote | inString);
+        uint64_t scalarStart = scalar & ~((scalar << 1) | index->prevScalar);
+        index->prevScalar = scalar >> 63;
+
+        uint64_t tokens = (block.structural & ~inString) | quote | scalarStart;
+        uint16_t offset = (uint16_t)(index->cur - index->batchBase);
+        while (tokens) {
+            index->tokens[index->count++] = offset + (uint16_t)u64_ctz(tokens);
+            tokens &= tokens - 1;
+        }
+        index->cur += min(remaining, 64);
     }
+}
 
-    uint8_t* inputEnd = inputBuffer.u + readBytes;
+/* returns one past the last bracket or comma outside of a string, or NULL if there is none */
+static const uint8_t* JSON_find_region_end(const uint8_t* source, const uint8_t* sourceEnd)
+{
+    const uint8_t* regionEnd = NULL;
+    uint64_t prevEscaped = 0;
+    uint64_t prevInString = 0;
+    const uint8_t* cur;
+    for (cur = source; cur < sourceEnd; cur += 64)
+    {
+        JSON_block block;
+        size_t remaining = sourceEnd - cur;
+        if (remaining >= 64) {
+            JSON_classify(cur, &block);
+        }
+        else {
+            uint8_t padded[64];
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, cur, remaining);
+            JSON_classify(padded, &block);
+        }
 
+        uint64_t escaped = JSON_find_escaped(block.backslash, &prevEscaped);
+        uint64_t quote = block.quote & ~escaped;
+        uint64_t inString = prefix_xor(quote) ^ prevInString;
+        prevInString = (uint64_t)((int64_t)inString >> 63);
 
-    if (readBytes < 4 || readBytes >= UINT32_MAX-3) {
-        return MUSTACHE_ERR_ARGS;
+        uint64_t structural = block.structural & ~inString;
+        while (structural) {
+            const uint8_t* token = cur + u64_ctz(structural);
+            if (*token != ':') {
+                regionEnd = token + 1;
+            }
+            structural &= structural - 1;
+        }
     }
+    return regionEnd;
+}
 
-    uint8_t* outputHead = outputBuffer.u;
-    uint8_t* outputEnd = outputBuffer.u + outputBuffer.len;
-
-    parent_stack parentStack = {
-        .buf =  parentStackBuffer,
-        .count = 0,
-        .MAX_COUNT = parentStackBuffer.len / sizeof(void*)
-    };
-
-    structure* structureRoot = (structure*)structChain;
+static bool JSON_reader_grow(JSON_reader* reader)
+{
+    size_t capacity = max(reader->capacity * 2, JSON_READER_MIN_CHUNK);
+    uint8_t* buf = reader->parser->alloc(reader->parser, capacity);
+    if (!buf) {
+        reader->err = MUSTACHE_ERR_ALLOC;
+        return false;
+    }
+    if (reader->filled) {
+        memcpy(buf, reader->buf, reader->filled);
+    }
+    if (reader->ownsBuf) {
+        reader->parser->free(reader->parser, reader->buf);
+    }
+    reader->buf = buf;
+    reader->capacity = capacity;
+    reader->ownsBuf = true;
+    return true;
+}
 
-    MUSTACHE_RES err;
-    if (!structureRoot->pNext) {
-        err = source_to_structured(parser, structureRoot, inputBuffer.u, inputHead, inputEnd);
-        if (err) {
-            return err;
-        }
+/* carries the bytes from regionEnd on to the front of the buffer and fills the rest from the stream.
+   Returns the end of the next region, which starts at the front of the buffer, or NULL once the
+   stream is exhausted. The last region holds whatever is left when the stream ends. */
+static const uint8_t* JSON_reader_next_region(JSON_reader* reader, const uint8_t* regionEnd)
+{
+    size_t carry = reader->buf + reader->filled - regionEnd;
+    if (carry) {
+        memmove(reader->buf, regionEnd, carry);
     }
-    else {
+    reader->filled = carry;
 
-        /* RESET EVAL STATE */
-        structure* root = (structure*)structureRoot;
-        root = root->pNext;
-        while (root)
-        {
-            if (root->type == STRUCTURE_TYPE_SCOPED_CARET || root->type == STRUCTURE_TYPE_SCOPED_POUND)
-            {
-                scoped_structure* asScoped = (scoped_structure*)root;
-                asScoped->wasEvaluated = false;
+    while (true)
+    {
+        while (!reader->eof && reader->filled < reader->capacity) {
+            size_t read = reader->stream->readCallback(reader->stream->udata, reader->buf + reader->filled, reader->capacity - reader->filled);
+            if (read == 0) {
+                reader->eof = true;
             }
-            root = root->pNext;
+            reader->filled += read;
+        }
+        if (reader->eof) {
+            return reader->filled ? reader->buf + reader->filled : NULL;
+        }
+        const uint8_t* end = JSON_find_region_end(reader->buf, reader->buf + reader->filled);
+        if (end) {
+            return end;
+        }
+        if (!JSON_reader_grow(reader)) {
+            return NULL;
         }
     }
+}
 
-    err = write_structured(
-        outputBuffer, &outputHead,
-        (mustache_const_slice){ inputBuffer.u,inputBuffer.len },
-        inputBuffer.u + readBytes,
-        structureRoot, params, &parentStack,
-        parser
-    );
-
-    if (err) {
-        return err;
+/* returns the next token, or NULL once the input is exhausted */
+static const uint8_t* JSON_index_next(JSON_index* index)
+{
+    while (index->next == index->count) {
+        if (index->cur >= index->sourceEnd) {
+            if (!index->reader) {
+                return NULL;
+            }
+            /* a region starts outside of any string, number or escape */
+            const uint8_t* regionEnd = JSON_reader_next_region(index->reader, index->sourceEnd);
+            if (!regionEnd) {
+                return NULL;
+            }
+            JSON_reader* reader = index->reader;
+            JSON_index_init(index, reader->buf, regionEnd);
+            index->reader = reader;
+        }
+        JSON_index_batch(index);
     }
-
-    mustache_slice parsedSlice = {
-        .u = outputBuffer.u,
-        .len = outputHead - outputBuffer.u,
-    };
-
-    parseCallback(parser, parseCallbackUdata, parsedSlice);
-
-    return MUSTACHE_SUCCESS;
+    return index->batchBase + index->tokens[index->next++];
 }
 
+/* With MUSTACHE_JSON_ARENA every node, name and copied string of the tree is carved out of a chain
+   of blocks, each twice the size of the last, rather than allocated on its own. The arena header is
+   the first allocation of the first block and the root object the second, so mustache_free_param_list
+   finds the chain from the root and releases the whole tree a block at a time. */
 
+#define JSON_ARENA_ALIGN 8
+#define JSON_ARENA_MIN_BLOCK 4096
+#define JSON_ARENA_ROUND(N) (((N) + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1))
 
+typedef struct JSON_arena_block {
+    struct JSON_arena_block* next;
+    size_t used;
+    size_t capacity;
+} JSON_arena_block;
 
+typedef struct {
+    JSON_arena_block* first;
+    JSON_arena_block* current;
+    uint32_t flags;             /*the MUSTACHE_JSON_FLAGS the tree was built with*/
+} JSON_arena;
 
+static uint8_t* JSON_arena_block_data(JSON_arena_block* block) {
+    return (uint8_t*)block + JSON_ARENA_ROUND(sizeof(JSON_arena_block));
+}
 
+static JSON_arena_block* JSON_arena_block_create(mustache_parser* parser, size_t capacity)
+{
+    JSON_arena_block* block = parser->alloc(parser, JSON_ARENA_ROUND(sizeof(JSON_arena_block)) + capacity);
+    if (!block) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->used = 0;
+    block->capacity = capacity;
+    return block;
+}
 
+/* sizes the first block to the JSON source, which is usually outgrown by a small factor */
+static JSON_arena* JSON_arena_create(mustache_parser* parser, size_t sourceLen, uint32_t flags)
+{
+    JSON_arena_block* block = JSON_arena_block_create(parser, JSON_ARENA_ROUND(max(sourceLen, JSON_ARENA_MIN_BLOCK)));
+    if (!block) {
+        return NULL;
+    }
+    JSON_arena* arena = (JSON_arena*)JSON_arena_block_data(block);
+    block->used = JSON_ARENA_ROUND(sizeof(JSON_arena));
+    arena->first = block;
+    arena->current = block;
+    arena->flags = flags;
+    return arena;
+}
 
+static void JSON_arena_free(mustache_parser* parser, JSON_arena* arena)
+{
+    JSON_arena_block* block = arena->first;
+    while (block) {
+        JSON_arena_block* next = block->next;
+        parser->free(parser, block);
+        block = next;
+    }
+}
 
+/* allocates from the arena if there is one, otherwise from parser->alloc */
+static void* JSON_alloc(mustache_parser* parser, JSON_arena* arena, size_t bytes)
+{
+    if (!arena) {
+        return parser->alloc(parser, bytes);
+    }
 
+    bytes = JSON_ARENA_ROUND(bytes);
+    JSON_arena_block* block = arena->current;
+    if (block->capacity - block->used < bytes) {
+        JSON_arena_block* next = JSON_arena_block_create(parser, max(block->capacity * 2, bytes));
+        if (!next) {
+            return NULL;
+        }
+        block->next = next;
+        arena->current = next;
+        block = next;
+    }
+    void* mem = JSON_arena_block_data(block) + block->used;
+    block->used += bytes;
+    return mem;
+}
 
+/* memory in an arena is only released along with the whole tree */
+static void JSON_free(mustache_parser* parser, JSON_arena* arena, void* mem)
+{
+    if (!arena) {
+        parser->free(parser, mem);
+    }
+}
 
+/* returns the arena a tree built with MUSTACHE_JSON_ARENA was placed in */
+static JSON_arena* JSON_arena_of(mustache_param* root) {
+    return (JSON_arena*)((uint8_t*)root - JSON_ARENA_ROUND(sizeof(JSON_arena)));
+}
 
 
+typedef struct {
+    uint64_t mantissa;          /*the first 19 significant digits*/
+    int64_t exponent;           /*the value is mantissa * 10^exponent*/
+    uint32_t fractionDigits;    /*digits written after the '.'*/
+    bool negative;
+    bool hasExponent;
+    bool truncated;             /*the number has more than 19 significant digits*/
+} JSON_number;
+
+static bool is_digit(uint8_t c) {
+    return (uint8_t)(c - '0') < 10;
+}
 
+/* returns true if the 8 bytes of v, loaded in little endian order, are all ASCII digits */
+static bool is_eight_digits(uint64_t v) {
+    return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
 
+/* converts 8 ASCII digits, loaded in little endian order, with three multiplies */
+static uint32_t parse_eight_digits(uint64_t v) {
+    const uint64_t mask = 0x000000FF000000FFull;
+    const uint64_t mul1 = 0x000F424000000064ull; /* 100 + (1000000 << 32) */
+    const uint64_t mul2 = 0x0000271000000001ull; /* 1 + (10000 << 32) */
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)v;
+}
 
-/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
-/* -+- -+- -+- -+- -+- -+-  JSON  PARSING  -+- -+- -+- -+- -+- -+- */
-/* =#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#==#= */
-
-uint8_t mustache_JSON_to_param_chain_from_disk(mustache_parser* parser, mustache_const_slice filename, mustache_param** paramRoot)
+/* accumulates the digits in [cur, end) into mantissa, 8 at a time where possible, and returns
+   the first byte that is not a digit. The mantissa wraps if there are more than 19 digits. */
+static const uint8_t* JSON_parse_digits(const uint8_t* cur, const uint8_t* end, uint64_t* mantissa)
 {
-#ifndef NDEBUG
-    if (filename.len > 2048) {
-        assert(00 && "mustache_parse_file: SUCH A LARGE FILENAME MAY RESULT IN PROGRAM INSTABILITY!");
+    uint64_t m = *mantissa;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (end - cur >= 8) {
+        uint64_t v;
+        memcpy(&v, cur, sizeof(v));
+        if (!is_eight_digits(v)) {
+            break;
+        }
+        m = m * 100000000 + parse_eight_digits(v);
+        cur += 8;
     }
 #endif
-    /* tragically fopen requires a null terminated string, and there is no workaround even for an all-around */
-    /* system specific design, it's possible on Windows but not on Linux to my knowledge :( */
-    uint8_t* filenameNT = alloca(filename.len + 1);
-    memcpy(filenameNT, filename.u, filename.len);
-    filenameNT[filename.len] = 0;
-
-    FILE* fptr;
-    fptr = fopen(filenameNT, "rb");
-    if (!fptr) {
-        return MUSTACHE_ERR_FILE_OPEN;
+    while (cur < end && is_digit(*cur)) {
+        m = m * 10 + (*cur - '0');
+        cur++;
     }
+    *mantissa = m;
+    return cur;
+}
 
-    fseek(fptr, 0, SEEK_END);
-    uint32_t fileLen = ftell(fptr);
-    rewind(fptr);
-
-    void* JSON_buf;
-    bool isBufferOnStack = fileLen < (16384);
+/* parses an RFC 8259 number and returns the first byte after it, or NULL if it is malformed */
+static const uint8_t* JSON_parse_number(const uint8_t* cur, const uint8_t* sourceEnd, JSON_number* num)
+{
+    num->negative = cur < sourceEnd && *cur == '-';
+    if (num->negative) {
+        cur++;
+    }
+    if (cur == sourceEnd || !is_digit(*cur)) {
+        return NULL;
+    }
 
-    if (!isBufferOnStack) {
-        JSON_buf = parser->alloc(parser, fileLen);
+    uint64_t mantissa = 0;
+    const uint8_t* intFirst = cur;
+    if (*cur == '0') {
+        cur++;
+        if (cur < sourceEnd && is_digit(*cur)) {
+            return NULL; /* leading zeros are not allowed */
+        }
     }
     else {
-        JSON_buf = alloca(fileLen);
+        cur = JSON_parse_digits(cur, sourceEnd, &mantissa);
     }
+    const uint8_t* intEnd = cur;
+    int64_t exponent = 0;
 
-    fread(JSON_buf, 1, fileLen, fptr);
+    const uint8_t* fracFirst = NULL;
+    if (cur < sourceEnd && *cur == '.') {
+        cur++;
+        fracFirst = cur;
+        cur = JSON_parse_digits(cur, sourceEnd, &mantissa);
+        if (cur == fracFirst) {
+            return NULL;
+        }
+        exponent = fracFirst - cur;
+    }
+    const uint8_t* fracEnd = cur;
+    num->fractionDigits = fracFirst ? (uint32_t)(fracEnd - fracFirst) : 0;
 
-    uint8_t err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ JSON_buf, fileLen}, paramRoot, true);
+    int64_t explicitExp = 0;
+    num->hasExponent = cur < sourceEnd && (*cur == 'e' || *cur == 'E');
+    if (num->hasExponent) {
+        cur++;
+        bool negExp = false;
+        if (cur < sourceEnd && (*cur == '-' || *cur == '+')) {
+            negExp = *cur == '-';
+            cur++;
+        }
+        if (cur == sourceEnd || !is_digit(*cur)) {
+            return NULL;
+        }
+        while (cur < sourceEnd && is_digit(*cur)) {
+            if (explicitExp < 0x10000000) {
+                explicitExp = explicitExp * 10 + (*cur - '0');
+            }
+            cur++;
+        }
+        if (negExp) {
+            explicitExp = -explicitExp;
+        }
+        exponent += explicitExp;
+    }
 
-    fclose(fptr);
-    if (!isBufferOnStack) {
-        parser->free(parser, JSON_buf);
+    /* beyond 19 digits the mantissa wrapped, keep the 19 most significant ones instead */
+    num->truncated = false;
+    uint64_t digitCount = (intEnd - intFirst) + num->fractionDigits;
+    if (digitCount > 19) {
+        const uint8_t* p = intFirst;
+        while (p < fracEnd && (*p == '0' || *p == '.')) {
+            if (*p == '0') {
+                digitCount--;
+            }
+            p++;
+        }
+        if (digitCount > 19) {
+            const uint64_t minNineteenDigits = 1000000000000000000ull;
+            num->truncated = true;
+            mantissa = 0;
+            p = intFirst;
+            while (mantissa < minNineteenDigits && p < intEnd) {
+                mantissa = mantissa * 10 + (*p - '0');
+                p++;
+            }
+            if (mantissa >= minNineteenDigits) {
+                exponent = (intEnd - p) + explicitExp;
+            }
+            else {
+                p = fracFirst;
+                while (mantissa < minNineteenDigits && p < fracEnd) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    p++;
+                }
+                exponent = (fracFirst - p) + explicitExp;
+            }
+        }
     }
-    return err;
+
+    num->mantissa = mantissa;
+    num->exponent = exponent;
+    return cur;
 }
 
+/* the 128 bit significands of 5^q for q in [-342, 308], high word first */
+static const uint64_t power_of_five_128[651][2] = {
+    { 0xEEF453D6923BD65AULL, 0x113FAA2906A13B3FULL },
+    { 0x9558B4661B6565F8ULL, 0x4AC7CA59A424C507ULL },
+    { 0xBAAEE17FA23EBF76ULL, 0x5D79BCF00D2DF649ULL },
+    { 0xE95A99DF8ACE6F53ULL, 0xF4D82C2C107973DCULL },
+    { 0x91D8A02BB6C10594ULL, 0x79071B9B8A4BE869ULL },
+    { 0xB64EC836A47146F9ULL, 0x9748E2826CDEE284ULL },
+    { 0xE3E27A444D8D98B7ULL, 0xFD1B1B2308169B25ULL },
+    { 0x8E6D8C6AB0787F72ULL, 0xFE30F0F5E50E20F7ULL },
+    { 0xB208EF855C969F4FULL, 0xBDBD2D335E51A935ULL },
+    { 0xDE8B2B66B3BC4723ULL, 0xAD2C788035E61382ULL },
+    { 0x8B16FB203055AC76ULL, 0x4C3BCB5021AFCC31ULL },
+    { 0xADDCB9E83C6B1793ULL, 0xDF4ABE242A1BBF3DULL },
+    { 0xD953E8624B85DD78ULL, 0xD71D6DAD34A2AF0DULL },
+    { 0x87D4713D6F33AA6BULL, 0x8672648C40E5AD68ULL },
+    { 0xA9C98D8CCB009506ULL, 0x680EFDAF511F18C2ULL },
+    { 0xD43BF0EFFDC0BA48ULL, 0x0212BD1B2566DEF2ULL },
+    { 0x84A57695FE98746DULL, 0x014BB630F7604B57ULL },
+    { 0xA5CED43B7E3E9188ULL, 0x419EA3BD35385E2DULL },
+    { 0xCF42894A5DCE35EAULL, 0x52064CAC828675B9ULL },
+    { 0x818995CE7AA0E1B2ULL, 0x7343EFEBD1940993ULL },
+    { 0xA1EBFB4219491A1FULL, 0x1014EBE6C5F90BF8ULL },
+    { 0xCA66FA129F9B60A6ULL, 0xD41A26E077774EF6ULL },
+    { 0xFD00B897478238D0ULL, 0x8920B098955522B4ULL },
+    { 0x9E20735E8CB16382ULL, 0x55B46E5F5D5535B0ULL },
+    { 0xC5A890362FDDBC62ULL, 0xEB2189F734AA831DULL },
+    { 0xF712B443BBD52B7BULL, 0xA5E9EC7501D523E4ULL },
+    { 0x9A6BB0AA55653B2DULL, 0x47B233C92125366EULL },
+    { 0xC1069CD4EABE89F8ULL, 0x999EC0BB696E840AULL },
+    { 0xF148440A256E2C76ULL, 0xC00670EA43CA250DULL },
+    { 0x96CD2A865764DBCAULL, 0x380406926A5E5728ULL },
+    { 0xBC807527ED3E12BCULL, 0xC605083704F5ECF2ULL },
+    { 0xEBA09271E88D976BULL, 0xF7864A44C633682EULL },
+    { 0x93445B8731587EA3ULL, 0x7AB3EE6AFBE0211DULL },
+    { 0xB8157268FDAE9E4CULL, 0x5960EA05BAD82964ULL },
+    { 0xE61ACF033D1A45DFULL, 0x6FB92487298E33BDULL },
+    { 0x8FD0C16206306BABULL, 0xA5D3B6D479F8E056ULL },
+    { 0xB3C4F1BA87BC8696ULL, 0x8F48A4899877186CULL },
+    { 0xE0B62E2929ABA83CULL, 0x331ACDABFE94DE87ULL },
+    { 0x8C71DCD9BA0B4925ULL, 0x9FF0C08B7F1D0B14ULL },
+    { 0xAF8E5410288E1B6FULL, 0x07ECF0AE5EE44DD9ULL },
+    { 0xDB71E91432B1A24AULL, 0xC9E82CD9F69D6150ULL },
+    { 0x892731AC9FAF056EULL, 0xBE311C083A225CD2ULL },
+    { 0xAB70FE17C79AC6CAULL, 0x6DBD630A48AAF406ULL },
+    { 0xD64D3D9DB981787DULL, 0x092CBBCCDAD5B108ULL },
+    { 0x85F0468293F0EB4EULL, 0x25BBF56008C58EA5ULL },
+    { 0xA76C582338ED2621ULL, 0xAF2AF2B80AF6F24EULL },
+    { 0xD1476E2C07286FAAULL, 0x1AF5AF660DB4AEE1ULL },
+    { 0x82CCA4DB847945CAULL, 0x50D98D9FC890ED4DULL },
+    { 0xA37FCE126597973CULL, 0xE50FF107BAB528A0ULL },
+    { 0xCC5FC196FEFD7D0CULL, 0x1E53ED49A96272C8ULL },
+    { 0xFF77B1FCBEBCDC4FULL, 0x25E8E89C13BB0F7AULL },
+    { 0x9FAACF3DF73609B1ULL, 0x77B191618C54E9ACULL },
+    { 0xC795830D75038C1DULL, 0xD59DF5B9EF6A2417ULL },
+    { 0xF97AE3D0D2446F25ULL, 0x4B0573286B44AD1DULL },
+    { 0x9BECCE62836AC577ULL, 0x4EE367F9430AEC32ULL },
+    { 0xC2E801FB244576D5ULL, 0x229C41F793CDA73FULL },
+    { 0xF3A20279ED56D48AULL, 0x6B43527578C1110FULL },
+    { 0x9845418C345644D6ULL, 0x830A13896B78AAA9ULL },
+    { 0xBE5691EF416BD60CULL, 0x23CC986BC656D553ULL },
+    { 0xEDEC366B11C6CB8FULL, 0x2CBFBE86B7EC8AA8ULL },
+    { 0x94B3A202EB1C3F39ULL, 0x7BF7D71432F3D6A9ULL },
+    { 0xB9E08A83A5E34F07ULL, 0xDAF5CCD93FB0CC53ULL },
+    { 0xE858AD248F5C22C9ULL, 0xD1B3400F8F9CFF68ULL },
+    { 0x91376C36D99995BEULL, 0x23100809B9C21FA1ULL },
+    { 0xB58547448FFFFB2DULL, 0xABD40A0C2832A78AULL },
+    { 0xE2E69915B3FFF9F9ULL, 0x16C90C8F323F516CULL },
+    { 0x8DD01FAD907FFC3BULL, 0xAE3DA7D97F6792E3ULL },
+    { 0xB1442798F49FFB4AULL, 0x99CD11CFDF41779CULL },
+    { 0xDD95317F31C7FA1DULL, 0x40405643D711D583ULL },
+    { 0x8A7D3EEF7F1CFC52ULL, 0x482835EA666B2572ULL },
+    { 0xAD1C8EAB5EE43B66ULL, 0xDA3243650005EECFULL },
+    { 0xD863B256369D4A40ULL, 0x90BED43E40076A82ULL },
+    { 0x873E4F75E2224E68ULL, 0x5A7744A6E804A291ULL },
+    { 0xA90DE3535AAAE202ULL, 0x711515D0A205CB36ULL },
+    { 0xD3515C2831559A83ULL, 0x0D5A5B44CA873E03ULL },
+    { 0x8412D9991ED58091ULL, 0xE858790AFE9486C2ULL },
+    { 0xA5178FFF668AE0B6ULL, 0x626E974DBE39A872ULL },
+    { 0xCE5D73FF402D98E3ULL, 0xFB0A3D212DC8128FULL },
+    { 0x80FA687F881C7F8EULL, 0x7CE66634BC9D0B99ULL },
+    { 0xA139029F6A239F72ULL, 0x1C1FFFC1EBC44E80ULL },
+    { 0xC987434744AC874EULL, 0xA327FFB266B56220ULL },
+    { 0xFBE9141915D7A922ULL, 0x4BF1FF9F0062BAA8ULL },
+    { 0x9D71AC8FADA6C9B5ULL, 0x6F773FC3603DB4A9ULL },
+    { 0xC4CE17B399107C22ULL, 0xCB550FB4384D21D3ULL },
+    { 0xF6019DA07F549B2BULL, 0x7E2A53A146606A48ULL },
+    { 0x99C102844F94E0FBULL, 0x2EDA7444CBFC426DULL },
+    { 0xC0314325637A1939ULL, 0xFA911155FEFB5308ULL },
+    { 0xF03D93EEBC589F88ULL, 0x793555AB7EBA27CAULL },
+    { 0x96267C7535B763B5ULL, 0x4BC1558B2F3458DEULL },
+    { 0xBBB01B9283253CA2ULL, 0x9EB1AAEDFB016F16ULL },
+    { 0xEA9C227723EE8BCBULL, 0x465E15A979C1CADCULL },
+    { 0x92A1958A7675175FULL, 0x0BFACD89EC191EC9ULL },
+    { 0xB749FAED14125D36ULL, 0xCEF980EC671F667BULL },
+    { 0xE51C79A85916F484ULL, 0x82B7E12780E7401AULL },
+    { 0x8F31CC0937AE58D2ULL, 0xD1B2ECB8B0908810ULL },
+    { 0xB2FE3F0B8599EF07ULL, 0x861FA7E6DCB4AA15ULL },
+    { 0xDFBDCECE67006AC9ULL, 0x67A791E093E1D49AULL },
+    { 0x8BD6A141006042BDULL, 0xE0C8BB2C5C6D24E0ULL },
+    { 0xAECC49914078536DULL, 0x58FAE9F773886E18ULL },
+    { 0xDA7F5BF590966848ULL, 0xAF39A475506A899EULL },
+    { 0x888F99797A5E012DULL, 0x6D8406C952429603ULL },
+    { 0xAAB37FD7D8F58178ULL, 0xC8E5087BA6D33B83ULL },
+    { 0xD5605FCDCF32E1D6ULL, 0xFB1E4A9A90880A64ULL },
+    { 0x855C3BE0A17FCD26ULL, 0x5CF2EEA09A55067FULL },
+    { 0xA6B34AD8C9DFC06FULL, 0xF42FAA48C0EA481EULL },
+    { 0xD0601D8EFC57B08BULL, 0xF13B94DAF124DA26ULL },
+    { 0x823C12795DB6CE57ULL, 0x76C53D08D6B70858ULL },
+    { 0xA2CB1717B52481EDULL, 0x54768C4B0C64CA6EULL },
+    { 0xCB7DDCDDA26DA268ULL, 0xA9942F5DCF7DFD09ULL },
+    { 0xFE5D54150B090B02ULL, 0xD3F93B35435D7C4CULL },
+    { 0x9EFA548D26E5A6E1ULL, 0xC47BC5014A1A6DAFULL },
+    { 0xC6B8E9B0709F109AULL, 0x359AB6419CA1091BULL },
+    { 0xF867241C8CC6D4C0ULL, 0xC30163D203C94B62ULL },
+    { 0x9B407691D7FC44F8ULL, 0x79E0DE63425DCF1DULL },
+    { 0xC21094364DFB5636ULL, 0x985915FC12F542E4ULL },
+    { 0xF294B943E17A2BC4ULL, 0x3E6F5B7B17B2939DULL },
+    { 0x979CF3CA6CEC5B5AULL, 0xA705992CEECF9C42ULL },
+    { 0xBD8430BD08277231ULL, 0x50C6FF782A838353ULL },
+    { 0xECE53CEC4A314EBDULL, 0xA4F8BF5635246428ULL },
+    { 0x940F4613AE5ED136ULL, 0x871B7795E136BE99ULL },
+    { 0xB913179899F68584ULL, 0x28E2557B59846E3FULL },
+    { 0xE757DD7EC07426E5ULL, 0x331AEADA2FE589CFULL },
+    { 0x9096EA6F3848984FULL, 0x3FF0D2C85DEF7621ULL },
+    { 0xB4BCA50B065ABE63ULL, 0x0FED077A756B53A9ULL },
+    { 0xE1EBCE4DC7F16DFBULL, 0xD3E8495912C62894ULL },
+    { 0x8D3360F09CF6E4BDULL, 0x64712DD7ABBBD95CULL },
+    { 0xB080392CC4349DECULL, 0xBD8D794D96AACFB3ULL },
+    { 0xDCA04777F541C567ULL, 0xECF0D7A0FC5583A0ULL },
+    { 0x89E42CAAF9491B60ULL, 0xF41686C49DB57244ULL },
+    { 0xAC5D37D5B79B6239ULL, 0x311C2875C522CED5ULL },
+    { 0xD77485CB25823AC7ULL, 0x7D633293366B828BULL },
+    { 0x86A8D39EF77164BCULL, 0xAE5DFF9C02033197ULL },
+    { 0xA8530886B54DBDEBULL, 0xD9F57F830283FDFCULL },
+    { 0xD267CAA862A12D66ULL, 0xD072DF63C324FD7BULL },
+    { 0x8380DEA93DA4BC60ULL, 0x4247CB9E59F71E6DULL },
+    { 0xA46116538D0DEB78ULL, 0x52D9BE85F074E608ULL },
+    { 0xCD795BE870516656ULL, 0x67902E276C921F8BULL },
+    { 0x806BD9714632DFF6ULL, 0x00BA1CD8A3DB53B6ULL },
+    { 0xA086CFCD97BF97F3ULL, 0x80E8A40ECCD228A4ULL },
+    { 0xC8A883C0FDAF7DF0ULL, 0x6122CD128006B2CDULL },
+    { 0xFAD2A4B13D1B5D6CULL, 0x796B805720085F81ULL },
+    { 0x9CC3A6EEC6311A63ULL, 0xCBE3303674053BB0ULL },
+    { 0xC3F490AA77BD60FCULL, 0xBEDBFC4411068A9CULL },
+    { 0xF4F1B4D515ACB93BULL, 0xEE92FB5515482D44ULL },
+    { 0x991711052D8BF3C5ULL, 0x751BDD152D4D1C4AULL },
+    { 0xBF5CD54678EEF0B6ULL, 0xD262D45A78A0635DULL },
+    { 0xEF340A98172AACE4ULL, 0x86FB897116C87C34ULL },
+    { 0x9580869F0E7AAC0EULL, 0xD45D35E6AE3D4DA0ULL },
+    { 0xBAE0A846D2195712ULL, 0x8974836059CCA109ULL },
+    { 0xE998D258869FACD7ULL, 0x2BD1A438703FC94BULL },
+    { 0x91FF83775423CC06ULL, 0x7B6306A34627DDCFULL },
+    { 0xB67F6455292CBF08ULL, 0x1A3BC84C17B1D542ULL },
+    { 0xE41F3D6A7377EECAULL, 0x20CABA5F1D9E4A93ULL },
+    { 0x8E938662882AF53EULL, 0x547EB47B7282EE9CULL },
+    { 0xB23867FB2A35B28DULL, 0xE99E619A4F23AA43ULL },
+    { 0xDEC681F9F4C31F31ULL, 0x6405FA00E2EC94D4ULL },
+    { 0x8B3C113C38F9F37EULL, 0xDE83BC408DD3DD04ULL },
+    { 0xAE0B158B4738705EULL, 0x9624AB50B148D445ULL },
+    { 0xD98DDAEE19068C76ULL, 0x3BADD624DD9B0957ULL },
+    { 0x87F8A8D4CFA417C9ULL, 0xE54CA5D70A80E5D6ULL },
+    { 0xA9F6D30A038D1DBCULL, 0x5E9FCF4CCD211F4CULL },
+    { 0xD47487CC8470652BULL, 0x7647C3200069671FULL },
+    { 0x84C8D4DFD2C63F3BULL, 0x29ECD9F40041E073ULL },
+    { 0xA5FB0A17C777CF09ULL, 0xF468107100525890ULL },
+    { 0xCF79CC9DB955C2CCULL, 0x7182148D4066EEB4ULL },
+    { 0x81AC1FE293D599BFULL, 0xC6F14CD848405530ULL },
+    { 0xA21727DB38CB002FULL, 0xB8ADA00E5A506A7CULL },
+    { 0xCA9CF1D206FDC03BULL, 0xA6D90811F0E4851CULL },
+    { 0xFD442E4688BD304AULL, 0x908F4A166D1DA663ULL },
+    { 0x9E4A9CEC15763E2EULL, 0x9A598E4E043287FEULL },
+    { 0xC5DD44271AD3CDBAULL, 0x40EFF1E1853F29FDULL },
+    { 0xF7549530E188C128ULL, 0xD12BEE59E68EF47CULL },
+    { 0x9A94DD3E8CF578B9ULL, 0x82BB74F8301958CEULL },
+    { 0xC13A148E3032D6E7ULL, 0xE36A52363C1FAF01ULL },
+    { 0xF18899B1BC3F8CA1ULL, 0xDC44E6C3CB279AC1ULL },
+    { 0x96F5600F15A7B7E5ULL, 0x29AB103A5EF8C0B9ULL },
+    { 0xBCB2B812DB11A5DEULL, 0x7415D448F6B6F0E7ULL },
+    { 0xEBDF661791D60F56ULL, 0x111B495B3464AD21ULL },
+    { 0x936B9FCEBB25C995ULL, 0xCAB10DD900BEEC34ULL },
+    { 0xB84687C269EF3BFBULL, 0x3D5D514F40EEA742ULL },
+    { 0xE65829B3046B0AFAULL, 0x0CB4A5A3112A5112ULL },
+    { 0x8FF71A0FE2C2E6DCULL, 0x47F0E785EABA72ABULL },
+    { 0xB3F4E093DB73A093ULL, 0x59ED216765690F56ULL },
+    { 0xE0F218B8D25088B8ULL, 0x306869C13EC3532CULL },
+    { 0x8C974F7383725573ULL, 0x1E414218C73A13FBULL },
+    { 0xAFBD2350644EEACFULL, 0xE5D1929EF90898FAULL },
+    { 0xDBAC6C247D62A583ULL, 0xDF45F746B74ABF39ULL },
+    { 0x894BC396CE5DA772ULL, 0x6B8BBA8C328EB783ULL },
+    { 0xAB9EB47C81F5114FULL, 0x066EA92F3F326564ULL },
+    { 0xD686619BA27255A2ULL, 0xC80A537B0EFEFEBDULL },
+    { 0x8613FD0145877585ULL, 0xBD06742CE95F5F36ULL },
+    { 0xA798FC4196E952E7ULL, 0x2C48113823B73704ULL },
+    { 0xD17F3B51FCA3A7A0ULL, 0xF75A15862CA504C5ULL },
+    { 0x82EF85133DE648C4ULL, 0x9A984D73DBE722FBULL },
+    { 0xA3AB66580D5FDAF5ULL, 0xC13E60D0D2E0EBBAULL },
+    { 0xCC963FEE10B7D1B3ULL, 0x318DF905079926A8ULL },
+    { 0xFFBBCFE994E5C61FULL, 0xFDF17746497F7052ULL },
+    { 0x9FD561F1FD0F9BD3ULL, 0xFEB6EA8BEDEFA633ULL },
+    { 0xC7CABA6E7C5382C8ULL, 0xFE64A52EE96B8FC0ULL },
+    { 0xF9BD690A1B68637BULL, 0x3DFDCE7AA3C673B0ULL },
+    { 0x9C1661A651213E2DULL, 0x06BEA10CA65C084EULL },
+    { 0xC31BFA0FE5698DB8ULL, 0x486E494FCFF30A62ULL },
+    { 0xF3E2F893DEC3F126ULL, 0x5A89DBA3C3EFCCFAULL },
+    { 0x986DDB5C6B3A76B7ULL, 0xF89629465A75E01CULL },
+    { 0xBE89523386091465ULL, 0xF6BBB397F1135823ULL },
+    { 0xEE2BA6C0678B597FULL, 0x746AA07DED582E2CULL },
+    { 0x94DB483840B717EFULL, 0xA8C2A44EB4571CDCULL },
+    { 0xBA121A4650E4DDEBULL, 0x92F34D62616CE413ULL },
+    { 0xE896A0D7E51E1566ULL, 0x77B020BAF9C81D17ULL },
+    { 0x915E2486EF32CD60ULL, 0x0ACE1474DC1D122EULL },
+    { 0xB5B5ADA8AAFF80B8ULL, 0x0D819992132456BAULL },
+    { 0xE3231912D5BF60E6ULL, 0x10E1FFF697ED6C69ULL },
+    { 0x8DF5EFABC5979C8FULL, 0xCA8D3FFA1EF463C1ULL },
+    { 0xB1736B96B6FD83B3ULL, 0xBD308FF8A6B17CB2ULL },
+    { 0xDDD0467C64BCE4A0ULL, 0xAC7CB3F6D05DDBDEULL },
+    { 0x8AA22C0DBEF60EE4ULL, 0x6BCDF07A423AA96BULL },
+    { 0xAD4AB7112EB3929DULL, 0x86C16C98D2C953C6ULL },
+    { 0xD89D64D57A607744ULL, 0xE871C7BF077BA8B7ULL },
+    { 0x87625F056C7C4A8BULL, 0x11471CD764AD4972ULL },
+    { 0xA93AF6C6C79B5D2DULL, 0xD598E40D3DD89BCFULL },
+    { 0xD389B47879823479ULL, 0x4AFF1D108D4EC2C3ULL },
+    { 0x843610CB4BF160CBULL, 0xCEDF722A585139BAULL },
+    { 0xA54394FE1EEDB8FEULL, 0xC2974EB4EE658828ULL },
+    { 0xCE947A3DA6A9273EULL, 0x733D226229FEEA32ULL },
+    { 0x811CCC668829B887ULL, 0x0806357D5A3F525FULL },
+    { 0xA163FF802A3426A8ULL, 0xCA07C2DCB0CF26F7ULL },
+    { 0xC9BCFF6034C13052ULL, 0xFC89B393DD02F0B5ULL },
+    { 0xFC2C3F3841F17C67ULL, 0xBBAC2078D443ACE2ULL },
+    { 0x9D9BA7832936EDC0ULL, 0xD54B944B84AA4C0DULL },
+    { 0xC5029163F384A931ULL, 0x0A9E795E65D4DF11ULL },
+    { 0xF64335BCF065D37DULL, 0x4D4617B5FF4A16D5ULL },
+    { 0x99EA0196163FA42EULL, 0x504BCED1BF8E4E45ULL },
+    { 0xC06481FB9BCF8D39ULL, 0xE45EC2862F71E1D6ULL },
+    { 0xF07DA27A82C37088ULL, 0x5D767327BB4E5A4CULL },
+    { 0x964E858C91BA2655ULL, 0x3A6A07F8D510F86FULL },
+    { 0xBBE226EFB628AFEAULL, 0x890489F70A55368BULL },
+    { 0xEADAB0ABA3B2DBE5ULL, 0x2B45AC74CCEA842EULL },
+    { 0x92C8AE6B464FC96FULL, 0x3B0B8BC90012929DULL },
+    { 0xB77ADA0617E3BBCBULL, 0x09CE6EBB40173744ULL },
+    { 0xE55990879DDCAABDULL, 0xCC420A6A101D0515ULL },
+    { 0x8F57FA54C2A9EAB6ULL, 0x9FA946824A12232DULL },
+    { 0xB32DF8E9F3546564ULL, 0x47939822DC96ABF9ULL },
+    { 0xDFF9772470297EBDULL, 0x59787E2B93BC56F7ULL },
+    { 0x8BFBEA76C619EF36ULL, 0x57EB4EDB3C55B65AULL },
+    { 0xAEFAE51477A06B03ULL, 0xEDE622920B6B23F1ULL },
+    { 0xDAB99E59958885C4ULL, 0xE95FAB368E45ECEDULL },
+    { 0x88B402F7FD75539BULL, 0x11DBCB0218EBB414ULL },
+    { 0xAAE103B5FCD2A881ULL, 0xD652BDC29F26A119ULL },
+    { 0xD59944A37C0752A2ULL, 0x4BE76D3346F0495FULL },
+    { 0x857FCAE62D8493A5ULL, 0x6F70A4400C562DDBULL },
+    { 0xA6DFBD9FB8E5B88EULL, 0xCB4CCD500F6BB952ULL },
+    { 0xD097AD07A71F26B2ULL, 0x7E2000A41346A7A7ULL },
+    { 0x825ECC24C873782FULL, 0x8ED400668C0C28C8ULL },
+    { 0xA2F67F2DFA90563BULL, 0x728900802F0F32FAULL },
+    { 0xCBB41EF979346BCAULL, 0x4F2B40A03AD2FFB9ULL },
+    { 0xFEA126B7D78186BCULL, 0xE2F610C84987BFA8ULL },
+    { 0x9F24B832E6B0F436ULL, 0x0DD9CA7D2DF4D7C9ULL },
+    { 0xC6EDE63FA05D3143ULL, 0x91503D1C79720DBBULL },
+    { 0xF8A95FCF88747D94ULL, 0x75A44C6397CE912AULL },
+    { 0x9B69DBE1B548CE7CULL, 0xC986AFBE3EE11ABAULL },
+    { 0xC24452DA229B021BULL, 0xFBE85BADCE996168ULL },
+    { 0xF2D56790AB41C2A2ULL, 0xFAE27299423FB9C3ULL },
+    { 0x97C560BA6B0919A5ULL, 0xDCCD879FC967D41AULL },
+    { 0xBDB6B8E905CB600FULL, 0x5400E987BBC1C920ULL },
+    { 0xED246723473E3813ULL, 0x290123E9AAB23B68ULL },
+    { 0x9436C0760C86E30BULL, 0xF9A0B6720AAF6521ULL },
+    { 0xB94470938FA89BCEULL, 0xF808E40E8D5B3E69ULL },
+    { 0xE7958CB87392C2C2ULL, 0xB60B1D1230B20E04ULL },
+    { 0x90BD77F3483BB9B9ULL, 0xB1C6F22B5E6F48C2ULL },
+    { 0xB4ECD5F01A4AA828ULL, 0x1E38AEB6360B1AF3ULL },
+    { 0xE2280B6C20DD5232ULL, 0x25C6DA63C38DE1B0ULL },
+    { 0x8D590723948A535FULL, 0x579C487E5A38AD0EULL },
+    { 0xB0AF48EC79ACE837ULL, 0x2D835A9DF0C6D851ULL },
+    { 0xDCDB1B2798182244ULL, 0xF8E431456CF88E65ULL },
+    { 0x8A08F0F8BF0F156BULL, 0x1B8E9ECB641B58FFULL },
+    { 0xAC8B2D36EED2DAC5ULL, 0xE272467E3D222F3FULL },
+    { 0xD7ADF884AA879177ULL, 0x5B0ED81DCC6ABB0FULL },
+    { 0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL },
+    { 0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL },
+    { 0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL },
+    { 0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL },
+    { 0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL },
+    { 0xCDB02555653131B6ULL, 0x3792F412CB06794DULL },
+    { 0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL },
+    { 0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL },
+    { 0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL },
+    { 0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL },
+    { 0x9CED737BB6C4183DULL, 0x55464DD69685606BULL },
+    { 0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL },
+    { 0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL },
+    { 0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL },
+    { 0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL },
+    { 0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL },
+    { 0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL },
+    { 0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL },
+    { 0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL },
+    { 0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL },
+    { 0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL },
+    { 0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL },
+    { 0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL },
+    { 0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL },
+    { 0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL },
+    { 0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL },
+    { 0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL },
+    { 0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL },
+    { 0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL },
+    { 0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL },
+    { 0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL },
+    { 0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL },
+    { 0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL },
+    { 0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL },
+    { 0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL },
+    { 0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL },
+    { 0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL },
+    { 0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL },
+    { 0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL },
+    { 0xC612062576589DDAULL, 0x95364AFE032A819EULL },
+    { 0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL },
+    { 0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL },
+    { 0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL },
+    { 0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL },
+    { 0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL },
+    { 0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL },
+    { 0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL },
+    { 0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL },
+    { 0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL },
+    { 0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL },
+    { 0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL },
+    { 0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL },
+    { 0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL },
+    { 0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL },
+    { 0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL },
+    { 0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL },
+    { 0x89705F4136B4A597ULL, 0x31680A88F8953031ULL },
+    { 0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL },
+    { 0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL },
+    { 0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL },
+    { 0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL },
+    { 0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL },
+    { 0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL },
+    { 0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL },
+    { 0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL },
+    { 0x8000000000000000ULL, 0x0000000000000000ULL },
+    { 0xA000000000000000ULL, 0x0000000000000000ULL },
+    { 0xC800000000000000ULL, 0x0000000000000000ULL },
+    { 0xFA00000000000000ULL, 0x0000000000000000ULL },
+    { 0x9C40000000000000ULL, 0x0000000000000000ULL },
+    { 0xC350000000000000ULL, 0x0000000000000000ULL },
+    { 0xF424000000000000ULL, 0x0000000000000000ULL },
+    { 0x9896800000000000ULL, 0x0000000000000000ULL },
+    { 0xBEBC200000000000ULL, 0x0000000000000000ULL },
+    { 0xEE6B280000000000ULL, 0x0000000000000000ULL },
+    { 0x9502F90000000000ULL, 0x0000000000000000ULL },
+    { 0xBA43B74000000000ULL, 0x0000000000000000ULL },
+    { 0xE8D4A51000000000ULL, 0x0000000000000000ULL },
+    { 0x9184E72A00000000ULL, 0x0000000000000000ULL },
+    { 0xB5E620F480000000ULL, 0x0000000000000000ULL },
+    { 0xE35FA931A0000000ULL, 0x0000000000000000ULL },
+    { 0x8E1BC9BF04000000ULL, 0x0000000000000000ULL },
+    { 0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL },
+    { 0xDE0B6B3A76400000ULL, 0x0000000000000000ULL },
+    { 0x8AC7230489E80000ULL, 0x0000000000000000ULL },
+    { 0xAD78EBC5AC620000ULL, 0x0000000000000000ULL },
+    { 0xD8D726B7177A8000ULL, 0x0000000000000000ULL },
+    { 0x878678326EAC9000ULL, 0x0000000000000000ULL },
+    { 0xA968163F0A57B400ULL, 0x0000000000000000ULL },
+    { 0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL },
+    { 0x84595161401484A0ULL, 0x0000000000000000ULL },
+    { 0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL },
+    { 0xCECB8F27F4200F3AULL, 0x0000000000000000ULL },
+    { 0x813F3978F8940984ULL, 0x4000000000000000ULL },
+    { 0xA18F07D736B90BE5ULL, 0x5000000000000000ULL },
+    { 0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL },
+    { 0xFC6F7C4045812296ULL, 0x4D00000000000000ULL },
+    { 0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL },
+    { 0xC5371912364CE305ULL, 0x6C28000000000000ULL },
+    { 0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL },
+    { 0x9A130B963A6C115CULL, 0x3C7F400000000000ULL },
+    { 0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL },
+    { 0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL },
+    { 0x96769950B50D88F4ULL, 0x1314448000000000ULL },
+    { 0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL },
+    { 0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL },
+    { 0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL },
+    { 0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL },
+    { 0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL },
+    { 0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL },
+    { 0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL },
+    { 0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL },
+    { 0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL },
+    { 0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL },
+    { 0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL },
+    { 0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL },
+    { 0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL },
+    { 0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL },
+    { 0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL },
+    { 0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL },
+    { 0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL },
+    { 0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL },
+    { 0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL },
+    { 0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL },
+    { 0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL },
+    { 0x9F4F2726179A2245ULL, 0x01D762422C946590ULL },
+    { 0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL },
+    { 0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL },
+    { 0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL },
+    { 0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL },
+    { 0xF316271C7FC3908AULL, 0x8BEF464E3945EF7AULL },
+    { 0x97EDD871CFDA3A56ULL, 0x97758BF0E3CBB5ACULL },
+    { 0xBDE94E8E43D0C8ECULL, 0x3D52EEED1CBEA317ULL },
+    { 0xED63A231D4C4FB27ULL, 0x4CA7AAA863EE4BDDULL },
+    { 0x945E455F24FB1CF8ULL, 0x8FE8CAA93E74EF6AULL },
+    { 0xB975D6B6EE39E436ULL, 0xB3E2FD538E122B44ULL },
+    { 0xE7D34C64A9C85D44ULL, 0x60DBBCA87196B616ULL },
+    { 0x90E40FBEEA1D3A4AULL, 0xBC8955E946FE31CDULL },
+    { 0xB51D13AEA4A488DDULL, 0x6BABAB6398BDBE41ULL },
+    { 0xE264589A4DCDAB14ULL, 0xC696963C7EED2DD1ULL },
+    { 0x8D7EB76070A08AECULL, 0xFC1E1DE5CF543CA2ULL },
+    { 0xB0DE65388CC8ADA8ULL, 0x3B25A55F43294BCBULL },
+    { 0xDD15FE86AFFAD912ULL, 0x49EF0EB713F39EBEULL },
+    { 0x8A2DBF142DFCC7ABULL, 0x6E3569326C784337ULL },
+    { 0xACB92ED9397BF996ULL, 0x49C2C37F07965404ULL },
+    { 0xD7E77A8F87DAF7FBULL, 0xDC33745EC97BE906ULL },
+    { 0x86F0AC99B4E8DAFDULL, 0x69A028BB3DED71A3ULL },
+    { 0xA8ACD7C0222311BCULL, 0xC40832EA0D68CE0CULL },
+    { 0xD2D80DB02AABD62BULL, 0xF50A3FA490C30190ULL },
+    { 0x83C7088E1AAB65DBULL, 0x792667C6DA79E0FAULL },
+    { 0xA4B8CAB1A1563F52ULL, 0x577001B891185938ULL },
+    { 0xCDE6FD5E09ABCF26ULL, 0xED4C0226B55E6F86ULL },
+    { 0x80B05E5AC60B6178ULL, 0x544F8158315B05B4ULL },
+    { 0xA0DC75F1778E39D6ULL, 0x696361AE3DB1C721ULL },
+    { 0xC913936DD571C84CULL, 0x03BC3A19CD1E38E9ULL },
+    { 0xFB5878494ACE3A5FULL, 0x04AB48A04065C723ULL },
+    { 0x9D174B2DCEC0E47BULL, 0x62EB0D64283F9C76ULL },
+    { 0xC45D1DF942711D9AULL, 0x3BA5D0BD324F8394ULL },
+    { 0xF5746577930D6500ULL, 0xCA8F44EC7EE36479ULL },
+    { 0x9968BF6ABBE85F20ULL, 0x7E998B13CF4E1ECBULL },
+    { 0xBFC2EF456AE276E8ULL, 0x9E3FEDD8C321A67EULL },
+    { 0xEFB3AB16C59B14A2ULL, 0xC5CFE94EF3EA101EULL },
+    { 0x95D04AEE3B80ECE5ULL, 0xBBA1F1D158724A12ULL },
+    { 0xBB445DA9CA61281FULL, 0x2A8A6E45AE8EDC97ULL },
+    { 0xEA1575143CF97226ULL, 0xF52D09D71A3293BDULL },
+    { 0x924D692CA61BE758ULL, 0x593C2626705F9C56ULL },
+    { 0xB6E0C377CFA2E12EULL, 0x6F8B2FB00C77836CULL },
+    { 0xE498F455C38B997AULL, 0x0B6DFB9C0F956447ULL },
+    { 0x8EDF98B59A373FECULL, 0x4724BD4189BD5EACULL },
+    { 0xB2977EE300C50FE7ULL, 0x58EDEC91EC2CB657ULL },
+    { 0xDF3D5E9BC0F653E1ULL, 0x2F2967B66737E3EDULL },
+    { 0x8B865B215899F46CULL, 0xBD79E0D20082EE74ULL },
+    { 0xAE67F1E9AEC07187ULL, 0xECD8590680A3AA11ULL },
+    { 0xDA01EE641A708DE9ULL, 0xE80E6F4820CC9495ULL },
+    { 0x884134FE908658B2ULL, 0x3109058D147FDCDDULL },
+    { 0xAA51823E34A7EEDEULL, 0xBD4B46F0599FD415ULL },
+    { 0xD4E5E2CDC1D1EA96ULL, 0x6C9E18AC7007C91AULL },
+    { 0x850FADC09923329EULL, 0x03E2CF6BC604DDB0ULL },
+    { 0xA6539930BF6BFF45ULL, 0x84DB8346B786151CULL },
+    { 0xCFE87F7CEF46FF16ULL, 0xE612641865679A63ULL },
+    { 0x81F14FAE158C5F6EULL, 0x4FCB7E8F3F60C07EULL },
+    { 0xA26DA3999AEF7749ULL, 0xE3BE5E330F38F09DULL },
+    { 0xCB090C8001AB551CULL, 0x5CADF5BFD3072CC5ULL },
+    { 0xFDCB4FA002162A63ULL, 0x73D9732FC7C8F7F6ULL },
+    { 0x9E9F11C4014DDA7EULL, 0x2867E7FDDCDD9AFAULL },
+    { 0xC646D63501A1511DULL, 0xB281E1FD541501B8ULL },
+    { 0xF7D88BC24209A565ULL, 0x1F225A7CA91A4226ULL },
+    { 0x9AE757596946075FULL, 0x3375788DE9B06958ULL },
+    { 0xC1A12D2FC3978937ULL, 0x0052D6B1641C83AEULL },
+    { 0xF209787BB47D6B84ULL, 0xC0678C5DBD23A49AULL },
+    { 0x9745EB4D50CE6332ULL, 0xF840B7BA963646E0ULL },
+    { 0xBD176620A501FBFFULL, 0xB650E5A93BC3D898ULL },
+    { 0xEC5D3FA8CE427AFFULL, 0xA3E51F138AB4CEBEULL },
+    { 0x93BA47C980E98CDFULL, 0xC66F336C36B10137ULL },
+    { 0xB8A8D9BBE123F017ULL, 0xB80B0047445D4184ULL },
+    { 0xE6D3102AD96CEC1DULL, 0xA60DC059157491E5ULL },
+    { 0x9043EA1AC7E41392ULL, 0x87C89837AD68DB2FULL },
+    { 0xB454E4A179DD1877ULL, 0x29BABE4598C311FBULL },
+    { 0xE16A1DC9D8545E94ULL, 0xF4296DD6FEF3D67AULL },
+    { 0x8CE2529E2734BB1DULL, 0x1899E4A65F58660CULL },
+    { 0xB01AE745B101E9E4ULL, 0x5EC05DCFF72E7F8FULL },
+    { 0xDC21A1171D42645DULL, 0x76707543F4FA1F73ULL },
+    { 0x899504AE72497EBAULL, 0x6A06494A791C53A8ULL },
+    { 0xABFA45DA0EDBDE69ULL, 0x0487DB9D17636892ULL },
+    { 0xD6F8D7509292D603ULL, 0x45A9D2845D3C42B6ULL },
+    { 0x865B86925B9BC5C2ULL, 0x0B8A2392BA45A9B2ULL },
+    { 0xA7F26836F282B732ULL, 0x8E6CAC7768D7141EULL },
+    { 0xD1EF0244AF2364FFULL, 0x3207D795430CD926ULL },
+    { 0x8335616AED761F1FULL, 0x7F44E6BD49E807B8ULL },
+    { 0xA402B9C5A8D3A6E7ULL, 0x5F16206C9C6209A6ULL },
+    { 0xCD036837130890A1ULL, 0x36DBA887C37A8C0FULL },
+    { 0x802221226BE55A64ULL, 0xC2494954DA2C9789ULL },
+    { 0xA02AA96B06DEB0FDULL, 0xF2DB9BAA10B7BD6CULL },
+    { 0xC83553C5C8965D3DULL, 0x6F92829494E5ACC7ULL },
+    { 0xFA42A8B73ABBF48CULL, 0xCB772339BA1F17F9ULL },
+    { 0x9C69A97284B578D7ULL, 0xFF2A760414536EFBULL },
+    { 0xC38413CF25E2D70DULL, 0xFEF5138519684ABAULL },
+    { 0xF46518C2EF5B8CD1ULL, 0x7EB258665FC25D69ULL },
+    { 0x98BF2F79D5993802ULL, 0xEF2F773FFBD97A61ULL },
+    { 0xBEEEFB584AFF8603ULL, 0xAAFB550FFACFD8FAULL },
+    { 0xEEAABA2E5DBF6784ULL, 0x95BA2A53F983CF38ULL },
+    { 0x952AB45CFA97A0B2ULL, 0xDD945A747BF26183ULL },
+    { 0xBA756174393D88DFULL, 0x94F971119AEEF9E4ULL },
+    { 0xE912B9D1478CEB17ULL, 0x7A37CD5601AAB85DULL },
+    { 0x91ABB422CCB812EEULL, 0xAC62E055C10AB33AULL },
+    { 0xB616A12B7FE617AAULL, 0x577B986B314D6009ULL },
+    { 0xE39C49765FDF9D94ULL, 0xED5A7E85FDA0B80BULL },
+    { 0x8E41ADE9FBEBC27DULL, 0x14588F13BE847307ULL },
+    { 0xB1D219647AE6B31CULL, 0x596EB2D8AE258FC8ULL },
+    { 0xDE469FBD99A05FE3ULL, 0x6FCA5F8ED9AEF3BBULL },
+    { 0x8AEC23D680043BEEULL, 0x25DE7BB9480D5854ULL },
+    { 0xADA72CCC20054AE9ULL, 0xAF561AA79A10AE6AULL },
+    { 0xD910F7FF28069DA4ULL, 0x1B2BA1518094DA04ULL },
+    { 0x87AA9AFF79042286ULL, 0x90FB44D2F05D0842ULL },
+    { 0xA99541BF57452B28ULL, 0x353A1607AC744A53ULL },
+    { 0xD3FA922F2D1675F2ULL, 0x42889B8997915CE8ULL },
+    { 0x847C9B5D7C2E09B7ULL, 0x69956135FEBADA11ULL },
+    { 0xA59BC234DB398C25ULL, 0x43FAB9837E699095ULL },
+    { 0xCF02B2C21207EF2EULL, 0x94F967E45E03F4BBULL },
+    { 0x8161AFB94B44F57DULL, 0x1D1BE0EEBAC278F5ULL },
+    { 0xA1BA1BA79E1632DCULL, 0x6462D92A69731732ULL },
+    { 0xCA28A291859BBF93ULL, 0x7D7B8F7503CFDCFEULL },
+    { 0xFCB2CB35E702AF78ULL, 0x5CDA735244C3D43EULL },
+    { 0x9DEFBF01B061ADABULL, 0x3A0888136AFA64A7ULL },
+    { 0xC56BAEC21C7A1916ULL, 0x088AAA1845B8FDD0ULL },
+    { 0xF6C69A72A3989F5BULL, 0x8AAD549E57273D45ULL },
+    { 0x9A3C2087A63F6399ULL, 0x36AC54E2F678864BULL },
+    { 0xC0CB28A98FCF3C7FULL, 0x84576A1BB416A7DDULL },
+    { 0xF0FDF2D3F3C30B9FULL, 0x656D44A2A11C51D5ULL },
+    { 0x969EB7C47859E743ULL, 0x9F644AE5A4B1B325ULL },
+    { 0xBC4665B596706114ULL, 0x873D5D9F0DDE1FEEULL },
+    { 0xEB57FF22FC0C7959ULL, 0xA90CB506D155A7EAULL },
+    { 0x9316FF75DD87CBD8ULL, 0x09A7F12442D588F2ULL },
+    { 0xB7DCBF5354E9BECEULL, 0x0C11ED6D538AEB2FULL },
+    { 0xE5D3EF282A242E81ULL, 0x8F1668C8A86DA5FAULL },
+    { 0x8FA475791A569D10ULL, 0xF96E017D694487BCULL },
+    { 0xB38D92D760EC4455ULL, 0x37C981DCC395A9ACULL },
+    { 0xE070F78D3927556AULL, 0x85BBE253F47B1417ULL },
+    { 0x8C469AB843B89562ULL, 0x93956D7478CCEC8EULL },
+    { 0xAF58416654A6BABBULL, 0x387AC8D1970027B2ULL },
+    { 0xDB2E51BFE9D0696AULL, 0x06997B05FCC0319EULL },
+    { 0x88FCF317F22241E2ULL, 0x441FECE3BDF81F03ULL },
+    { 0xAB3C2FDDEEAAD25AULL, 0xD527E81CAD7626C3ULL },
+    { 0xD60B3BD56A5586F1ULL, 0x8A71E223D8D3B074ULL },
+    { 0x85C7056562757456ULL, 0xF6872D5667844E49ULL },
+    { 0xA738C6BEBB12D16CULL, 0xB428F8AC016561DBULL },
+    { 0xD106F86E69D785C7ULL, 0xE13336D701BEBA52ULL },
+    { 0x82A45B450226B39CULL, 0xECC0024661173473ULL },
+    { 0xA34D721642B06084ULL, 0x27F002D7F95D0190ULL },
+    { 0xCC20CE9BD35C78A5ULL, 0x31EC038DF7B441F4ULL },
+    { 0xFF290242C83396CEULL, 0x7E67047175A15271ULL },
+    { 0x9F79A169BD203E41ULL, 0x0F0062C6E984D386ULL },
+    { 0xC75809C42C684DD1ULL, 0x52C07B78A3E60868ULL },
+    { 0xF92E0C3537826145ULL, 0xA7709A56CCDF8A82ULL },
+    { 0x9BBCC7A142B17CCBULL, 0x88A66076400BB691ULL },
+    { 0xC2ABF989935DDBFEULL, 0x6ACFF893D00EA435ULL },
+    { 0xF356F7EBF83552FEULL, 0x0583F6B8C4124D43ULL },
+    { 0x98165AF37B2153DEULL, 0xC3727A337A8B704AULL },
+    { 0xBE1BF1B059E9A8D6ULL, 0x744F18C0592E4C5CULL },
+    { 0xEDA2EE1C7064130CULL, 0x1162DEF06F79DF73ULL },
+    { 0x9485D4D1C63E8BE7ULL, 0x8ADDCB5645AC2BA8ULL },
+    { 0xB9A74A0637CE2EE1ULL, 0x6D953E2BD7173692ULL },
+    { 0xE8111C87C5C1BA99ULL, 0xC8FA8DB6CCDD0437ULL },
+    { 0x910AB1D4DB9914A0ULL, 0x1D9C9892400A22A2ULL },
+    { 0xB54D5E4A127F59C8ULL, 0x2503BEB6D00CAB4BULL },
+    { 0xE2A0B5DC971F303AULL, 0x2E44AE64840FD61DULL },
+    { 0x8DA471A9DE737E24ULL, 0x5CEAECFED289E5D2ULL },
+    { 0xB10D8E1456105DADULL, 0x7425A83E872C5F47ULL },
+    { 0xDD50F1996B947518ULL, 0xD12F124E28F77719ULL },
+    { 0x8A5296FFE33CC92FULL, 0x82BD6B70D99AAA6FULL },
+    { 0xACE73CBFDC0BFB7BULL, 0x636CC64D1001550BULL },
+    { 0xD8210BEFD30EFA5AULL, 0x3C47F7E05401AA4EULL },
+    { 0x8714A775E3E95C78ULL, 0x65ACFAEC34810A71ULL },
+    { 0xA8D9D1535CE3B396ULL, 0x7F1839A741A14D0DULL },
+    { 0xD31045A8341CA07CULL, 0x1EDE48111209A050ULL },
+    { 0x83EA2B892091E44DULL, 0x934AED0AAB460432ULL },
+    { 0xA4E4B66B68B65D60ULL, 0xF81DA84D5617853FULL },
+    { 0xCE1DE40642E3F4B9ULL, 0x36251260AB9D668EULL },
+    { 0x80D2AE83E9CE78F3ULL, 0xC1D72B7C6B426019ULL },
+    { 0xA1075A24E4421730ULL, 0xB24CF65B8612F81FULL },
+    { 0xC94930AE1D529CFCULL, 0xDEE033F26797B627ULL },
+    { 0xFB9B7CD9A4A7443CULL, 0x169840EF017DA3B1ULL },
+    { 0x9D412E0806E88AA5ULL, 0x8E1F289560EE864EULL },
+    { 0xC491798A08A2AD4EULL, 0xF1A6F2BAB92A27E2ULL },
+    { 0xF5B5D7EC8ACB58A2ULL, 0xAE10AF696774B1DBULL },
+    { 0x9991A6F3D6BF1765ULL, 0xACCA6DA1E0A8EF29ULL },
+    { 0xBFF610B0CC6EDD3FULL, 0x17FD090A58D32AF3ULL },
+    { 0xEFF394DCFF8A948EULL, 0xDDFC4B4CEF07F5B0ULL },
+    { 0x95F83D0A1FB69CD9ULL, 0x4ABDAF101564F98EULL },
+    { 0xBB764C4CA7A4440FULL, 0x9D6D1AD41ABE37F1ULL },
+    { 0xEA53DF5FD18D5513ULL, 0x84C86189216DC5EDULL },
+    { 0x92746B9BE2F8552CULL, 0x32FD3CF5B4E49BB4ULL },
+    { 0xB7118682DBB66A77ULL, 0x3FBC8C33221DC2A1ULL },
+    { 0xE4D5E82392A40515ULL, 0x0FABAF3FEAA5334AULL },
+    { 0x8F05B1163BA6832DULL, 0x29CB4D87F2A7400EULL },
+    { 0xB2C71D5BCA9023F8ULL, 0x743E20E9EF511012ULL },
+    { 0xDF78E4B2BD342CF6ULL, 0x914DA9246B255416ULL },
+    { 0x8BAB8EEFB6409C1AULL, 0x1AD089B6C2F7548EULL },
+    { 0xAE9672ABA3D0C320ULL, 0xA184AC2473B529B1ULL },
+    { 0xDA3C0F568CC4F3E8ULL, 0xC9E5D72D90A2741EULL },
+    { 0x8865899617FB1871ULL, 0x7E2FA67C7A658892ULL },
+    { 0xAA7EEBFB9DF9DE8DULL, 0xDDBB901B98FEEAB7ULL },
+    { 0xD51EA6FA85785631ULL, 0x552A74227F3EA565ULL },
+    { 0x8533285C936B35DEULL, 0xD53A88958F87275FULL },
+    { 0xA67FF273B8460356ULL, 0x8A892ABAF368F137ULL },
+    { 0xD01FEF10A657842CULL, 0x2D2B7569B0432D85ULL },
+    { 0x8213F56A67F6B29BULL, 0x9C3B29620E29FC73ULL },
+    { 0xA298F2C501F45F42ULL, 0x8349F3BA91B47B8FULL },
+    { 0xCB3F2F7642717713ULL, 0x241C70A936219A73ULL },
+    { 0xFE0EFB53D30DD4D7ULL, 0xED238CD383AA0110ULL },
+    { 0x9EC95D1463E8A506ULL, 0xF4363804324A40AAULL },
+    { 0xC67BB4597CE2CE48ULL, 0xB143C6053EDCD0D5ULL },
+    { 0xF81AA16FDC1B81DAULL, 0xDD94B7868E94050AULL },
+    { 0x9B10A4E5E9913128ULL, 0xCA7CF2B4191C8326ULL },
+    { 0xC1D4CE1F63F57D72ULL, 0xFD1C2F611F63A3F0ULL },
+    { 0xF24A01A73CF2DCCFULL, 0xBC633B39673C8CECULL },
+    { 0x976E41088617CA01ULL, 0xD5BE0503E085D813ULL },
+    { 0xBD49D14AA79DBC82ULL, 0x4B2D8644D8A74E18ULL },
+    { 0xEC9C459D51852BA2ULL, 0xDDF8E7D60ED1219EULL },
+    { 0x93E1AB8252F33B45ULL, 0xCABB90E5C942B503ULL },
+    { 0xB8DA1662E7B00A17ULL, 0x3D6A751F3B936243ULL },
+    { 0xE7109BFBA19C0C9DULL, 0x0CC512670A783AD4ULL },
+    { 0x906A617D450187E2ULL, 0x27FB2B80668B24C5ULL },
+    { 0xB484F9DC9641E9DAULL, 0xB1F9F660802DEDF6ULL },
+    { 0xE1A63853BBD26451ULL, 0x5E7873F8A0396973ULL },
+    { 0x8D07E33455637EB2ULL, 0xDB0B487B6423E1E8ULL },
+    { 0xB049DC016ABC5E5FULL, 0x91CE1A9A3D2CDA62ULL },
+    { 0xDC5C5301C56B75F7ULL, 0x7641A140CC7810FBULL },
+    { 0x89B9B3E11B6329BAULL, 0xA9E904C87FCB0A9DULL },
+    { 0xAC2820D9623BF429ULL, 0x546345FA9FBDCD44ULL },
+    { 0xD732290FBACAF133ULL, 0xA97C177947AD4095ULL },
+    { 0x867F59A9D4BED6C0ULL, 0x49ED8EABCCCC485DULL },
+    { 0xA81F301449EE8C70ULL, 0x5C68F256BFFF5A74ULL },
+    { 0xD226FC195C6A2F8CULL, 0x73832EEC6FFF3111ULL },
+    { 0x83585D8FD9C25DB7ULL, 0xC831FD53C5FF7EABULL },
+    { 0xA42E74F3D032F525ULL, 0xBA3E7CA8B77F5E55ULL },
+    { 0xCD3A1230C43FB26FULL, 0x28CE1BD2E55F35EBULL },
+    { 0x80444B5E7AA7CF85ULL, 0x7980D163CF5B81B3ULL },
+    { 0xA0555E361951C366ULL, 0xD7E105BCC332621FULL },
+    { 0xC86AB5C39FA63440ULL, 0x8DD9472BF3FEFAA7ULL },
+    { 0xFA856334878FC150ULL, 0xB14F98F6F0FEB951ULL },
+    { 0x9C935E00D4B9D8D2ULL, 0x6ED1BF9A569F33D3ULL },
+    { 0xC3B8358109E84F07ULL, 0x0A862F80EC4700C8ULL },
+    { 0xF4A642E14C6262C8ULL, 0xCD27BB612758C0FAULL },
+    { 0x98E7E9CCCFBD7DBDULL, 0x8038D51CB897789CULL },
+    { 0xBF21E44003ACDD2CULL, 0xE0470A63E6BD56C3ULL },
+    { 0xEEEA5D5004981478ULL, 0x1858CCFCE06CAC74ULL },
+    { 0x95527A5202DF0CCBULL, 0x0F37801E0C43EBC8ULL },
+    { 0xBAA718E68396CFFDULL, 0xD30560258F54E6BAULL },
+    { 0xE950DF20247C83FDULL, 0x47C6B82EF32A2069ULL },
+    { 0x91D28B7416CDD27EULL, 0x4CDC331D57FA5441ULL },
+    { 0xB6472E511C81471DULL, 0xE0133FE4ADF8E952ULL },
+    { 0xE3D8F9E563A198E5ULL, 0x58180FDDD97723A6ULL },
+    { 0x8E679C2F5E44FF8FULL, 0x570F09EAA7EA7648ULL }
+};
 
-static const uint8_t* JSON_get_object_close(const uint8_t* openingBracket, const uint8_t* sourceEnd)
-{
-#ifndef NDEBUG
-    if (*openingBracket != '{') {
-        assert(00 && "JSON_get_object_close: INVALID CALL, openingBracket MUST BE A PTR TO A '{'");
-    }
+static int32_t u64_clz(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return 63 - (int32_t)i;
+#else
+    return __builtin_clzll(v);
 #endif
+}
 
-    uint32_t depth = 0;
-    while (openingBracket!=sourceEnd)
-    {
-        if (*openingBracket == '{') {
-            depth++;
+/* returns the IEEE bits of w * 10^q rounded to nearest, even, following Eisel and Lemire.
+   The 128 bit product is always sufficient when w holds every digit of the number. */
+static uint64_t eisel_lemire(int64_t q, uint64_t w)
+{
+    if (w == 0 || q < -342) {
+        return 0;
+    }
+    if (q > 308) {
+        return 0x7FFull << DOUBLE_MANTISSA_BITS;
+    }
+
+    int32_t lz = u64_clz(w);
+    w <<= lz;
+
+    /* the first 55 bits of the product decide the result unless the bits below them are all ones */
+    const uint64_t* pow5 = power_of_five_128[q + 342];
+    uint64_t high;
+    uint64_t low = u64_mul128(w, pow5[0], &high);
+    const uint64_t precisionMask = 0xFFFFFFFFFFFFFFFFull >> (DOUBLE_MANTISSA_BITS + 3);
+    if ((high & precisionMask) == precisionMask) {
+        uint64_t secondHigh;
+        u64_mul128(w, pow5[1], &secondHigh);
+        low += secondHigh;
+        if (secondHigh > low) {
+            high++;
         }
-        if (*openingBracket == '}') {
-            depth--;
-            if (depth == 0) {
-                return openingBracket;
-            }
+    }
+
+    int32_t upperBit = (int32_t)(high >> 63);
+    int32_t shift = upperBit + 64 - DOUBLE_MANTISSA_BITS - 3;
+    uint64_t mantissa = high >> shift;
+    int32_t power2 = (int32_t)((((152170 + 65536) * q) >> 16) + 63) + upperBit - lz + DOUBLE_BIAS;
+
+    if (power2 <= 0) {
+        /* subnormal */
+        if (-power2 + 1 >= 64) {
+            return 0;
         }
-        openingBracket++;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < (1ull << DOUBLE_MANTISSA_BITS) ? 0 : 1;
+        return (mantissa & ((1ull << DOUBLE_MANTISSA_BITS) - 1)) | ((uint64_t)power2 << DOUBLE_MANTISSA_BITS);
     }
-    return NULL;
+
+    /* exactly halfway between two doubles, round to even */
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high) {
+        mantissa &= ~1ull;
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ull << DOUBLE_MANTISSA_BITS)) {
+        mantissa = 1ull << DOUBLE_MANTISSA_BITS;
+        power2++;
+    }
+    mantissa &= ~(1ull << DOUBLE_MANTISSA_BITS);
+    if (power2 >= 0x7FF) {
+        return 0x7FFull << DOUBLE_MANTISSA_BITS;
+    }
+    return mantissa | ((uint64_t)power2 << DOUBLE_MANTISSA_BITS);
 }
 
-static const uint8_t* JSON_get_list_close(const uint8_t* openingBracket, const uint8_t* sourceEnd)
+/* converts a parsed JSON number to the nearest double. Returns MUSTACHE_ERR_ALLOC if an alloc failed, or
+   MUSTACHE_ERR_INVALID_JSON if the magnitude is beyond the largest double, JSON has no infinity.
+   [numBegin, numEnd) is only read again when a truncated mantissa lies too close to a halfway point. */
+static uint8_t JSON_number_to_double(mustache_parser* parser, const JSON_number* num, const uint8_t* numBegin, const uint8_t* numEnd, double* out)
 {
-#ifndef NDEBUG
-    if (*openingBracket != '[') {
-        assert(00 && "JSON_get_object_close: INVALID CALL, openingBracket MUST BE A PTR TO A '{'");
+    /* both the mantissa and the power of ten are exact doubles, so one operation rounds correctly */
+    if (!num->truncated && num->mantissa <= (1ull << 53) && num->exponent >= -22 && num->exponent <= 22) {
+        double d = (double)num->mantissa;
+        d = num->exponent < 0 ? d / n_pow10((uint16_t)-num->exponent) : d * n_pow10((uint16_t)num->exponent);
+        *out = num->negative ? -d : d;
+        return MUSTACHE_SUCCESS;
+    }
+
+    uint64_t bits = eisel_lemire(num->exponent, num->mantissa);
+    if (num->truncated && bits != eisel_lemire(num->exponent, num->mantissa + 1)) {
+        /* the dropped digits decide the rounding, let the C library read every digit */
+        size_t len = numEnd - numBegin;
+        char* copy = parser->alloc(parser, len + 1);
+        if (!copy) {
+            return MUSTACHE_ERR_ALLOC;
+        }
+        memcpy(copy, numBegin, len);
+        copy[len] = '\0';
+        double d = strtod(copy, NULL);
+        parser->free(parser, copy);
+        memcpy(&bits, &d, sizeof(bits));
+        bits &= ~(1ull << 63);
     }
-#endif 
 
-    uint32_t depth = 0;
-    while (openingBracket != sourceEnd)
-    {
-        if (*openingBracket == '[') {
-            depth++;
-        }
-        if (*openingBracket == ']') {
-            depth--;
-            if (depth == 0) {
-                return openingBracket;
+    if (bits >= (0x7FFull << DOUBLE_MANTISSA_BITS)) {
+        return MUSTACHE_ERR_INVALID_JSON;
+    }
+    bits |= (uint64_t)num->negative << 63;
+    memcpy(out, &bits, sizeof(bits));
+    return MUSTACHE_SUCCESS;
+}
+
+/* returns an INT64 param for an integer, a DECIMAL param for a number with a fraction and no
+   exponent, or a NUMBER param if it does not fit in 19 significant digits or is a negative zero.
+   NULL if an alloc failed, with *err set to MUSTACHE_ERR_ALLOC, or if the number overflows a double.
+   With MUSTACHE_JSON_KEEP_NUMERALS the param references the literal to be written as is. */
+static mustache_param* JSON_number_to_param(mustache_parser* parser, JSON_arena* arena, const JSON_number* num, const uint8_t* numBegin, const uint8_t* numEnd, uint32_t flags, uint8_t* err)
+{
+    mustache_const_slice numeral = { NULL, 0 };
+    if (flags & MUSTACHE_JSON_KEEP_NUMERALS) {
+        numeral = (mustache_const_slice){ numBegin, (uint64_t)(numEnd - numBegin) };
+    }
+
+    /* the magnitude of INT64_MIN is one past INT64_MAX */
+    uint64_t maxUnits = (uint64_t)INT64_MAX + num->negative;
+    bool negativeZero = num->negative && num->mantissa == 0;
+    if (!num->hasExponent && !num->truncated && !negativeZero && num->fractionDigits <= UINT8_MAX && num->mantissa <= maxUnits) {
+        int64_t units = num->negative ? (int64_t)(0 - num->mantissa) : (int64_t)num->mantissa;
+        if (num->fractionDigits == 0) {
+            mustache_param_int64* param = JSON_alloc(parser, arena, sizeof(mustache_param_int64));
+            if (!param) {
+                *err = MUSTACHE_ERR_ALLOC;
+                return NULL;
             }
+            param->type = MUSTACHE_PARAM_INT64;
+            param->value = units;
+            param->numeral = numeral;
+            return (mustache_param*)param;
+        }
+        mustache_param_decimal* param = JSON_alloc(parser, arena, sizeof(mustache_param_decimal));
+        if (!param) {
+            *err = MUSTACHE_ERR_ALLOC;
+            return NULL;
+        }
+        param->type = MUSTACHE_PARAM_DECIMAL;
+        param->units = units;
+        param->scale = (uint8_t)num->fractionDigits;
+        param->numeral = numeral;
+        return (mustache_param*)param;
+    }
+
+    mustache_param_number* param = JSON_alloc(parser, arena, sizeof(mustache_param_number));
+    if (!param) {
+        *err = MUSTACHE_ERR_ALLOC;
+        return NULL;
+    }
+    param->type = MUSTACHE_PARAM_NUMBER;
+    param->trimZeros = false;
+    param->numeral = numeral;
+    /* written as many decimals as the source had, or as the shortest round trip if it used an exponent */
+    param->decimals = num->hasExponent ? MUSTACHE_DECIMALS_SHORTEST : (uint8_t)min(num->fractionDigits, UINT8_MAX - 1);
+    uint8_t res = JSON_number_to_double(parser, num, numBegin, numEnd, &param->value);
+    if (res) {
+        if (res == MUSTACHE_ERR_ALLOC) {
+            *err = res;
         }
-        openingBracket++;
+        JSON_free(parser, arena, param);
+        return NULL;
     }
-    return NULL;
+    return (mustache_param*)param;
 }
 
+typedef enum {
+    JSON_EXPECT_KEY_OR_CLOSE,   /*after '{'*/
+    JSON_EXPECT_KEY,            /*after ',' in an object*/
+    JSON_EXPECT_COLON,
+    JSON_EXPECT_VALUE_OR_CLOSE, /*after '['*/
+    JSON_EXPECT_VALUE,
+    JSON_EXPECT_COMMA_OR_CLOSE
+} JSON_EXPECT;
+
+/* an open object or list, and the last child linked into it */
+typedef struct {
+    mustache_param* container;
+    mustache_param* last;
+    const path_node* paths; /*the filter below the container, NULL keeps every child*/
+} JSON_frame;
+
+#define JSON_INLINE_FRAMES 32
 
-static const uint8_t* JSON_get_string_end(const uint8_t* strFirst, const uint8_t* sourceEnd)
+typedef struct {
+    JSON_frame* frames;
+    uint32_t count;
+    uint32_t capacity;
+    JSON_frame inlineFrames[JSON_INLINE_FRAMES];
+} JSON_stack;
+
+/* pushes a container, moving the stack to the heap once it outgrows its inline frames */
+static uint8_t JSON_stack_push(mustache_parser* parser, JSON_stack* stack, mustache_param* container, const path_node* paths)
 {
-#ifndef NDEBUG
-    if (*strFirst == '\"') {
-        assert(00 && "JSON_get_string_end: INVALID CALL, strFirst MUST BE THE FIRST CHAR AFTER QUOTATION MARK OF THE STRING VALUE.");
+    if (stack->count == stack->capacity) {
+        uint32_t capacity = stack->capacity * 2;
+        JSON_frame* frames = parser->alloc(parser, capacity * sizeof(JSON_frame));
+        if (!frames) {
+            return MUSTACHE_ERR_ALLOC;
+        }
+        memcpy(frames, stack->frames, stack->count * sizeof(JSON_frame));
+        if (stack->frames != stack->inlineFrames) {
+            parser->free(parser, stack->frames);
+        }
+        stack->frames = frames;
+        stack->capacity = capacity;
     }
-#endif 
+    stack->frames[stack->count].container = container;
+    stack->frames[stack->count].last = NULL;
+    stack->frames[stack->count].paths = paths;
+    stack->count++;
+    return MUSTACHE_SUCCESS;
+}
 
-    while (strFirst < sourceEnd)
-    {
-        if (*strFirst == '"') {
-            return strFirst;
+static void mustache_free_node(mustache_parser* parser, mustache_param* node, bool deepCopy);
+
+/* links a new child into the open container on top of the stack. The child is linked before its
+   name is copied so that a failed alloc leaves a tree mustache_free_node can release. */
+static uint8_t JSON_link_param(mustache_parser* parser, JSON_arena* arena, JSON_frame* frame, mustache_param* param, mustache_const_slice key, bool deepCopy)
+{
+    param->pNext = NULL;
+    param->name = (mustache_const_slice){ NULL, 0 };
+
+    if (frame->container->type == MUSTACHE_PARAM_LIST) {
+        mustache_param_list* list = (mustache_param_list*)frame->container;
+        if (frame->last) {
+            frame->last->pNext = param;
         }
-        strFirst++;
+        else {
+            list->pValues = param;
+        }
+        list->valueCount++;
+        frame->last = param;
+        return MUSTACHE_SUCCESS;
     }
 
-    return NULL;
+    mustache_param_object* obj = (mustache_param_object*)frame->container;
+    if (frame->last) {
+        frame->last->pNext = param;
+    }
+    else {
+        obj->pMembers = param;
+    }
+    frame->last = param;
+
+    if (key.len > 0) {
+        if (deepCopy) {
+            uint8_t* name = JSON_alloc(parser, arena, key.len);
+            if (!name) {
+                return MUSTACHE_ERR_ALLOC;
+            }
+            memcpy(name, key.u, key.len);
+            param->name.u = name;
+        }
+        else {
+            param->name.u = key.u;
+        }
+        param->name.len = key.len;
+    }
+    return MUSTACHE_SUCCESS;
 }
 
+/* a number or literal must run up to the next token, anything else left over is not indexed */
+static bool JSON_is_scalar_end(const uint8_t* cur, const uint8_t* sourceEnd)
+{
+    if (cur == sourceEnd) {
+        return true;
+    }
+    switch (*cur)
+    {
+    case ' ': case '\t': case '\n': case '\r':
+    case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+        return true;
+    default:
+        return false;
+    }
+}
 
-static const uint8_t* JSON_get_number_end(const uint8_t* numFirst, const uint8_t* sourceEnd)
+/* parses the scalar value at the token cur into *paramOut, and returns false if it is malformed.
+   The closing quote of a string is the next token. A null value leaves *paramOut NULL. */
+static bool JSON_parse_scalar(mustache_parser* parser, JSON_arena* arena, mustache_param** paramOut, JSON_index* index, const uint8_t* cur, uint32_t flags, uint8_t* err)
 {
+    *paramOut = NULL;
+    *err = MUSTACHE_ERR_INVALID_JSON;
+
+    if (*cur == '"') {
+        const uint8_t* strBegin = cur + 1;
+        const uint8_t* strEnd = JSON_index_next(index);
+        if (!strEnd) {
+            return false;
+        }
 #ifndef NDEBUG
-    if (!isdigit(*numFirst)) {
-        assert(00 && "JSON_get_string_end: INVALID CALL, numFirst MUST BE A PTR TO THE FIRST DIGIT OF THE NUMBER.");
-    }
+        if (*strEnd != '"') {
+            assert(00 && "JSON_parse_scalar: THE TOKEN AFTER AN OPENING QUOTE MUST BE ITS CLOSING QUOTE.");
+        }
 #endif
+        uint32_t strLen = strEnd - strBegin;
 
-    while (numFirst < sourceEnd)
-    {
-        if (!(isdigit(*numFirst) || *numFirst == '.')) {
-            return numFirst;
+        mustache_param_string* param = JSON_alloc(parser, arena, sizeof(mustache_param_string));
+        if (!param) {
+            *err = MUSTACHE_ERR_ALLOC;
+            return false;
         }
-        numFirst++;
+        param->type = MUSTACHE_PARAM_STRING;
+        param->str.u = strLen > 0 ? (uint8_t*)strBegin : NULL;
+        param->str.len = strLen;
+        param->encoding = MUSTACHE_ENCODING_JSON;
+        param->escapeState = MUSTACHE_ESCAPE_UNKNOWN;
+        param->cacheEscaped = (flags & MUSTACHE_JSON_CACHE_ESCAPED) != 0;
+        param->escaped = (mustache_slice){ NULL, 0 };
+        *paramOut = (mustache_param*)param;
+        return true;
     }
 
-    return sourceEnd;
-}
-
-static void JSON_number_to_mustache_number(mustache_param_number* param, const uint8_t* numBegin, const uint8_t* numEnd)
-{
-    /* first, find dec. place (if it exists) */
-    const uint8_t* cur = numBegin;
-    const uint8_t* dec = NULL;
-    while (cur < numEnd)
-    {
-        if (*cur == '.') {
-            dec = cur;
-            break;
+    const uint8_t* sourceEnd = index->sourceEnd;
+    if (*cur == '-' || is_digit(*cur)) {
+        JSON_number num;
+        const uint8_t* numEnd = JSON_parse_number(cur, sourceEnd, &num);
+        if (!numEnd || !JSON_is_scalar_end(numEnd, sourceEnd)) {
+            return false;
         }
-        cur++;
+        *paramOut = JSON_number_to_param(parser, arena, &num, cur, numEnd, flags, err);
+        return *paramOut != NULL;
     }
 
-    if (!dec) {
-        dec = numEnd;
+    size_t remaining = sourceEnd - cur;
+    if (remaining >= 4 && strneql(cur, "null", 4)) {
+        return JSON_is_scalar_end(cur + 4, sourceEnd);
     }
-    param->value = 0;
-    param->decimals = numEnd - dec;
-
-    cur = numBegin;
-    while (cur < dec) {
-        uint32_t n = dec - cur - 1;
-        param->value += n_pow10(n)*((*cur) - 48);
-        cur++;
+    bool value;
+    if (remaining >= 4 && strneql(cur, "true", 4)) {
+        value = true;
+        cur += 4;
     }
-
-    cur++;
-    while (cur < numEnd) { 
-        uint32_t n = cur - dec;
-        double t = (*cur) - 48; 
-        param->value += t / n_pow10(n); 
-        cur++; 
+    else if (remaining >= 5 && strneql(cur, "false", 5)) {
+        value = false;
+        cur += 5;
+    }
+    else {
+        return false;
+    }
+    if (!JSON_is_scalar_end(cur, sourceEnd)) {
+        return false;
     }
 
-
-    double scale = n_pow10(param->decimals);
-    param->value = round(param->value * scale) / scale;
+    mustache_param_boolean* param = JSON_alloc(parser, arena, sizeof(mustache_param_boolean));
+    if (!param) {
+        *err = MUSTACHE_ERR_ALLOC;
+        return false;
+    }
+    param->type = MUSTACHE_PARAM_BOOLEAN;
+    param->value = value;
+    *paramOut = (mustache_param*)param;
+    return true;
 }
 
-/* FORWARD DECLARATION */
-static uint8_t JSON_parse_object(mustache_parser* parser, mustache_param_object** objOut, const uint8_t** inputHead, const uint8_t* openingBracket, const uint8_t* sourceEnd, bool deepCopy);
-
-static uint8_t JSON_parse_key(mustache_parser* parser, mustache_param** paramOut, const uint8_t** inputHead, 
-    mustache_const_slice key_name, const uint8_t* keyEnd, const uint8_t* sourceEnd, bool deepCopy)
+/* With MUSTACHE_JSON_LAZY the children of an object or list are parsed one level at a time. Nested
+   objects and lists are skipped to their closing bracket and stand as MUSTACHE_PARAM_JSON nodes until
+   a lookup reaches into them, so a template pays for the part of the document it uses. */
+typedef struct {
+    mustache_parser* parser;
+    JSON_arena* arena;
+    uint32_t flags;     /*the flags every level is parsed with*/
+    uint8_t* source;    /*the private copy of the JSON made for MUSTACHE_JSON_DEEP_COPY, or NULL*/
+} JSON_document;
+
+/* consumes the tokens of the object or list opened by the last token and returns its closing bracket,
+   or NULL if the input ends first. Brackets are only counted, the contents are not validated. */
+static const uint8_t* JSON_index_skip_container(JSON_index* index)
 {
-    const uint8_t* cur = keyEnd;
-
-    /* find next non-whitespace / colon / " */
-    while (cur < sourceEnd)
+    uint32_t depth = 1;
+    const uint8_t* cur;
+    while ((cur = JSON_index_next(index)))
     {
-        if (!isspace(*cur)) {
-            break;
+        if (*cur == '{' || *cur == '[') {
+            depth++;
+        }
+        else if ((*cur == '}' || *cur == ']') && --depth == 0) {
+            return cur;
         }
-        cur++;
-    }
-    if (cur >= sourceEnd) {
-        return MUSTACHE_ERR_INVALID_JSON;
     }
+    return NULL;
+}
 
-    mustache_param* asGenParam = NULL;
-    if (*cur == '"') 
-    {
-        const uint8_t* strBegin = cur + 1;
-        /* PARAM IS A STRING */
-        const uint8_t* strEnd = JSON_get_string_end(strBegin,sourceEnd);
-        if (!strEnd) {
-            return MUSTACHE_ERR_INVALID_JSON;
-        }
-        uint32_t strLen = strEnd - strBegin;
+/*FORWARD DECLARATION*/
+static void mustache_free_children(mustache_parser* parser, mustache_param* parent, bool deepCopy);
+
+/* parses the children of the object or list starting at openingBracket into container in one forward
+   pass over the structural index. Open objects and lists are kept on an explicit stack rather than the
+   C stack, so the cost is linear in the input and any depth of nesting is bounded only by memory. With
+   a document, nested objects and lists are left unparsed instead. Null values are skipped, and so are
+   members that paths does not hold, these are only checked for balanced brackets. The index must
+   be positioned right after the container's opening bracket. On error the container is left
+   without children. */
+static uint8_t JSON_parse_container(mustache_parser* parser, JSON_arena* arena, JSON_document* doc, mustache_param* container, const path_node* paths, JSON_index* index, uint32_t flags)
+{
+    const bool deepCopy = flags & MUSTACHE_JSON_DEEP_COPY;
 
-        mustache_param_string* param = parser->alloc(parser, sizeof(mustache_param_string));
-        if (!param) {
-            return MUSTACHE_ERR_ALLOC;
+    JSON_stack stack;
+    stack.frames = stack.inlineFrames;
+    stack.count = 0;
+    stack.capacity = JSON_INLINE_FRAMES;
+    JSON_stack_push(parser, &stack, container, paths);
+
+    uint8_t err = MUSTACHE_SUCCESS;
+    JSON_EXPECT expect = container->type == MUSTACHE_PARAM_LIST ? JSON_EXPECT_VALUE_OR_CLOSE : JSON_EXPECT_KEY_OR_CLOSE;
+    mustache_const_slice key = { NULL, 0 };
+
+    while (stack.count > 0)
+    {
+        const uint8_t* cur = JSON_index_next(index);
+        if (!cur) {
+            err = MUSTACHE_ERR_INVALID_JSON;
+            break;
         }
-        param->type = MUSTACHE_PARAM_STRING;
-        asGenParam = (mustache_param*)param;
+        JSON_frame* top = &stack.frames[stack.count - 1];
 
-        if (strLen > 0) {
-            if (deepCopy == true) {
-                void* tmpstr = parser->alloc(parser, strLen);
-                if (!tmpstr) {
-                    return MUSTACHE_ERR_INVALID_JSON;
-                }
-                memcpy(tmpstr, strBegin, strLen);
-                param->str.u = tmpstr;
+        if (expect == JSON_EXPECT_COMMA_OR_CLOSE || (expect == JSON_EXPECT_KEY_OR_CLOSE && *cur == '}')
+            || (expect == JSON_EXPECT_VALUE_OR_CLOSE && *cur == ']')) {
+            bool isList = top->container->type == MUSTACHE_PARAM_LIST;
+            if (*cur == ',' && expect == JSON_EXPECT_COMMA_OR_CLOSE) {
+                expect = isList ? JSON_EXPECT_VALUE : JSON_EXPECT_KEY;
+            }
+            else if (*cur == (isList ? ']' : '}')) {
+                stack.count--;
+                expect = JSON_EXPECT_COMMA_OR_CLOSE;
             }
             else {
-                param->str.u = (uint8_t*)strBegin;
+                err = MUSTACHE_ERR_INVALID_JSON;
+                break;
             }
         }
-        param->str.len = strLen;
-
-        *inputHead = strEnd;
-    }
-    else if (*cur == '[') {
-        /* PARAM IS A LIST */
-        const uint8_t* listClose = JSON_get_list_close(cur, sourceEnd);
-        if (!listClose) {
-            return MUSTACHE_ERR_INVALID_JSON;
+        else if (expect == JSON_EXPECT_KEY_OR_CLOSE || expect == JSON_EXPECT_KEY) {
+            if (*cur != '"') {
+                err = MUSTACHE_ERR_INVALID_JSON;
+                break;
+            }
+            const uint8_t* keyEnd = JSON_index_next(index);
+            if (!keyEnd) {
+                err = MUSTACHE_ERR_INVALID_JSON;
+                break;
+            }
+            key = (mustache_const_slice){ cur + 1, (uint64_t)(keyEnd - cur - 1) };
+            expect = JSON_EXPECT_COLON;
         }
-
-        /* CREATE LIST PARAM */
-        mustache_param_list* param = parser->alloc(parser, sizeof(mustache_param_list));
-        if (!param) {
-            return MUSTACHE_ERR_ALLOC;
+        else if (expect == JSON_EXPECT_COLON) {
+            if (*cur != ':') {
+                err = MUSTACHE_ERR_INVALID_JSON;
+                break;
+            }
+            expect = JSON_EXPECT_VALUE;
         }
-        param->type = MUSTACHE_PARAM_LIST;
-
-        asGenParam = (mustache_param*)param;
-
-        param->valueCount = 0;
-        param->pValues = NULL;
-        mustache_param* lastChildParam = NULL;
-
-        cur++;
-        const uint8_t* beg = NULL;
-        /* parse all key value pairs in list */
-        while (cur<listClose)
-        {
+        else {
+            /* a value, in a list the key is always empty */
+            if (top->container->type == MUSTACHE_PARAM_LIST) {
+                key = (mustache_const_slice){ NULL, 0 };
+            }
 
-            if (!(isspace(*cur) || *cur == ',')) {
-                beg = cur;
-                const uint8_t* end = NULL;
-                while (cur < listClose) {
-                    if (isspace(*cur) || *cur == ',' || cur == listClose) {
-                        end = cur;
+            /* list elements share the filter of their list */
+            const path_node* childPaths = top->paths;
+            if (childPaths && top->container->type == MUSTACHE_PARAM_OBJECT) {
+                childPaths = path_find_child(childPaths, key.u, key.len);
+                if (!childPaths) {
+                    if (*cur == '{' || *cur == '[') {
+                        cur = JSON_index_skip_container(index);
+                    }
+                    else if (*cur == '"') {
+                        cur = JSON_index_next(index);
+                    }
+                    if (!cur) {
+                        err = MUSTACHE_ERR_INVALID_JSON;
                         break;
                     }
-                    cur++;
+                    expect = JSON_EXPECT_COMMA_OR_CLOSE;
+                    continue;
                 }
-                if (!end) {
-                    return MUSTACHE_ERR_INVALID_JSON;
+                if (childPaths->whole) {
+                    childPaths = NULL;
                 }
+            }
 
-                mustache_param* listChild = NULL;
-                uint8_t err = JSON_parse_key(parser, &listChild, &cur, 
-                    (mustache_const_slice) { NULL, 0 }, beg, end, true);
-                if (err || !listChild) {
-                    return MUSTACHE_ERR_INVALID_JSON;
+            if ((*cur == '{' || *cur == '[') && doc) {
+                const uint8_t* close = JSON_index_skip_container(index);
+                if (!close) {
+                    err = MUSTACHE_ERR_INVALID_JSON;
+                    break;
+                }
+                mustache_param_json* lazy = JSON_alloc(parser, arena, sizeof(mustache_param_json));
+                if (!lazy) {
+                    err = MUSTACHE_ERR_ALLOC;
+                    break;
                 }
+                lazy->type = MUSTACHE_PARAM_JSON;
+                lazy->pValues = NULL;
+                lazy->valueCount = 0;
+                lazy->source = (mustache_const_slice){ cur, (uint64_t)(close + 1 - cur) };
+                lazy->document = doc;
+                lazy->paths = childPaths;
+                err = JSON_link_param(parser, arena, top, (mustache_param*)lazy, key, deepCopy);
+                if (err) {
+                    break;
+                }
+                expect = JSON_EXPECT_COMMA_OR_CLOSE;
+                continue;
+            }
 
-                if (lastChildParam) {
-                    lastChildParam->pNext = listChild;
+            if (*cur == '{' || *cur == '[') {
+                bool isList = *cur == '[';
+                mustache_param* child = JSON_alloc(parser, arena, isList ? sizeof(mustache_param_list) : sizeof(mustache_param_object));
+                if (!child) {
+                    err = MUSTACHE_ERR_ALLOC;
+                    break;
+                }
+                if (isList) {
+                    mustache_param_list* list = (mustache_param_list*)child;
+                    list->type = MUSTACHE_PARAM_LIST;
+                    list->pValues = NULL;
+                    list->valueCount = 0;
                 }
                 else {
-                    param->pValues = listChild;
+                    mustache_param_object* obj = (mustache_param_object*)child;
+                    obj->type = MUSTACHE_PARAM_OBJECT;
+                    obj->pMembers = NULL;
+                }
+                err = JSON_link_param(parser, arena, top, child, key, deepCopy);
+                if (err) {
+                    break;
+                }
+                err = JSON_stack_push(parser, &stack, child, childPaths);
+                if (err) {
+                    break;
                 }
-                lastChildParam = listChild;
-                param->valueCount++;
+                expect = isList ? JSON_EXPECT_VALUE_OR_CLOSE : JSON_EXPECT_KEY_OR_CLOSE;
+                continue;
             }
-            cur++;
+
+            mustache_param* param;
+            if (!JSON_parse_scalar(parser, arena, &param, index, cur, flags, &err)) {
+                break;
+            }
+            err = MUSTACHE_SUCCESS;
+            if (param) {
+                err = JSON_link_param(parser, arena, top, param, key, deepCopy);
+                if (err) {
+                    break;
+                }
+                if (deepCopy && param->type == MUSTACHE_PARAM_STRING) {
+                    mustache_param_string* str = (mustache_param_string*)param;
+                    /* the escapes are decoded while the string is copied anyway */
+                    if (str->str.len > 0) {
+                        uint8_t* copy = JSON_alloc(parser, arena, str->str.len);
+                        if (!copy) {
+                            str->str.u = NULL;
+                            err = MUSTACHE_ERR_ALLOC;
+                            break;
+                        }
+                        str->str.len = JSON_decode_string(str->str.u, str->str.u + str->str.len, copy) - copy;
+                        str->str.u = copy;
+                    }
+                    str->encoding = MUSTACHE_ENCODING_NONE;
+                }
+            }
+            expect = JSON_EXPECT_COMMA_OR_CLOSE;
         }
+    }
 
-        *inputHead = listClose;
+    if (stack.frames != stack.inlineFrames) {
+        parser->free(parser, stack.frames);
     }
-    else if (*cur == '{') {
-        /* PARAM IS AN OBJECT */
-        mustache_param_object* param = NULL;
-        uint8_t err = JSON_parse_object(parser, &param, inputHead, cur, sourceEnd, deepCopy);
-        if (err || !param) {
-            return err;
+    if (err) {
+        /* partial children in an arena are released with the arena */
+        if (!arena) {
+            mustache_free_children(parser, container, deepCopy);
         }
-        asGenParam = (mustache_param*)param;
-    }
-    else if (isdigit(*cur)) {
-        const uint8_t* numBegin = cur;
-        /* PARAM IS A NUMBER */
-        const uint8_t* numEnd = JSON_get_number_end(numBegin,sourceEnd);
-        if (!numEnd) {
-            return MUSTACHE_ERR_INVALID_JSON;
+        if (container->type == MUSTACHE_PARAM_LIST) {
+            ((mustache_param_list*)container)->pValues = NULL;
+            ((mustache_param_list*)container)->valueCount = 0;
         }
-
-        mustache_param_number* param = parser->alloc(parser, sizeof(mustache_param_number));
-        if (!param) {
-            return MUSTACHE_ERR_ALLOC;
+        else {
+            ((mustache_param_object*)container)->pMembers = NULL;
         }
-        param->type = MUSTACHE_PARAM_NUMBER;
-
-        asGenParam = (mustache_param*)param;
-
-        param->trimZeros = false;
-        JSON_number_to_mustache_number(param, numBegin, numEnd);
+    }
+    return err;
+}
 
-        *inputHead = numEnd;
+/* parses a MUSTACHE_PARAM_JSON node into the object or list it holds, one level deep and in place, so
+   every pointer to it stays valid. A subtree that turns out to be malformed stays a MUSTACHE_PARAM_JSON
+   node without children, so every lookup that reaches it fails again. */
+static uint8_t JSON_materialize(mustache_param* param)
+{
+    if (param->type != MUSTACHE_PARAM_JSON) {
+        return MUSTACHE_SUCCESS;
+    }
+    mustache_param_json* lazy = (mustache_param_json*)param;
+    JSON_document* doc = lazy->document;
+    const uint8_t* openingBracket = lazy->source.u;
+
+    param->type = *openingBracket == '[' ? MUSTACHE_PARAM_LIST : MUSTACHE_PARAM_OBJECT;
+    lazy->pValues = NULL;
+    lazy->valueCount = 0;
+    JSON_index index;
+    JSON_index_init(&index, openingBracket + 1, openingBracket + lazy->source.len);
+    uint8_t err = JSON_parse_container(doc->parser, doc->arena, doc, param, lazy->paths, &index, doc->flags);
+    if (err) {
+        param->type = MUSTACHE_PARAM_JSON;
+        lazy->pValues = NULL;
+        lazy->valueCount = 0;
     }
-    else {
-        /* PARAM MAY BE BOOLEAN */
-        const uint8_t* end = get_key_value_end(cur, sourceEnd);
-        if (!end) {
-            return MUSTACHE_ERR_INVALID_JSON;
-        }
-        uint32_t len = end - cur;
-        bool val;
-        if (len == 4 && strneql(cur, "true", 4)) {
-            val = true;
-        }
-        else if (len == 5 && strneql(cur, "false", 5)) {
-            val = false;
+    return err;
+}
+
+/* builds the tree of the root object opening at cur. cur to jsonEnd is the whole document, or with a
+   reader the first region of it. */
+static uint8_t JSON_parse_document(mustache_parser* parser, const uint8_t* cur, const uint8_t* jsonEnd, JSON_reader* reader, mustache_param** paramRoot, uint32_t flags, const mustache_path_set* filter)
+{
+    /* the members of the JSON root are matched against the names below 'root', which holds the
+       template's global names too, see path_set_add_chain */
+    static const path_node unreferenced = { NULL, NULL, { NULL, 0 }, false };
+    const path_set* set = (const path_set*)filter;
+    const path_node* paths = NULL;
+    if (set && set->root && !set->root->whole) {
+        paths = path_find_child(set->root, (const uint8_t*)"root", 4);
+        if (!paths) {
+            paths = &unreferenced;
         }
-        else {
-            /* INVALID PARAM OR PARAM IS NULL */
-            *inputHead = end;
-            return MUSTACHE_SUCCESS;
+        else if (paths->whole) {
+            paths = NULL;
         }
+    }
 
-        mustache_param_boolean* param = parser->alloc(parser, sizeof(mustache_param_boolean));
-        if (!param) {
+    JSON_arena* arena = NULL;
+    if (flags & MUSTACHE_JSON_ARENA) {
+        arena = JSON_arena_create(parser, jsonEnd - cur, flags);
+        if (!arena) {
             return MUSTACHE_ERR_ALLOC;
         }
-        param->type = MUSTACHE_PARAM_BOOLEAN;
-        param->value = val;
-
-        asGenParam = (mustache_param*)param;
-
-        *inputHead = end;
     }
 
-    if (!asGenParam) {
+    /* a lazy root keeps the document for the levels parsed later */
+    const bool lazy = flags & MUSTACHE_JSON_LAZY;
+    mustache_param_json* root = JSON_alloc(parser, arena, lazy ? sizeof(mustache_param_json) : sizeof(mustache_param_object));
+    if (!root) {
+        if (arena) {
+            JSON_arena_free(parser, arena);
+        }
         return MUSTACHE_ERR_ALLOC;
     }
+    root->type = MUSTACHE_PARAM_OBJECT;
+    root->pNext = NULL;
+    root->name = (mustache_const_slice){ NULL, 0 };
+    root->pValues = NULL;
 
-    if (key_name.len > 0) {
-        if (deepCopy) {
-            asGenParam->name.u = parser->alloc(parser, key_name.len);
-            if (!asGenParam->name.u) {
-                return MUSTACHE_ERR_ALLOC;
-            }
-            memcpy((uint8_t*)asGenParam->name.u, key_name.u, key_name.len);
+    JSON_document* doc = NULL;
+    uint8_t err = MUSTACHE_SUCCESS;
+    if (lazy) {
+        root->valueCount = 0;
+        root->source = (mustache_const_slice){ cur, (uint64_t)(jsonEnd - cur) };
+        root->document = NULL;
+        root->paths = paths;
+
+        doc = JSON_alloc(parser, arena, sizeof(JSON_document));
+        if (!doc) {
+            err = MUSTACHE_ERR_ALLOC;
         }
         else {
-            asGenParam->name = key_name;
+            doc->parser = parser;
+            doc->arena = arena;
+            doc->flags = flags & ~MUSTACHE_JSON_DEEP_COPY;
+            doc->source = NULL;
+            root->document = doc;
+            /* a deep copy copies the document once, every level then borrows from the copy */
+            if (flags & MUSTACHE_JSON_DEEP_COPY) {
+                doc->source = JSON_alloc(parser, arena, jsonEnd - cur);
+                if (!doc->source) {
+                    err = MUSTACHE_ERR_ALLOC;
+                }
+                else {
+                    memcpy(doc->source, cur, jsonEnd - cur);
+                    jsonEnd = doc->source + (jsonEnd - cur);
+                    cur = doc->source;
+                    root->source.u = cur;
+                }
+            }
         }
     }
-    else {
-        asGenParam->name.u = NULL;
-    }
-    asGenParam->name.len = key_name.len;
-    asGenParam->pNext = NULL;
 
-    *paramOut = asGenParam;
+    if (!err) {
+        JSON_index index;
+        JSON_index_init(&index, cur + 1, jsonEnd);
+        index.reader = reader;
+        err = JSON_parse_container(parser, arena, doc, (mustache_param*)root, paths, &index, doc ? doc->flags : flags);
+        if (reader && reader->err) {
+            err = reader->err;
+        }
+    }
+    if (err) {
+        mustache_free_param_list(parser, (mustache_param*)root, flags);
+        return err;
+    }
 
+    /* the root's name is only freed along with a deep copied tree that owns its names */
+    if ((flags & MUSTACHE_JSON_DEEP_COPY) && !arena && !lazy) {
+        uint8_t* name = parser->alloc(parser, 4);
+        if (!name) {
+            mustache_free_param_list(parser, (mustache_param*)root, flags);
+            return MUSTACHE_ERR_ALLOC;
+        }
+        memcpy(name, "root", 4);
+        root->name = (mustache_const_slice){ name, 4 };
+    }
+    else {
+        root->name = (mustache_const_slice){ (const uint8_t*)"root", 4 };
+    }
+    *paramRoot = (mustache_param*)root;
     return MUSTACHE_SUCCESS;
 }
 
-static uint8_t JSON_parse_object(mustache_parser* parser, mustache_param_object** objOut, const uint8_t** inputHead, const uint8_t* openingBracket, const uint8_t* sourceEnd, bool deepCopy)
+uint8_t mustache_JSON_to_param_chain(mustache_parser* parser, mustache_const_slice JSON, mustache_param** paramRoot, uint32_t flags, const mustache_path_set* filter)
 {
-    const uint8_t* objClose = JSON_get_object_close(openingBracket, sourceEnd);
-    if (!objClose) {
-        return MUSTACHE_ERR_INVALID_JSON;
-    }
-
-    mustache_param* firstChild = NULL;
-    mustache_param* lastParam = NULL;
-    const uint8_t* cur = openingBracket + 1;
-    while (cur < objClose)
-    {
-        /* get key name */
-        if (*cur == '"') {
-            const uint8_t* nameBeg = cur+1;
-            const uint8_t* nameEnd = NULL;
-            cur = nameBeg+1;
-            while (cur <objClose)
-            {
-                if (*cur == '"') {
-                    nameEnd = cur;
-                    break;
-                }
-                cur++;
-            }
-            if (!nameEnd) {
-                return MUSTACHE_ERR_INVALID_JSON;
-            }
-
-            const uint8_t* colonEnd=nameEnd+1;
-            while (colonEnd < objClose+1) {
-                if (*colonEnd == ':') {
-                    colonEnd++;
-                    break;
-                }
-                colonEnd++;
-            }
+    const uint8_t* cur = JSON.u;
+    const uint8_t* jsonEnd = JSON.u + JSON.len;
 
-            mustache_const_slice keyName = { nameBeg, nameEnd - nameBeg };
-            /* get value */
-            mustache_param* param = NULL;
-            uint8_t err = JSON_parse_key(parser, &param, &cur, keyName, colonEnd, objClose+1, deepCopy);
-            if (err) {
-                return err;
-            }
-            if (param) {
-                if (lastParam) {
-                    lastParam->pNext = param;
-                }
-                else {
-                    firstChild = param;
-                }
-                lastParam = param;
-            }
-        }
+    /*ONLY 1 ROOT ALLOWED AS PER JSON STANDARD*/
+    while (cur < jsonEnd && *cur != '{') {
         cur++;
     }
-
-    *inputHead = objClose;
-
-    mustache_param_object* obj = parser->alloc(parser, sizeof(mustache_param_object));
-    if (!obj) {
-        return MUSTACHE_ERR_ALLOC;
+    if (cur == jsonEnd) {
+        return MUSTACHE_SUCCESS;
     }
-    obj->type = MUSTACHE_PARAM_OBJECT;
-    obj->pMembers = firstChild;
-    *objOut = obj;
-
-    return MUSTACHE_SUCCESS;
+    return JSON_parse_document(parser, cur, jsonEnd, NULL, paramRoot, flags, filter);
 }
 
-uint8_t mustache_JSON_to_param_chain(mustache_parser* parser, mustache_const_slice JSON, mustache_param** paramRoot, bool deepCopy)
+uint8_t mustache_JSON_to_param_chain_from_stream(mustache_parser* parser, mustache_stream* stream, mustache_slice chunkBuffer, mustache_param** paramRoot, uint32_t flags, const mustache_path_set* filter)
 {
-    const uint8_t* jsonBeg = JSON.u;
-    const uint8_t* cur = jsonBeg;
-    const uint8_t* jsonEnd = JSON.u + JSON.len;
+    /* the buffer is reused for every region, so nothing can borrow from it */
+    if (!(flags & MUSTACHE_JSON_DEEP_COPY) || (flags & (MUSTACHE_JSON_LAZY | MUSTACHE_JSON_KEEP_NUMERALS))) {
+        return MUSTACHE_ERR_ARGS;
+    }
 
-    uint8_t err = MUSTACHE_SUCCESS;
+    JSON_reader reader = {
+        .parser = parser,
+        .stream = stream,
+        .buf = chunkBuffer.u,
+        .capacity = chunkBuffer.u ? chunkBuffer.len : 0,
+        .filled = 0,
+        .ownsBuf = false,
+        .eof = false,
+        .err = MUSTACHE_SUCCESS
+    };
 
-    while (cur < jsonEnd)
+    /*ONLY 1 ROOT ALLOWED AS PER JSON STANDARD*/
+    const uint8_t* cur = reader.buf;
+    const uint8_t* regionEnd = reader.buf;
+    uint8_t err = MUSTACHE_SUCCESS;
+    while (true)
     {
-        if (*cur == '{') 
-        {
-            mustache_param_object* root = NULL;
-            err = JSON_parse_object(parser, &root, &cur, cur, jsonEnd, deepCopy);
-            if (err) {
-                break;
-            }
-            root->name.u = parser->alloc(parser, 4);
-            if (!root->name.u)
-                return MUSTACHE_ERR_ALLOC;
-
-            memcpy((uint8_t*)root->name.u, "root", 4);
-            root->name.len = strlen("root");
-            root->pNext = NULL;
-            *paramRoot = (mustache_param*)root;
-            break; /*ONLY 1 ROOT ALLOWED AS PER JSON STANDARD*/ 
+        regionEnd = JSON_reader_next_region(&reader, regionEnd);
+        if (!regionEnd) {
+            err = reader.err;
+            break;
+        }
+        cur = memchr(reader.buf, '{', regionEnd - reader.buf);
+        if (cur) {
+            err = JSON_parse_document(parser, cur, regionEnd, &reader, paramRoot, flags, filter);
+            break;
         }
-        cur++;
     }
 
+    if (reader.ownsBuf) {
+        parser->free(parser, reader.buf);
+    }
     return err;
 }
 
 
 
-/*FORWARD DECLARATION*/
-static void mustache_free_node(mustache_parser* parser, mustache_param* node, bool deepCopy);
+void mustache_param_string_release(mustache_parser* parser, mustache_param_string* param)
+{
+    if (param->escaped.u) {
+        parser->free(parser, param->escaped.u);
+    }
+    param->escaped = (mustache_slice){ NULL, 0 };
+    param->escapeState = MUSTACHE_ESCAPE_UNKNOWN;
+}
 
-static void mustache_free_children(mustache_parser* parser, mustache_param* parent, bool deepCopy)
+/* links the children of a container in front of pending and returns the new head, so a tree is walked
+   as one chain without recursion and its depth costs no stack. The children are about to be freed, the
+   pNext of the last one is overwritten */
+static mustache_param* splice_children(mustache_param* node, mustache_param* pending)
 {
-    uint32_t MAX_COUNT;
-    mustache_param_list* asList = (mustache_param_list*)parent;
-    if (parent->type == MUSTACHE_PARAM_LIST) {
-        MAX_COUNT = asList->valueCount;
+    if (node->type != MUSTACHE_PARAM_LIST && node->type != MUSTACHE_PARAM_OBJECT) {
+        return pending;
     }
-    else {
-        MAX_COUNT = UINT32_MAX;
+    mustache_param_list* asList = (mustache_param_list*)node;
+    uint32_t MAX_COUNT = node->type == MUSTACHE_PARAM_LIST ? asList->valueCount : UINT32_MAX;
+    mustache_param* first = asList->pValues;
+    if (!first || !MAX_COUNT) {
+        return pending;
     }
 
-    mustache_param* child = asList->pValues;
-    uint32_t i = 0;
-    while (child && i < MAX_COUNT)
+    mustache_param* last = first;
+    uint32_t i = 1;
+    while (last->pNext && i < MAX_COUNT)
     {
-        mustache_param* next = child->pNext;
-        mustache_free_node(parser, child, deepCopy);
-        child = next;
+        last = last->pNext;
         ++i;
     }
+    last->pNext = pending;
+    return first;
 }
 
-static void mustache_free_node(mustache_parser* parser, mustache_param* node, bool deepCopy)
+static void mustache_free_storage(mustache_parser* parser, mustache_param* node, bool deepCopy)
 {
     if (deepCopy && node->name.u) {
         parser->free(parser, (uint8_t*)node->name.u);
@@ -2967,16 +9512,74 @@ static void mustache_free_node(mustache_parser* parser, mustache_param* node, bo
         if (deepCopy && asStr->str.u) {
             parser->free(parser, asStr->str.u);
         }
-    } 
-    else if (node->type == MUSTACHE_PARAM_LIST || node->type == MUSTACHE_PARAM_OBJECT) {
-        mustache_free_children(parser, node, deepCopy);
+        mustache_param_string_release(parser, asStr);
     }
     parser->free(parser, node);
 }
 
-uint8_t mustache_free_param_list(mustache_parser* parser, mustache_param* paramRoot, bool deepCopy)
+static void mustache_free_pending(mustache_parser* parser, mustache_param* pending, bool deepCopy)
+{
+    while (pending)
+    {
+        mustache_param* node = pending;
+        pending = splice_children(node, node->pNext);
+        mustache_free_storage(parser, node, deepCopy);
+    }
+}
+
+static void mustache_free_children(mustache_parser* parser, mustache_param* parent, bool deepCopy)
+{
+    mustache_free_pending(parser, splice_children(parent, NULL), deepCopy);
+}
+
+/* releases the cached escaped strings of a tree whose nodes are freed with its arena, the tree is
+   unlinked on the way */
+static void mustache_release_escaped(mustache_parser* parser, mustache_param* node)
+{
+    mustache_param* pending = splice_children(node, NULL);
+    while (node)
+    {
+        if (node->type == MUSTACHE_PARAM_STRING) {
+            mustache_param_string_release(parser, (mustache_param_string*)node);
+        }
+        node = pending;
+        if (pending) {
+            pending = splice_children(node, node->pNext);
+        }
+    }
+}
+
+static void mustache_free_node(mustache_parser* parser, mustache_param* node, bool deepCopy)
+{
+    mustache_param* pending = splice_children(node, NULL);
+    mustache_free_storage(parser, node, deepCopy);
+    mustache_free_pending(parser, pending, deepCopy);
+}
+
+uint8_t mustache_free_param_list(mustache_parser* parser, mustache_param* paramRoot, uint32_t flags)
 {
-    mustache_free_node(parser, paramRoot, deepCopy);
+    if (flags & MUSTACHE_JSON_ARENA) {
+        JSON_arena* arena = JSON_arena_of(paramRoot);
+        /* strings are only visited if they may own a cached escaped form */
+        if (arena->flags & MUSTACHE_JSON_CACHE_ESCAPED) {
+            mustache_release_escaped(parser, paramRoot);
+        }
+        JSON_arena_free(parser, arena);
+        return MUSTACHE_SUCCESS;
+    }
+    if (flags & MUSTACHE_JSON_LAZY) {
+        /* the nodes of a lazy tree borrow their names and strings, even from a deep copy */
+        JSON_document* doc = ((mustache_param_json*)paramRoot)->document;
+        mustache_free_node(parser, paramRoot, false);
+        if (doc) {
+            if (doc->source) {
+                parser->free(parser, doc->source);
+            }
+            parser->free(parser, doc);
+        }
+        return MUSTACHE_SUCCESS;
+    }
+    mustache_free_node(parser, paramRoot, flags & MUSTACHE_JSON_DEEP_COPY);
 
     return MUSTACHE_SUCCESS;
 }
@@ -3061,6 +9664,22 @@ void mustache_print_node(mustache_param* node, int depth)
         }
         printf("%f", nno->value);
     }
+    else if (node->type == MUSTACHE_PARAM_INT64) {
+        mustache_param_int64* nint = (mustache_param_int64*)node;
+        if (node->name.len) {
+            printf("\"%.*s\": ", node->name.len, node->name.u);
+        }
+        printf("%lld", (long long)nint->value);
+    }
+    else if (node->type == MUSTACHE_PARAM_DECIMAL) {
+        mustache_param_decimal* ndec = (mustache_param_decimal*)node;
+        if (node->name.len) {
+            printf("\"%.*s\": ", node->name.len, node->name.u);
+        }
+        uint8_t buf[DTOA_BUFFER_SIZE];
+        uint8_t* end = decimaltoa(ndec->units, ndec->scale, buf, sizeof(buf));
+        printf("%.*s", (int)(end - buf), buf);
+    }
     else if (node->type == MUSTACHE_PARAM_BOOLEAN) {
         mustache_param_boolean* nbool = (mustache_param_boolean*)node;
         if (node->name.len) {
@@ -3073,6 +9692,13 @@ void mustache_print_node(mustache_param* node, int depth)
             printf("false");
         }
     }
+    else if (node->type == MUSTACHE_PARAM_JSON) {
+        mustache_param_json* njson = (mustache_param_json*)node;
+        if (node->name.len) {
+            printf("\"%.*s\": ", node->name.len, node->name.u);
+        }
+        printf("%.*s", (int)njson->source.len, njson->source.u);
+    }
     else {
         printf("\"%.*s\": !!INVALID PARAMETER!!", node->name.len, node->name.u);
     }
@@ -3087,4 +9713,35 @@ void mustache_print_parameter_list(mustache_param* root)
     }
 }
 
+/* prints one path per line for every leaf of the set, a trailing '.*' marks a path kept whole */
+static void mustache_print_path_node(const path_node* node, const path_node** trail, uint32_t depth)
+{
+    while (node)
+    {
+        trail[depth] = node;
+        if (!node->pChildren || node->whole || depth + 1 == 64) {
+            uint32_t i;
+            for (i = 0; i <= depth; i++) {
+                printf(i ? ".%.*s" : "%.*s", (int)trail[i]->name.len, trail[i]->name.u);
+            }
+            printf(node->whole ? ".*\n" : "\n");
+        }
+        else {
+            mustache_print_path_node(node->pChildren, trail, depth + 1);
+        }
+        node = node->pNext;
+    }
+}
+
+void mustache_print_path_set(mustache_path_set* paths)
+{
+    const path_set* set = (const path_set*)paths;
+    const path_node* trail[64];
+    if (!set->root || set->root->whole) {
+        printf("*\n");
+        return;
+    }
+    mustache_print_path_node(set->root->pChildren, trail, 0);
+}
+
 #endif
\ No newline at end of file
@@ -35,6 +35,7 @@ form of Artificial Intelligence.
 
 PREPROCESSOR FLAGS:
 - NOT_MUSTACHE_TARGET_MSVC <- define if targeting the MSVC or Odin compiler.
+- NOT_MUSTACHE_NO_SIMD <- define to use the scalar fallbacks in place of the SSE2/AVX2 kernels.
 
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 */
@@ -80,9 +81,47 @@ typedef enum {
     MUSTACHE_PARAM_STRING,
     MUSTACHE_PARAM_LIST,
     MUSTACHE_PARAM_OBJECT,
-    MUSTACHE_PARAM_TEMPLATE
+    MUSTACHE_PARAM_TEMPLATE,
+    MUSTACHE_PARAM_INT64,
+    MUSTACHE_PARAM_DECIMAL,
+    MUSTACHE_PARAM_JSON
 } MUSTACHE_PARAM_TYPE;
 
+typedef enum {
+    /* the escape state of a string param refers to HTML escaping, the other escape modes are applied while writing */
+    MUSTACHE_ESCAPE_UNKNOWN = 0,    /* the string has not been scanned yet */
+    MUSTACHE_ESCAPE_CLEAN,          /* the string contains no characters that must be escaped */
+    MUSTACHE_ESCAPE_DIRTY           /* the string contains characters that must be escaped */
+} MUSTACHE_ESCAPE_STATE;
+
+typedef enum {
+    MUSTACHE_ENCODING_NONE = 0,     /* str is written as it is */
+    MUSTACHE_ENCODING_JSON          /* str may hold JSON backslash escapes, they are decoded each time it is written */
+} MUSTACHE_STRING_ENCODING;
+
+typedef enum {
+    MUSTACHE_JSON_DEEP_COPY = 1 << 0,       /* source data is copied rather than shallowly referenced where applicable */
+    MUSTACHE_JSON_CACHE_ESCAPED = 1 << 1,   /* string params keep their escaped form once it has been built */
+    MUSTACHE_JSON_KEEP_NUMERALS = 1 << 2,   /* number params reference their numeral in the JSON source, which must outlive them */
+    MUSTACHE_JSON_ARENA = 1 << 3,           /* the tree is placed in a few large blocks and freed with them in one pass */
+    MUSTACHE_JSON_LAZY = 1 << 4             /* objects and lists are parsed when a template first reaches into them, the parser must outlive the tree */
+} MUSTACHE_JSON_FLAGS;
+
+typedef enum {
+    MUSTACHE_FD_ALIGNED = 1 << 0    /* output is written in whole 4096 byte blocks from an aligned part of the parse buffer, for fds opened with O_DIRECT */
+} MUSTACHE_FD_FLAGS;
+
+typedef enum {
+    MUSTACHE_DEFLATE_RAW = 0,       /* a bare deflate stream, RFC 1951 */
+    MUSTACHE_DEFLATE_ZLIB,          /* the zlib format of RFC 1950, the "deflate" content coding of HTTP */
+    MUSTACHE_DEFLATE_GZIP           /* the gzip format of RFC 1952, the "gzip" content coding of HTTP */
+} MUSTACHE_DEFLATE_FORMAT;
+
+enum {
+    MUSTACHE_DECIMALS_SHORTEST = 0xFF   /* a number is written as the shortest string that parses back to the same value, in scientific
+                                           notation below 1e-6 and from 1e21 up. Any other decimals always write plain digits. */
+};
+
 /* ===== STRUCTURE FORWARD DECLARATIONS */
 
 typedef struct mustache_slice mustache_slice;
@@ -97,6 +136,8 @@ typedef struct mustache_stream mustache_stream;
 
 typedef struct mustache_structure mustache_structure;
 
+typedef struct mustache_path_set mustache_path_set;
+
 /* ====== FUNCTION CALLBACK TYPES ====== */
 
 typedef uint64_t (*mustache_seek_callback)(void* udata, int64_t whence, MUSTACHE_SEEK_DIR seekdir);
@@ -145,6 +186,11 @@ typedef struct {
     MUSTACHE_PARAM_TYPE type;
     mustache_const_slice name;
     mustache_slice str;
+
+    uint8_t encoding;           /* MUSTACHE_STRING_ENCODING, reset to MUSTACHE_ENCODING_NONE on the first write if str has no escapes */
+    uint8_t escapeState;        /* MUSTACHE_ESCAPE_STATE, computed on the first escaped write if left as MUSTACHE_ESCAPE_UNKNOWN */
+    bool cacheEscaped;          /* if true, the escaped form of str is built once and stored in escaped */
+    mustache_slice escaped;     /* owned by the param, see mustache_param_string_release */
 } mustache_param_string;
 
 typedef struct {
@@ -152,10 +198,29 @@ typedef struct {
     MUSTACHE_PARAM_TYPE type;
     mustache_const_slice name;
     double value;
-    uint8_t decimals;
-    bool trimZeros;
+    uint8_t decimals;           /* digits written after the decimal point, or MUSTACHE_DECIMALS_SHORTEST */
+    bool trimZeros;             /* trailing zeros after the decimal point are not written */
+    mustache_const_slice numeral; /* if set, written verbatim instead of formatting value */
 } mustache_param_number;
 
+typedef struct {
+    void* pNext;
+    MUSTACHE_PARAM_TYPE type;
+    mustache_const_slice name;
+    int64_t value;
+    mustache_const_slice numeral; /* if set, written verbatim instead of formatting value */
+} mustache_param_int64;
+
+/* a fixed-point number, its value is units / 10^scale and it is written with scale decimals */
+typedef struct {
+    void* pNext;
+    MUSTACHE_PARAM_TYPE type;
+    mustache_const_slice name;
+    int64_t units;
+    uint8_t scale;
+    mustache_const_slice numeral; /* if set, written verbatim instead of formatting units */
+} mustache_param_decimal;
+
 typedef struct {
     void* pNext;
     MUSTACHE_PARAM_TYPE type;
@@ -171,6 +236,19 @@ typedef struct {
     bool value;
 } mustache_param_boolean;
 
+/* an object or list that has not been parsed yet, see MUSTACHE_JSON_LAZY. It shares the layout of a
+   list because it becomes a MUSTACHE_PARAM_OBJECT or MUSTACHE_PARAM_LIST in place when it is parsed. */
+typedef struct {
+    void* pNext;
+    MUSTACHE_PARAM_TYPE type;
+    mustache_const_slice name;
+    void* pValues;
+    uint32_t valueCount;
+    mustache_const_slice source;    /* the JSON of the object or list, brackets included */
+    void* document;                 /* DO NOT ATTEMPT TO MODIFY THIS MEMBER */
+    const void* paths;              /* DO NOT ATTEMPT TO MODIFY THIS MEMBER */
+} mustache_param_json;
+
 typedef struct {
     void* pNext;
     MUSTACHE_PARAM_TYPE type;
@@ -197,7 +275,7 @@ typedef struct mustache_stream
 {
     void* udata;
     mustache_read_callback readCallback;
-    mustache_seek_callback seekCallback;
+    mustache_seek_callback seekCallback;   /* may be NULL, MUSTACHE_SEEK_LEN returns UINT64_MAX when the length is not known */
 } mustache_stream;
 
 typedef struct mustache_structure 
@@ -212,6 +290,47 @@ typedef struct mustache_structure
     void*           __H;        /* DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER */
 } mustache_structure;
 
+/* the parameter paths a set of templates can reference, zero initialize it before its first use */
+typedef struct mustache_path_set
+{
+    void*           __A;        /* DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER */
+} mustache_path_set;
+
+/* one file of a mustache_load_files batch, set exactly one of structChain and paramRoot */
+typedef struct mustache_load
+{
+    mustache_const_slice filename;
+    mustache_structure* structChain;    /* an empty chain to compile the template into, it keeps the file's contents */
+    mustache_param** paramRoot;         /* where the parameter chain of a JSON file is stored */
+    uint32_t flags;                     /* MUSTACHE_JSON_FLAGS, MUSTACHE_JSON_DEEP_COPY is required, MUSTACHE_JSON_LAZY and MUSTACHE_JSON_KEEP_NUMERALS are not supported */
+    const mustache_path_set* filter;    /* see mustache_JSON_to_param_chain, may be NULL */
+    uint8_t err;                        /* the MUSTACHE_RES of this file, set by mustache_load_files */
+} mustache_load;
+
+/* a thread that recompiles watched template files as they change (Linux) */
+typedef struct mustache_hot_watcher
+{
+    void*           __A;        /* DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER */
+} mustache_hot_watcher;
+
+/* a template file kept compiled by a mustache_hot_watcher (Linux) */
+typedef struct mustache_hot_template
+{
+    void*           __A;        /* DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER */
+} mustache_hot_template;
+
+/* a thread that hands the output of pipelined renders to their parse callback (Linux) */
+typedef struct mustache_flusher
+{
+    void*           __A;        /* DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER */
+} mustache_flusher;
+
+/* the compression state of mustache_render_deflate, a deflater serves one render at a time */
+typedef struct mustache_deflater
+{
+    void*           __A;        /* DO NOT ATTEMPT TO MODIFY THIS MEMBER, IT IS A PLACEHOLDER */
+} mustache_deflater;
+
 /* ====== FUNCTION CALLBACK TYPES ====== */
 
 typedef void (*mustache_parse_callback)(mustache_parser* parser, void* udata, mustache_slice parsed);
@@ -228,7 +347,8 @@ typedef void (*mustache_parse_callback)(mustache_parser* parser, void* udata, mu
 @param mustache_const_slice filename
 @param mustache_structure* structChain - a pointer to a chain of mustache structures
 @param mustache_param* params - the parameter chain
-@param mustache_slice sourceBuffer - if the file length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE
+@param mustache_slice sourceBuffer - if the file length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE,
+    unused where the file is memory mapped (POSIX builds without NOT_MUSTACHE_NO_MMAP)
 @param mustache_slice parseBuffer - where the parsed template will be stored
 @param void* parseCallbackUdata - passed to the parseCallback function
 @param mustache_parse_callback - called upon parse completion
@@ -249,7 +369,8 @@ uint8_t mustache_parse_file(mustache_parser* parser, mustache_slice parentStackB
 @param mustache_stream - the input stream to parse from
 @param mustache_structure* structChain - a pointer to a chain of mustache structures
 @param mustache_param* params - the parameter chain
-@param mustache_slice sourceBuffer - if the stream length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE
+@param mustache_slice sourceBuffer - if the stream length is larger than the source buffer, mustache_parse_file will return ERR_NO_SPACE.
+    A stream without a seek callback is read until it ends, see mustache_compile_stream for templates of any size
 @param mustache_slice parseBuffer - where the parsed template will be stored
 @param void* parseCallbackUdata - passed to the parseCallback function
 @param mustache_parse_callback - called upon parse completion.
@@ -260,6 +381,86 @@ uint8_t mustache_parse_file(mustache_parser* parser, mustache_slice parentStackB
 *****/
 uint8_t mustache_parse_stream(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_stream* stream, mustache_structure* structChain, mustache_param* params, mustache_slice sourceBuffer, mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback);
 
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a mustache template source that is already in memory. -+-
+    The structure chain borrows the source instead of copying it, the source must stay
+    alive and unchanged until the chain is freed.
+
+@param mustache_parser* parser
+@param mustache_const_slice source - the template source
+@param mustache_structure* structChain - an empty (zero initialized or freed) structure chain
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain is not empty.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_compile(mustache_parser* parser, mustache_const_slice source, mustache_structure* structChain);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a mustache template read from an input stream of any length. -+-
+    The stream is read and compiled a window of at most 64 KB at a time.
+    Only the literal text and the tags are kept, comments and mode pragmas are cut out as they are
+    read, in memory the chain owns and frees with mustache_structure_chain_free. The stream needs
+    no seek callback. Render the chain with mustache_render. Its source no longer lines up with the
+    stream, mustache_path_set_add_template and nested templates use the chain's own copy, and
+    mustache_render_sendfile writes it from memory, compile with mustache_compile_fd to send from the file.
+
+@param mustache_parser* parser
+@param mustache_stream* stream - the input stream to compile from, read until it ends
+@param mustache_structure* structChain - an empty (zero initialized or freed) structure chain
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain is not empty.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_compile_stream(mustache_parser* parser, mustache_stream* stream, mustache_structure* structChain);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Parses a template compiled by mustache_compile or mustache_compile_stream straight from its source. -+-
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer - a stack to hold the parent context(s)
+@param mustache_structure* structChain - a chain compiled by mustache_compile or mustache_compile_stream
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - where the parsed template will be stored
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback - called upon parse completion.
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain was not compiled by mustache_compile(_stream).
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_render(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params, mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders like mustache_render and hashes the output as it is written, while it is still in cache. -+-
+    The hash is set before the parse callback is called, the callback can send it as an ETag ahead
+    of the output. It is the 64 bit XXH64 of the output with a seed of 0, as any xxHash library
+    computes it with XXH64(). It is not XXH3, whose XXH3_64bits() gives a different value.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer - a stack to hold the parent context(s)
+@param mustache_structure* structChain - a chain compiled by mustache_compile or mustache_compile_stream
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - where the parsed template will be stored
+@param uint64_t* hash - where the hash of the output is stored
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback - called upon parse completion.
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain was not compiled by mustache_compile(_stream) or hash is NULL.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_render_hashed(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params, mustache_slice parseBuffer, uint64_t* hash, void* parseCallbackUdata, mustache_parse_callback parseCallback);
+
 
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
@@ -277,10 +478,9 @@ void mustache_structure_chain_free(mustache_parser* parser, mustache_structure*
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
--+- Primes a structure chain for its next use, this must be called if the parameter -+-
-    chain used to generate this structure chain has nodes that were invalidated
-    or changed addresses since the last call to mustache_parse_file or 
-    mustache_parse_stream.
+-+- Clears the params a structure chain resolved in its last render. -+-
+    Every render resolves its params again from the parameter chain it is given,
+    so a chain can be rendered with a new or changed parameter chain without this.
 
 @param mustache_structure* structure_chain
 
@@ -291,7 +491,45 @@ void mustache_structure_chain_flush(mustache_structure* structure_chain);
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
+-+- Adds every parameter path a template can reference to a path set. -+-
+    Nested templates found in params are added as well. A name used inside a section is added
+    below every section it could be resolved in, so the set can only hold more than the template
+    uses, never less. The structure chain is built from source if it is still empty, source must be
+    the same template that is later passed to mustache_parse_stream.
+    A JSON tree can be rendered from its root param, where the template names its members
+    'root.title', or from the root's members, where it names them 'title'. Both are matched
+    against the members of the JSON root, so either template projects the same tree.
+
+@param mustache_parser* parser
+@param mustache_path_set* paths - a zero initialized or previously used path set
+@param mustache_structure* structChain - the template's structure chain
+@param mustache_const_slice source - the template source
+@param mustache_param* params - the parameter chain holding the nested templates
+
+@return uint8_t - MUSTACHE_RES return code. On error the set falls back to keeping every path.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_path_set_add_template(mustache_parser* parser, mustache_path_set* paths, mustache_structure* structChain, mustache_const_slice source, mustache_param* params);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Destroys a path set, calling parser->free for every path in it. -+-
+
+@param mustache_parser* parser
+@param mustache_path_set* paths
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+void mustache_path_set_free(mustache_parser* parser, mustache_path_set* paths);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
 -+- Converts JSON from a file on disk into a mustache parameter chain. -+-
+    The file is memory mapped where the platform allows it and streamed otherwise,
+    the chain never points into it.
 @param mustache_parser* parser
 @param mustache_const_slice filename
 @param mustache_param** paramRoot - pointer to a pointer to the beginning of the parameter chain.
@@ -302,6 +540,24 @@ void mustache_structure_chain_flush(mustache_structure* structure_chain);
 *****/
 uint8_t mustache_JSON_to_param_chain_from_disk(mustache_parser* parser, mustache_const_slice filename, mustache_param** paramRoot);
 
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Loads a batch of template and JSON files. -+-
+    On Linux the reads are queued on an io_uring and every file is compiled or converted
+    as soon as its read completes, while the rest are still being read. Elsewhere, and for
+    anything that is not a regular file, the files are read one by one.
+
+@param mustache_parser* parser
+@param mustache_load* loads - the files, each one's err is set
+@param uint32_t count
+
+@return uint8_t - MUSTACHE_RES return code, the err of the first file that failed to load.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_load_files(mustache_parser* parser, mustache_load* loads, uint32_t count);
+
 
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
@@ -311,31 +567,397 @@ uint8_t mustache_JSON_to_param_chain_from_disk(mustache_parser* parser, mustache
 @param mustache_parser* parser
 @param mustache_const_slice - JSON source
 @param mustache_param** paramRoot - pointer to a pointer 
-@param bool deepCopyData - if true, the source data will be copied rather than shallowly referenced where applicable.
+@param uint32_t flags - MUSTACHE_JSON_FLAGS, passing true is equivalent to MUSTACHE_JSON_DEEP_COPY.
+@param const mustache_path_set* filter - members no template in the set references are skipped without
+                                         being allocated, NULL keeps every member. A member of the root
+                                         is kept if a template names it 'name' or 'root.name'.
+                                         The set must outlive a tree built with MUSTACHE_JSON_LAZY.
+
+@return uint8_t - MUSTACHE_RES return code. With MUSTACHE_JSON_LAZY the nested objects and lists are
+                  only checked for their brackets, a render that reaches a malformed one fails with
+                  MUSTACHE_ERR_INVALID_JSON.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_JSON_to_param_chain(mustache_parser* parser, mustache_const_slice JSON, mustache_param** paramRoot, uint32_t flags, const mustache_path_set* filter);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Converts JSON read from a stream into a mustache parameter chain. -+-
+    The stream is read into chunkBuffer a chunk at a time and only the tree is kept, so the
+    document never has to fit in memory. A key and value that do not fit in chunkBuffer together
+    move the chunk to a larger buffer from parser->alloc.
+
+@param mustache_parser* parser
+@param mustache_stream* stream - only the read callback is used
+@param mustache_slice chunkBuffer - the buffer the stream is read into
+@param mustache_param** paramRoot - pointer to a pointer 
+@param uint32_t flags - MUSTACHE_JSON_FLAGS, MUSTACHE_JSON_DEEP_COPY is required, MUSTACHE_JSON_LAZY and MUSTACHE_JSON_KEEP_NUMERALS are not supported.
+@param const mustache_path_set* filter - see mustache_JSON_to_param_chain.
 
 @return uint8_t - MUSTACHE_RES return code.
 
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 *****/
-uint8_t mustache_JSON_to_param_chain(mustache_parser* parser, mustache_const_slice JSON, mustache_param** paramRoot, bool deepCopyData);
+uint8_t mustache_JSON_to_param_chain_from_stream(mustache_parser* parser, mustache_stream* stream, mustache_slice chunkBuffer, mustache_param** paramRoot, uint32_t flags, const mustache_path_set* filter);
 
 
 
 /*****
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 
--+- Converts JSON into a mustache parameter chain. -+-
+-+- Frees a parameter chain created by mustache_JSON_to_param_chain. -+-
 
 @param mustache_parser* parser
-@param mustache_const_slice - JSON source
 @param mustache_param* paramRoot - the parameter root
-@param bool deepCopyData - determines what data will be freed.
+@param uint32_t flags - the MUSTACHE_JSON_FLAGS the chain was created with, passing true is equivalent to MUSTACHE_JSON_DEEP_COPY.
+                        With MUSTACHE_JSON_ARENA paramRoot must be the root returned by mustache_JSON_to_param_chain.
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+uint8_t mustache_free_param_list(mustache_parser* parser, mustache_param* paramRoot, uint32_t flags);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Releases the cached escaped form of a string param. -+-
+    This must be called before the contents of param->str are modified,
+    mustache_free_param_list calls it for every string in the list.
+
+@param mustache_parser* parser
+@param mustache_param_string* param
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+void mustache_param_string_release(mustache_parser* parser, mustache_param_string* param);
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 HOT RELOAD (LINUX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_HOT_RELOAD)
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Starts a thread that watches template files with inotify and recompiles them as they change. -+-
+    The thread allocates through the parser, parser->alloc and parser->free must be thread safe.
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_hot_watcher_start(mustache_parser* parser, mustache_hot_watcher* watcher);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a template file and keeps it compiled as it changes on disk. -+-
+    Every change is compiled on the watcher's thread and published atomically, renders that
+    are in flight finish on the version they began with. A change that fails to compile
+    leaves the last good version published.
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher - a started watcher
+@param mustache_const_slice filename
+@param mustache_hot_template* hot
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_hot_template_open(mustache_parser* parser, mustache_hot_watcher* watcher, mustache_const_slice filename, mustache_hot_template* hot);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Parses the latest compiled version of a hot template, it never compiles. -+-
+    Like any structure chain a hot template is rendered by one thread at a time.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer - a stack to hold the parent context(s)
+@param mustache_hot_template* hot
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - where the parsed template will be stored
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback - called upon parse completion.
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_hot_render(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_hot_template* hot, mustache_param* params, mustache_slice parseBuffer, void* parseCallbackUdata, mustache_parse_callback parseCallback);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Stops watching a hot template and frees it, it must not be rendered while it is closed. -+-
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher
+@param mustache_hot_template* hot
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+void mustache_hot_template_close(mustache_parser* parser, mustache_hot_watcher* watcher, mustache_hot_template* hot);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Stops the watcher's thread and frees the watcher along with any template still open on it. -+-
+
+@param mustache_parser* parser
+@param mustache_hot_watcher* watcher
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+void mustache_hot_watcher_stop(mustache_parser* parser, mustache_hot_watcher* watcher);
+
+#endif
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 FD OUTPUT (POSIX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compiles a template from an open file, for rendering with mustache_render_sendfile. -+-
+    The file is read from offset 0 whatever the fd's position, the position is left unchanged.
+    The chain owns a copy of the contents, it is freed with mustache_structure_chain_free.
+
+@param mustache_parser* parser
+@param int templateFd - a regular file
+@param mustache_structure* structChain - an empty chain
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_FILE_OPEN if the fd is not a regular file.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_compile_fd(mustache_parser* parser, int templateFd, mustache_structure* structChain);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template to an fd as it goes, a file, pipe or socket. -+-
+    Values and short literal spans are gathered in the parse buffer, longer literal spans are
+    written from the compiled source in place. Both go out together with writev once 128 KB
+    are queued, or earlier when half of the parse buffer is used. The parse buffer only has
+    to hold the output between two writes, a longer value is escaped into memory from
+    parser->alloc and written across as many writes as it takes.
+    With MUSTACHE_FD_ALIGNED everything is copied into the parse buffer and written in whole
+    4096 byte blocks from an aligned address within it, only the last block of the render
+    may be partial. It is written with O_DIRECT lifted from the fd. The fd's offset should
+    be block aligned when the render starts. A non-blocking outFd is polled.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - a compiled chain, see mustache_compile
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - holds the output between writes, at least 3 blocks with MUSTACHE_FD_ALIGNED
+@param int outFd
+@param uint32_t flags - MUSTACHE_FD_FLAGS
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_STREAM if writing to outFd failed.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_render_fd(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params, mustache_slice parseBuffer, int outFd, uint32_t flags);
+
+#endif
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 SENDFILE OUTPUT (LINUX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_SENDFILE)
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template to an fd, sending long literal spans straight from the template's file. -+-
+    Literal spans of 16 KB or more go from the page cache to outFd, spliced into a pipe and sent
+    with sendfile to a socket or file. Values and shorter spans are written as by mustache_render_fd,
+    ahead of the next span that is sent. If templateFd is not a regular file at least as long as
+    the source, the spans are written from the compiled source instead.
+    templateFd must hold the source at offset 0 and must not be written while it renders, replace
+    the file with a rename and keep rendering from the old fd. A non-blocking outFd is polled.
+    On a TCP socket, TCP_CORK keeps the sends of a render from going out as many small segments.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - compiled from templateFd, see mustache_compile_fd
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - holds the output between sends
+@param int templateFd - the file the template was compiled from
+@param int outFd - a socket, pipe or file
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_STREAM if writing to outFd failed.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_render_sendfile(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params, mustache_slice parseBuffer, int templateFd, int outFd);
+
+#endif
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 PIPELINED OUTPUT (LINUX)
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*/
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_PIPELINE)
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Starts a thread that flushes the output of pipelined renders through their parse callback. -+-
+    A flusher serves one render at a time, start one per rendering thread.
+
+@param mustache_parser* parser
+@param mustache_flusher* flusher
 
 @return uint8_t - MUSTACHE_RES return code.
 
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_flusher_start(mustache_parser* parser, mustache_flusher* flusher);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template into one half of the parse buffer while the flusher hands the other to the parse callback. -+-
+    The parse callback is called on the flusher's thread with each half as it fills, in order,
+    and may be called many times per render. It must be done with a slice when it returns,
+    the render writes into it again. The render returns once the callback has been called
+    with the last of the output. A value longer than a half is escaped into memory from
+    parser->alloc and handed over across as many halves as it takes.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - a compiled chain, see mustache_compile
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - split in two halves, one is rendered into while the other is flushed
+@param mustache_flusher* flusher - a started flusher, not used by any other render at the same time
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback parseCallback - called on the flusher's thread
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_render_pipelined(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params, mustache_slice parseBuffer, mustache_flusher* flusher, void* parseCallbackUdata, mustache_parse_callback parseCallback);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Stops the flusher's thread and frees the flusher, no render may be using it. -+-
+
+@param mustache_parser* parser
+@param mustache_flusher* flusher
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+void mustache_flusher_stop(mustache_parser* parser, mustache_flusher* flusher);
+
+#endif
+
+/*
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+                                 COMPRESSED OUTPUT
+
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
 */
-uint8_t mustache_free_param_list(mustache_parser* parser, mustache_param* paramRoot, bool deepCopy);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Allocates the compression state of mustache_render_deflate, about 420 KB. -+-
+
+@param mustache_parser* parser
+@param mustache_deflater* deflater
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_deflater_create(mustache_parser* parser, mustache_deflater* deflater);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Compresses the long literal spans of a compiled chain once, so that renders do not compress them again. -+-
+    mustache_render_deflate splices a compressed span into its output whenever it writes all of it.
+    Each span is compressed on its own and nothing after it can refer back into it, the output
+    is somewhat larger than if it was all compressed together. The spans are freed with the chain.
+
+@param mustache_parser* parser
+@param mustache_structure* structChain - a compiled chain, see mustache_compile
+
+@return uint8_t - MUSTACHE_RES return code, MUSTACHE_ERR_ARGS if the chain is not compiled or already has its spans compressed.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_compile_deflate(mustache_parser* parser, mustache_structure* structChain);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Renders a compiled template and compresses the output as it is written. -+-
+    The parse callback is called with the compressed output in chunks of up to 32 KB as they
+    fill, the last call ends the stream. A value longer than the parse buffer is escaped into
+    memory from parser->alloc and compressed across as many chunks as it takes.
+
+@param mustache_parser* parser
+@param mustache_slice parentStackBuffer
+@param mustache_structure* structChain - a compiled chain, see mustache_compile and mustache_compile_deflate
+@param mustache_param* params - the parameter chain
+@param mustache_slice parseBuffer - holds the output between compressions
+@param mustache_deflater* deflater - not used by any other render at the same time
+@param uint32_t format - MUSTACHE_DEFLATE_FORMAT
+@param void* parseCallbackUdata - passed to the parseCallback function
+@param mustache_parse_callback parseCallback - called with the compressed output
+
+@return uint8_t - MUSTACHE_RES return code.
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+uint8_t mustache_render_deflate(mustache_parser* parser, mustache_slice parentStackBuffer, mustache_structure* structChain, mustache_param* params, mustache_slice parseBuffer, mustache_deflater* deflater, uint32_t format, void* parseCallbackUdata, mustache_parse_callback parseCallback);
+
+/*****
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+
+-+- Frees a deflater, no render may be using it. -+-
+
+@param mustache_parser* parser
+@param mustache_deflater* deflater
+
+-+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
+*****/
+void mustache_deflater_free(mustache_parser* parser, mustache_deflater* deflater);
 
 /*
 -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+- -+-
@@ -351,6 +973,8 @@ void mustache_print_node(mustache_param* node, int depth);
 
 void mustache_print_parameter_list(mustache_param* root);
 
+void mustache_print_path_set(mustache_path_set* paths);
+
 #endif
 
 #endif
\ No newline at end of file
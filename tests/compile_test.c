@@ -0,0 +1,377 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static size_t largestAlloc = 0;
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    if (bytes > largestAlloc) {
+        largestAlloc = bytes;
+    }
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    free(b);
+}
+
+typedef struct
+{
+    uint8_t parsed[8192];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed, parsed.u, parsed.len);
+    output->len = parsed.len;
+    return;
+}
+
+/* hands the template over at most chunk bytes at a time, like a pipe would */
+typedef struct
+{
+    const uint8_t* source;
+    size_t len;
+    size_t read;
+    size_t chunk;
+} chunked_stream;
+
+static size_t chunked_read(void* udata, uint8_t* dst, size_t dstlen)
+{
+    chunked_stream* stream = udata;
+    size_t len = stream->len - stream->read;
+    if (len > stream->chunk) {
+        len = stream->chunk;
+    }
+    if (len > dstlen) {
+        len = dstlen;
+    }
+    memcpy(dst, stream->source + stream->read, len);
+    stream->read += len;
+    return len;
+}
+
+static uint64_t chunked_seek(void* udata, int64_t whence, MUSTACHE_SEEK_DIR seekdir)
+{
+    chunked_stream* stream = udata;
+    return seekdir == MUSTACHE_SEEK_LEN ? stream->len : UINT64_MAX;
+}
+
+static int failures = 0;
+
+/* compiles template with mustache_compile or, if chunk is set, with mustache_compile_stream reading
+   chunk bytes at a time, then renders it with params */
+static uint8_t compile_render(mustache_parser* parser, const char* template, size_t templateLen, size_t chunk, bool knownLen,
+    mustache_param* params, render_output* output)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[8192];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    output->len = 0;
+
+    mustache_structure struct_chain = { 0 };
+    uint8_t err;
+    if (chunk) {
+        chunked_stream stream = { (const uint8_t*)template, templateLen, 0, chunk };
+        mustache_stream input = { &stream, chunked_read, knownLen ? chunked_seek : NULL };
+        err = mustache_compile_stream(parser, &input, &struct_chain);
+    }
+    else {
+        err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, templateLen }, &struct_chain);
+    }
+    if (!err) {
+        err = mustache_render(parser,
+            (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+            &struct_chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+            output, parse_callback);
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+    return err;
+}
+
+/* a template compiled from a stream, whatever the chunks it arrives in, renders as it does from memory */
+static void expect_same(mustache_parser* parser, const char* template, size_t templateLen, mustache_param* params)
+{
+    static const size_t chunks[] = { 1, 2, 3, 7, 64, 1 << 20 };
+    render_output expected;
+    uint8_t expectedErr = compile_render(parser, template, templateLen, 0, false, params, &expected);
+
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+    {
+        for (int knownLen = 0; knownLen < 2; knownLen++)
+        {
+            render_output output;
+            uint8_t err = compile_render(parser, template, templateLen, chunks[i], knownLen, params, &output);
+            if (err != expectedErr || (!err && (output.len != expected.len || memcmp(output.parsed, expected.parsed, output.len)))) {
+                fprintf(stderr, "FAILED: %.*s\n    chunks of %zu, expected \"%.*s\" (err %d)\n    got      \"%.*s\" (err %d)\n",
+                    (int)(templateLen < 80 ? templateLen : 80), template, chunks[i], (int)expected.len, expected.parsed, expectedErr,
+                    (int)output.len, output.parsed, err);
+                failures++;
+                return;
+            }
+        }
+    }
+}
+
+static void expect_same_str(mustache_parser* parser, const char* template, mustache_param* params)
+{
+    expect_same(parser, template, strlen(template), params);
+}
+
+/* appends count copies of piece to buf at *len */
+static void append_repeated(char* buf, size_t* len, const char* piece, size_t count)
+{
+    size_t pieceLen = strlen(piece);
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(buf + *len, piece, pieceLen);
+        *len += pieceLen;
+    }
+}
+
+
+/* a template compiled in memory renders as mustache_parse_stream parses it, and renders again the same */
+static void expect_same_as_parse_stream(mustache_parser* parser, const char* template, mustache_param* params)
+{
+    uint8_t SOURCE_BUFFER[8192];
+    uint8_t PARSER_OUTPUT_BUFFER[8192];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output expected = { .len = 0 };
+    size_t templateLen = strlen(template);
+
+    chunked_stream stream = { (const uint8_t*)template, templateLen, 0, templateLen };
+    mustache_stream input = { &stream, chunked_read, chunked_seek };
+    mustache_structure parsed_chain = { 0 };
+    uint8_t expectedErr = mustache_parse_stream(parser,
+        (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+        &input, &parsed_chain, params,
+        (mustache_slice){ SOURCE_BUFFER,sizeof(SOURCE_BUFFER) },
+        (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+        &expected, parse_callback);
+    mustache_structure_chain_free(parser, &parsed_chain);
+
+    mustache_structure struct_chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, templateLen }, &struct_chain);
+    for (int pass = 0; pass < 2 && !err; pass++)
+    {
+        render_output output = { .len = 0 };
+        err = mustache_render(parser,
+            (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+            &struct_chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+            &output, parse_callback);
+        if (err != expectedErr || output.len != expected.len || memcmp(output.parsed, expected.parsed, output.len)) {
+            fprintf(stderr, "FAILED: %s (render %d)\n    expected \"%.*s\" (err %d)\n    got      \"%.*s\" (err %d)\n", template, pass,
+                (int)expected.len, expected.parsed, expectedErr, (int)output.len, output.parsed, err);
+            failures++;
+        }
+    }
+    if (err && err != expectedErr) {
+        fprintf(stderr, "FAILED: %s\n    expected err %d\n    got err %d\n", template, expectedErr, err);
+        failures++;
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+}
+
+/* renders an already compiled chain with params and compares the output to expected */
+static void expect_chain_render(mustache_parser* parser, mustache_structure* chain, mustache_param* params, const char* what, const char* expected)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[8192];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output output = { .len = 0 };
+    uint8_t err = mustache_render(parser,
+        (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+        chain, params,
+        (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+        &output, parse_callback);
+    if (err || output.len != strlen(expected) || memcmp(output.parsed, expected, output.len)) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got      \"%.*s\" (err %d)\n", what, expected, (int)output.len, output.parsed, err);
+        failures++;
+    }
+}
+
+/* renders one compiled chain with a params chain built from each JSON, freeing each before the next is built */
+static void expect_renders(mustache_parser* parser, const char* template, const char** JSONs, const char** expected, size_t count, uint32_t flags)
+{
+    mustache_structure chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &chain);
+    for (size_t i = 0; i < count && !err; i++)
+    {
+        mustache_param* root = NULL;
+        err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSONs[i], strlen(JSONs[i]) }, &root, flags, NULL);
+        if (err) {
+            break;
+        }
+        expect_chain_render(parser, &chain, ((mustache_param_object*)root)->pMembers, template, expected[i]);
+        mustache_free_param_list(parser, root, flags);
+    }
+    if (err) {
+        fprintf(stderr, "FAILED: %s\n    err %d\n", template, err);
+        failures++;
+    }
+    mustache_structure_chain_free(parser, &chain);
+}
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+    const char* JSON = "{ \"name\": \"<b>\", \"flag\": true, \"none\": false, \"users\": [ { \"name\": \"a\" }, { \"name\": \"b\" } ] }";
+    mustache_param* jsonRoot = NULL;
+    if (mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, 0, NULL)) {
+        fprintf(stderr, "FAILED: the test params did not parse\n");
+        return -1;
+    }
+    mustache_param* params = ((mustache_param_object*)jsonRoot)->pMembers;
+
+    /* plain text, variables and escape modes */
+    expect_same_str(&parser, "Hello, {{name}} and {{&name}}.", params);
+    expect_same_str(&parser, "{{%url name}} {{%json}}{{name}}", params);
+    expect_same_str(&parser, "{{len(users)}} users, first {{users[0].name}} last {{users[-1].name}}", params);
+
+    /* comments inline, on their own line and spread over lines are dropped from the stream's source */
+    expect_same_str(&parser, "a{{! comment }}b", params);
+    expect_same_str(&parser, "line1\n  {{! standalone }}\nline2\n", params);
+    expect_same_str(&parser, "line1\r\n{{! standalone }}\r\nline2", params);
+    expect_same_str(&parser, "{{!\nspread\nover lines\n}}\nafter", params);
+    expect_same_str(&parser, "{{! a }}{{! b }}\n{{! c }}{{name}}", params);
+    expect_same_str(&parser, "{{! only a comment }}", params);
+    expect_same_str(&parser, "{ {{! joins }}{ name }}", params);
+    expect_same_str(&parser, "x {{! a }} {{! b }} {{name}}", params);
+
+    /* sections, inverted sections and else around comments */
+    expect_same_str(&parser, "{{#users}}{{name}}{{! inside }},{{/users}}", params);
+    expect_same_str(&parser, "{{#users}}\n{{! c }}\n  {{name}}\n{{/users}}\ndone", params);
+    expect_same_str(&parser, "{{#flag}}yes{{! c }}{{else}}no{{/flag}} {{#none}}yes{{else}}{{! c }}no{{/none}}", params);
+    expect_same_str(&parser, "{{^none}}empty{{/none}}{{^flag}}full{{/flag}}", params);
+    expect_same_str(&parser, "{{#users}}{{#flag}}{{name}}{{/flag}}{{/users}}", params);
+    expect_same_str(&parser, "{{#users}}{{name}}{{/}}", params);
+
+    /* templates that do not compile fail the same way from a stream */
+    expect_same_str(&parser, "{{#users}}{{name}}", params);
+    expect_same_str(&parser, "{{#users}}{{! never closed }}", params);
+    expect_same_str(&parser, "{{%foo name}}", params);
+
+    /* mustache_compile renders as the stream parser does, from the caller's bytes */
+    expect_same_as_parse_stream(&parser, "Hello, {{name}} and {{&name}}.", params);
+    expect_same_as_parse_stream(&parser, "{{#users}}\n  {{name}}\n{{/users}}\n{{^none}}empty{{/none}}", params);
+    expect_same_as_parse_stream(&parser, "{{#flag}}yes{{else}}no{{/flag}}{{! comment }} {{len(users)}}", params);
+    expect_same_as_parse_stream(&parser, "no tags at all", params);
+
+    /* a chain must be empty to compile into and compiled to render */
+    uint8_t PARSER_OUTPUT_BUFFER[256];
+    uint8_t PARENT_STACK_BUFFER[256];
+    render_output unused;
+    mustache_structure compiled = { 0 };
+    mustache_structure uncompiled = { 0 };
+    const char* source = "{{name}}";
+    if (mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)source, strlen(source) }, &compiled)
+        || mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)source, strlen(source) }, &compiled) != MUSTACHE_ERR_ARGS
+        || mustache_render(&parser, (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) }, &uncompiled, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) }, &unused, parse_callback) != MUSTACHE_ERR_ARGS) {
+        fprintf(stderr, "FAILED: compiling into a full chain and rendering an empty one\n");
+        failures++;
+    }
+    mustache_structure_chain_free(&parser, &compiled);
+
+    /* every render of a compiled chain resolves its names in the params it is given, top level ones included */
+    {
+        const char* JSONs[] = {
+            "{ \"title\": \"A\", \"users\": [ { \"name\": \"a\" } ], \"flag\": true }",
+            "{ \"title\": \"B\", \"users\": [ { \"name\": \"x\" }, { \"name\": \"y\" } ], \"flag\": false }",
+            "{ \"users\": [ { \"name\": \"z\", \"title\": \"Z\" } ], \"title\": \"C\", \"flag\": true }"
+        };
+        const char* expected[] = { "A aA; 1 yes", "B xB;yB; 2 no", "C zZ; 1 yes" };
+        const char* template = "{{title}} {{#users}}{{name}}{{title}};{{/users}} {{len(users)}} {{#flag}}yes{{else}}no{{/flag}}";
+        expect_renders(&parser, template, JSONs, expected, 3, 0);
+        expect_renders(&parser, template, JSONs, expected, 3, MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_ARENA);
+    }
+
+    /* a name found outside the loop is still looked for in every element, which may shadow it */
+    {
+        const char* JSONs[] = {
+            "{ \"title\": \"T\", \"users\": [ { \"name\": \"a\" }, { \"name\": \"b\", \"title\": \"B\" }, { \"name\": \"c\" } ] }",
+            "{ \"title\": \"T\", \"users\": [ { \"name\": \"a\", \"title\": \"A\" }, { \"name\": \"b\" }, { \"title\": \"C\" } ] }"
+        };
+        const char* expected[] = { "Ta;Bb;Tc;", "Aa;Tb;C;" };
+        expect_renders(&parser, "{{#users}}{{title}}{{name}};{{/users}}", JSONs, expected, 2, 0);
+    }
+
+    /* sections, comments and tags that span the compile windows */
+    size_t bigCapacity = 4 * 1024 * 1024;
+    char* big = malloc(bigCapacity);
+    size_t bigLen = 0;
+    append_repeated(big, &bigLen, "{{#users}}", 1);
+    append_repeated(big, &bigLen, "{{! a comment that is cut }}", 5000);
+    append_repeated(big, &bigLen, "[{{name}}]\n  {{! standalone }}\n", 3);
+    append_repeated(big, &bigLen, "{{/users}}", 1);
+    expect_same(&parser, big, bigLen, params);
+
+    bigLen = 0;
+    append_repeated(big, &bigLen, "{{#flag}}{{!", 1);
+    append_repeated(big, &bigLen, " a single comment longer than a window ", 4000);
+    append_repeated(big, &bigLen, "}}{{name}}{{/flag}}", 1);
+    expect_same(&parser, big, bigLen, params);
+
+    /* a stream of comments is compiled without ever holding all of it */
+    bigLen = 0;
+    append_repeated(big, &bigLen, "{{! a comment that is cut }}\n", bigCapacity / 32);
+    append_repeated(big, &bigLen, "{{name}}", 1);
+    largestAlloc = 0;
+    render_output output;
+    uint8_t err = compile_render(&parser, big, bigLen, 4096, true, params, &output);
+    if (err || output.len != 9 || memcmp(output.parsed, "&lt;b&gt;", 9) || largestAlloc >= bigLen / 8) {
+        fprintf(stderr, "FAILED: %zu bytes of comments\n    largest allocation %zu, got \"%.*s\" (err %d)\n",
+            bigLen, largestAlloc, (int)output.len, output.parsed, err);
+        failures++;
+    }
+    free(big);
+
+    mustache_free_param_list(&parser, jsonRoot, 0);
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}
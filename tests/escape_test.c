@@ -0,0 +1,285 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    free(b);
+}
+
+typedef struct
+{
+    uint8_t parsed[4096];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed, parsed.u, parsed.len);
+    output->len = parsed.len;
+    return;
+}
+
+static int failures = 0;
+
+/* renders template with params into a parse buffer of outputLen bytes and compares the output to expected */
+static void expect_render(mustache_parser* parser, const char* template, mustache_param* params, size_t outputLen, const char* expected)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[4096];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output output = { .len = 0 };
+
+    mustache_structure struct_chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &struct_chain);
+    if (!err) {
+        err = mustache_render(parser,
+            (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+            &struct_chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,outputLen },
+            &output, parse_callback);
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+
+    if (err || output.len != strlen(expected) || memcmp(output.parsed, expected, output.len)) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got      \"%.*s\" (err %d)\n", template, expected, (int)output.len, output.parsed, err);
+        failures++;
+    }
+}
+
+/* the HTML escape of len bytes of in, one byte at a time */
+static size_t html_reference(const uint8_t* in, size_t len, char* out)
+{
+    char* head = out;
+    for (size_t i = 0; i < len; i++) {
+        switch (in[i]) {
+        case '&': head += sprintf(head, "&amp;"); break;
+        case '<': head += sprintf(head, "&lt;"); break;
+        case '>': head += sprintf(head, "&gt;"); break;
+        case '"': head += sprintf(head, "&quot;"); break;
+        case '\'': head += sprintf(head, "&#039;"); break;
+        default: *head++ = in[i];
+        }
+    }
+    *head = '\0';
+    return head - out;
+}
+
+/* compiling template must fail with err */
+static void expect_compile_error(mustache_parser* parser, const char* template, uint8_t err)
+{
+    mustache_structure struct_chain = { 0 };
+    uint8_t res = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &struct_chain);
+    if (res != err) {
+        fprintf(stderr, "FAILED: %s\n    expected err %d, got %d\n", template, err, res);
+        failures++;
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+}
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+    mustache_param_string param_name = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"name",strlen("name")},
+        .str = {"<b>Tom & \"Jerry\"</b>",strlen("<b>Tom & \"Jerry\"</b>")}
+    };
+
+    expect_render(&parser, "{{name}}", (mustache_param*)&param_name, 4096,
+        "&lt;b&gt;Tom &amp; &quot;Jerry&quot;&lt;/b&gt;");
+    expect_render(&parser, "{{&name}}", (mustache_param*)&param_name, 4096,
+        "<b>Tom & \"Jerry\"</b>");
+
+    /* a replacement that does not fit is dropped whole */
+    expect_render(&parser, "{{name}}", (mustache_param*)&param_name, 12, "&lt;b&gt;Tom");
+
+    /* the cached escaped form is built once and reused */
+    mustache_param_string param_cached = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"cached",strlen("cached")},
+        .str = {"abcde&x",strlen("abcde&x")},
+        .cacheEscaped = true
+    };
+
+    expect_render(&parser, "{{cached}}", (mustache_param*)&param_cached, 4096, "abcde&amp;x");
+    if (param_cached.escapeState != MUSTACHE_ESCAPE_DIRTY || param_cached.escaped.len != strlen("abcde&amp;x")) {
+        fprintf(stderr, "FAILED: the escaped form of a dirty string was not cached\n");
+        failures++;
+    }
+    expect_render(&parser, "{{cached}}", (mustache_param*)&param_cached, 4096, "abcde&amp;x");
+
+    /* a cached form that does not fit is not cut inside an entity */
+    expect_render(&parser, "{{cached}}", (mustache_param*)&param_cached, 8, "abcde");
+    mustache_param_string_release(&parser, &param_cached);
+
+    /* the same holds for a string that still holds JSON escapes, as it is escaped and once cached */
+    mustache_param_string param_json = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"json",strlen("json")},
+        .str = {"\\\"a\\\"&b",strlen("\\\"a\\\"&b")},
+        .encoding = MUSTACHE_ENCODING_JSON,
+        .cacheEscaped = true
+    };
+
+    expect_render(&parser, "{{json}}", (mustache_param*)&param_json, 8, "&quot;a");
+    expect_render(&parser, "{{json}}", (mustache_param*)&param_json, 4096, "&quot;a&quot;&amp;b");
+    expect_render(&parser, "{{json}}", (mustache_param*)&param_json, 8, "&quot;a");
+    expect_render(&parser, "{{&json}}", (mustache_param*)&param_json, 4096, "\"a\"&b");
+    mustache_param_string_release(&parser, &param_json);
+
+    mustache_param_string param_clean = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"clean",strlen("clean")},
+        .str = {"nothing to escape",strlen("nothing to escape")},
+        .cacheEscaped = true
+    };
+
+    expect_render(&parser, "{{clean}}", (mustache_param*)&param_clean, 4096, "nothing to escape");
+    if (param_clean.escapeState != MUSTACHE_ESCAPE_CLEAN || param_clean.escaped.u) {
+        fprintf(stderr, "FAILED: a clean string was given an escaped form\n");
+        failures++;
+    }
+
+    /* escape modes per variable and as the default of the template */
+    mustache_param_string param_text = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"text",strlen("text")},
+        .str = {"a \"b\", <c>\n'd' & e/f",strlen("a \"b\", <c>\n'd' & e/f")}
+    };
+
+    expect_render(&parser, "{{%html text}}", (mustache_param*)&param_text, 4096, "a &quot;b&quot;, &lt;c&gt;\n&#039;d&#039; &amp; e/f");
+    expect_render(&parser, "{{%url text}}", (mustache_param*)&param_text, 4096, "a%20%22b%22%2C%20%3Cc%3E%0A%27d%27%20%26%20e%2Ff");
+    expect_render(&parser, "{{%js text}}", (mustache_param*)&param_text, 4096, "a \\\"b\\\", \\u003Cc\\u003E\\n\\'d\\' \\u0026 e/f");
+    expect_render(&parser, "{{%json text}}", (mustache_param*)&param_text, 4096, "a \\\"b\\\", <c>\\n'd' & e/f");
+    expect_render(&parser, "{{%csv text}}", (mustache_param*)&param_text, 4096, "\"a \"\"b\"\", <c>\n'd' & e/f\"");
+    expect_render(&parser, "{{%raw text}}", (mustache_param*)&param_text, 4096, "a \"b\", <c>\n'd' & e/f");
+    expect_render(&parser, "{{%url}}{{text}}|{{%html text}}", (mustache_param*)&param_text, 4096,
+        "a%20%22b%22%2C%20%3Cc%3E%0A%27d%27%20%26%20e%2Ff|a &quot;b&quot;, &lt;c&gt;\n&#039;d&#039; &amp; e/f");
+
+    /* a quoted CSV field is only written if both of its quotes fit */
+    expect_render(&parser, "{{%csv text}}", (mustache_param*)&param_text, 1, "");
+
+    /* U+2028 and U+2029 end a line inside a JS string literal, other characters with their lead byte do not */
+    mustache_param_string param_separators = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"sep",strlen("sep")},
+        .str = {"a\xE2\x80\xA8" "b\xE2\x80\xA9" "c\xE2\x82\xAC",strlen("a\xE2\x80\xA8" "b\xE2\x80\xA9" "c\xE2\x82\xAC")}
+    };
+
+    expect_render(&parser, "{{%js sep}}", (mustache_param*)&param_separators, 4096, "a\\u2028b\\u2029c\xE2\x82\xAC");
+    expect_render(&parser, "{{%js sep}}", (mustache_param*)&param_separators, 9, "a\\u2028b");
+    expect_render(&parser, "{{%json sep}}", (mustache_param*)&param_separators, 4096, "a\xE2\x80\xA8" "b\xE2\x80\xA9" "c\xE2\x82\xAC");
+
+    /* long enough for the vector kernels */
+    const char* longSeparators = "0123456789012345678901234567890123456789\xE2\x80\xA8" "0123456789012345678901234567890123456789";
+    param_separators.str = (mustache_slice){ (uint8_t*)longSeparators, strlen(longSeparators) };
+    expect_render(&parser, "{{%js sep}}", (mustache_param*)&param_separators, 4096,
+        "0123456789012345678901234567890123456789\\u20280123456789012345678901234567890123456789");
+
+    /* HTML escapes through the 32 byte AVX2 blocks, the 16 byte SSE2 blocks after them and the bytes
+       left over, with an escapable byte at every position. The filler holds the neighbours of every
+       escapable byte and bytes above 0x7F, which a signed compare would take for escapable */
+    const char* filler = "%!#(;=?\xA6\xBC" "a";
+    const char* escapable = "&<>\"'";
+    const size_t longLens[] = { 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65, 95, 96, 97, 130 };
+    uint8_t longText[1 + 130];
+    char longExpected[130 * 6 + 1];
+    mustache_param_string param_long = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_STRING,
+        .name = {"text",strlen("text")}
+    };
+    for (size_t l = 0; l < sizeof(longLens) / sizeof(longLens[0]); l++) {
+        /* odd addresses, the kernels load unaligned */
+        uint8_t* text = longText + 1;
+        for (size_t e = 0; e < strlen(escapable); e++) {
+            for (size_t pos = 0; pos < longLens[l]; pos++) {
+                for (size_t i = 0; i < longLens[l]; i++) {
+                    text[i] = filler[i % strlen(filler)];
+                }
+                text[pos] = escapable[e];
+                html_reference(text, longLens[l], longExpected);
+                param_long.str = (mustache_slice){ text, longLens[l] };
+                param_long.cacheEscaped = false;
+                expect_render(&parser, "{{text}}", (mustache_param*)&param_long, 4096, longExpected);
+                param_long.cacheEscaped = true;
+                expect_render(&parser, "{{text}}", (mustache_param*)&param_long, 4096, longExpected);
+                mustache_param_string_release(&parser, &param_long);
+            }
+        }
+        /* and none at all */
+        for (size_t i = 0; i < longLens[l]; i++) {
+            text[i] = filler[i % strlen(filler)];
+        }
+        html_reference(text, longLens[l], longExpected);
+        param_long.str = (mustache_slice){ text, longLens[l] };
+        param_long.cacheEscaped = false;
+        expect_render(&parser, "{{text}}", (mustache_param*)&param_long, 4096, longExpected);
+        mustache_param_string_release(&parser, &param_long);
+    }
+
+    /* a mode must be known and only prefixes variables */
+    expect_compile_error(&parser, "{{%foo text}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+    expect_compile_error(&parser, "{{%js #text}}{{/text}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+    expect_compile_error(&parser, "{{%js ^text}}{{/text}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+    expect_compile_error(&parser, "{{%js len(text)}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+    expect_compile_error(&parser, "{{%js &text}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+    expect_compile_error(&parser, "{{%js >text}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+    expect_compile_error(&parser, "{{%js !text}}", MUSTACHE_ERR_INVALID_TEMPLATE);
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+/* mkdtemp and nanosleep are hidden under -std=c99 */
+#define _GNU_SOURCE
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    free(b);
+}
+
+typedef struct
+{
+    uint8_t parsed[4096];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed, parsed.u, parsed.len);
+    output->len = parsed.len;
+    return;
+}
+
+static int failures = 0;
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_HOT_RELOAD)
+
+/* replaces the file at path with source, in place or by renaming a new file over it */
+static bool write_template(const char* path, const char* source, bool rename_over)
+{
+    char tmpPath[256];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* file = fopen(rename_over ? tmpPath : path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = fwrite(source, 1, strlen(source), file) == strlen(source);
+    written = !fclose(file) && written;
+    return written && (!rename_over || !rename(tmpPath, path));
+}
+
+static uint8_t hot_render(mustache_parser* parser, mustache_hot_template* hot, mustache_param* params, render_output* output)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[4096];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    output->len = 0;
+    return mustache_hot_render(parser,
+        (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+        hot, params,
+        (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+        output, parse_callback);
+}
+
+/* renders hot until it gives expected, the watcher recompiles on its own thread. With waitAll the
+   whole time is waited and the output must stay expected throughout */
+static void expect_hot(mustache_parser* parser, mustache_hot_template* hot, mustache_param* params, const char* what,
+    const char* expected, bool waitAll)
+{
+    const struct timespec tick = { 0, 10 * 1000 * 1000 };
+    render_output output;
+    uint8_t err = MUSTACHE_SUCCESS;
+    bool same = false;
+    for (int i = 0; i < 300; i++)
+    {
+        err = hot_render(parser, hot, params, &output);
+        same = !err && output.len == strlen(expected) && !memcmp(output.parsed, expected, output.len);
+        if (same != waitAll || (waitAll && i == 30)) {
+            break;
+        }
+        nanosleep(&tick, NULL);
+    }
+    if (!same) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got      \"%.*s\" (err %d)\n", what, expected, (int)output.len, output.parsed, err);
+        failures++;
+    }
+}
+
+/* renders hot with a params chain parsed from JSON for this render alone, freed right after it */
+static void expect_hot_JSON(mustache_parser* parser, mustache_hot_template* hot, const char* JSON, const char* what,
+    const char* expected)
+{
+    mustache_param* root = NULL;
+    if (mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &root, 0, NULL)) {
+        fprintf(stderr, "FAILED: %s, the params did not parse\n", what);
+        failures++;
+        return;
+    }
+    expect_hot(parser, hot, ((mustache_param_object*)root)->pMembers, what, expected, false);
+    mustache_free_param_list(parser, root, 0);
+}
+
+#endif
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_HOT_RELOAD)
+    const char* JSON = "{ \"name\": \"<b>\", \"users\": [ { \"name\": \"a\" }, { \"name\": \"b\" } ] }";
+    mustache_param* jsonRoot = NULL;
+    if (mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, 0, NULL)) {
+        fprintf(stderr, "FAILED: the test params did not parse\n");
+        return -1;
+    }
+    mustache_param* params = ((mustache_param_object*)jsonRoot)->pMembers;
+
+    char dir[] = "/tmp/not_mustache_hot_XXXXXX";
+    char path[256];
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "FAILED: no temporary directory\n");
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/page.html", dir);
+
+    mustache_hot_watcher watcher = { 0 };
+    mustache_hot_template hot = { 0 };
+    uint8_t err = write_template(path, "v1 {{name}}", false) ? mustache_hot_watcher_start(&parser, &watcher) : MUSTACHE_ERR_FILE_OPEN;
+    if (!err) {
+        err = mustache_hot_template_open(&parser, &watcher, (mustache_const_slice){ (const uint8_t*)path, strlen(path) }, &hot);
+        if (err) {
+            mustache_hot_watcher_stop(&parser, &watcher);
+        }
+    }
+    if (err) {
+        fprintf(stderr, "FAILED: opening %s (err %d)\n", path, err);
+        failures++;
+    }
+    else {
+        expect_hot(&parser, &hot, params, "the first version", "v1 &lt;b&gt;", false);
+
+        /* an editor that saves by renaming a new file over the old one */
+        write_template(path, "v2 {{#users}}{{name}};{{/users}}", true);
+        expect_hot(&parser, &hot, params, "a file renamed over the template", "v2 a;b;", false);
+
+        /* a change that does not compile leaves the last good version */
+        write_template(path, "v3 {{#users}}{{name}}", true);
+        expect_hot(&parser, &hot, params, "a template that does not compile", "v2 a;b;", true);
+
+        /* a template rewritten in place */
+        write_template(path, "v4 {{&name}}", false);
+        expect_hot(&parser, &hot, params, "a template rewritten in place", "v4 <b>", false);
+
+        /* every render resolves its params from the chain it is given, the last one is already freed */
+        expect_hot_JSON(&parser, &hot, "{ \"name\": \"first\" }", "a params chain of one render", "v4 first");
+        expect_hot_JSON(&parser, &hot, "{ \"other\": 1, \"name\": \"second\" }", "a params chain of the next render", "v4 second");
+
+        mustache_hot_template_close(&parser, &watcher, &hot);
+        mustache_hot_watcher_stop(&parser, &watcher);
+    }
+
+    unlink(path);
+    rmdir(dir);
+    mustache_free_param_list(&parser, jsonRoot, 0);
+#endif
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}
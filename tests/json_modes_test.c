@@ -0,0 +1,479 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static size_t allocations = 0;
+static size_t liveAllocations = 0;
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    allocations++;
+    liveAllocations++;
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    if (b) {
+        liveAllocations--;
+    }
+    free(b);
+}
+
+typedef struct
+{
+    uint8_t parsed[4096];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed, parsed.u, parsed.len);
+    output->len = parsed.len;
+    return;
+}
+
+static int failures = 0;
+
+/* renders template with params and compares the output to expected */
+static void expect_render(mustache_parser* parser, const char* template, mustache_param* params, const char* expected)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[4096];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output output = { .len = 0 };
+
+    mustache_structure struct_chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &struct_chain);
+    if (!err) {
+        err = mustache_render(parser,
+            (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+            &struct_chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+            &output, parse_callback);
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+
+    if (err || output.len != strlen(expected) || memcmp(output.parsed, expected, output.len)) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got      \"%.*s\" (err %d)\n", template, expected, (int)output.len, output.parsed, err);
+        failures++;
+    }
+}
+
+/* renders template with params and expects the render to fail with expectedErr */
+static void expect_render_err(mustache_parser* parser, const char* template, mustache_param* params, uint8_t expectedErr)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[4096];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output output = { .len = 0 };
+
+    mustache_structure struct_chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &struct_chain);
+    if (!err) {
+        err = mustache_render(parser,
+            (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+            &struct_chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+            &output, parse_callback);
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+
+    if (err != expectedErr) {
+        fprintf(stderr, "FAILED: %s\n    expected err %d\n    got err %d\n", template, expectedErr, err);
+        failures++;
+    }
+}
+
+/* parses JSON with flags, projected onto the paths of projection, and renders template against the root
+   param, or against the root's members if fromMembers is set */
+static void expect_projected(mustache_parser* parser, const char* JSON, uint32_t flags, const char* projection, bool fromMembers,
+    const char* template, const char* expected)
+{
+    mustache_structure projection_chain = { 0 };
+    mustache_path_set paths = { 0 };
+    uint8_t err = mustache_path_set_add_template(parser, &paths, &projection_chain,
+        (mustache_const_slice){ (const uint8_t*)projection, strlen(projection) }, NULL);
+
+    mustache_param* jsonRoot = NULL;
+    if (!err) {
+        err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, flags, &paths);
+    }
+    if (err) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got err %d\n", projection, expected, err);
+        failures++;
+    }
+    else {
+        expect_render(parser, template, fromMembers ? ((mustache_param_object*)jsonRoot)->pMembers : jsonRoot, expected);
+        mustache_free_param_list(parser, jsonRoot, flags);
+    }
+    mustache_structure_chain_free(parser, &projection_chain);
+    mustache_path_set_free(parser, &paths);
+}
+
+
+/* parses JSON with flags and renders template against the root's members */
+static void expect_json(mustache_parser* parser, const char* JSON, uint32_t flags, const char* template, const char* expected)
+{
+    mustache_param* jsonRoot = NULL;
+    uint8_t err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, flags, NULL);
+    if (err || !jsonRoot) {
+        fprintf(stderr, "FAILED: %.64s (flags %u)\n    expected \"%s\"\n    got err %d\n", JSON, flags, expected, err);
+        failures++;
+        return;
+    }
+    expect_render(parser, template, ((mustache_param_object*)jsonRoot)->pMembers, expected);
+    mustache_free_param_list(parser, jsonRoot, flags);
+}
+
+/* expects JSON to be rejected as invalid under flags */
+static void expect_invalid_json(mustache_parser* parser, const char* JSON, uint32_t flags)
+{
+    mustache_param* jsonRoot = NULL;
+    uint8_t err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, flags, NULL);
+    if (err != MUSTACHE_ERR_INVALID_JSON) {
+        fprintf(stderr, "FAILED: %s (flags %u)\n    expected MUSTACHE_ERR_INVALID_JSON\n    got err %d\n", JSON, flags, err);
+        failures++;
+    }
+    if (!err) {
+        mustache_free_param_list(parser, jsonRoot, flags);
+    }
+}
+
+/* wraps depth levels of open, then close, around inner in {"a": ...} */
+static char* nested_JSON(const char* open, const char* inner, const char* close, size_t depth)
+{
+    size_t openLen = strlen(open), innerLen = strlen(inner), closeLen = strlen(close);
+    char* JSON = malloc(strlen("{\"a\": }") + depth * (openLen + closeLen) + innerLen + 1);
+    char* head = JSON;
+    memcpy(head, "{\"a\": ", strlen("{\"a\": "));
+    head += strlen("{\"a\": ");
+    for (size_t i = 0; i < depth; i++, head += openLen) {
+        memcpy(head, open, openLen);
+    }
+    memcpy(head, inner, innerLen);
+    head += innerLen;
+    for (size_t i = 0; i < depth; i++, head += closeLen) {
+        memcpy(head, close, closeLen);
+    }
+    memcpy(head, "}", 2);
+    return JSON;
+}
+
+
+/* builds {"pad": "<padLen bytes of pad>", ...} so the strings and escapes after the pad move across
+   the 64 byte blocks and the batches of the structural index */
+static char* padded_JSON(const char* pad, size_t padLen)
+{
+    const char* head = "{\"pad\": \"";
+    const char* tail = "\", \"s\": \"\\\"\\\\{}[],:\\\\\\\\\\\\\\\"x\", \"k\\\"ey\": \"\\\\\", \"t\": 1}";
+    size_t headLen = strlen(head), tailLen = strlen(tail), patternLen = strlen(pad);
+    char* JSON = malloc(headLen + padLen + tailLen + 1);
+    memcpy(JSON, head, headLen);
+    for (size_t i = 0; i < padLen; i++) {
+        JSON[headLen + i] = pad[i % patternLen];
+    }
+    memcpy(JSON + headLen + padLen, tail, tailLen + 1);
+    return JSON;
+}
+
+
+/* parses JSON into an arena in at most maxAllocations allocations, renders template against the root's
+   members and checks that freeing the tree releases every allocation */
+static void expect_arena(mustache_parser* parser, const char* JSON, uint32_t flags, size_t maxAllocations,
+    const char* template, const char* expected)
+{
+    size_t liveBefore = liveAllocations;
+    allocations = 0;
+    mustache_param* jsonRoot = NULL;
+    uint8_t err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot,
+        flags | MUSTACHE_JSON_ARENA, NULL);
+    if (err || !jsonRoot || allocations > maxAllocations) {
+        fprintf(stderr, "FAILED: arena %.64s (flags %u)\n    expected at most %zu allocations\n    got %zu (err %d)\n",
+            JSON, flags, maxAllocations, allocations, err);
+        failures++;
+    }
+    if (err || !jsonRoot) {
+        return;
+    }
+    expect_render(parser, template, ((mustache_param_object*)jsonRoot)->pMembers, expected);
+    mustache_free_param_list(parser, jsonRoot, flags | MUSTACHE_JSON_ARENA);
+    if (liveAllocations != liveBefore) {
+        fprintf(stderr, "FAILED: arena %.64s (flags %u)\n    leaked %zu allocations\n", JSON, flags, liveAllocations - liveBefore);
+        failures++;
+    }
+}
+
+/* builds {"values": [0, ..., count-1], "text": "<textLen bytes of <>>"} */
+static char* wide_JSON(size_t count, size_t textLen)
+{
+    char* JSON = malloc(64 + count * 12 + textLen);
+    char* head = JSON + sprintf(JSON, "{\"values\": [");
+    for (size_t i = 0; i < count; i++) {
+        head += sprintf(head, i ? ", %zu" : "%zu", i);
+    }
+    head += sprintf(head, "], \"text\": \"");
+    memset(head, '<', textLen);
+    sprintf(head + textLen, "\"}");
+    return JSON;
+}
+
+
+typedef struct
+{
+    const uint8_t* source;
+    size_t len;
+    size_t read;
+    size_t maxRead;
+} memory_stream;
+
+static size_t memory_read(void* udata, uint8_t* dst, size_t dstlen)
+{
+    memory_stream* stream = udata;
+    size_t len = stream->len - stream->read < dstlen ? stream->len - stream->read : dstlen;
+    len = len < stream->maxRead ? len : stream->maxRead;
+    memcpy(dst, stream->source + stream->read, len);
+    stream->read += len;
+    return len;
+}
+
+/* streams JSON through a chunkLen buffer, no buffer if chunkLen is 0, in reads of at most maxRead
+   bytes and renders template against the root's members. Returns the parse error */
+static uint8_t expect_streamed_json(mustache_parser* parser, const char* JSON, size_t chunkLen, size_t maxRead, uint32_t flags,
+    const char* template, const char* expected)
+{
+    size_t liveBefore = liveAllocations;
+    uint8_t* chunk = chunkLen ? malloc(chunkLen) : NULL;
+    memory_stream memory = { (const uint8_t*)JSON, strlen(JSON), 0, maxRead };
+    mustache_stream stream = { &memory, memory_read, NULL };
+    mustache_param* jsonRoot = NULL;
+    uint8_t err = mustache_JSON_to_param_chain_from_stream(parser, &stream, (mustache_slice){ chunk, chunkLen }, &jsonRoot, flags, NULL);
+    free(chunk);
+    if (!err && jsonRoot) {
+        expect_render(parser, template, ((mustache_param_object*)jsonRoot)->pMembers, expected);
+        mustache_free_param_list(parser, jsonRoot, flags);
+    }
+    else if (expected) {
+        fprintf(stderr, "FAILED: stream %.64s (chunk %zu, reads %zu)\n    expected \"%s\"\n    got err %d\n", JSON, chunkLen, maxRead, expected, err);
+        failures++;
+    }
+    if (liveAllocations != liveBefore) {
+        fprintf(stderr, "FAILED: stream %.64s (chunk %zu, reads %zu)\n    leaked %zu allocations\n", JSON, chunkLen, maxRead, liveAllocations - liveBefore);
+        failures++;
+    }
+    return err;
+}
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+    const char* users = "{ \"title\": \"T\", \"users\": [ { \"name\": \"a\", \"age\": 1 }, { \"name\": \"b\", \"age\": 2 } ], \"skip\": { \"deep\": 1 } }";
+    const char* everything = "{{title}}{{#users}}{{name}}{{age}}{{/users}}{{skip.deep}}";
+    const char* everythingFromRoot = "{{root.title}}{{#root.users}}{{name}}{{age}}{{/root.users}}{{root.skip.deep}}";
+
+    /* a template rendered from the root's members projects the tree by its global names */
+    expect_projected(&parser, users, 0, "{{title}}{{#users}}{{name}}{{/users}}", true, everything, "Tab");
+    expect_projected(&parser, users, MUSTACHE_JSON_ARENA, "{{title}}{{#users}}{{name}}{{/users}}", true, everything, "Tab");
+    expect_projected(&parser, users, MUSTACHE_JSON_LAZY, "{{title}}{{#users}}{{name}}{{/users}}", true, everything, "Tab");
+
+    /* a template rendered from the root param reaches the same members through 'root' */
+    expect_projected(&parser, users, 0, "{{root.title}}{{#root.users}}{{name}}{{/root.users}}", false, everythingFromRoot, "Tab");
+    expect_projected(&parser, users, MUSTACHE_JSON_DEEP_COPY, "{{#root}}{{title}}{{skip.deep}}{{/root}}", false,
+        "{{root.title}}{{#root}}{{users[0].name}}{{/root}}{{root.skip.deep}}", "T1");
+
+    /* a whole section keeps everything below it, a template that names nothing keeps nothing */
+    expect_projected(&parser, users, 0, "{{#users}}{{.}}{{/users}}", true, everything, "a1b2");
+    expect_projected(&parser, users, 0, "no names", true, "{{title}}{{users[0].name}}{{skip.deep}}", "");
+
+    /* every value type parses the same whichever tree is built */
+    const uint32_t treeFlags[] = { 0, MUSTACHE_JSON_DEEP_COPY, MUSTACHE_JSON_ARENA, MUSTACHE_JSON_LAZY };
+    for (size_t i = 0; i < sizeof(treeFlags) / sizeof(treeFlags[0]); i++) {
+        expect_json(&parser, "{\"n\": -1.5e2, \"i\": 42, \"t\": true, \"f\": false, \"s\": \"str\", \"o\": {\"k\": \"v\"}}", treeFlags[i],
+            "{{n}} {{i}} {{t}} {{f}} {{s}} {{#o}}{{k}}{{/o}}", "-150 42 true false str v");
+        expect_json(&parser, "{ \"a\": { \"b\": { \"c\": [ 1, [ 2, [ 3 ] ] ] } } }", treeFlags[i], "{{#a}}{{#b}}{{len(c)}}{{/b}}{{/a}}", "2");
+        expect_json(&parser, "{\"a\":[1,2,3],\"b\":{}}", treeFlags[i], "{{len(a)}}{{#a}}{{.}}{{/a}}", "3123");
+    }
+
+    /* nesting depth is bounded by memory, not by the call stack */
+    char* deepLists = nested_JSON("[", "7", "]", 100000);
+    char* deepObjects = nested_JSON("{\"a\": ", "7", "}", 50000);
+    const uint32_t deepFlags[] = { 0, MUSTACHE_JSON_DEEP_COPY, MUSTACHE_JSON_ARENA | MUSTACHE_JSON_CACHE_ESCAPED, MUSTACHE_JSON_LAZY };
+    for (size_t i = 0; i < sizeof(deepFlags) / sizeof(deepFlags[0]); i++) {
+        expect_json(&parser, deepLists, deepFlags[i], "{{len(a)}}", "1");
+        expect_json(&parser, deepObjects, deepFlags[i], "{{#a}}{{#a}}{{len(a)}}{{/a}}{{/a}}", "1");
+    }
+    free(deepLists);
+    free(deepObjects);
+
+    /* malformed documents are rejected in every mode */
+    const char* invalid[] = { "{\"a\": [1, 2}", "{\"a\" 1}", "{\"a\": \"x}", "{\"a\": 1,}", "{\"a\": tru}", "{\"a\": 1" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        expect_invalid_json(&parser, invalid[i], 0);
+        expect_invalid_json(&parser, invalid[i], MUSTACHE_JSON_ARENA);
+        expect_invalid_json(&parser, invalid[i], MUSTACHE_JSON_LAZY);
+    }
+    expect_invalid_json(&parser, "{\"a\": [1 2]}", 0);
+
+    /* quotes, escapes and structural characters inside strings at every offset of a block and a batch */
+    const char* pads[] = { "x", "\\\\", "{[\\\",:]}" };
+    for (size_t p = 0; p < sizeof(pads) / sizeof(pads[0]); p++) {
+        for (size_t padLen = 0; padLen < 4300; padLen += padLen < 200 || padLen > 3950 ? 1 : 61) {
+            if (padLen % strlen(pads[p])) {
+                continue;
+            }
+            char* JSON = padded_JSON(pads[p], padLen);
+            expect_json(&parser, JSON, 0, "{{&s}}|{{t}}", "\"\\{}[],:\\\\\\\"x|1");
+            expect_json(&parser, JSON, MUSTACHE_JSON_LAZY, "{{&s}}|{{t}}", "\"\\{}[],:\\\\\\\"x|1");
+            free(JSON);
+        }
+    }
+
+    /* an arena holds a wide tree in a handful of blocks, with or without copies, and frees all of them */
+    char* wide = wide_JSON(5000, 10000);
+    const uint32_t arenaFlags[] = { 0, MUSTACHE_JSON_DEEP_COPY, MUSTACHE_JSON_CACHE_ESCAPED, MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_CACHE_ESCAPED };
+    for (size_t i = 0; i < sizeof(arenaFlags) / sizeof(arenaFlags[0]); i++) {
+        expect_arena(&parser, wide, arenaFlags[i], 16, "{{len(values)}} {{values[4999]}} {{#text}}text{{/text}}", "5000 4999 text");
+        expect_arena(&parser, "{\"s\": \"<a\\u00e9>\", \"o\": {\"l\": [{}, [], \"x\"]}}", arenaFlags[i], 4,
+            "{{s}}{{s}}{{&s}}{{#o}}{{len(l)}}{{/o}}", "&lt;a\xc3\xa9&gt;&lt;a\xc3\xa9&gt;<a\xc3\xa9>3");
+    }
+    free(wide);
+
+    /* a document rejected part way releases the blocks it had filled */
+    size_t liveBefore = liveAllocations;
+    expect_invalid_json(&parser, "{\"a\": [1, 2, {\"b\": \"c\"}, [3, 4}", MUSTACHE_JSON_ARENA);
+    expect_invalid_json(&parser, "{\"a\": [1, 2, {\"b\": \"c\"}, [3, 4}", MUSTACHE_JSON_ARENA | MUSTACHE_JSON_DEEP_COPY);
+    if (liveAllocations != liveBefore) {
+        fprintf(stderr, "FAILED: invalid JSON in an arena leaked %zu allocations\n", liveAllocations - liveBefore);
+        failures++;
+    }
+
+    /* escapes are decoded when the string is written, the same in every mode, and twice over a cached escape */
+    const char* escapes = "{\"s\": \"a\\nb\\t\\\"\\\\\\/\\u0041\\u00e9\\u20AC\\ud83d\\ude00<&>\", \"l\": \"\\ud800x\\udc00\"}";
+    const uint32_t escapeFlags[] = { 0, MUSTACHE_JSON_DEEP_COPY, MUSTACHE_JSON_CACHE_ESCAPED, MUSTACHE_JSON_ARENA | MUSTACHE_JSON_CACHE_ESCAPED, MUSTACHE_JSON_LAZY };
+    for (size_t i = 0; i < sizeof(escapeFlags) / sizeof(escapeFlags[0]); i++) {
+        expect_json(&parser, escapes, escapeFlags[i], "{{s}}|{{&s}}|{{&l}}|{{s}}",
+            "a\nb\t&quot;\\/A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80&lt;&amp;&gt;|a\nb\t\"\\/A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80<&>|"
+            "\xef\xbf\xbdx\xef\xbf\xbd|a\nb\t&quot;\\/A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80&lt;&amp;&gt;");
+        expect_json(&parser, "{\"s\": \"\\u003c\\u0026\\u003E\"}", escapeFlags[i], "{{s}}{{&s}}", "&lt;&amp;&gt;<&>");
+    }
+
+    /* a lazy tree parses a container only when a template reaches into it, and a deep copy lets the
+       source go before the tree is rendered */
+    char* lazySource = wide_JSON(5000, 100);
+    size_t lazyLen = strlen(lazySource);
+    char* lazyJSON = malloc(lazyLen + 64);
+    sprintf(lazyJSON, "{\"wide\": %.*s, \"o\": {\"l\": [\"x\", {\"y\": \"z\"}]}}", (int)lazyLen, lazySource);
+    free(lazySource);
+    mustache_param* lazyRoot = NULL;
+    allocations = 0;
+    uint8_t lazyErr = mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)lazyJSON, strlen(lazyJSON) }, &lazyRoot,
+        MUSTACHE_JSON_LAZY | MUSTACHE_JSON_DEEP_COPY, NULL);
+    memset(lazyJSON, ' ', strlen(lazyJSON));
+    free(lazyJSON);
+    if (lazyErr || !lazyRoot || allocations > 8) {
+        fprintf(stderr, "FAILED: lazy parse\n    expected at most 8 allocations\n    got %zu (err %d)\n", allocations, lazyErr);
+        failures++;
+    }
+    else {
+        mustache_param* lazyMembers = ((mustache_param_object*)lazyRoot)->pMembers;
+        expect_render(&parser, "{{#o}}{{l[0]}}{{#l}}{{y}}{{/l}}{{/o}}", lazyMembers, "xz");
+        expect_render(&parser, "{{#o.l}}{{y}}{{/o.l}}{{#wide}}{{len(values)}}{{/wide}}", lazyMembers, "z5000");
+        expect_render(&parser, "{{#o}}{{#l}}{{y}}{{/l}}{{/o}}{{#wide}}{{values[4999]}}{{/wide}}", lazyMembers, "z4999");
+        mustache_free_param_list(&parser, lazyRoot, MUSTACHE_JSON_LAZY | MUSTACHE_JSON_DEEP_COPY);
+    }
+
+    /* a lazy subtree is only checked for its brackets, one that turns out to be malformed fails every render
+       that reaches it, however it is reached, and leaves the rest of the document usable */
+    const char* brokenJSON = "{ \"t\": 1, \"o\": { \"l\": [1 2] }, \"l\": [{ \"x\": 1 }, { \"x\" 2 }], \"s\": [[1, 2], [3 4]] }";
+    const uint32_t brokenFlags[] = { MUSTACHE_JSON_LAZY, MUSTACHE_JSON_LAZY | MUSTACHE_JSON_DEEP_COPY, MUSTACHE_JSON_LAZY | MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_ARENA };
+    for (size_t i = 0; i < sizeof(brokenFlags) / sizeof(brokenFlags[0]); i++) {
+        mustache_param* brokenRoot = NULL;
+        if (mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)brokenJSON, strlen(brokenJSON) }, &brokenRoot, brokenFlags[i], NULL)) {
+            fprintf(stderr, "FAILED: lazy parse of a malformed subtree\n");
+            failures++;
+            continue;
+        }
+        mustache_param* brokenMembers = ((mustache_param_object*)brokenRoot)->pMembers;
+        for (int pass = 0; pass < 2; pass++) {
+            expect_render_err(&parser, "{{t}}{{#o}}{{#l}}{{.}}{{/l}}{{/o}}", brokenMembers, MUSTACHE_ERR_INVALID_JSON);
+            expect_render_err(&parser, "{{o.l}}", brokenMembers, MUSTACHE_ERR_INVALID_JSON);
+            expect_render_err(&parser, "{{#l}}{{x}};{{/l}}", brokenMembers, MUSTACHE_ERR_INVALID_JSON);
+            expect_render_err(&parser, "{{#s}}{{len(.)}}{{/s}}", brokenMembers, MUSTACHE_ERR_INVALID_JSON);
+            expect_render(&parser, "{{t}}{{len(l)}}{{len(s)}}", brokenMembers, "122");
+        }
+        mustache_free_param_list(&parser, brokenRoot, brokenFlags[i]);
+    }
+
+    /* a streamed document parses the same through any chunk, however the stream splits its reads */
+    char* streamed = wide_JSON(2000, 100);
+    const size_t chunkLens[] = { 0, 1, 7, 64, 4096, 1 << 20 };
+    const size_t maxReads[] = { 1, 3, SIZE_MAX };
+    for (size_t c = 0; c < sizeof(chunkLens) / sizeof(chunkLens[0]); c++) {
+        for (size_t r = 0; r < sizeof(maxReads) / sizeof(maxReads[0]); r++) {
+            expect_streamed_json(&parser, streamed, chunkLens[c], maxReads[r], MUSTACHE_JSON_DEEP_COPY,
+                "{{len(values)}} {{values[1999]}} {{#text}}text{{/text}}", "2000 1999 text");
+            expect_streamed_json(&parser, streamed, chunkLens[c], maxReads[r], MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_ARENA,
+                "{{values[0]}} {{values[1000]}}", "0 1000");
+            expect_streamed_json(&parser, escapes, chunkLens[c], maxReads[r], MUSTACHE_JSON_DEEP_COPY, "{{&s}}|{{&l}}",
+                "a\nb\t\"\\/A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80<&>|\xef\xbf\xbdx\xef\xbf\xbd");
+        }
+    }
+    free(streamed);
+    for (size_t padLen = 0; padLen < 140; padLen++) {
+        char* JSON = padded_JSON("\\\\", padLen * 2);
+        expect_streamed_json(&parser, JSON, 16, SIZE_MAX, MUSTACHE_JSON_DEEP_COPY, "{{&s}}|{{t}}", "\"\\{}[],:\\\\\\\"x|1");
+        free(JSON);
+    }
+
+    /* the chunk is reused, so the tree must copy and cannot be lazy or keep numerals, and a cut off document is invalid */
+    if (expect_streamed_json(&parser, "{\"a\": 1}", 64, SIZE_MAX, 0, "", NULL) != MUSTACHE_ERR_ARGS
+        || expect_streamed_json(&parser, "{\"a\": 1}", 64, SIZE_MAX, MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_LAZY, "", NULL) != MUSTACHE_ERR_ARGS
+        || expect_streamed_json(&parser, "{\"a\": 1.5}", 64, SIZE_MAX, MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_KEEP_NUMERALS, "", NULL) != MUSTACHE_ERR_ARGS
+        || expect_streamed_json(&parser, "{\"a\": [1, {\"b\": \"c", 4, SIZE_MAX, MUSTACHE_JSON_DEEP_COPY, "", NULL) != MUSTACHE_ERR_INVALID_JSON) {
+        fprintf(stderr, "FAILED: streams that cannot be parsed\n");
+        failures++;
+    }
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+/* mkdtemp is hidden under -std=c99 */
+#define _GNU_SOURCE
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    free(b);
+}
+
+typedef struct
+{
+    uint8_t parsed[4096];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed, parsed.u, parsed.len);
+    output->len = parsed.len;
+    return;
+}
+
+static int failures = 0;
+
+/* more files than the ring has entries, so reads are queued as others complete */
+#define FILE_COUNT 150
+
+static bool write_file(const char* path, const char* contents)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = fwrite(contents, 1, strlen(contents), file) == strlen(contents);
+    return !fclose(file) && written;
+}
+
+static void expect_render(mustache_parser* parser, mustache_structure* chain, mustache_param* params, const char* what, const char* expected)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[4096];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output output = { .len = 0 };
+    uint8_t err = mustache_render(parser,
+        (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+        chain, params,
+        (mustache_slice){ PARSER_OUTPUT_BUFFER,sizeof(PARSER_OUTPUT_BUFFER) },
+        &output, parse_callback);
+    if (err || output.len != strlen(expected) || memcmp(output.parsed, expected, output.len)) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got      \"%.*s\" (err %d)\n", what, expected, (int)output.len, output.parsed, err);
+        failures++;
+    }
+}
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+    char dir[] = "/tmp/not_mustache_load_XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "FAILED: no temporary directory\n");
+        return -1;
+    }
+
+    /* even files are templates and odd files the JSON each template before them renders with */
+    static char paths[FILE_COUNT + 1][256];
+    static mustache_structure chains[FILE_COUNT];
+    static mustache_param* roots[FILE_COUNT];
+    static mustache_load loads[FILE_COUNT + 1];
+    char contents[256];
+    for (int i = 0; i < FILE_COUNT; i++)
+    {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%d.%s", dir, i, i % 2 ? "json" : "html");
+        if (i % 2) {
+            snprintf(contents, sizeof(contents), "{ \"name\": \"n%d\", \"users\": [ { \"name\": \"a\" }, { \"name\": \"b%d\" } ] }", i, i);
+            loads[i].paramRoot = &roots[i];
+            loads[i].flags = i % 4 == 1 ? MUSTACHE_JSON_DEEP_COPY : MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_ARENA;
+        }
+        else {
+            snprintf(contents, sizeof(contents), "t%d {{name}} {{#users}}{{name}};{{/users}}\n", i);
+            loads[i].structChain = &chains[i];
+        }
+        loads[i].filename = (mustache_const_slice){ (const uint8_t*)paths[i], strlen(paths[i]) };
+        if (!write_file(paths[i], contents)) {
+            fprintf(stderr, "FAILED: writing %s\n", paths[i]);
+            return -1;
+        }
+    }
+
+    /* a file that is missing fails on its own, the rest of the batch still loads */
+    mustache_structure missingChain = { 0 };
+    snprintf(paths[FILE_COUNT], sizeof(paths[FILE_COUNT]), "%s/missing.html", dir);
+    loads[FILE_COUNT].filename = (mustache_const_slice){ (const uint8_t*)paths[FILE_COUNT], strlen(paths[FILE_COUNT]) };
+    loads[FILE_COUNT].structChain = &missingChain;
+
+    uint8_t err = mustache_load_files(&parser, loads, FILE_COUNT + 1);
+    if (err != MUSTACHE_ERR_FILE_OPEN || loads[FILE_COUNT].err != MUSTACHE_ERR_FILE_OPEN) {
+        fprintf(stderr, "FAILED: a missing file\n    expected err %d\n    got err %d, the file's err %d\n", MUSTACHE_ERR_FILE_OPEN, err, loads[FILE_COUNT].err);
+        failures++;
+    }
+    for (int i = 0; i < FILE_COUNT; i += 2)
+    {
+        if (loads[i].err || loads[i + 1].err) {
+            fprintf(stderr, "FAILED: loading %s and %s (err %d and %d)\n", paths[i], paths[i + 1], loads[i].err, loads[i + 1].err);
+            failures++;
+            continue;
+        }
+        char expected[64];
+        snprintf(expected, sizeof(expected), "t%d n%d a;b%d;\n", i, i + 1, i + 1);
+        expect_render(&parser, &chains[i], ((mustache_param_object*)roots[i + 1])->pMembers, paths[i], expected);
+    }
+    /* a batch of one is read without a ring */
+    mustache_structure single = { 0 };
+    mustache_load singleLoad = { .filename = loads[0].filename, .structChain = &single };
+    err = mustache_load_files(&parser, &singleLoad, 1);
+    if (err) {
+        fprintf(stderr, "FAILED: loading a single file (err %d)\n", err);
+        failures++;
+    }
+    else {
+        expect_render(&parser, &single, loads[1].err ? NULL : ((mustache_param_object*)roots[1])->pMembers, "a single file", "t0 n1 a;b1;\n");
+        mustache_structure_chain_free(&parser, &single);
+    }
+
+    for (int i = 0; i < FILE_COUNT; i++)
+    {
+        if (loads[i].err) {
+            continue;
+        }
+        if (i % 2) {
+            mustache_free_param_list(&parser, roots[i], loads[i].flags);
+        }
+        else {
+            mustache_structure_chain_free(&parser, &chains[i]);
+        }
+    }
+
+    /* a load names either a chain or a root, and a JSON root must copy out of the file, numerals included */
+    mustache_structure argsChain = { 0 };
+    mustache_param* argsRoot = NULL;
+    mustache_load badLoads[] = {
+        { .filename = loads[0].filename, .structChain = &argsChain, .paramRoot = &argsRoot, .flags = MUSTACHE_JSON_DEEP_COPY },
+        { .filename = loads[0].filename },
+        { .filename = loads[1].filename, .paramRoot = &argsRoot, .flags = 0 },
+        { .filename = loads[1].filename, .paramRoot = &argsRoot, .flags = MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_LAZY },
+        { .filename = loads[1].filename, .paramRoot = &argsRoot, .flags = MUSTACHE_JSON_DEEP_COPY | MUSTACHE_JSON_KEEP_NUMERALS },
+    };
+    err = mustache_load_files(&parser, badLoads, sizeof(badLoads) / sizeof(badLoads[0]));
+    for (size_t i = 0; i < sizeof(badLoads) / sizeof(badLoads[0]); i++) {
+        if (err != MUSTACHE_ERR_ARGS || badLoads[i].err != MUSTACHE_ERR_ARGS) {
+            fprintf(stderr, "FAILED: bad load %zu\n    expected err %d\n    got err %d\n", i, MUSTACHE_ERR_ARGS, badLoads[i].err);
+            failures++;
+        }
+    }
+
+    for (int i = 0; i < FILE_COUNT; i++) {
+        unlink(paths[i]);
+    }
+    rmdir(dir);
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    free(b);
+}
+
+typedef struct
+{
+    uint8_t parsed[4096];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed, parsed.u, parsed.len);
+    output->len = parsed.len;
+    return;
+}
+
+static int failures = 0;
+
+/* renders template with params into a parse buffer of outputLen bytes and compares the output to expected */
+static void expect_render(mustache_parser* parser, const char* template, mustache_param* params, size_t outputLen, const char* expected)
+{
+    uint8_t PARSER_OUTPUT_BUFFER[4096];
+    uint8_t PARENT_STACK_BUFFER[2048];
+    render_output output = { .len = 0 };
+
+    mustache_structure struct_chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &struct_chain);
+    if (!err) {
+        err = mustache_render(parser,
+            (mustache_slice){ PARENT_STACK_BUFFER,sizeof(PARENT_STACK_BUFFER) },
+            &struct_chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER,outputLen },
+            &output, parse_callback);
+    }
+    mustache_structure_chain_free(parser, &struct_chain);
+
+    if (err || output.len != strlen(expected) || memcmp(output.parsed, expected, output.len)) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got      \"%.*s\" (err %d)\n", template, expected, (int)output.len, output.parsed, err);
+        failures++;
+    }
+}
+
+/* parses JSON with flags and renders template against the members of its root */
+static void expect_json_render(mustache_parser* parser, const char* JSON, uint32_t flags, const char* template, const char* expected)
+{
+    mustache_param* jsonRoot = NULL;
+    uint8_t err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, flags, NULL);
+    if (err) {
+        fprintf(stderr, "FAILED: %s\n    expected \"%s\"\n    got err %d\n", JSON, expected, err);
+        failures++;
+        return;
+    }
+    expect_render(parser, template, ((mustache_param_object*)jsonRoot)->pMembers, 4096, expected);
+    mustache_free_param_list(parser, jsonRoot, flags);
+}
+
+/* parses JSON with flags and expects it to fail with err */
+static void expect_json_error(mustache_parser* parser, const char* JSON, uint32_t flags, uint8_t expectedErr)
+{
+    mustache_param* jsonRoot = NULL;
+    uint8_t err = mustache_JSON_to_param_chain(parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, flags, NULL);
+    if (err != expectedErr) {
+        fprintf(stderr, "FAILED: %s\n    expected err %d\n    got err      %d\n", JSON, expectedErr, err);
+        failures++;
+    }
+    if (!err) {
+        mustache_free_param_list(parser, jsonRoot, flags);
+    }
+}
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+    mustache_param_number param_number = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_NUMBER,
+        .name = {"n",strlen("n")},
+        .decimals = MUSTACHE_DECIMALS_SHORTEST
+    };
+    mustache_param* params = (mustache_param*)&param_number;
+
+    /* shortest round-trip */
+    param_number.value = 0.1;
+    expect_render(&parser, "{{n}}", params, 4096, "0.1");
+    param_number.value = 123456.789;
+    expect_render(&parser, "{{n}}", params, 4096, "123456.789");
+    param_number.value = -2.5e-7;
+    expect_render(&parser, "{{n}}", params, 4096, "-2.5e-7");
+    param_number.value = 1e21;
+    expect_render(&parser, "{{n}}", params, 4096, "1e+21");
+    param_number.value = 5e-324;
+    expect_render(&parser, "{{n}}", params, 4096, "5e-324");
+    param_number.value = 1.7976931348623157e308;
+    expect_render(&parser, "{{n}}", params, 4096, "1.7976931348623157e+308");
+    param_number.value = 9007199254740993.0;
+    expect_render(&parser, "{{n}}", params, 4096, "9007199254740992");
+
+    /* fixed decimals, rounded half away from zero */
+    param_number.decimals = 2;
+    param_number.value = 3.14159;
+    expect_render(&parser, "{{n}}", params, 4096, "3.14");
+    param_number.value = 2.675;
+    expect_render(&parser, "{{n}}", params, 4096, "2.68");
+    param_number.value = 9.999;
+    expect_render(&parser, "{{n}}", params, 4096, "10.00");
+    param_number.value = -0.001;
+    expect_render(&parser, "{{n}}", params, 4096, "0.00");
+    param_number.decimals = 0;
+    param_number.value = 2.5;
+    expect_render(&parser, "{{n}}", params, 4096, "3");
+    param_number.decimals = 4;
+    param_number.trimZeros = true;
+    param_number.value = 1.5;
+    expect_render(&parser, "{{n}}", params, 4096, "1.5");
+    param_number.value = 7;
+    expect_render(&parser, "{{n}}", params, 4096, "7");
+    param_number.trimZeros = false;
+
+    /* fixed decimals stay in plain notation however large the value */
+    param_number.decimals = 2;
+    param_number.value = 1e21;
+    expect_render(&parser, "{{n}}", params, 4096, "1000000000000000000000.00");
+    param_number.value = -1.5e25;
+    expect_render(&parser, "{{n}}", params, 4096, "-15000000000000000000000000.00");
+    param_number.decimals = 0;
+    param_number.value = 1.7976931348623157e308;
+    {
+        char expected[400] = "17976931348623157";
+        memset(expected + 17, '0', 292);
+        expected[309] = '\0';
+        expect_render(&parser, "{{n}}", params, 4096, expected);
+    }
+
+    /* a value cut at the end of the parse buffer */
+    param_number.decimals = 2;
+    param_number.value = 12345.678;
+    expect_render(&parser, "{{n}}", params, 5, "12345");
+
+    /* int64 and fixed-point decimals */
+    mustache_param_int64 param_int = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_INT64,
+        .name = {"i",strlen("i")},
+        .value = INT64_MIN
+    };
+    expect_render(&parser, "{{i}}", (mustache_param*)&param_int, 4096, "-9223372036854775808");
+    param_int.value = INT64_MAX;
+    expect_render(&parser, "{{i}}", (mustache_param*)&param_int, 4096, "9223372036854775807");
+
+    mustache_param_decimal param_decimal = {
+        .pNext = NULL,
+        .type = MUSTACHE_PARAM_DECIMAL,
+        .name = {"d",strlen("d")},
+        .units = 12345,
+        .scale = 2
+    };
+    expect_render(&parser, "{{d}}", (mustache_param*)&param_decimal, 4096, "123.45");
+    param_decimal.units = -5;
+    param_decimal.scale = 3;
+    expect_render(&parser, "{{d}}", (mustache_param*)&param_decimal, 4096, "-0.005");
+    param_decimal.units = 42;
+    param_decimal.scale = 0;
+    expect_render(&parser, "{{d}}", (mustache_param*)&param_decimal, 4096, "42");
+
+    /* JSON numbers, verbatim with MUSTACHE_JSON_KEEP_NUMERALS */
+    const char* numbers = "{ \"a\": 1.50, \"b\": -12, \"c\": 2.5e3, \"d\": 12345678901234567890, \"e\": 1E-2 }";
+    expect_json_render(&parser, numbers, MUSTACHE_JSON_KEEP_NUMERALS, "{{a}} {{b}} {{c}} {{d}} {{e}}", "1.50 -12 2.5e3 12345678901234567890 1E-2");
+    expect_json_render(&parser, numbers, MUSTACHE_JSON_DEEP_COPY, "{{a}} {{b}} {{c}} {{e}}", "1.50 -12 2500 0.01");
+
+    /* a negative zero keeps its sign, a value that only rounds to zero does not */
+    expect_json_render(&parser, "{ \"a\": -0, \"b\": -0.0, \"c\": -0e5, \"d\": 0 }", 0, "{{a}} {{b}} {{c}} {{d}}", "-0 -0.0 -0 0");
+    param_number.value = -0.0;
+    param_number.decimals = 2;
+    expect_render(&parser, "{{n}}", (mustache_param*)&param_number, 4096, "-0.00");
+    param_number.value = -0.001;
+    expect_render(&parser, "{{n}}", (mustache_param*)&param_number, 4096, "0.00");
+
+    /* JSON has no infinity, a magnitude beyond the largest double is invalid */
+    expect_json_error(&parser, "{ \"a\": 1.5e400 }", 0, MUSTACHE_ERR_INVALID_JSON);
+    expect_json_error(&parser, "{ \"a\": -1e309 }", MUSTACHE_JSON_KEEP_NUMERALS, MUSTACHE_ERR_INVALID_JSON);
+    expect_json_error(&parser, "{ \"a\": 200000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000.5 }", 0, MUSTACHE_ERR_INVALID_JSON);
+    expect_json_render(&parser, "{ \"a\": 1.7976931348623157e308, \"b\": 1e-400 }", 0, "{{a}} {{b}}", "1.7976931348623157e+308 0");
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,907 @@
+/***************************************************
+
+Robins Free of Charge & Open Source Public License 25
+
+Copyright (C), 2025 - Tripp R. All rights reserved.
+
+Permission for this software, the "software" being source code, binaries, and documentation,
+shall hereby be granted, free of charge, to be used for any purpose, including commercial applications,
+modification, merging, and redistrubution. The software is provided 'as-is' and comes without any
+express or implied warranty. This license is valid under the following restrictions:
+
+1. The origin of the software must not be misrepresentented; only the true author(s) of the software
+must be attributed as the it's creators. This applies every alteration of the "software", the name(s)
+of the developer(s) of any alterations must be appended to the list of names of
+the author(s) of the preceding version of the software which the alteration is based upon.
+
+2. This license must be included in all redistributions of the software source.
+
+3. All distrubitions of altered forms of the software must be clearly marked as such.
+
+4. The author(s) of this software and all subsequent alterations hold no responsibility for any
+damages that may result from use of the software.
+
+5. The software shall not be used for the purpose of training LLMs ("Large Language Models"),
+be included in datasets used for the purpose of training AI, or be used in the advancement of any
+form of Artificial Intelligence.
+
+***************************************************/
+
+#define MUSTACHE_SYSTEM_TESTS
+/* mkstemp, pipe2 and socketpair are hidden under -std=c99 */
+#define _GNU_SOURCE
+
+#include <not_mustache.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_PIPELINE)
+#include <pthread.h>
+#endif
+
+
+void* _alloc(mustache_parser* parser, size_t bytes) {
+    return malloc(bytes);
+}
+
+
+void _free(mustache_parser* parser, void* b) {
+    free(b);
+}
+
+/* output of up to 256 KB, every call of the parse callback is appended */
+typedef struct
+{
+    uint8_t parsed[256 * 1024];
+    size_t len;
+} render_output;
+
+void parse_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    render_output* output = udata;
+    memcpy(output->parsed + output->len, parsed.u, parsed.len);
+    output->len += parsed.len;
+    return;
+}
+
+static int failures = 0;
+static uint8_t PARENT_STACK_BUFFER[2048];
+
+/* a file holding source, unlinked so it goes away with the fd */
+static int template_file(const char* source)
+{
+    char path[] = "/tmp/not_mustache_sink_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    size_t len = strlen(source);
+    if (write(fd, source, len) != (ssize_t)len) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* reads fd until it ends into output */
+static void read_all(int fd, render_output* output)
+{
+    output->len = 0;
+    ssize_t got;
+    while ((got = read(fd, output->parsed + output->len, sizeof(output->parsed) - output->len)) > 0) {
+        output->len += (size_t)got;
+    }
+}
+
+/* renders the chain into one buffer, the output every sink must match */
+static uint8_t render_whole(mustache_parser* parser, mustache_structure* chain, mustache_param* params, render_output* output)
+{
+    static uint8_t PARSER_OUTPUT_BUFFER[256 * 1024];
+    output->len = 0;
+    return mustache_render(parser, (mustache_slice){ PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) }, chain, params,
+        (mustache_slice){ PARSER_OUTPUT_BUFFER, sizeof(PARSER_OUTPUT_BUFFER) }, output, parse_callback);
+}
+
+static void expect_output(const char* what, uint8_t err, const render_output* expected, const render_output* output)
+{
+    if (err || output->len != expected->len || memcmp(output->parsed, expected->parsed, output->len)) {
+        fprintf(stderr, "FAILED: %s\n    expected %zu bytes, got %zu (err %d)\n", what, expected->len, output->len, err);
+        failures++;
+    }
+}
+
+typedef struct
+{
+    const uint8_t* source;
+    size_t len;
+    size_t read;
+} memory_stream;
+
+static size_t memory_read(void* udata, uint8_t* dst, size_t dstlen)
+{
+    memory_stream* stream = udata;
+    size_t len = stream->len - stream->read < dstlen ? stream->len - stream->read : dstlen;
+    memcpy(dst, stream->source + stream->read, len);
+    stream->read += len;
+    return len;
+}
+
+/* the CRC-32 of ISO-HDLC that ends a gzip stream */
+static uint32_t crc32(const uint8_t* data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t* data, size_t len)
+{
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return b << 16 | a;
+}
+
+typedef struct
+{
+    const uint8_t* in;
+    size_t len;
+    size_t bit;
+} bit_reader;
+
+/* reads count bits, least significant first, past the end of the input reads zeros */
+static uint32_t read_bits(bit_reader* reader, uint32_t count)
+{
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < count; i++, reader->bit++) {
+        if (reader->bit / 8 < reader->len) {
+            v |= (uint32_t)(reader->in[reader->bit / 8] >> (reader->bit % 8) & 1) << i;
+        }
+    }
+    return v;
+}
+
+/* reads a Huffman code of count bits, which are packed most significant first */
+static uint32_t read_code(bit_reader* reader, uint32_t code, uint32_t count)
+{
+    while (count--) {
+        code = code << 1 | read_bits(reader, 1);
+    }
+    return code;
+}
+
+/* the literal or length symbol of the fixed codes of RFC 1951 3.2.6 */
+static uint32_t read_fixed_symbol(bit_reader* reader)
+{
+    uint32_t code = read_code(reader, 0, 7);
+    if (code <= 23) {
+        return 256 + code;
+    }
+    code = read_code(reader, code, 1);
+    if (code >= 48 && code <= 191) {
+        return code - 48;
+    }
+    if (code >= 192 && code <= 199) {
+        return 280 + code - 192;
+    }
+    return 144 + read_code(reader, code, 1) - 400;
+}
+
+/* inflates a deflate stream of stored and fixed code blocks, the only ones the deflater writes, into
+   output and returns the bytes of in it took or 0 if it is not a valid stream */
+static size_t inflate(const uint8_t* in, size_t len, render_output* output)
+{
+    static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    bit_reader reader = { in, len, 0 };
+    output->len = 0;
+
+    uint32_t final;
+    do {
+        final = read_bits(&reader, 1);
+        uint32_t type = read_bits(&reader, 2);
+        if (type == 0) {
+            reader.bit = (reader.bit + 7) / 8 * 8;
+            uint32_t storedLen = read_bits(&reader, 16);
+            if ((read_bits(&reader, 16) ^ 0xFFFF) != storedLen || reader.bit / 8 + storedLen > len
+                || output->len + storedLen > sizeof(output->parsed)) {
+                return 0;
+            }
+            memcpy(output->parsed + output->len, in + reader.bit / 8, storedLen);
+            output->len += storedLen;
+            reader.bit += 8 * storedLen;
+            continue;
+        }
+        if (type != 1) {
+            return 0;
+        }
+        uint32_t symbol;
+        while ((symbol = read_fixed_symbol(&reader)) != 256)
+        {
+            if (reader.bit > 8 * len || output->len == sizeof(output->parsed)) {
+                return 0;
+            }
+            if (symbol < 256) {
+                output->parsed[output->len++] = (uint8_t)symbol;
+                continue;
+            }
+            if (symbol > 285) {
+                return 0;
+            }
+            uint32_t matchLen = lengthBase[symbol - 257] + read_bits(&reader, lengthExtra[symbol - 257]);
+            uint32_t distSymbol = read_code(&reader, 0, 5);
+            if (distSymbol > 29) {
+                return 0;
+            }
+            uint32_t dist = distBase[distSymbol] + read_bits(&reader, distExtra[distSymbol]);
+            if (dist > output->len || output->len + matchLen > sizeof(output->parsed)) {
+                return 0;
+            }
+            for (uint32_t i = 0; i < matchLen; i++, output->len++) {
+                output->parsed[output->len] = output->parsed[output->len - dist];
+            }
+        }
+    } while (!final);
+
+    return reader.bit > 8 * len ? 0 : (reader.bit + 7) / 8;
+}
+
+static uint32_t read_le32(const uint8_t* b) {
+    return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static uint32_t read_be32(const uint8_t* b) {
+    return (uint32_t)b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3];
+}
+
+/* inflates the output of a render in format, checks its framing and compares it to expected */
+static void expect_deflated(const char* what, uint8_t err, uint32_t format, const render_output* expected, const render_output* output)
+{
+    static render_output inflated;
+    const char* problem = NULL;
+    size_t headerLen = format == MUSTACHE_DEFLATE_GZIP ? 10 : format == MUSTACHE_DEFLATE_ZLIB ? 2 : 0;
+    size_t trailerLen = format == MUSTACHE_DEFLATE_GZIP ? 8 : format == MUSTACHE_DEFLATE_ZLIB ? 4 : 0;
+    const uint8_t* out = output->parsed;
+    size_t streamLen = 0;
+
+    if (err) {
+        problem = "the render failed";
+    }
+    else if (output->len < headerLen + trailerLen) {
+        problem = "the output is too short";
+    }
+    else if ((format == MUSTACHE_DEFLATE_GZIP && (out[0] != 0x1F || out[1] != 0x8B || out[2] != 8 || out[3]))
+        || (format == MUSTACHE_DEFLATE_ZLIB && ((out[0] & 0x0F) != 8 || (out[0] << 8 | out[1]) % 31 || out[1] & 0x20))) {
+        problem = "the header is wrong";
+    }
+    else if (!(streamLen = inflate(out + headerLen, output->len - headerLen - trailerLen, &inflated))) {
+        problem = "the deflate stream does not inflate";
+    }
+    else if (headerLen + streamLen + trailerLen != output->len) {
+        problem = "bytes follow the stream";
+    }
+    else if (inflated.len != expected->len || memcmp(inflated.parsed, expected->parsed, expected->len)) {
+        problem = "the stream inflates to something else";
+    }
+    else if ((format == MUSTACHE_DEFLATE_GZIP && (read_le32(out + output->len - 8) != crc32(expected->parsed, expected->len)
+            || read_le32(out + output->len - 4) != (uint32_t)expected->len))
+        || (format == MUSTACHE_DEFLATE_ZLIB && read_be32(out + output->len - 4) != adler32(expected->parsed, expected->len))) {
+        problem = "the trailer is wrong";
+    }
+    if (problem) {
+        fprintf(stderr, "FAILED: %s (format %u)\n    %s, %zu bytes of output for %zu (err %d)\n", what, format, problem, output->len, expected->len, err);
+        failures++;
+    }
+}
+
+/* a string of len copies of c */
+static char* repeated(char c, size_t len)
+{
+    char* s = malloc(len + 1);
+    memset(s, c, len);
+    s[len] = 0;
+    return s;
+}
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_SENDFILE)
+/* renders with mustache_render_sendfile into a pipe, a socket and a file and compares each to the whole render */
+static void expect_sendfile(mustache_parser* parser, const char* what, mustache_structure* chain, int templateFd,
+    mustache_param* params, uint64_t parseBufferLen)
+{
+    render_output expected, output;
+    uint8_t* parseBuffer = malloc(parseBufferLen);
+    mustache_slice parse = { parseBuffer, parseBufferLen };
+    mustache_slice stack = { PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) };
+    if (render_whole(parser, chain, params, &expected)) {
+        fprintf(stderr, "FAILED: %s\n    the whole render failed\n", what);
+        failures++;
+        free(parseBuffer);
+        return;
+    }
+
+    int fds[2];
+    if (pipe(fds) == 0) {
+        uint8_t err = mustache_render_sendfile(parser, stack, chain, params, parse, templateFd, fds[1]);
+        close(fds[1]);
+        read_all(fds[0], &output);
+        close(fds[0]);
+        expect_output(what, err, &expected, &output);
+    }
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0) {
+        uint8_t err = mustache_render_sendfile(parser, stack, chain, params, parse, templateFd, fds[1]);
+        close(fds[1]);
+        read_all(fds[0], &output);
+        close(fds[0]);
+        expect_output(what, err, &expected, &output);
+    }
+    int outFd = template_file("");
+    if (outFd >= 0) {
+        uint8_t err = mustache_render_sendfile(parser, stack, chain, params, parse, templateFd, outFd);
+        lseek(outFd, 0, SEEK_SET);
+        read_all(outFd, &output);
+        close(outFd);
+        expect_output(what, err, &expected, &output);
+    }
+    free(parseBuffer);
+}
+#endif
+
+/* renders with every sink into a parse buffer of parseBufferLen and compares each to the whole render */
+static void expect_sinks(mustache_parser* parser, const char* what, mustache_structure* chain, int templateFd,
+    mustache_param* params, uint64_t parseBufferLen)
+{
+    render_output expected, output;
+    uint8_t* parseBuffer = malloc(parseBufferLen);
+    mustache_slice parse = { parseBuffer, parseBufferLen };
+    mustache_slice stack = { PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) };
+    if (render_whole(parser, chain, params, &expected)) {
+        fprintf(stderr, "FAILED: %s\n    the whole render failed\n", what);
+        failures++;
+        free(parseBuffer);
+        return;
+    }
+    uint8_t err;
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+    int outFd = template_file("");
+    if (outFd >= 0) {
+        err = mustache_render_fd(parser, stack, chain, params, parse, outFd, 0);
+        lseek(outFd, 0, SEEK_SET);
+        read_all(outFd, &output);
+        close(outFd);
+        expect_output(what, err, &expected, &output);
+    }
+#endif
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_SENDFILE)
+    outFd = templateFd >= 0 ? template_file("") : -1;
+    if (outFd >= 0) {
+        err = mustache_render_sendfile(parser, stack, chain, params, parse, templateFd, outFd);
+        lseek(outFd, 0, SEEK_SET);
+        read_all(outFd, &output);
+        close(outFd);
+        expect_output(what, err, &expected, &output);
+    }
+#endif
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_PIPELINE)
+    mustache_flusher flusher = { 0 };
+    if (!mustache_flusher_start(parser, &flusher)) {
+        output.len = 0;
+        err = mustache_render_pipelined(parser, stack, chain, params, parse, &flusher, &output, parse_callback);
+        mustache_flusher_stop(parser, &flusher);
+        expect_output(what, err, &expected, &output);
+    }
+#endif
+    mustache_deflater deflater = { 0 };
+    if (!mustache_deflater_create(parser, &deflater)) {
+        output.len = 0;
+        err = mustache_render_deflate(parser, stack, chain, params, parse, &deflater, MUSTACHE_DEFLATE_GZIP, &output, parse_callback);
+        mustache_deflater_free(parser, &deflater);
+        expect_deflated(what, err, MUSTACHE_DEFLATE_GZIP, &expected, &output);
+    }
+    free(parseBuffer);
+}
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_PIPELINE)
+/* what a pipelined render's parse callback saw besides the output */
+typedef struct
+{
+    render_output output;
+    pthread_t renderThread;
+    size_t calls;
+    size_t largestSlice;
+    bool onRenderThread;
+} pipelined_output;
+
+static void pipelined_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    pipelined_output* pipelined = udata;
+    pipelined->calls++;
+    pipelined->largestSlice = parsed.len > pipelined->largestSlice ? parsed.len : pipelined->largestSlice;
+    pipelined->onRenderThread |= pthread_equal(pthread_self(), pipelined->renderThread) != 0;
+    parse_callback(parser, &pipelined->output, parsed);
+}
+
+/* renders three times through one flusher into parse buffers of each of parseBufferLens, every output must
+   match the whole render and reach the callback on the flusher's thread a half at most at a time */
+static void expect_pipelined(mustache_parser* parser, const char* what, mustache_structure* chain, mustache_param* params,
+    const uint64_t* parseBufferLens, size_t count)
+{
+    static pipelined_output pipelined;
+    render_output expected;
+    mustache_slice stack = { PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) };
+    mustache_flusher flusher = { 0 };
+    uint8_t err = render_whole(parser, chain, params, &expected);
+    if (!err) {
+        err = mustache_flusher_start(parser, &flusher);
+    }
+    if (err) {
+        fprintf(stderr, "FAILED: %s\n    the whole render or the flusher failed (err %d)\n", what, err);
+        failures++;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t* parseBuffer = malloc(parseBufferLens[i]);
+        mustache_slice parse = { parseBuffer, parseBufferLens[i] };
+        for (int pass = 0; pass < 3; pass++)
+        {
+            memset(&pipelined, 0, sizeof(pipelined));
+            pipelined.renderThread = pthread_self();
+            err = mustache_render_pipelined(parser, stack, chain, params, parse, &flusher, &pipelined, pipelined_callback);
+            expect_output(what, err, &expected, &pipelined.output);
+            if (pipelined.onRenderThread || pipelined.largestSlice > parseBufferLens[i] / 2) {
+                fprintf(stderr, "FAILED: %s (parse buffer %llu)\n    %zu calls, %s, the largest slice %zu bytes\n", what,
+                    (unsigned long long)parseBufferLens[i], pipelined.calls,
+                    pipelined.onRenderThread ? "on the render's thread" : "on the flusher's thread", pipelined.largestSlice);
+                failures++;
+            }
+        }
+        free(parseBuffer);
+    }
+    mustache_flusher_stop(parser, &flusher);
+}
+#endif
+
+#if defined(__linux__)
+/* renders with MUSTACHE_FD_ALIGNED into a file opened for direct I/O where the file system allows it, from a
+   parse buffer that starts off a block boundary, and compares the file to the whole render */
+static void expect_aligned(mustache_parser* parser, const char* what, mustache_structure* chain, mustache_param* params, uint64_t parseBufferLen)
+{
+    render_output expected, output;
+    uint8_t* parseBuffer = malloc(parseBufferLen + 1);
+    mustache_slice parse = { parseBuffer + 1, parseBufferLen };
+    mustache_slice stack = { PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) };
+    char path[] = "/tmp/not_mustache_aligned_XXXXXX";
+    int outFd = mkstemp(path);
+    uint8_t err = render_whole(parser, chain, params, &expected);
+    if (err || outFd < 0) {
+        fprintf(stderr, "FAILED: %s\n    the whole render or the file failed (err %d)\n", what, err);
+        failures++;
+    }
+    else {
+        unlink(path);
+        fcntl(outFd, F_SETFL, fcntl(outFd, F_GETFL) | O_DIRECT);
+        err = mustache_render_fd(parser, stack, chain, params, parse, outFd, MUSTACHE_FD_ALIGNED);
+        lseek(outFd, 0, SEEK_SET);
+        fcntl(outFd, F_SETFL, fcntl(outFd, F_GETFL) & ~O_DIRECT);
+        read_all(outFd, &output);
+        expect_output(what, err, &expected, &output);
+    }
+    if (outFd >= 0) {
+        close(outFd);
+    }
+    free(parseBuffer);
+}
+#endif
+
+/* renders twice in each format through one deflater into a parse buffer of parseBufferLen and inflates every output */
+static void expect_deflate(mustache_parser* parser, const char* what, mustache_structure* chain, mustache_param* params, uint64_t parseBufferLen)
+{
+    static const uint32_t formats[] = { MUSTACHE_DEFLATE_RAW, MUSTACHE_DEFLATE_ZLIB, MUSTACHE_DEFLATE_GZIP };
+    render_output expected, output;
+    uint8_t* parseBuffer = malloc(parseBufferLen);
+    mustache_slice parse = { parseBuffer, parseBufferLen };
+    mustache_slice stack = { PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) };
+    mustache_deflater deflater = { 0 };
+    uint8_t err = render_whole(parser, chain, params, &expected);
+    if (!err) {
+        err = mustache_deflater_create(parser, &deflater);
+    }
+    if (err) {
+        fprintf(stderr, "FAILED: %s\n    the whole render or the deflater failed (err %d)\n", what, err);
+        failures++;
+        free(parseBuffer);
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        for (int pass = 0; pass < 2; pass++)
+        {
+            output.len = 0;
+            err = mustache_render_deflate(parser, stack, chain, params, parse, &deflater, formats[i], &output, parse_callback);
+            expect_deflated(what, err, formats[i], &expected, &output);
+        }
+    }
+    mustache_deflater_free(parser, &deflater);
+    free(parseBuffer);
+}
+
+/* the output of a deflated render whose first callback renames the global title and every element's name */
+typedef struct
+{
+    render_output output;
+    mustache_param_object* root;
+    bool renamed;
+} renaming_output;
+
+static void renaming_callback(mustache_parser* parser, void* udata, mustache_slice parsed)
+{
+    renaming_output* renaming = udata;
+    parse_callback(parser, &renaming->output, parsed);
+    if (renaming->renamed) {
+        return;
+    }
+    renaming->renamed = true;
+    for (mustache_param* member = renaming->root->pMembers; member; member = member->pNext)
+    {
+        if (member->name.len == 5 && !memcmp(member->name.u, "title", 5)) {
+            member->name.u = (const uint8_t*)"TITLE";
+        }
+        if (member->type != MUSTACHE_PARAM_LIST) {
+            continue;
+        }
+        mustache_param_list* users = (mustache_param_list*)member;
+        mustache_param* user = users->pValues;
+        for (uint32_t i = 0; i < users->valueCount; i++, user = user->pNext) {
+            for (mustache_param* field = ((mustache_param_object*)user)->pMembers; field; field = field->pNext) {
+                if (field->name.len == 4 && !memcmp(field->name.u, "name", 4)) {
+                    field->name.u = (const uint8_t*)"NAME";
+                }
+            }
+        }
+    }
+}
+
+/* renders template with mustache_render_hashed and compares the hash to expected and the output to mustache_render */
+static void expect_hash(mustache_parser* parser, const char* template, mustache_param* params, uint64_t expected)
+{
+    static uint8_t PARSER_OUTPUT_BUFFER[256 * 1024];
+    render_output whole, output = { .len = 0 };
+    uint64_t hash = 0;
+    mustache_structure chain = { 0 };
+    uint8_t err = mustache_compile(parser, (mustache_const_slice){ (const uint8_t*)template, strlen(template) }, &chain);
+    if (!err) {
+        err = render_whole(parser, &chain, params, &whole);
+    }
+    if (!err) {
+        err = mustache_render_hashed(parser, (mustache_slice){ PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) }, &chain, params,
+            (mustache_slice){ PARSER_OUTPUT_BUFFER, sizeof(PARSER_OUTPUT_BUFFER) }, &hash, &output, parse_callback);
+    }
+    mustache_structure_chain_free(parser, &chain);
+
+    if (err || hash != expected || output.len != whole.len || memcmp(output.parsed, whole.parsed, output.len)) {
+        fprintf(stderr, "FAILED: %.40s\n    expected hash %016llx, got %016llx (err %d)\n", template,
+            (unsigned long long)expected, (unsigned long long)hash, err);
+        failures++;
+    }
+}
+
+int main()
+{
+    mustache_parser parser;
+    parser.alloc = _alloc;
+    parser.free = _free;
+    parser.userData = NULL;
+    parser.spacesPerTab = 4;
+
+    const char* JSON = "{ \"name\": \"<b>\", \"users\": [ { \"name\": \"a\" }, { \"name\": \"b\" } ] }";
+    mustache_param* jsonRoot = NULL;
+    if (mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)JSON, strlen(JSON) }, &jsonRoot, 0, NULL)) {
+        fprintf(stderr, "FAILED: the test params did not parse\n");
+        return -1;
+    }
+    mustache_param* params = ((mustache_param_object*)jsonRoot)->pMembers;
+
+    /* long literal spans around values and a section, the pieces a sink sends or writes differently */
+    char* x = repeated('x', 20000);
+    char* y = repeated('y', 30000);
+    size_t sourceLen = strlen(x) + strlen(y) + 128;
+    char* source = malloc(sourceLen);
+    snprintf(source, sourceLen, "%s{{name}}%s\n{{#users}}[{{name}}]{{/users}}{{! the end }}", x, y);
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_SENDFILE)
+    {
+        int templateFd = template_file(source);
+        mustache_structure chain = { 0 };
+        uint8_t err = templateFd < 0 ? MUSTACHE_ERR_FILE_OPEN : mustache_compile_fd(&parser, templateFd, &chain);
+        if (err) {
+            fprintf(stderr, "FAILED: compiling the template file (err %d)\n", err);
+            failures++;
+        }
+        else {
+            /* the spans are spliced into the pipe and sent to the socket and the file */
+            expect_sendfile(&parser, "render_sendfile", &chain, templateFd, params, 4096);
+
+            /* a chain compiled from a stream no longer lines up with its file, it is written from memory */
+            mustache_structure streamed = { 0 };
+            memory_stream memory = { (const uint8_t*)source, strlen(source), 0 };
+            mustache_stream stream = { &memory, memory_read, NULL };
+            err = mustache_compile_stream(&parser, &stream, &streamed);
+            if (err) {
+                fprintf(stderr, "FAILED: compiling the template stream (err %d)\n", err);
+                failures++;
+            }
+            else {
+                expect_sendfile(&parser, "render_sendfile of a stream", &streamed, templateFd, params, 4096);
+            }
+            mustache_structure_chain_free(&parser, &streamed);
+            mustache_structure_chain_free(&parser, &chain);
+        }
+        if (templateFd >= 0) {
+            close(templateFd);
+        }
+    }
+#endif
+
+    /* a value longer than the parse buffer is written across as many flushes as it takes */
+    {
+        char* lt = repeated('<', 20000);
+        size_t bigLen = strlen(lt) + 64;
+        char* bigJSON = malloc(bigLen);
+        snprintf(bigJSON, bigLen, "{ \"big\": \"%s\" }", lt);
+        mustache_param* bigRoot = NULL;
+        mustache_structure chain = { 0 };
+        const char* bigTemplate = "[{{big}}]{{&big}}{{%url big}}";
+        int templateFd = template_file(bigTemplate);
+        uint8_t err = mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)bigJSON, strlen(bigJSON) }, &bigRoot, 0, NULL);
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)bigTemplate, strlen(bigTemplate) }, &chain);
+        }
+        if (err) {
+            fprintf(stderr, "FAILED: the big value template (err %d)\n", err);
+            failures++;
+        }
+        else {
+            expect_sinks(&parser, "a 20000 byte value through a 1000 byte parse buffer", &chain, templateFd,
+                ((mustache_param_object*)bigRoot)->pMembers, 1000);
+        }
+        mustache_structure_chain_free(&parser, &chain);
+        if (bigRoot) {
+            mustache_free_param_list(&parser, bigRoot, 0);
+        }
+        if (templateFd >= 0) {
+            close(templateFd);
+        }
+        free(bigJSON);
+        free(lt);
+    }
+
+#if defined(__linux__)
+    /* aligned writes cover outputs shorter than a block and values longer than the parse buffer */
+    {
+        const char* small = "{{#users}}{{name}};{{/users}}";
+        size_t bigLen = 20000 + 64;
+        char* lt = repeated('<', 20000);
+        char* bigJSON = malloc(bigLen);
+        snprintf(bigJSON, bigLen, "{ \"big\": \"%s\" }", lt);
+        const char* bigTemplate = "[{{big}}]{{&big}}";
+        mustache_param* bigRoot = NULL;
+        mustache_structure chain = { 0 }, smallChain = { 0 }, bigChain = { 0 };
+        uint8_t err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)source, strlen(source) }, &chain);
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)small, strlen(small) }, &smallChain);
+        }
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)bigTemplate, strlen(bigTemplate) }, &bigChain);
+        }
+        if (!err) {
+            err = mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)bigJSON, strlen(bigJSON) }, &bigRoot, 0, NULL);
+        }
+        if (err) {
+            fprintf(stderr, "FAILED: compiling the aligned templates (err %d)\n", err);
+            failures++;
+        }
+        else {
+            expect_aligned(&parser, "render_fd aligned", &chain, params, 3 * 4096);
+            expect_aligned(&parser, "render_fd aligned", &chain, params, 64 * 1024);
+            expect_aligned(&parser, "render_fd aligned of less than a block", &smallChain, params, 3 * 4096);
+            expect_aligned(&parser, "render_fd aligned of a long value", &bigChain, ((mustache_param_object*)bigRoot)->pMembers, 3 * 4096);
+
+            /* an aligned render needs room for whole blocks */
+            uint8_t parseBuffer[2 * 4096];
+            if (mustache_render_fd(&parser, (mustache_slice){ PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) }, &smallChain, params,
+                    (mustache_slice){ parseBuffer, sizeof(parseBuffer) }, STDOUT_FILENO, MUSTACHE_FD_ALIGNED) != MUSTACHE_ERR_ARGS) {
+                fprintf(stderr, "FAILED: render_fd aligned into a parse buffer of two blocks\n");
+                failures++;
+            }
+        }
+        mustache_structure_chain_free(&parser, &chain);
+        mustache_structure_chain_free(&parser, &smallChain);
+        mustache_structure_chain_free(&parser, &bigChain);
+        if (bigRoot) {
+            mustache_free_param_list(&parser, bigRoot, 0);
+        }
+        free(bigJSON);
+        free(lt);
+    }
+#endif
+
+#if defined(__linux__) && !defined(NOT_MUSTACHE_NO_PIPELINE)
+    /* one flusher serves render after render, through halves from a few bytes to more than the output */
+    {
+        static const uint64_t parseBufferLens[] = { 16, 101, 1000, 4096, 128 * 1024 };
+        const char* small = "{{#users}}{{name}};{{/users}}";
+        mustache_structure chain = { 0 }, smallChain = { 0 };
+        uint8_t err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)source, strlen(source) }, &chain);
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)small, strlen(small) }, &smallChain);
+        }
+        if (err) {
+            fprintf(stderr, "FAILED: compiling the pipelined templates (err %d)\n", err);
+            failures++;
+        }
+        else {
+            expect_pipelined(&parser, "render_pipelined", &chain, params, parseBufferLens, sizeof(parseBufferLens) / sizeof(parseBufferLens[0]));
+            expect_pipelined(&parser, "render_pipelined of a small template", &smallChain, params, parseBufferLens,
+                sizeof(parseBufferLens) / sizeof(parseBufferLens[0]));
+        }
+        mustache_structure_chain_free(&parser, &chain);
+        mustache_structure_chain_free(&parser, &smallChain);
+    }
+#endif
+
+    /* every format inflates back to the render, with the literal spans compressed as the output comes or
+       once ahead of time. Only whole lines without tags are compressed ahead, so lines has pieces and source none */
+    {
+        const char* empty = "{{! nothing }}";
+        size_t linesLen = sourceLen + 64;
+        char* lines = malloc(linesLen);
+        snprintf(lines, linesLen, "%s\n{{name}}\n%s\n{{#users}}[{{name}}]{{/users}}\n%.1500s", x, y, x);
+        mustache_structure chain = { 0 }, linesChain = { 0 }, emptyChain = { 0 }, uncompiled = { 0 };
+        uint8_t err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)source, strlen(source) }, &chain);
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)lines, strlen(lines) }, &linesChain);
+        }
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)empty, strlen(empty) }, &emptyChain);
+        }
+        if (err) {
+            fprintf(stderr, "FAILED: compiling the deflate templates (err %d)\n", err);
+            failures++;
+        }
+        else {
+            expect_deflate(&parser, "render_deflate", &chain, params, 1000);
+            expect_deflate(&parser, "render_deflate", &linesChain, params, 64 * 1024);
+            expect_deflate(&parser, "render_deflate of nothing", &emptyChain, params, 1000);
+            err = mustache_compile_deflate(&parser, &chain);
+            if (!err) {
+                err = mustache_compile_deflate(&parser, &linesChain);
+            }
+            if (err || mustache_compile_deflate(&parser, &linesChain) != MUSTACHE_ERR_ARGS || mustache_compile_deflate(&parser, &uncompiled) != MUSTACHE_ERR_ARGS) {
+                fprintf(stderr, "FAILED: compile_deflate of a chain once, twice and uncompiled (err %d)\n", err);
+                failures++;
+            }
+            expect_deflate(&parser, "render_deflate without pieces", &chain, params, 1000);
+            expect_deflate(&parser, "render_deflate of pieces", &linesChain, params, 1000);
+            expect_deflate(&parser, "render_deflate of pieces", &linesChain, params, 64 * 1024);
+        }
+        mustache_structure_chain_free(&parser, &chain);
+        mustache_structure_chain_free(&parser, &linesChain);
+        mustache_structure_chain_free(&parser, &emptyChain);
+        free(lines);
+    }
+
+    /* a name that does not change inside a loop is looked up once, a name bound to the element once per element.
+       The deflater's callback comes in the middle of the render and renames both, only the element's is seen */
+    {
+        const size_t userCount = 200, padLen = 1000;
+        size_t cacheJSONLen = userCount * (padLen + 64) + 64;
+        char* cacheJSON = malloc(cacheJSONLen);
+        char* head = cacheJSON + sprintf(cacheJSON, "{ \"title\": \"T\", \"users\": [");
+        uint32_t seed = 1;
+        for (size_t i = 0; i < userCount; i++)
+        {
+            head += sprintf(head, "%s{ \"name\": \"N%zu\", \"pad\": \"", i ? ", " : "", i);
+            for (size_t j = 0; j < padLen; j++) {
+                seed = seed * 1103515245 + 12345;
+                *head++ = 'a' + (seed >> 16) % 26;
+            }
+            head += sprintf(head, "\" }");
+        }
+        sprintf(head, "] }");
+
+        const char* cacheTemplate = "{{#users}}{{title}}{{name}}{{pad}};{{/users}}";
+        mustache_param* cacheRoot = NULL;
+        mustache_structure chain = { 0 };
+        mustache_deflater deflater = { 0 };
+        static renaming_output renaming;
+        static render_output inflated;
+        static uint8_t parseBuffer[4096];
+        uint8_t err = mustache_JSON_to_param_chain(&parser, (mustache_const_slice){ (const uint8_t*)cacheJSON, strlen(cacheJSON) }, &cacheRoot, 0, NULL);
+        if (!err) {
+            err = mustache_compile(&parser, (mustache_const_slice){ (const uint8_t*)cacheTemplate, strlen(cacheTemplate) }, &chain);
+        }
+        if (!err) {
+            err = mustache_deflater_create(&parser, &deflater);
+        }
+        if (!err) {
+            renaming.root = (mustache_param_object*)cacheRoot;
+            err = mustache_render_deflate(&parser, (mustache_slice){ PARENT_STACK_BUFFER, sizeof(PARENT_STACK_BUFFER) }, &chain,
+                renaming.root->pMembers, (mustache_slice){ parseBuffer, sizeof(parseBuffer) }, &deflater, MUSTACHE_DEFLATE_RAW,
+                &renaming, renaming_callback);
+        }
+        if (!err && !inflate(renaming.output.parsed, renaming.output.len, &inflated)) {
+            err = MUSTACHE_ERR_STREAM;
+        }
+
+        /* every element keeps the title, the names stop where the callback came */
+        size_t titled = 0, named = 0;
+        bool namesInOrder = true;
+        const uint8_t* cur = inflated.parsed;
+        const uint8_t* end = inflated.parsed + inflated.len;
+        while (!err && cur < end)
+        {
+            const uint8_t* next = memchr(cur, ';', end - cur);
+            next = next ? next : end;
+            titled += *cur == 'T';
+            if (cur + 1 < next && cur[1] == 'N') {
+                namesInOrder &= named == titled - 1;
+                named++;
+            }
+            cur = next + 1;
+        }
+        if (err || titled != userCount || !named || named == userCount || !namesInOrder) {
+            fprintf(stderr, "FAILED: loop invariant names\n    expected %zu titles and the names up to the callback\n"
+                "    got %zu titles and %zu names (err %d)\n", userCount, titled, named, err);
+            failures++;
+        }
+        mustache_deflater_free(&parser, &deflater);
+        mustache_structure_chain_free(&parser, &chain);
+        if (cacheRoot) {
+            mustache_free_param_list(&parser, cacheRoot, 0);
+        }
+        free(cacheJSON);
+    }
+
+    /* the hash is XXH64 with a seed of 0, the values are those of the reference xxHash */
+    expect_hash(&parser, "{{! nothing }}", params, 0xEF46DB3751D8E999ull);
+    expect_hash(&parser, "abc{{! c }}", params, 0x44BC2CF5AD770999ull);
+    {
+        size_t hashedLen = 40000 + 64;
+        char* hashed = malloc(hashedLen);
+        char* xs = repeated('x', 40000);
+        snprintf(hashed, hashedLen, "{{name}}%s{{#users}}{{name}};{{/users}}", xs);
+        expect_hash(&parser, hashed, params, 0x67E5D5BACEDF4A52ull);
+        free(xs);
+        free(hashed);
+    }
+
+    free(source);
+    free(x);
+    free(y);
+    mustache_free_param_list(&parser, jsonRoot, 0);
+
+    if (failures) {
+        fprintf(stderr, "%d FAILED\n", failures);
+        return -1;
+    }
+    return 0;
+}